@@ -0,0 +1,303 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2007      Carlos Licea     <carlos _licea@hotmail.com>
+// Copyright 2011      Bernhard Beschow <bbeschow@cs.tu-berlin.de>
+//
+
+
+// local
+#include "CylindricalScanlineTextureMapper.h"
+
+// posix
+#include <cmath>
+
+// Qt
+#include <QRect>
+#include <QRunnable>
+
+// Marble
+#include "GeoPainter.h"
+#include "MarbleMath.h"
+#include "JobGroup.h"
+#include "ScanlineTextureMapperContext.h"
+#include "StackedTileLoader.h"
+#include "TextureColorizer.h"
+#include "ViewportParams.h"
+
+using namespace Marble;
+
+CylindricalScanlineTextureMapper::CylindricalScanlineTextureMapper( StackedTileLoader *tileLoader )
+    : TextureMapperInterface(),
+      m_tileLoader( tileLoader ),
+      m_radius( 0 ),
+      m_oldYPaintedTop( 0 ),
+      m_oldYPaintedBottom( 0 ),
+      m_oldYCenterOffset( 0 ),
+      m_oldCenterLon( 0.0 ),
+      m_oldTileZoomLevel( -1 ),
+      m_oldMapQuality( NormalQuality ),
+      m_scrollError( 0.0 ),
+      m_centerMoved( false )
+{
+}
+
+void CylindricalScanlineTextureMapper::mapTexture( GeoPainter *painter,
+                                                const ViewportParams *viewport,
+                                                int tileZoomLevel,
+                                                const QRect &dirtyRect,
+                                                TextureColorizer *texColorizer )
+{
+    if ( m_canvasImage.size() != viewport->size() || m_radius != viewport->radius() ) {
+        const QImage::Format optimalFormat = ScanlineTextureMapperContext::optimalCanvasImageFormat( viewport );
+
+        if ( m_canvasImage.size() != viewport->size() || m_canvasImage.format() != optimalFormat ) {
+            m_canvasImage = QImage( viewport->size(), optimalFormat );
+        }
+
+        if ( !viewport->mapCoversViewport() ) {
+            m_canvasImage.fill( 0 );
+        }
+
+        m_radius = viewport->radius();
+        m_repaintNeeded = true;
+    }
+
+    // The colorized image depends on the whole canvas, so don't bother
+    // patching it.
+    if ( !m_repaintNeeded && ( m_centerMoved || !m_dirtyTiles.isEmpty() ) ) {
+        m_repaintNeeded = texColorizer || !updateTexture( viewport, tileZoomLevel, painter->mapQuality() );
+    }
+
+    if ( m_repaintNeeded ) {
+        mapTexture( viewport, tileZoomLevel, painter->mapQuality() );
+
+        if ( texColorizer ) {
+            texColorizer->colorize( &m_canvasImage, viewport, painter->mapQuality() );
+        }
+
+        m_repaintNeeded = false;
+    }
+
+    m_centerMoved = false;
+    m_dirtyTiles.clear();
+
+    painter->drawImage( dirtyRect, m_canvasImage, dirtyRect );
+}
+
+void CylindricalScanlineTextureMapper::setCenterMoved()
+{
+    m_centerMoved = true;
+}
+
+void CylindricalScanlineTextureMapper::setTileRepaintNeeded( const TileId &stackedTileId )
+{
+    if ( !m_dirtyTiles.contains( stackedTileId ) ) {
+        m_dirtyTiles.append( stackedTileId );
+    }
+}
+
+void CylindricalScanlineTextureMapper::mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality )
+{
+    // Reset backend
+    m_tileLoader->resetTilehash();
+
+    // Initialize needed constants:
+
+    const int imageHeight = m_canvasImage.height();
+    const int imageWidth  = m_canvasImage.width();
+
+    // Calculate translation of center point and the y-range that
+    // actually can be painted
+    const int yCenterOffset = this->yCenterOffset( viewport );
+
+    int yPaintedTop    = 0;
+    int yPaintedBottom = 0;
+    paintedRows( viewport, &yPaintedTop, &yPaintedBottom );
+
+    JobGroup jobs( MarbleGlobal::getInstance()->threadPool() );
+    const int yStep = ScanlineTextureMapperContext::rowBandHeight( yPaintedBottom - yPaintedTop, jobs.maxThreadCount() );
+    for ( int yStart = yPaintedTop; yStart < yPaintedBottom; yStart += yStep ) {
+        const int yEnd = qMin( yPaintedBottom, yStart + yStep );
+        QRunnable *const job = createRenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, yStart, yEnd, 0, imageWidth );
+        jobs.start( job );
+    }
+
+    // Remove unused lines
+    const int clearStart = ( yPaintedTop - m_oldYPaintedTop <= 0 ) ? yPaintedBottom : 0;
+    const int clearStop  = ( yPaintedTop - m_oldYPaintedTop <= 0 ) ? imageHeight  : yPaintedTop;
+
+    QRgb * const itClearBegin = (QRgb*)( m_canvasImage.scanLine( clearStart ) );
+    QRgb * const itClearEnd = (QRgb*)( m_canvasImage.scanLine( clearStop ) );
+
+    for ( QRgb * it = itClearBegin; it < itClearEnd; ++it ) {
+        *(it) = 0;
+    }
+
+    jobs.waitForDone();
+
+    m_oldYPaintedTop = yPaintedTop;
+    m_oldYPaintedBottom = yPaintedBottom;
+    m_oldYCenterOffset = yCenterOffset;
+    m_oldCenterLon = viewport->centerLongitude();
+    m_oldTileZoomLevel = tileZoomLevel;
+    m_oldMapQuality = mapQuality;
+    m_scrollError = 0.0;
+
+    m_tileLoader->cleanupTilehash();
+}
+
+bool CylindricalScanlineTextureMapper::updateTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality )
+{
+    if ( tileZoomLevel != m_oldTileZoomLevel || mapQuality != m_oldMapQuality ) {
+        return false;
+    }
+
+    const int imageHeight = m_canvasImage.height();
+    const int imageWidth  = m_canvasImage.width();
+    const qint64  radius  = viewport->radius();
+    const float rad2Pixel = (float)( 2 * radius ) / M_PI;
+
+    // Horizontal shift of the map in pixels, taking the date line into account
+    qreal deltaLon = viewport->centerLongitude() - m_oldCenterLon;
+    if ( deltaLon >  M_PI ) deltaLon -= 2 * M_PI;
+    if ( deltaLon < -M_PI ) deltaLon += 2 * M_PI;
+
+    const qreal dxExact = -deltaLon * rad2Pixel;
+    const int dx = qRound( dxExact );
+
+    const int yCenterOffset = this->yCenterOffset( viewport );
+    const int dy = yCenterOffset - m_oldYCenterOffset;
+
+    // The canvas can only be moved by whole pixels. Repaint it completely
+    // before the accumulated rounding error becomes visible.
+    const qreal scrollError = m_scrollError + dxExact - dx;
+    if ( qAbs( scrollError ) > 0.25 || qAbs( dx ) >= imageWidth || qAbs( dy ) >= imageHeight ) {
+        return false;
+    }
+
+    int yPaintedTop    = 0;
+    int yPaintedBottom = 0;
+    paintedRows( viewport, &yPaintedTop, &yPaintedBottom );
+
+    ScanlineTextureMapperContext::scrollImage( &m_canvasImage, dx, dy );
+
+    // Lines that were painted before and are still painted now
+    const int reuseTop    = qMax( yPaintedTop, m_oldYPaintedTop + dy );
+    const int reuseBottom = qMin( yPaintedBottom, m_oldYPaintedBottom + dy );
+
+    // Remove lines that were scrolled outside of the painted range
+    for ( int y = qMax( 0, m_oldYPaintedTop + dy ); y < qMin( imageHeight, m_oldYPaintedBottom + dy ); ++y ) {
+        if ( y < yPaintedTop || y >= yPaintedBottom ) {
+            memset( m_canvasImage.scanLine( y ), 0, m_canvasImage.bytesPerLine() );
+        }
+    }
+
+    QVector<QRect> rects;
+    if ( reuseTop >= reuseBottom ) {
+        rects << QRect( 0, yPaintedTop, imageWidth, yPaintedBottom - yPaintedTop );
+    }
+    else {
+        rects << QRect( 0, yPaintedTop, imageWidth, reuseTop - yPaintedTop );
+        rects << QRect( 0, reuseBottom, imageWidth, yPaintedBottom - reuseBottom );
+        if ( dx > 0 ) {
+            rects << QRect( 0, reuseTop, dx, reuseBottom - reuseTop );
+        }
+        else if ( dx < 0 ) {
+            rects << QRect( imageWidth + dx, reuseTop, -dx, reuseBottom - reuseTop );
+        }
+    }
+
+    foreach ( const TileId &id, m_dirtyTiles ) {
+        if ( id.zoomLevel() == tileZoomLevel ) {
+            addTileRects( id, viewport, &rects );
+        }
+    }
+
+    const QRect paintedRect( 0, yPaintedTop, imageWidth, yPaintedBottom - yPaintedTop );
+    for ( int i = 0; i < rects.size(); ++i ) {
+        rects[i] = rects[i].intersected( paintedRect );
+    }
+
+    renderRects( rects, viewport, tileZoomLevel, mapQuality );
+
+    m_oldYPaintedTop = yPaintedTop;
+    m_oldYPaintedBottom = yPaintedBottom;
+    m_oldYCenterOffset = yCenterOffset;
+    m_oldCenterLon = viewport->centerLongitude();
+    m_scrollError = scrollError;
+
+    return true;
+}
+
+void CylindricalScanlineTextureMapper::addTileRects( const TileId &stackedTileId, const ViewportParams *viewport, QVector<QRect> *rects ) const
+{
+    const int imageWidth  = m_canvasImage.width();
+    const qint64  radius  = viewport->radius();
+    const qreal rad2Pixel = (qreal)( 2 * radius ) / M_PI;
+
+    const int columnCount = m_tileLoader->tileColumnCount( stackedTileId.zoomLevel() );
+    const int rowCount = m_tileLoader->tileRowCount( stackedTileId.zoomLevel() );
+
+    const qreal lonLeft = ( 2.0 * stackedTileId.x() / columnCount - 1.0 ) * M_PI;
+    const qreal lonWidth = 2 * M_PI / columnCount;
+
+    qreal latTop = 0;
+    qreal latBottom = 0;
+    if ( m_tileLoader->tileProjection() == GeoSceneTileDataset::Mercator ) {
+        latTop = gd( ( 1.0 - 2.0 * stackedTileId.y() / rowCount ) * M_PI );
+        latBottom = gd( ( 1.0 - 2.0 * ( stackedTileId.y() + 1 ) / rowCount ) * M_PI );
+    }
+    else {
+        latTop = ( 0.5 - (qreal)stackedTileId.y() / rowCount ) * M_PI;
+        latBottom = ( 0.5 - (qreal)( stackedTileId.y() + 1 ) / rowCount ) * M_PI;
+    }
+
+    int y1 = 0;
+    int y2 = 0;
+    latitudeRows( latTop, latBottom, viewport, &y1, &y2 );
+
+    // The map repeats horizontally, so the tile may be visible several times
+    const qreal period = 2 * M_PI * rad2Pixel;
+    qreal x1 = ( lonLeft - viewport->centerLongitude() ) * rad2Pixel + imageWidth / 2;
+    x1 = fmod( x1, period );
+    if ( x1 > 0 ) {
+        x1 -= period;
+    }
+
+    for ( ; x1 < imageWidth; x1 += period ) {
+        const int left = (int)floor( x1 ) - 1;
+        const int right = (int)ceil( x1 + lonWidth * rad2Pixel ) + 1;
+        if ( right > 0 ) {
+            rects->append( QRect( left, y1, right - left, y2 - y1 ) );
+        }
+    }
+}
+
+void CylindricalScanlineTextureMapper::renderRects( const QVector<QRect> &rects, const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality )
+{
+    m_tileLoader->resetTilehash();
+
+    JobGroup jobs( MarbleGlobal::getInstance()->threadPool() );
+
+    foreach ( const QRect &rect, rects ) {
+        if ( rect.isEmpty() ) {
+            continue;
+        }
+
+        const int yStep = ScanlineTextureMapperContext::rowBandHeight( rect.height(), jobs.maxThreadCount() );
+        for ( int yStart = rect.top(); yStart <= rect.bottom(); yStart += yStep ) {
+            const int yEnd = qMin( rect.bottom() + 1, yStart + yStep );
+            QRunnable *const job = createRenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, yStart, yEnd, rect.left(), rect.right() + 1 );
+            jobs.start( job );
+        }
+    }
+
+    jobs.waitForDone();
+
+    m_tileLoader->cleanupTilehash();
+}
@@ -0,0 +1,114 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2007      Carlos Licea     <carlos _licea@hotmail.com>
+// Copyright 2008      Inge Wallin      <inge@lysator.liu.se>
+// Copyright 2011      Bernhard Beschow <bbeschow@cs.tu-berlin.de>
+//
+
+#ifndef MARBLE_CYLINDRICALSCANLINETEXTUREMAPPER_H
+#define MARBLE_CYLINDRICALSCANLINETEXTUREMAPPER_H
+
+
+#include "TextureMapperInterface.h"
+
+#include "MarbleGlobal.h"
+#include "TileId.h"
+
+#include <QImage>
+#include <QList>
+#include <QVector>
+
+class QRunnable;
+
+namespace Marble
+{
+
+/**
+ * Base class of the texture mappers of the cylindrical projections.
+ *
+ * In these projections panning the map horizontally or vertically moves
+ * the canvas by whole pixels, so the previous canvas is scrolled and only
+ * the uncovered areas and the changed tiles are rendered again.
+ * Subclasses provide the mapping between latitudes and rows of the canvas
+ * and the jobs that render parts of the canvas.
+ */
+class CylindricalScanlineTextureMapper : public TextureMapperInterface
+{
+ public:
+    explicit CylindricalScanlineTextureMapper( StackedTileLoader *tileLoader );
+
+    virtual void mapTexture( GeoPainter *painter,
+                             const ViewportParams *viewport,
+                             int tileZoomLevel,
+                             const QRect &dirtyRect,
+                             TextureColorizer *texColorizer );
+
+    virtual void setCenterMoved();
+
+    virtual void setTileRepaintNeeded( const TileId &stackedTileId );
+
+ protected:
+    /**
+     * Returns the vertical offset of the map in pixels caused by the
+     * latitude of the center.
+     */
+    virtual int yCenterOffset( const ViewportParams *viewport ) const = 0;
+
+    /**
+     * Determines the range of rows of the canvas covered by the map,
+     * limited to the canvas.
+     */
+    virtual void paintedRows( const ViewportParams *viewport, int *yPaintedTop, int *yPaintedBottom ) const = 0;
+
+    /**
+     * Determines the range of rows of the canvas covered by the latitudes
+     * from @p latTop to @p latBottom, including one row of margin on each side.
+     */
+    virtual void latitudeRows( qreal latTop, qreal latBottom, const ViewportParams *viewport, int *y1, int *y2 ) const = 0;
+
+    /**
+     * Creates the job that renders the given part of the canvas.
+     */
+    virtual QRunnable *createRenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage,
+                                        const ViewportParams *viewport, MapQuality mapQuality,
+                                        int yTop, int yBottom, int xLeft, int xRight ) const = 0;
+
+ private:
+    void mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality );
+
+    /**
+     * Scrolls the previously rendered canvas according to the change of the
+     * center and renders only the uncovered areas and the dirty tiles.
+     *
+     * Returns false if the canvas cannot be reused and needs to be
+     * repainted completely.
+     */
+    bool updateTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality );
+
+    void addTileRects( const TileId &stackedTileId, const ViewportParams *viewport, QVector<QRect> *rects ) const;
+
+    void renderRects( const QVector<QRect> &rects, const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality );
+
+ private:
+    StackedTileLoader *const m_tileLoader;
+    int m_radius;
+    QImage m_canvasImage;
+    int    m_oldYPaintedTop;
+    int    m_oldYPaintedBottom;
+    int    m_oldYCenterOffset;
+    qreal  m_oldCenterLon;
+    int    m_oldTileZoomLevel;
+    MapQuality m_oldMapQuality;
+    qreal  m_scrollError;
+    bool   m_centerMoved;
+    QList<TileId> m_dirtyTiles;
+};
+
+}
+
+#endif
@@ -14,55 +14,73 @@
 
 // Qt
 #include <QtGlobal>
+#include <QDateTime>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QDirIterator>
 #include <QDataStream>
+#include <QMap>
+#include <QPair>
+#include <QVector>
+
+#include <algorithm>
 
 using namespace Marble;
 
+// "MDCI", followed by the version of the index format
+static const quint32 indexMagic = 0x4d444349;
+static const quint32 indexVersion = 1;
+
+static const int shardCount = 256;
+
 static QString indexFileName( const QString &cacheDirectory )
 {
     return cacheDirectory + "/cache_index.idx";
 }
 
+// The subdirectory of an entry. This is a FNV-1a hash of the key rather than
+// qHash(), whose values may change between Qt versions.
+static int keyToShard( const QString &key )
+{
+    quint32 hash = 2166136261u;
+    const QChar *const end = key.constData() + key.size();
+    for ( const QChar *c = key.constData(); c != end; ++c ) {
+        hash ^= c->unicode();
+        hash *= 16777619u;
+    }
+
+    return hash % shardCount;
+}
+
+static QString shardName( int shard )
+{
+    return QString( "%1" ).arg( shard, 2, 16, QChar( '0' ) );
+}
+
+static bool olderThan( const QPair<QDateTime, QString> &a, const QPair<QDateTime, QString> &b )
+{
+    return a.first < b.first;
+}
+
 DiscCache::DiscCache( const QString &cacheDirectory )
     : m_CacheDirectory( cacheDirectory ),
       m_CacheLimit( 300 * 1024 * 1024 ),
-      m_CurrentCacheSize( 0 )
+      m_CurrentCacheSize( 0 ),
+      m_Oldest( 0 ),
+      m_Newest( 0 ),
+      m_ExistingShards( shardCount, false )
 {
     Q_ASSERT( !m_CacheDirectory.isEmpty() && "Passed empty cache directory!" );
 
-    QFile file( indexFileName( m_CacheDirectory ) );
-
-    if ( file.exists() ) {
-        if ( file.open( QIODevice::ReadOnly ) ) {
-            QDataStream s( &file );
-            s.setVersion( 8 );
-
-            s >> m_CacheLimit;
-            s >> m_CurrentCacheSize;
-            s >> m_Entries;
-
-        } else {
-            qWarning( "Unable to open cache directory %s", qPrintable( m_CacheDirectory ) );
-        }
-    }
+    readIndex();
 }
 
 DiscCache::~DiscCache()
 {
-    QFile file( indexFileName( m_CacheDirectory ) );
-
-    if ( file.open( QIODevice::WriteOnly ) ) {
-        QDataStream s( &file );
-        s.setVersion( 8 );
+    writeIndex();
 
-        s << m_CacheLimit;
-        s << m_CurrentCacheSize;
-        s << m_Entries;
-    }
-
-    file.close();
+    qDeleteAll( m_Entries );
 }
 
 quint64 DiscCache::cacheLimit() const
@@ -72,20 +90,24 @@ quint64 DiscCache::cacheLimit() const
 
 void DiscCache::clear()
 {
-    QDirIterator it( m_CacheDirectory );
+    const QString indexFile = QFileInfo( indexFileName( m_CacheDirectory ) ).absoluteFilePath();
+    QDirIterator it( m_CacheDirectory, QDir::Files, QDirIterator::Subdirectories );
 
     // Remove all files from cache directory
     while ( it.hasNext() ) {
         it.next();
 
-        if ( it.fileName() == indexFileName( m_CacheDirectory ) ) // skip index file
+        if ( it.fileInfo().absoluteFilePath() == indexFile ) // skip index file
             continue;
 
-        QFile::remove( it.fileName() );
+        QFile::remove( it.filePath() );
     }
 
     // Delete entries
+    qDeleteAll( m_Entries );
     m_Entries.clear();
+    m_Oldest = 0;
+    m_Newest = 0;
 
     // Reset current cache size
     m_CurrentCacheSize = 0;
@@ -98,16 +120,19 @@ bool DiscCache::exists( const QString &key ) const
 
 bool DiscCache::find( const QString &key, QByteArray &data )
 {
+    Entry *const entry = m_Entries.value( key, 0 );
+
     // Return error if we don't know this key
-    if ( !m_Entries.contains( key ) )
+    if ( !entry )
         return false;
 
-    // If we can open the file, load all data and update access timestamp
+    // If we can open the file, load all data and mark the entry as recently used
     QFile file( keyToFileName( key ) );
     if ( file.open( QIODevice::ReadOnly ) ) {
         data = file.readAll();
 
-        m_Entries[ key ].first = QDateTime::currentDateTime();
+        unlink( entry );
+        link( entry );
         return true;
     }
 
@@ -116,23 +141,26 @@ bool DiscCache::find( const QString &key, QByteArray &data )
 
 bool DiscCache::insert( const QString &key, const QByteArray &data )
 {
+    const int shard = keyToShard( key );
+    if ( !m_ExistingShards.testBit( shard ) ) {
+        QDir( m_CacheDirectory ).mkpath( shardName( shard ) );
+        m_ExistingShards.setBit( shard );
+    }
+
     // If we can't open/create a file for this entry signal an error
     QFile file( keyToFileName( key ) );
     if ( !file.open( QIODevice::WriteOnly ) )
         return false;
 
-    // If we overwrite an existing entry, subtract the size first
-    if ( m_Entries.contains( key ) )
-        m_CurrentCacheSize -= m_Entries.value( key ).second;
+    // If we overwrite an existing entry, remove it first
+    if ( Entry *const entry = m_Entries.value( key, 0 ) )
+        removeEntry( entry );
 
     // Store the data on disc
     file.write( data );
 
-    // Create/Overwrite with a new entry
-    m_Entries.insert( key, QPair<QDateTime, quint64>(QDateTime::currentDateTime(), data.length()) );
-
-    // Add the size of the new entry
-    m_CurrentCacheSize += data.length();
+    // Create a new entry, this adds its size to the current cache size
+    addEntry( key, data.length() );
 
     cleanup();
 
@@ -141,8 +169,10 @@ bool DiscCache::insert( const QString &key, const QByteArray &data )
 
 void DiscCache::remove( const QString &key )
 {
+    Entry *const entry = m_Entries.value( key, 0 );
+
     // Do nothing if we don't know the key
-    if ( !m_Entries.contains( key ) )
+    if ( !entry )
         return;
 
     // If we can't remove the file we don't remove
@@ -150,11 +180,7 @@ void DiscCache::remove( const QString &key )
     if ( !QFile::remove( keyToFileName( key ) ) )
         return;
 
-    // Subtract from current size
-    m_CurrentCacheSize -= m_Entries.value( key ).second;
-
-    // Finally remove entry
-    m_Entries.remove( key );
+    removeEntry( entry );
 }
 
 void DiscCache::setCacheLimit( quint64 n )
@@ -169,32 +195,186 @@ QString DiscCache::keyToFileName( const QString &key ) const
     QString fileName( key );
     fileName.replace( '/', '_' );
 
-    return m_CacheDirectory + '/' + fileName;
+    return m_CacheDirectory + '/' + shardName( keyToShard( key ) ) + '/' + fileName;
 }
 
 void DiscCache::cleanup()
 {
-    // Calculate 5% of our current cache limit
-    quint64 fivePercent = quint64( m_CacheLimit * 0.05 );
+    if ( m_CurrentCacheSize <= m_CacheLimit )
+        return;
+
+    // Evict the least recently used entries until 5% of the cache limit are free
+    const quint64 fivePercent = quint64( m_CacheLimit * 0.05 );
+
+    while ( m_Oldest && m_CurrentCacheSize > ( m_CacheLimit - fivePercent ) ) {
+        Entry *const entry = m_Oldest;
+        const QString fileName = keyToFileName( entry->key );
+
+        // Stop if a file can't be removed, rather than trying again and again.
+        // Entries whose files are gone already are dropped though.
+        if ( !QFile::remove( fileName ) && QFile::exists( fileName ) )
+            break;
+
+        removeEntry( entry );
+    }
+}
+
+void DiscCache::readIndex()
+{
+    QFile file( indexFileName( m_CacheDirectory ) );
+
+    if ( !file.exists() )
+        return;
+
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        qWarning( "Unable to open cache directory %s", qPrintable( m_CacheDirectory ) );
+        return;
+    }
+
+    QDataStream s( &file );
+    s.setVersion( 8 );
+
+    quint32 magic;
+    quint32 version;
+    s >> magic >> version;
+
+    if ( magic != indexMagic ) {
+        file.seek( 0 );
+        readLegacyIndex( s );
+        return;
+    }
+
+    if ( version != indexVersion ) {
+        qWarning( "Unknown cache index version %u in %s", version, qPrintable( m_CacheDirectory ) );
+        return;
+    }
+
+    quint64 cacheLimit;
+    quint32 count;
+    s >> cacheLimit >> count;
+    m_CacheLimit = cacheLimit;
+
+    // The entries are stored from the least to the most recently used one
+    for ( quint32 i = 0; i < count && s.status() == QDataStream::Ok; ++i ) {
+        QString key;
+        quint64 size;
+        s >> key >> size;
+
+        if ( s.status() == QDataStream::Ok && !m_Entries.contains( key ) )
+            addEntry( key, size );
+    }
+
+    for ( int shard = 0; shard < shardCount; ++shard ) {
+        m_ExistingShards.setBit( shard, QDir( m_CacheDirectory + '/' + shardName( shard ) ).exists() );
+    }
+}
+
+void DiscCache::readLegacyIndex( QDataStream &s )
+{
+    // Older versions stored the access time of each entry in a map and all
+    // files in the cache directory itself. Move them to their subdirectories.
+    QMap<QString, QPair<QDateTime, quint64> > legacyEntries;
+    quint64 currentCacheSize;
+
+    s >> m_CacheLimit;
+    s >> currentCacheSize;
+    s >> legacyEntries;
+
+    QVector<QPair<QDateTime, QString> > keys;
+    keys.reserve( legacyEntries.size() );
+    QMap<QString, QPair<QDateTime, quint64> >::const_iterator it = legacyEntries.constBegin();
+    for ( ; it != legacyEntries.constEnd(); ++it ) {
+        keys.append( qMakePair( it.value().first, it.key() ) );
+    }
+    std::sort( keys.begin(), keys.end(), olderThan );
 
-    while ( m_CurrentCacheSize > (m_CacheLimit - fivePercent) ) {
-        QDateTime oldestDate( QDateTime::currentDateTime() );
-        QString oldestKey;
+    QDir cacheDirectory( m_CacheDirectory );
+    for ( int shard = 0; shard < shardCount; ++shard ) {
+        cacheDirectory.mkpath( shardName( shard ) );
+    }
+    m_ExistingShards.fill( true );
 
-        QMapIterator<QString, QPair<QDateTime, quint64> > it( m_Entries );
-        while ( it.hasNext() ) {
-            it.next();
+    for ( int i = 0; i < keys.size(); ++i ) {
+        const QString &key = keys.at( i ).second;
+        QString legacyFileName( key );
+        legacyFileName.replace( '/', '_' );
 
-            if ( it.value().first < oldestDate ) {
-                oldestDate = it.value().first;
-                oldestKey = it.key();
-            }
+        if ( QFile::rename( m_CacheDirectory + '/' + legacyFileName, keyToFileName( key ) ) ) {
+            addEntry( key, legacyEntries.value( key ).second );
         }
+    }
+}
+
+void DiscCache::writeIndex() const
+{
+    QFile file( indexFileName( m_CacheDirectory ) );
+
+    if ( file.open( QIODevice::WriteOnly ) ) {
+        QDataStream s( &file );
+        s.setVersion( 8 );
 
-        if ( !oldestKey.isEmpty() ) {
-            // We found the oldest key, so using remove() to
-            // remove it from cache
-            remove( oldestKey );
+        s << indexMagic << indexVersion;
+        s << m_CacheLimit;
+        s << quint32( m_Entries.size() );
+
+        for ( const Entry *entry = m_Oldest; entry; entry = entry->next ) {
+            s << entry->key << entry->size;
         }
     }
+
+    file.close();
+}
+
+DiscCache::Entry *DiscCache::addEntry( const QString &key, quint64 size )
+{
+    Q_ASSERT( !m_Entries.contains( key ) );
+
+    Entry *const entry = new Entry;
+    entry->key = key;
+    entry->size = size;
+    link( entry );
+
+    m_Entries.insert( key, entry );
+    m_CurrentCacheSize += size;
+
+    return entry;
+}
+
+void DiscCache::removeEntry( Entry *entry )
+{
+    m_CurrentCacheSize -= entry->size;
+    m_Entries.remove( entry->key );
+    unlink( entry );
+
+    delete entry;
+}
+
+void DiscCache::link( Entry *entry )
+{
+    // Append as the most recently used entry
+    entry->previous = m_Newest;
+    entry->next = 0;
+
+    if ( m_Newest )
+        m_Newest->next = entry;
+    else
+        m_Oldest = entry;
+
+    m_Newest = entry;
+}
+
+void DiscCache::unlink( Entry *entry )
+{
+    if ( entry->previous )
+        entry->previous->next = entry->next;
+    else
+        m_Oldest = entry->next;
+
+    if ( entry->next )
+        entry->next->previous = entry->previous;
+    else
+        m_Newest = entry->previous;
+
+    entry->previous = 0;
+    entry->next = 0;
 }
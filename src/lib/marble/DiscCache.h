@@ -11,16 +11,25 @@
 #ifndef MARBLE_DISCCACHE_H
 #define MARBLE_DISCCACHE_H
 
-#include <QDateTime>
-#include <QMap>
-#include <QPair>
+#include <QBitArray>
+#include <QHash>
 #include <QString>
 
 class QByteArray;
+class QDataStream;
 
 namespace Marble
 {
 
+/**
+ * A size limited cache of files, identified by keys.
+ *
+ * The entries are kept in least recently used order, the least recently
+ * used ones are evicted in batches once the cache limit is exceeded. The
+ * files are spread over 256 subdirectories of the cache directory, the
+ * index of all entries is stored in a binary file when the cache is
+ * destroyed and read back on construction.
+ */
 class DiscCache
 {
     public:
@@ -36,15 +45,40 @@ class DiscCache
         void setCacheLimit( quint64 n );
 
     private:
+        Q_DISABLE_COPY( DiscCache )
+
+        struct Entry
+        {
+            QString key;
+            quint64 size;
+            // neighbours in least recently used order
+            Entry *previous;
+            Entry *next;
+        };
+
         QString keyToFileName( const QString& ) const;
         void cleanup();
 
+        void readIndex();
+        void readLegacyIndex( QDataStream &stream );
+        void writeIndex() const;
+
+        Entry *addEntry( const QString &key, quint64 size );
+        void removeEntry( Entry *entry );
+        void link( Entry *entry );
+        void unlink( Entry *entry );
+
         QString m_CacheDirectory;
         quint64 m_CacheLimit;
         quint64 m_CurrentCacheSize;
 
-        typedef QPair<QDateTime, quint64> Entry;
-        QMap<QString, Entry> m_Entries;
+        QHash<QString, Entry*> m_Entries;
+        // least and most recently used entry
+        Entry *m_Oldest;
+        Entry *m_Newest;
+
+        // subdirectories known to exist
+        QBitArray m_ExistingShards;
 };
 
 }
@@ -15,21 +15,30 @@
 
 #include "DownloadQueueSet.h"
 
+#include <algorithm>
+
 #include "MarbleDebug.h"
+#include "MarbleMath.h"
 
 #include "HttpJob.h"
 
 namespace Marble
 {
 
+// Maximum number of queued browse jobs that are held back because they are
+// not needed for the current viewport
+static const int maximumHeldBackJobs = 1000;
+
 DownloadQueueSet::DownloadQueueSet( QObject * const parent )
-    : QObject( parent )
+    : QObject( parent ),
+      m_suspended( false )
 {
 }
 
 DownloadQueueSet::DownloadQueueSet( DownloadPolicy const & policy, QObject * const parent )
     : QObject( parent ),
-      m_downloadPolicy( policy )
+      m_downloadPolicy( policy ),
+      m_suspended( false )
 {
 }
 
@@ -78,13 +87,14 @@ void DownloadQueueSet::addJob( HttpJob * const job )
     m_jobs.push( job );
     mDebug() << "addJob: new job queue size:" << m_jobs.count();
     emit jobAdded();
-    emit progressChanged( m_activeJobs.size(), m_jobs.count() );
+    emit progressChanged( m_activeJobs.size(), m_jobs.urgentCount() );
     activateJobs();
 }
 
 void DownloadQueueSet::activateJobs()
 {
-    while ( !m_jobs.isEmpty()
+    while ( !m_suspended
+            && m_jobs.hasUrgentJob()
             && m_activeJobs.count() < m_downloadPolicy.maximumConnections() )
     {
         HttpJob * const job = m_jobs.pop();
@@ -119,7 +129,51 @@ void DownloadQueueSet::purgeJobs()
         deactivateJob( m_activeJobs.first() );
     }
 
-    emit progressChanged( m_activeJobs.size(), m_jobs.count() );
+    emit progressChanged( m_activeJobs.size(), m_jobs.urgentCount() );
+}
+
+void DownloadQueueSet::setViewport( const GeoDataLatLonBox &latLonBox, int tileZoomLevel )
+{
+    const int urgentCount = m_jobs.urgentCount();
+    const int heldBackCount = m_jobs.setViewport( latLonBox, tileZoomLevel );
+
+    // Jobs that are held back are not waited for anymore, so they leave the
+    // progress like finished ones. If they become urgent again they are
+    // counted as queued again.
+    for ( int i = 0; i < heldBackCount; ++i ) {
+        emit jobRemoved();
+    }
+
+    // Jobs beyond the limit are dropped. The tile cache keeps the placeholder
+    // of their tiles, so the initiator is told to request them again.
+    const QList<HttpJob*> staleJobs = m_jobs.takeHeldBackJobs( maximumHeldBackJobs );
+    if ( !staleJobs.isEmpty() ) {
+        mDebug() << "Dropping" << staleJobs.size() << "jobs outside of the viewport";
+        foreach ( HttpJob *job, staleJobs ) {
+            emit jobDropped( job->initiatorId() );
+            job->deleteLater();
+        }
+    }
+
+    if ( m_jobs.urgentCount() != urgentCount ) {
+        emit progressChanged( m_activeJobs.size(), m_jobs.urgentCount() );
+    }
+
+    activateJobs();
+}
+
+void DownloadQueueSet::setSuspended( bool suspended )
+{
+    if ( m_suspended == suspended )
+        return;
+
+    m_suspended = suspended;
+    activateJobs();
+}
+
+bool DownloadQueueSet::isBusy() const
+{
+    return !m_activeJobs.isEmpty() || m_jobs.hasUrgentJob();
 }
 
 void DownloadQueueSet::finishJob( HttpJob * job, const QByteArray& data )
@@ -176,7 +230,7 @@ void DownloadQueueSet::retryOrBlacklistJob( HttpJob * job, const int errorCode )
 void DownloadQueueSet::activateJob( HttpJob * const job )
 {
     m_activeJobs.push_back( job );
-    emit progressChanged( m_activeJobs.size(), m_jobs.count() );
+    emit progressChanged( m_activeJobs.size(), m_jobs.urgentCount() );
 
     connect( job, SIGNAL(jobDone(HttpJob*,int)),
              SLOT(retryOrBlacklistJob(HttpJob*,int)));
@@ -203,7 +257,7 @@ void DownloadQueueSet::deactivateJob( HttpJob * const job )
     const bool removed = m_activeJobs.removeOne( job );
     Q_ASSERT( removed );
     Q_UNUSED( removed ); // for Q_ASSERT in release mode
-    emit progressChanged( m_activeJobs.size(), m_jobs.count() );
+    emit progressChanged( m_activeJobs.size(), m_jobs.urgentCount() );
 }
 
 bool DownloadQueueSet::jobIsActive( QString const & destinationFileName ) const
@@ -243,36 +297,161 @@ bool DownloadQueueSet::jobIsBlackListed( const QUrl& sourceUrl ) const
 }
 
 
-inline bool DownloadQueueSet::JobStack::contains( const QString& destinationFileName ) const
+DownloadQueueSet::JobQueue::JobQueue()
+    : m_viewportTileZoomLevel( -1 ),
+      m_heldBackCount( 0 ),
+      m_sequence( 0 )
+{
+}
+
+inline bool DownloadQueueSet::JobQueue::contains( const QString& destinationFileName ) const
 {
     return m_jobsContent.contains( destinationFileName );
 }
 
-inline int DownloadQueueSet::JobStack::count() const
+inline int DownloadQueueSet::JobQueue::count() const
 {
     return m_jobs.count();
 }
 
-inline bool DownloadQueueSet::JobStack::isEmpty() const
+inline int DownloadQueueSet::JobQueue::urgentCount() const
+{
+    return m_jobs.count() - m_heldBackCount;
+}
+
+inline bool DownloadQueueSet::JobQueue::isEmpty() const
 {
     return m_jobs.isEmpty();
 }
 
-inline HttpJob * DownloadQueueSet::JobStack::pop()
+inline bool DownloadQueueSet::JobQueue::hasUrgentJob() const
 {
-    HttpJob * const job = m_jobs.pop();
+    return !m_jobs.isEmpty() && !m_jobs.first().heldBack;
+}
+
+HttpJob * DownloadQueueSet::JobQueue::pop()
+{
+    std::pop_heap( m_jobs.begin(), m_jobs.end(), lessUrgent );
+    HttpJob * const job = m_jobs.last().job;
+    if ( m_jobs.last().heldBack ) {
+        --m_heldBackCount;
+    }
+    m_jobs.removeLast();
     bool const removed = m_jobsContent.remove( job->destinationFileName() );
     Q_UNUSED( removed ); // for Q_ASSERT in release mode
     Q_ASSERT( removed );
     return job;
 }
 
-inline void DownloadQueueSet::JobStack::push( HttpJob * const job )
+void DownloadQueueSet::JobQueue::push( HttpJob * const job )
 {
-    m_jobs.push( job );
+    Entry entry;
+    entry.job = job;
+    entry.sequence = m_sequence++;
+    updatePriority( entry );
+    if ( entry.heldBack ) {
+        ++m_heldBackCount;
+    }
+
+    m_jobs.append( entry );
+    std::push_heap( m_jobs.begin(), m_jobs.end(), lessUrgent );
     m_jobsContent.insert( job->destinationFileName() );
 }
 
+int DownloadQueueSet::JobQueue::setViewport( const GeoDataLatLonBox &latLonBox, int tileZoomLevel )
+{
+    m_viewportLatLonBox = latLonBox;
+    m_viewportTileZoomLevel = tileZoomLevel;
+
+    int newlyHeldBack = 0;
+    m_heldBackCount = 0;
+    QVector<Entry>::iterator it = m_jobs.begin();
+    QVector<Entry>::iterator const end = m_jobs.end();
+    for (; it != end; ++it ) {
+        const bool wasHeldBack = it->heldBack;
+        updatePriority( *it );
+        if ( it->heldBack ) {
+            ++m_heldBackCount;
+            if ( !wasHeldBack ) {
+                ++newlyHeldBack;
+            }
+        }
+    }
+    std::make_heap( m_jobs.begin(), m_jobs.end(), lessUrgent );
+
+    return newlyHeldBack;
+}
+
+QList<HttpJob*> DownloadQueueSet::JobQueue::takeHeldBackJobs( int count )
+{
+    QVector<Entry> heldBack;
+    QVector<Entry> remaining;
+    QVector<Entry>::const_iterator it = m_jobs.constBegin();
+    QVector<Entry>::const_iterator const end = m_jobs.constEnd();
+    for (; it != end; ++it ) {
+        if ( it->heldBack ) {
+            heldBack.append( *it );
+        }
+        else {
+            remaining.append( *it );
+        }
+    }
+
+    QList<HttpJob*> result;
+    if ( heldBack.size() <= count ) {
+        return result;
+    }
+
+    // keep the most urgent ones
+    std::sort( heldBack.begin(), heldBack.end(), lessUrgent );
+    for ( int i = 0; i < heldBack.size() - count; ++i ) {
+        HttpJob * const job = heldBack.at( i ).job;
+        m_jobsContent.remove( job->destinationFileName() );
+        result.append( job );
+    }
+    for ( int i = heldBack.size() - count; i < heldBack.size(); ++i ) {
+        remaining.append( heldBack.at( i ) );
+    }
+
+    m_jobs = remaining;
+    m_heldBackCount = count;
+    std::make_heap( m_jobs.begin(), m_jobs.end(), lessUrgent );
+
+    return result;
+}
+
+bool DownloadQueueSet::JobQueue::lessUrgent( const Entry &a, const Entry &b )
+{
+    if ( a.heldBack != b.heldBack )
+        return a.heldBack;
+    if ( a.levelDifference != b.levelDifference )
+        return a.levelDifference > b.levelDifference;
+    if ( a.distance != b.distance )
+        return a.distance > b.distance;
+    return a.sequence < b.sequence;
+}
+
+void DownloadQueueSet::JobQueue::updatePriority( Entry &entry ) const
+{
+    entry.heldBack = false;
+    entry.levelDifference = 0;
+    entry.distance = 0.0;
+
+    const int tileZoomLevel = entry.job->tileZoomLevel();
+    if ( tileZoomLevel < 0 || m_viewportTileZoomLevel < 0 ) {
+        return;
+    }
+
+    const GeoDataLatLonBox tileLatLonBox = entry.job->tileLatLonBox();
+    entry.levelDifference = qAbs( tileZoomLevel - m_viewportTileZoomLevel );
+    entry.distance = distanceSphere( tileLatLonBox.center(), m_viewportLatLonBox.center() );
+
+    // Tiles that are too detailed or out of sight are only needed again
+    // if the viewport returns to them, bulk downloads are never held back.
+    entry.heldBack = entry.job->downloadUsage() == DownloadBrowse
+                     && ( tileZoomLevel > m_viewportTileZoomLevel
+                          || !m_viewportLatLonBox.intersects( tileLatLonBox ) );
+}
 
 }
 
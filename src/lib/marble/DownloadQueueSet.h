@@ -20,10 +20,11 @@
 #include <QQueue>
 #include <QObject>
 #include <QSet>
-#include <QStack>
 #include <QUrl>
+#include <QVector>
 
 #include "DownloadPolicy.h"
+#include "GeoDataLatLonBox.h"
 
 namespace Marble
 {
@@ -89,6 +90,26 @@ class DownloadQueueSet: public QObject
     void retryJobs();
     void purgeJobs();
 
+    /**
+     * Prioritizes the waiting tile jobs by their distance to @p latLonBox and
+     * by how much their zoom level differs from @p tileZoomLevel. Browse jobs
+     * for tiles outside of @p latLonBox or above @p tileZoomLevel are held
+     * back until the viewport returns to them. Held back jobs do not count
+     * as queued in progressChanged().
+     */
+    void setViewport( const GeoDataLatLonBox &latLonBox, int tileZoomLevel );
+
+    /**
+     * While suspended, no further jobs are activated.
+     */
+    void setSuspended( bool suspended );
+
+    /**
+     * Returns true if jobs are being downloaded or waiting to be downloaded
+     * for the current viewport.
+     */
+    bool isBusy() const;
+
  Q_SIGNALS:
     void jobAdded();
     void jobRemoved();
@@ -99,6 +120,12 @@ class DownloadQueueSet: public QObject
                         const QString& id, DownloadUsage );
     void progressChanged( int active, int queued );
 
+    /**
+     * A held back job was removed from the queue without being downloaded.
+     * The initiator needs to request the file again when it is needed.
+     */
+    void jobDropped( const QString& id );
+
  private Q_SLOTS:
     void finishJob( HttpJob * job, const QByteArray& data );
     void redirectJob( HttpJob * job, const QUrl& newSourceUrl );
@@ -115,21 +142,48 @@ class DownloadQueueSet: public QObject
     DownloadPolicy m_downloadPolicy;
 
     /** This is the first stage a job enters, from this queue it will get
-     *  into the activatedJobs container.
+     *  into the activatedJobs container. The queue is a heap that yields the
+     *  most urgent job first, see setViewport(). Among jobs of the same
+     *  priority the most recently added one comes first.
      */
-    class JobStack
+    class JobQueue
     {
     public:
+        JobQueue();
         bool contains( const QString& destinationFileName ) const;
         int count() const;
+        /// Returns the number of jobs which are not held back.
+        int urgentCount() const;
         bool isEmpty() const;
+        /// Returns true if the most urgent job is not held back.
+        bool hasUrgentJob() const;
         HttpJob * pop();
         void push( HttpJob * const );
+        /// Returns the number of jobs which are held back and were not before.
+        int setViewport( const GeoDataLatLonBox &latLonBox, int tileZoomLevel );
+        /// Removes the least urgent jobs that are held back, leaving @p count of them.
+        QList<HttpJob*> takeHeldBackJobs( int count );
     private:
-        QStack<HttpJob*> m_jobs;
+        struct Entry
+        {
+            HttpJob *job;
+            quint64 sequence;
+            bool heldBack;
+            int levelDifference;
+            qreal distance;
+        };
+        static bool lessUrgent( const Entry &a, const Entry &b );
+        void updatePriority( Entry &entry ) const;
+
+        QVector<Entry> m_jobs;
         QSet<QString> m_jobsContent;
+        GeoDataLatLonBox m_viewportLatLonBox;
+        int m_viewportTileZoomLevel;
+        int m_heldBackCount;
+        quint64 m_sequence;
     };
-    JobStack m_jobs;
+    JobQueue m_jobs;
+    bool m_suspended;
 
     /// Contains the jobs which are currently being downloaded.
     QList<HttpJob*> m_activeJobs;
@@ -9,26 +9,129 @@
 //
 
 #include "ElevationModel.h"
+#include "GeoDataLineString.h"
 #include "GeoSceneHead.h"
 #include "GeoSceneLayer.h"
 #include "GeoSceneMap.h"
 #include "GeoSceneDocument.h"
 #include "GeoSceneTextureTileDataset.h"
 #include "HttpDownloadManager.h"
+#include "JobGroup.h"
+#include "MarbleGlobal.h"
 #include "Tile.h"
 #include "TileLoader.h"
 #include "TileLoaderHelper.h"
 #include "MarbleDebug.h"
+#include "MarbleMath.h"
 #include "MapThemeManager.h"
 #include "TileId.h"
 #include "PluginManager.h"
 
+#include <QHash>
 #include <QLabel>
+#include <QRunnable>
 #include <qmath.h>
 
+#include <algorithm>
+
 namespace Marble
 {
 
+// the maximum number of tiles whose samples are interpolated at once by heights()
+static const int maxTilesPerChunk = 8;
+
+/**
+ * A coordinate to be sampled by ElevationModel::heights(), in pixels of the
+ * whole elevation texture.
+ */
+struct HeightSample
+{
+    // the tile of the upper left pixel
+    int tile;
+    int x;
+    int y;
+    qreal fractionX;
+    qreal fractionY;
+    // of the coordinates passed to heights()
+    int index;
+};
+
+static bool isBefore( const HeightSample &a, const HeightSample &b )
+{
+    return a.tile < b.tile;
+}
+
+/**
+ * Returns @p image in a format whose scanlines can be read as 32 bit pixels.
+ */
+static QImage elevationImage( const QImage &image )
+{
+    if ( image.format() == QImage::Format_RGB32 || image.format() == QImage::Format_ARGB32 ) {
+        return image;
+    }
+
+    return image.convertToFormat( QImage::Format_ARGB32 );
+}
+
+/**
+ * Interpolates bilinearly between the four @p pixels around a coordinate,
+ * ordered upper left, upper right, lower left, lower right. Pixels without
+ * data are left out and their weight is distributed on the others.
+ */
+static qreal interpolatedHeight( const QRgb pixels[4], qreal fractionX, qreal fractionY )
+{
+    const qreal weights[4] = {
+        ( 1 - fractionX ) * ( 1 - fractionY ),
+        fractionX * ( 1 - fractionY ),
+        ( 1 - fractionX ) * fractionY,
+        fractionX * fractionY
+    };
+
+    qreal ret = 0;
+    bool hasHeight = false;
+    qreal noData = 0;
+
+    for ( int i = 0; i < 4; ++i ) {
+        unsigned int pixel = pixels[i] & 0xffff; // 16 valid bits
+        short int elevation = (short int) pixel; // and signed type, so just cast it
+        if ( pixel != invalidElevationData ) { //no data?
+            ret += ( qreal )elevation * weights[i];
+            hasHeight = true;
+        } else {
+            noData += weights[i];
+        }
+    }
+
+    if ( !hasHeight ) {
+        ret = invalidElevationData; //no data
+    } else {
+        if ( noData ) {
+            ret += ( ret / ( 1 - noData ) ) * noData;
+        }
+    }
+
+    return ret;
+}
+
+class TileDecodeJob : public QRunnable
+{
+public:
+    TileDecodeJob( const QString &fileName, QImage *image )
+        : m_fileName( fileName ),
+          m_image( image )
+    {
+    }
+
+    virtual void run()
+    {
+        *m_image = elevationImage( QImage( m_fileName ) );
+    }
+
+private:
+    const QString m_fileName;
+    QImage *const m_image;
+};
+
 class ElevationModelPrivate
 {
 public:
@@ -66,10 +169,22 @@ public:
 
     void tileCompleted( const TileId & tileId, const QImage &image )
     {
-        m_cache.insert( tileId, new QImage( image ) );
+        m_cache.insert( tileId, new QImage( elevationImage( image ) ) );
         emit q->updateAvailable();
     }
 
+    /**
+     * Inserts the images of the tiles @p tiles, given as row * columns + column,
+     * into @p images. Tiles which are not in the cache are loaded
+     * concurrently if their files are up to date.
+     */
+    void loadTiles( const QVector<int> &tiles, int tileZoomLevel, int numTilesX, QHash<int, QImage> &images );
+
+    /**
+     * Sets @p result to the heights at the @p count @p coordinates.
+     */
+    void heights( const GeoDataCoordinates *coordinates, int count, qreal *result );
+
 public:
     ElevationModel *q;
 
@@ -79,6 +194,171 @@ public:
     GeoSceneDocument *m_srtmTheme;
 };
 
+void ElevationModelPrivate::loadTiles( const QVector<int> &tiles, int tileZoomLevel, int numTilesX, QHash<int, QImage> &images )
+{
+    QVector<TileId> pendingIds;
+    QVector<int> pendingTiles;
+
+    foreach ( int tile, tiles ) {
+        const TileId id( 0, tileZoomLevel, tile % numTilesX, tile / numTilesX );
+        const QImage *image = m_cache.object( id );
+        if ( image ) {
+            images.insert( tile, *image );
+        }
+        else if ( TileLoader::tileStatus( m_textureLayer, id ) == TileLoader::Available ) {
+            pendingIds << id;
+            pendingTiles << tile;
+        }
+        else {
+            // Missing and expired tiles need to be downloaded, which has to
+            // happen on this thread
+            const QImage loaded = elevationImage( m_tileLoader.loadTileImage( m_textureLayer, id, DownloadBrowse ) );
+            m_cache.insert( id, new QImage( loaded ) );
+            images.insert( tile, loaded );
+        }
+    }
+
+    QVector<QImage> decoded( pendingIds.size() );
+    if ( pendingIds.size() == 1 ) {
+        TileDecodeJob( TileLoader::tileFileName( m_textureLayer, pendingIds.first() ), &decoded[0] ).run();
+    }
+    else if ( pendingIds.size() > 1 ) {
+        JobGroup jobs( MarbleGlobal::getInstance()->threadPool() );
+        for ( int i = 0; i < pendingIds.size(); ++i ) {
+            jobs.start( new TileDecodeJob( TileLoader::tileFileName( m_textureLayer, pendingIds.at( i ) ), &decoded[i] ) );
+        }
+        jobs.waitForDone();
+    }
+
+    for ( int i = 0; i < pendingIds.size(); ++i ) {
+        QImage image = decoded.at( i );
+        if ( image.isNull() ) {
+            image = elevationImage( m_tileLoader.loadTileImage( m_textureLayer, pendingIds.at( i ), DownloadBrowse ) );
+        }
+        m_cache.insert( pendingIds.at( i ), new QImage( image ) );
+        images.insert( pendingTiles.at( i ), image );
+    }
+}
+
+void ElevationModelPrivate::heights( const GeoDataCoordinates *coordinates, int count, qreal *result )
+{
+    if ( !m_textureLayer ) {
+        for ( int i = 0; i < count; ++i ) {
+            result[i] = invalidElevationData;
+        }
+        return;
+    }
+
+    const int tileZoomLevel = TileLoader::maximumTileLevel( *m_textureLayer );
+    Q_ASSERT( tileZoomLevel == 9 );
+
+    const int width = m_textureLayer->tileSize().width();
+    const int height = m_textureLayer->tileSize().height();
+
+    const int numTilesX = TileLoaderHelper::levelToColumn( m_textureLayer->levelZeroColumns(), tileZoomLevel );
+    const int numTilesY = TileLoaderHelper::levelToRow( m_textureLayer->levelZeroRows(), tileZoomLevel );
+    Q_ASSERT( numTilesX > 0 );
+    Q_ASSERT( numTilesY > 0 );
+
+    const int textureWidth = numTilesX * width;
+    const int textureHeight = numTilesY * height;
+
+    QVector<HeightSample> samples( count );
+    for ( int i = 0; i < count; ++i ) {
+        // same as in ElevationModel::height()
+        qreal textureX = 180 + coordinates[i].longitude( GeoDataCoordinates::Degree );
+        textureX *= numTilesX * width / 360;
+
+        qreal textureY = 90 - coordinates[i].latitude( GeoDataCoordinates::Degree );
+        textureY *= numTilesY * height / 180;
+
+        HeightSample &sample = samples[i];
+        sample.x = static_cast<int>( textureX );
+        sample.y = static_cast<int>( textureY );
+        sample.fractionX = textureX - sample.x;
+        sample.fractionY = textureY - sample.y;
+        sample.tile = ( ( sample.y % textureHeight ) / height ) * numTilesX + ( sample.x % textureWidth ) / width;
+        sample.index = i;
+    }
+
+    std::sort( samples.begin(), samples.end(), isBefore );
+
+    QVector<int> tiles;
+    QHash<int, QImage> images;
+    int begin = 0;
+    while ( begin < samples.size() ) {
+        // Take the samples of the next few tiles, along with the tiles
+        // of the pixels right and below of samples at the tile borders
+        tiles.resize( 0 );
+        int end = begin;
+        int tileCount = 0;
+        for ( ; end < samples.size(); ++end ) {
+            const HeightSample &sample = samples.at( end );
+            if ( end == begin || sample.tile != samples.at( end - 1 ).tile ) {
+                if ( tileCount == maxTilesPerChunk ) {
+                    break;
+                }
+                ++tileCount;
+                tiles << sample.tile;
+            }
+
+            if ( sample.x % width == width - 1 || sample.y % height == height - 1 ) {
+                for ( int i = 1; i < 4; ++i ) {
+                    const int x = sample.x + ( i % 2 );
+                    const int y = sample.y + ( i / 2 );
+                    tiles << ( ( y % textureHeight ) / height ) * numTilesX + ( x % textureWidth ) / width;
+                }
+            }
+        }
+
+        std::sort( tiles.begin(), tiles.end() );
+        tiles.erase( std::unique( tiles.begin(), tiles.end() ), tiles.end() );
+
+        images.clear();
+        loadTiles( tiles, tileZoomLevel, numTilesX, images );
+
+        const uchar *bits = 0;
+        int bytesPerLine = 0;
+        for ( int s = begin; s < end; ++s ) {
+            const HeightSample &sample = samples.at( s );
+            if ( s == begin || sample.tile != samples.at( s - 1 ).tile ) {
+                const QImage &image = images[sample.tile];
+                Q_ASSERT( !image.isNull() );
+                Q_ASSERT( width == image.width() );
+                Q_ASSERT( height == image.height() );
+                bits = image.constBits();
+                bytesPerLine = image.bytesPerLine();
+            }
+
+            const int x = sample.x % width;
+            const int y = sample.y % height;
+
+            QRgb pixels[4];
+            if ( x + 1 < width && y + 1 < height ) {
+                const QRgb *const upper = reinterpret_cast<const QRgb *>( bits + y * bytesPerLine ) + x;
+                const QRgb *const lower = reinterpret_cast<const QRgb *>( bits + ( y + 1 ) * bytesPerLine ) + x;
+                pixels[0] = upper[0];
+                pixels[1] = upper[1];
+                pixels[2] = lower[0];
+                pixels[3] = lower[1];
+            }
+            else {
+                for ( int i = 0; i < 4; ++i ) {
+                    const int pixelX = sample.x + ( i % 2 );
+                    const int pixelY = sample.y + ( i / 2 );
+                    const int tile = ( ( pixelY % textureHeight ) / height ) * numTilesX + ( pixelX % textureWidth ) / width;
+                    const QImage &image = images[tile];
+                    pixels[i] = reinterpret_cast<const QRgb *>( image.constScanLine( pixelY % height ) )[pixelX % width];
+                }
+            }
+
+            result[sample.index] = interpolatedHeight( pixels, sample.fractionX, sample.fractionY );
+        }
+
+        begin = end;
+    }
+}
+
 ElevationModel::ElevationModel( HttpDownloadManager *downloadManager, PluginManager* pluginManager, QObject *parent ) :
     QObject( parent ),
     d( new ElevationModelPrivate( this, downloadManager, pluginManager ) )
@@ -116,10 +396,7 @@ qreal ElevationModel::height( qreal lon, qreal lat ) const
     qreal textureY = 90 - lat;
     textureY *= numTilesY * height / 180;
 
-    qreal ret = 0;
-    bool hasHeight = false;
-    qreal noData = 0;
-
+    QRgb pixels[4];
     for ( int i = 0; i < 4; ++i ) {
         const int x = static_cast<int>( textureX + ( i % 2 ) );
         const int y = static_cast<int>( textureY + ( i / 2 ) );
@@ -132,7 +409,7 @@ qreal ElevationModel::height( qreal lon, qreal lat ) const
 
         const QImage *image = d->m_cache[id];
         if ( image == 0 ) {
-            image = new QImage( d->m_tileLoader.loadTileImage( d->m_textureLayer, id, DownloadBrowse ) );
+            image = new QImage( elevationImage( d->m_tileLoader.loadTileImage( d->m_textureLayer, id, DownloadBrowse ) ) );
             d->m_cache.insert( id, image );
         }
         Q_ASSERT( image );
@@ -140,37 +417,29 @@ qreal ElevationModel::height( qreal lon, qreal lat ) const
         Q_ASSERT( width == image->width() );
         Q_ASSERT( height == image->height() );
 
-        const qreal dx = ( textureX > ( qreal )x ) ? textureX - ( qreal )x : ( qreal )x - textureX;
-        const qreal dy = ( textureY > ( qreal )y ) ? textureY - ( qreal )y : ( qreal )y - textureY;
-
-        Q_ASSERT( 0 <= dx && dx <= 1 );
-        Q_ASSERT( 0 <= dy && dy <= 1 );
-        unsigned int pixel = image->pixel( x % width, y % height ) & 0xffff; // 16 valid bits
-        short int elevation = (short int) pixel; // and signed type, so just cast it
-        //mDebug() << "(1-dx)" << (1-dx) << "(1-dy)" << (1-dy);
-        if ( pixel != invalidElevationData ) { //no data?
-            //mDebug() << "got at x" << x % width << "y" << y % height << "a height of" << pixel << "** RGB" << qRed(pixel) << qGreen(pixel) << qBlue(pixel);
-            ret += ( qreal )elevation * ( 1 - dx ) * ( 1 - dy );
-            hasHeight = true;
-        } else {
-            //mDebug() << "no data at" <<  x % width << "y" << y % height;
-            noData += ( 1 - dx ) * ( 1 - dy );
-        }
+        pixels[i] = image->pixel( x % width, y % height );
     }
 
-    if ( !hasHeight ) {
-        ret = invalidElevationData; //no data
-    } else {
-        if ( noData ) {
-            //mDebug() << "NO DATA" << noData;
-            ret += ( ret / ( 1 - noData ) ) * noData;
-        }
-    }
+    const qreal ret = interpolatedHeight( pixels, textureX - static_cast<int>( textureX ), textureY - static_cast<int>( textureY ) );
 
     //mDebug() << ">>>" << lat << lon << "returning an elevation of" << ret;
     return ret;
 }
 
+QVector<qreal> ElevationModel::heights( const QVector<GeoDataCoordinates> &coordinates ) const
+{
+    QVector<qreal> result( coordinates.size() );
+    d->heights( coordinates.constData(), coordinates.size(), result.data() );
+    return result;
+}
+
+QVector<qreal> ElevationModel::heights( const GeoDataLineString &lineString ) const
+{
+    QVector<qreal> result( lineString.size() );
+    d->heights( lineString.constBegin(), lineString.size(), result.data() );
+    return result;
+}
+
 QList<GeoDataCoordinates> ElevationModel::heightProfile( qreal fromLon, qreal fromLat, qreal toLon, qreal toLat ) const
 {
     if ( !d->m_textureLayer ) {
@@ -192,13 +461,10 @@ QList<GeoDataCoordinates> ElevationModel::heightProfile( qreal fromLon, qreal fr
     //mDebug() << "fromLon" << fromLon << "fromLat" << fromLat;
     //mDebug() << "diff lon" << ( fromLon - toLon ) << "diff lat" << ( fromLat - toLat );
     //mDebug() << "dirLon" << QString::number(dirLon) << "dirLat" << QString::number(dirLat) << "k" << k;
-    QList<GeoDataCoordinates> ret;
+    QVector<GeoDataCoordinates> samples;
     while ( lat*dirLat <= toLat*dirLat && lon*dirLon <= toLon * dirLon ) {
         //mDebug() << lat << lon;
-        qreal h = height( lon, lat );
-        if ( h < 32000 ) {
-            ret << GeoDataCoordinates( lon, lat, h, GeoDataCoordinates::Degree );
-        }
+        samples << GeoDataCoordinates( lon, lat, 0, GeoDataCoordinates::Degree );
         if ( k < 0.5 ) {
             //mDebug() << "lon(x) += distPerPixel";
             lat += distPerPixel * k * dirLat;
@@ -209,10 +475,58 @@ QList<GeoDataCoordinates> ElevationModel::heightProfile( qreal fromLon, qreal fr
             lon += distPerPixel / k * dirLon;
         }
     }
+
+    const QVector<qreal> sampleHeights = heights( samples );
+    QList<GeoDataCoordinates> ret;
+    for ( int i = 0; i < samples.size(); ++i ) {
+        if ( sampleHeights.at( i ) < 32000 ) {
+            GeoDataCoordinates coordinates = samples.at( i );
+            coordinates.setAltitude( sampleHeights.at( i ) );
+            ret << coordinates;
+        }
+    }
     //mDebug() << ret;
     return ret;
 }
 
+QList<GeoDataCoordinates> ElevationModel::heightProfile( const GeoDataLineString &path ) const
+{
+    if ( !d->m_textureLayer || path.isEmpty() ) {
+        return QList<GeoDataCoordinates>();
+    }
+
+    const int tileZoomLevel = TileLoader::maximumTileLevel( *( d->m_textureLayer ) );
+    const int width = d->m_textureLayer->tileSize().width();
+    const int numTilesX = TileLoaderHelper::levelToColumn( d->m_textureLayer->levelZeroColumns(), tileZoomLevel );
+
+    // in radians
+    const qreal distPerPixel = 2 * M_PI / ( width * numTilesX );
+
+    QVector<GeoDataCoordinates> samples;
+    GeoDataLineString::ConstIterator it = path.constBegin();
+    for ( GeoDataLineString::ConstIterator previous = it++; it != path.constEnd(); previous = it++ ) {
+        const qreal distance = distanceSphere( *previous, *it );
+        const int steps = qCeil( distance / distPerPixel );
+        samples << *previous;
+        for ( int i = 1; i < steps; ++i ) {
+            samples << previous->interpolate( *it, qreal( i ) / steps );
+        }
+    }
+    samples << path.last();
+
+    const QVector<qreal> sampleHeights = heights( samples );
+    QList<GeoDataCoordinates> ret;
+    for ( int i = 0; i < samples.size(); ++i ) {
+        if ( sampleHeights.at( i ) < 32000 ) {
+            GeoDataCoordinates coordinates = samples.at( i );
+            coordinates.setAltitude( sampleHeights.at( i ) );
+            ret << coordinates;
+        }
+    }
+
+    return ret;
+}
+
 }
 
 
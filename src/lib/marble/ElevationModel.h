@@ -18,6 +18,7 @@
 #include <QObject>
 #include <QCache>
 #include <QImage>
+#include <QVector>
 
 namespace Marble
 {
@@ -27,6 +28,7 @@ namespace {
 }
 
 class TileId;
+class GeoDataLineString;
 class ElevationModelPrivate;
 class HttpDownloadManager;
 class PluginManager;
@@ -41,6 +43,28 @@ public:
     qreal height( qreal lon, qreal lat ) const;
     QList<GeoDataCoordinates> heightProfile( qreal fromLon, qreal fromLat, qreal toLon, qreal toLat ) const;
 
+    /**
+     * Returns the heights at @p coordinates in the same order, or
+     * invalidElevationData where there is no data.
+     *
+     * The coordinates are grouped by elevation tile, the tiles which are not
+     * in memory yet are loaded concurrently. Prefer this over calling
+     * height() for each of many coordinates.
+     */
+    QVector<qreal> heights( const QVector<GeoDataCoordinates> &coordinates ) const;
+
+    /**
+     * @overload
+     */
+    QVector<qreal> heights( const GeoDataLineString &lineString ) const;
+
+    /**
+     * Returns the coordinates and heights along @p path, sampled along the
+     * great circles between the nodes at the resolution of the elevation
+     * data. Samples without data are left out.
+     */
+    QList<GeoDataCoordinates> heightProfile( const GeoDataLineString &path ) const;
+
 Q_SIGNALS:
     /**
      * Elevation tiles loaded. You will get more accurate results when querying height
@@ -20,11 +20,10 @@
 #include <QRunnable>
 
 // Marble
-#include "GeoPainter.h"
 #include "MarbleDebug.h"
+#include "MarbleGlobal.h"
 #include "ScanlineTextureMapperContext.h"
 #include "StackedTileLoader.h"
-#include "TextureColorizer.h"
 #include "ViewportParams.h"
 
 using namespace Marble;
@@ -32,7 +31,7 @@ using namespace Marble;
 class EquirectScanlineTextureMapper::RenderJob : public QRunnable
 {
 public:
-    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewportParams, MapQuality mapQuality, int yTop, int yBottom );
+    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewportParams, MapQuality mapQuality, int yTop, int yBottom, int xLeft, int xRight );
 
     virtual void run();
 
@@ -44,115 +43,61 @@ private:
     const MapQuality m_mapQuality;
     const int m_yPaintedTop;
     const int m_yPaintedBottom;
+    const int m_xPaintedLeft;
+    const int m_xPaintedRight;
 };
 
-EquirectScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom )
+EquirectScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom, int xLeft, int xRight )
     : m_tileLoader( tileLoader ),
       m_tileLevel( tileLevel ),
       m_canvasImage( canvasImage ),
       m_viewport( viewport ),
       m_mapQuality( mapQuality ),
       m_yPaintedTop( yTop ),
-      m_yPaintedBottom( yBottom )
+      m_yPaintedBottom( yBottom ),
+      m_xPaintedLeft( xLeft ),
+      m_xPaintedRight( xRight )
 {
 }
 
 
 EquirectScanlineTextureMapper::EquirectScanlineTextureMapper( StackedTileLoader *tileLoader )
-    : TextureMapperInterface(),
-      m_tileLoader( tileLoader ),
-      m_radius( 0 ),
-      m_oldYPaintedTop( 0 )
+    : CylindricalScanlineTextureMapper( tileLoader )
 {
 }
 
-void EquirectScanlineTextureMapper::mapTexture( GeoPainter *painter,
-                                                const ViewportParams *viewport,
-                                                int tileZoomLevel,
-                                                const QRect &dirtyRect,
-                                                TextureColorizer *texColorizer )
+int EquirectScanlineTextureMapper::yCenterOffset( const ViewportParams *viewport ) const
 {
-    if ( m_canvasImage.size() != viewport->size() || m_radius != viewport->radius() ) {
-        const QImage::Format optimalFormat = ScanlineTextureMapperContext::optimalCanvasImageFormat( viewport );
-
-        if ( m_canvasImage.size() != viewport->size() || m_canvasImage.format() != optimalFormat ) {
-            m_canvasImage = QImage( viewport->size(), optimalFormat );
-        }
-
-        if ( !viewport->mapCoversViewport() ) {
-            m_canvasImage.fill( 0 );
-        }
-
-        m_radius = viewport->radius();
-        m_repaintNeeded = true;
-    }
-
-    if ( m_repaintNeeded ) {
-        mapTexture( viewport, tileZoomLevel, painter->mapQuality() );
-
-        if ( texColorizer ) {
-            texColorizer->colorize( &m_canvasImage, viewport, painter->mapQuality() );
-        }
-
-        m_repaintNeeded = false;
-    }
+    // Calculate how many degrees are being represented per pixel.
+    const float rad2Pixel = (float)( 2 * viewport->radius() ) / M_PI;
 
-    painter->drawImage( dirtyRect, m_canvasImage, dirtyRect );
+    return (int)( viewport->centerLatitude() * rad2Pixel );
 }
 
-void EquirectScanlineTextureMapper::mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality )
+void EquirectScanlineTextureMapper::paintedRows( const ViewportParams *viewport, int *yPaintedTop, int *yPaintedBottom ) const
 {
-    // Reset backend
-    m_tileLoader->resetTilehash();
-
-    // Initialize needed constants:
+    const int imageHeight = viewport->height();
+    const qint64  radius  = viewport->radius();
 
-    const int imageHeight = m_canvasImage.height();
-    const qint64  radius      = viewport->radius();
-    // Calculate how many degrees are being represented per pixel.
-    const float rad2Pixel = (float)( 2 * radius ) / M_PI;
-
-    // Calculate translation of center point
-    const qreal centerLat = viewport->centerLatitude();
-
-    int yCenterOffset = (int)( centerLat * rad2Pixel );
-
-    // Calculate y-range the represented by the center point, yTop and
-    // what actually can be painted
-    const int yTop     = imageHeight / 2 - radius + yCenterOffset;;
-    int yPaintedTop    = imageHeight / 2 - radius + yCenterOffset;
-    int yPaintedBottom = imageHeight / 2 + radius + yCenterOffset;
- 
-    if (yPaintedTop < 0)                yPaintedTop = 0;
-    if (yPaintedTop > imageHeight)    yPaintedTop = imageHeight;
-    if (yPaintedBottom < 0)             yPaintedBottom = 0;
-    if (yPaintedBottom > imageHeight) yPaintedBottom = imageHeight;
-
-    const int numThreads = m_threadPool.maxThreadCount();
-    const int yStep = ( yPaintedBottom - yPaintedTop ) / numThreads;
-    for ( int i = 0; i < numThreads; ++i ) {
-        const int yStart = yPaintedTop +  i      * yStep;
-        const int yEnd   = yPaintedTop + (i + 1) * yStep;
-        QRunnable *const job = new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, yStart, yEnd );
-        m_threadPool.start( job );
-    }
-
-    // Remove unused lines
-    const int clearStart = ( yPaintedTop - m_oldYPaintedTop <= 0 ) ? yPaintedBottom : 0;
-    const int clearStop  = ( yPaintedTop - m_oldYPaintedTop <= 0 ) ? imageHeight  : yTop;
-
-    QRgb * const itClearBegin = (QRgb*)( m_canvasImage.scanLine( clearStart ) );
-    QRgb * const itClearEnd = (QRgb*)( m_canvasImage.scanLine( clearStop ) );
-
-    for ( QRgb * it = itClearBegin; it < itClearEnd; ++it ) {
-        *(it) = 0;
-    }
+    *yPaintedTop    = qBound( 0, int( imageHeight / 2 - radius + yCenterOffset( viewport ) ), imageHeight );
+    *yPaintedBottom = qBound( 0, int( imageHeight / 2 + radius + yCenterOffset( viewport ) ), imageHeight );
+}
 
-    m_threadPool.waitForDone();
+void EquirectScanlineTextureMapper::latitudeRows( qreal latTop, qreal latBottom, const ViewportParams *viewport, int *y1, int *y2 ) const
+{
+    const qint64  radius  = viewport->radius();
+    const qreal rad2Pixel = (qreal)( 2 * radius ) / M_PI;
 
-    m_oldYPaintedTop = yPaintedTop;
+    const int yTop = viewport->height() / 2 - radius + yCenterOffset( viewport );
+    *y1 = yTop + (int)floor( ( M_PI / 2 - latTop ) * rad2Pixel ) - 1;
+    *y2 = yTop + (int)ceil( ( M_PI / 2 - latBottom ) * rad2Pixel ) + 1;
+}
 
-    m_tileLoader->cleanupTilehash();
+QRunnable *EquirectScanlineTextureMapper::createRenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage,
+                                                           const ViewportParams *viewport, MapQuality mapQuality,
+                                                           int yTop, int yBottom, int xLeft, int xRight ) const
+{
+    return new RenderJob( tileLoader, tileLevel, canvasImage, viewport, mapQuality, yTop, yBottom, xLeft, xRight );
 }
 
 void EquirectScanlineTextureMapper::RenderJob::run()
@@ -182,11 +127,11 @@ void EquirectScanlineTextureMapper::RenderJob::run()
 
     const int yTop = imageHeight / 2 - radius + yCenterOffset;
 
-    qreal leftLon = + centerLon - ( imageWidth / 2 * pixel2Rad );
+    qreal leftLon = + centerLon - ( imageWidth / 2 * pixel2Rad ) + m_xPaintedLeft * pixel2Rad;
     while ( leftLon < -M_PI ) leftLon += 2 * M_PI;
     while ( leftLon >  M_PI ) leftLon -= 2 * M_PI;
 
-    const int maxInterpolationPointX = n * (int)( imageWidth / n - 1 ) + 1;
+    const int maxInterpolationPointX = m_xPaintedLeft + n * (int)( ( m_xPaintedRight - m_xPaintedLeft ) / n - 1 ) + 1;
 
 
     // initialize needed variables that are modified during texture mapping:
@@ -198,16 +143,16 @@ void EquirectScanlineTextureMapper::RenderJob::run()
 
     for ( int y = m_yPaintedTop; y < m_yPaintedBottom; ++y ) {
 
-        QRgb * scanLine = (QRgb*)( m_canvasImage->scanLine( y ) );
+        QRgb * scanLine = (QRgb*)( m_canvasImage->scanLine( y ) ) + m_xPaintedLeft;
 
         qreal lon = leftLon;
         const qreal lat = M_PI/2 - (y - yTop )* pixel2Rad;
 
-        for ( int x = 0; x < imageWidth; ++x ) {
+        for ( int x = m_xPaintedLeft; x < m_xPaintedRight; ++x ) {
 
             // Prepare for interpolation
             bool interpolate = false;
-            if ( x > 0 && x <= maxInterpolationPointX ) {
+            if ( x > m_xPaintedLeft && x <= maxInterpolationPointX ) {
                 x += n - 1;
                 lon += (n - 1) * pixel2Rad;
                 interpolate = !printQuality;
@@ -228,7 +173,7 @@ void EquirectScanlineTextureMapper::RenderJob::run()
                 scanLine += ( n - 1 );
             }
 
-            if ( x < imageWidth ) {
+            if ( x < m_xPaintedRight ) {
                 if ( highQuality )
                     context.pixelValueF( lon, lat, scanLine );
                 else
@@ -244,9 +189,9 @@ void EquirectScanlineTextureMapper::RenderJob::run()
 
             const int pixelByteSize = m_canvasImage->bytesPerLine() / imageWidth;
 
-            memcpy( m_canvasImage->scanLine( y + 1 ),
-                    m_canvasImage->scanLine( y     ),
-                    imageWidth * pixelByteSize );
+            memcpy( m_canvasImage->scanLine( y + 1 ) + m_xPaintedLeft * pixelByteSize,
+                    m_canvasImage->scanLine( y     ) + m_xPaintedLeft * pixelByteSize,
+                    ( m_xPaintedRight - m_xPaintedLeft ) * pixelByteSize );
             ++y;
         }
     }
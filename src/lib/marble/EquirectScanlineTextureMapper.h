@@ -14,39 +14,30 @@
 #define MARBLE_EQUIRECTSCANLINETEXTUREMAPPER_H
 
 
-#include "TextureMapperInterface.h"
-
-#include "MarbleGlobal.h"
-
-#include <QThreadPool>
-#include <QImage>
+#include "CylindricalScanlineTextureMapper.h"
 
 
 namespace Marble
 {
 
-class EquirectScanlineTextureMapper : public TextureMapperInterface
+class EquirectScanlineTextureMapper : public CylindricalScanlineTextureMapper
 {
  public:
     explicit EquirectScanlineTextureMapper( StackedTileLoader *tileLoader );
 
-    virtual void mapTexture( GeoPainter *painter,
-                             const ViewportParams *viewport,
-                             int tileZoomLevel,
-                             const QRect &dirtyRect,
-                             TextureColorizer *texColorizer );
+ protected:
+    virtual int yCenterOffset( const ViewportParams *viewport ) const;
 
- private:
-    void mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality );
+    virtual void paintedRows( const ViewportParams *viewport, int *yPaintedTop, int *yPaintedBottom ) const;
+
+    virtual void latitudeRows( qreal latTop, qreal latBottom, const ViewportParams *viewport, int *y1, int *y2 ) const;
+
+    virtual QRunnable *createRenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage,
+                                        const ViewportParams *viewport, MapQuality mapQuality,
+                                        int yTop, int yBottom, int xLeft, int xRight ) const;
 
  private:
     class RenderJob;
-
-    StackedTileLoader *const m_tileLoader;
-    int m_radius;
-    QImage m_canvasImage;
-    int    m_oldYPaintedTop;
-    QThreadPool m_threadPool;
 };
 
 }
@@ -0,0 +1,205 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "FeatureRegistry.h"
+
+#include <QHash>
+
+#include "GeoDataContainer.h"
+#include "GeoDataGroundOverlay.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTypes.h"
+
+namespace Marble
+{
+
+/**
+ * The features of one type. Each feature knows its position in the vector,
+ * so it is removed in constant time by moving the last feature into its place.
+ */
+template<class T>
+class FeatureBucket
+{
+public:
+    /**
+     * Registers the features of @p batch and drops the ones registered already from @p batch.
+     */
+    void insert( QVector<const T *> &batch );
+
+    /**
+     * Drops the features which are not registered from @p batch.
+     */
+    void filterRegistered( QVector<const T *> &batch ) const;
+
+    void remove( const QVector<const T *> &batch );
+
+    void clear();
+
+    QVector<const T *> m_features;
+    QHash<const T *, int> m_positions;
+};
+
+template<class T>
+void FeatureBucket<T>::insert( QVector<const T *> &batch )
+{
+    int size = 0;
+    for ( int i = 0; i < batch.size(); ++i ) {
+        const T *const feature = batch.at( i );
+        if ( m_positions.contains( feature ) ) {
+            continue;
+        }
+
+        m_positions.insert( feature, m_features.size() );
+        m_features.append( feature );
+        batch[size++] = feature;
+    }
+
+    batch.resize( size );
+}
+
+template<class T>
+void FeatureBucket<T>::filterRegistered( QVector<const T *> &batch ) const
+{
+    int size = 0;
+    for ( int i = 0; i < batch.size(); ++i ) {
+        if ( m_positions.contains( batch.at( i ) ) ) {
+            batch[size++] = batch.at( i );
+        }
+    }
+
+    batch.resize( size );
+}
+
+template<class T>
+void FeatureBucket<T>::remove( const QVector<const T *> &batch )
+{
+    foreach ( const T *feature, batch ) {
+        typename QHash<const T *, int>::iterator position = m_positions.find( feature );
+        if ( position == m_positions.end() ) {
+            continue;
+        }
+
+        const int index = position.value();
+        m_positions.erase( position );
+
+        const T *const last = m_features.last();
+        if ( last != feature ) {
+            m_features[index] = last;
+            m_positions[last] = index;
+        }
+        m_features.pop_back();
+    }
+}
+
+template<class T>
+void FeatureBucket<T>::clear()
+{
+    m_features.clear();
+    m_positions.clear();
+}
+
+class Q_DECL_HIDDEN FeatureRegistry::Private
+{
+public:
+    static void collect( const GeoDataFeature *feature,
+                         QVector<const GeoDataPlacemark *> &placemarks,
+                         QVector<const GeoDataGroundOverlay *> &groundOverlays );
+
+    FeatureBucket<GeoDataPlacemark> m_placemarks;
+    FeatureBucket<GeoDataGroundOverlay> m_groundOverlays;
+};
+
+void FeatureRegistry::Private::collect( const GeoDataFeature *feature,
+                                        QVector<const GeoDataPlacemark *> &placemarks,
+                                        QVector<const GeoDataGroundOverlay *> &groundOverlays )
+{
+    const char *const nodeType = feature->nodeType();
+    if ( nodeType == GeoDataTypes::GeoDataPlacemarkType ) {
+        placemarks.append( static_cast<const GeoDataPlacemark *>( feature ) );
+    }
+    else if ( nodeType == GeoDataTypes::GeoDataGroundOverlayType ) {
+        groundOverlays.append( static_cast<const GeoDataGroundOverlay *>( feature ) );
+    }
+    else if ( nodeType == GeoDataTypes::GeoDataFolderType
+              || nodeType == GeoDataTypes::GeoDataDocumentType ) {
+        const GeoDataContainer *const container = static_cast<const GeoDataContainer *>( feature );
+        for ( int i = 0; i < container->size(); ++i ) {
+            collect( container->child( i ), placemarks, groundOverlays );
+        }
+    }
+}
+
+FeatureRegistry::FeatureRegistry( QObject *parent ) :
+    QObject( parent ),
+    d( new Private )
+{
+}
+
+FeatureRegistry::~FeatureRegistry()
+{
+    delete d;
+}
+
+const QVector<const GeoDataPlacemark *> &FeatureRegistry::placemarks() const
+{
+    return d->m_placemarks.m_features;
+}
+
+const QVector<const GeoDataGroundOverlay *> &FeatureRegistry::groundOverlays() const
+{
+    return d->m_groundOverlays.m_features;
+}
+
+void FeatureRegistry::addFeature( const GeoDataFeature *feature )
+{
+    QVector<const GeoDataPlacemark *> placemarks;
+    QVector<const GeoDataGroundOverlay *> groundOverlays;
+    Private::collect( feature, placemarks, groundOverlays );
+
+    d->m_placemarks.insert( placemarks );
+    d->m_groundOverlays.insert( groundOverlays );
+
+    if ( !placemarks.isEmpty() ) {
+        emit placemarksAdded( placemarks );
+    }
+    if ( !groundOverlays.isEmpty() ) {
+        emit groundOverlaysAdded( groundOverlays );
+    }
+}
+
+void FeatureRegistry::removeFeature( const GeoDataFeature *feature )
+{
+    QVector<const GeoDataPlacemark *> placemarks;
+    QVector<const GeoDataGroundOverlay *> groundOverlays;
+    Private::collect( feature, placemarks, groundOverlays );
+
+    d->m_placemarks.filterRegistered( placemarks );
+    d->m_groundOverlays.filterRegistered( groundOverlays );
+
+    if ( !placemarks.isEmpty() ) {
+        emit placemarksAboutToBeRemoved( placemarks );
+    }
+    if ( !groundOverlays.isEmpty() ) {
+        emit groundOverlaysAboutToBeRemoved( groundOverlays );
+    }
+
+    d->m_placemarks.remove( placemarks );
+    d->m_groundOverlays.remove( groundOverlays );
+}
+
+void FeatureRegistry::clear()
+{
+    d->m_placemarks.clear();
+    d->m_groundOverlays.clear();
+
+    emit cleared();
+}
+
+}
+
+#include "moc_FeatureRegistry.cpp"
@@ -0,0 +1,88 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_FEATUREREGISTRY_H
+#define MARBLE_FEATUREREGISTRY_H
+
+#include <QObject>
+#include <QVector>
+
+#include "marble_export.h"
+
+namespace Marble
+{
+
+class GeoDataFeature;
+class GeoDataGroundOverlay;
+class GeoDataPlacemark;
+
+/**
+ * @brief The placemarks and ground overlays of a GeoDataTreeModel, bucketed by type.
+ *
+ * GeoDataTreeModel registers every feature it inserts, including the
+ * features of inserted documents and folders, and unregisters them before
+ * they are removed. Layers interested in a type of features subscribe to
+ * the signals of the registry rather than filtering the rows of the tree
+ * model: inserting a document emits placemarksAdded() once with all of
+ * its placemarks.
+ */
+class MARBLE_EXPORT FeatureRegistry : public QObject
+{
+    Q_OBJECT
+
+ public:
+    explicit FeatureRegistry( QObject *parent = 0 );
+    ~FeatureRegistry();
+
+    /**
+     * Returns the registered placemarks in no particular order.
+     */
+    const QVector<const GeoDataPlacemark *> &placemarks() const;
+
+    /**
+     * Returns the registered ground overlays in no particular order.
+     */
+    const QVector<const GeoDataGroundOverlay *> &groundOverlays() const;
+
+    /**
+     * Registers @p feature and, if it is a container, all features in it.
+     * Features which are registered already are skipped.
+     */
+    void addFeature( const GeoDataFeature *feature );
+
+    /**
+     * Unregisters @p feature and, if it is a container, all features in it.
+     */
+    void removeFeature( const GeoDataFeature *feature );
+
+    /**
+     * Unregisters all features.
+     */
+    void clear();
+
+ Q_SIGNALS:
+    void placemarksAdded( const QVector<const GeoDataPlacemark *> &placemarks );
+    void placemarksAboutToBeRemoved( const QVector<const GeoDataPlacemark *> &placemarks );
+
+    void groundOverlaysAdded( const QVector<const GeoDataGroundOverlay *> &groundOverlays );
+    void groundOverlaysAboutToBeRemoved( const QVector<const GeoDataGroundOverlay *> &groundOverlays );
+
+    /**
+     * Emitted by clear() after all features have been unregistered.
+     */
+    void cleared();
+
+ private:
+    Q_DISABLE_COPY( FeatureRegistry )
+    class Private;
+    Private *const d;
+};
+
+}
+
+#endif
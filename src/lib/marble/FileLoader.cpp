@@ -20,6 +20,9 @@
 #include "GeoDataDocument.h"
 #include "GeoDataFolder.h"
 #include "GeoDataPlacemark.h"
+#include "GeoDataLinearRing.h"
+#include "GeoDataMultiGeometry.h"
+#include "GeoDataPolygon.h"
 #include "GeoDataData.h"
 #include "GeoDataExtendedData.h"
 #include "GeoDataStyleMap.h"
@@ -77,6 +80,7 @@ public:
     }
 
     void createFilterProperties( GeoDataContainer *container );
+    static void compactGeometry( GeoDataGeometry *geometry );
     static int cityPopIdx( qint64 population );
     static int spacePopIdx( qint64 population );
     static int areaPopIdx( qreal area );
@@ -248,8 +252,6 @@ void FileLoaderPrivate::createFilterProperties( GeoDataContainer *container )
             GeoDataPlacemark* placemark = static_cast<GeoDataPlacemark*>( *i );
             Q_ASSERT( placemark->geometry() );
 
-            bool hasPopularity = false;
-
             if ( placemark->geometry()->nodeType() != GeoDataTypes::GeoDataTrackType &&
                 placemark->geometry()->nodeType() != GeoDataTypes::GeoDataPointType
                  && m_documentRole == MapDocument
@@ -257,166 +259,201 @@ void FileLoaderPrivate::createFilterProperties( GeoDataContainer *container )
                 placemark->setStyleUrl( QString("#").append( m_styleMap->id() ) );
             }
 
-            // Mountain (H), Volcano (V), Shipwreck (W)
-            if ( placemark->role() == "H" || placemark->role() == "V" || placemark->role() == "W" )
-            {
-                qreal altitude = placemark->coordinate().altitude();
-                if ( altitude != 0.0 )
-                {
-                    hasPopularity = true;
-                    placemark->setPopularity( (qint64)(altitude * 1000.0) );
-                    placemark->setZoomLevel( cityPopIdx( qAbs( (qint64)(altitude * 1000.0) ) ) );
-                }
+            FileLoader::createFilterProperties( placemark );
+
+            // The geometries of map documents are loaded once and rendered
+            // afterwards, so they are kept in the compact form
+            if ( m_documentRole == MapDocument ) {
+                compactGeometry( placemark->geometry() );
             }
-            // Continent (K), Ocean (O), Nation (S)
-            else if ( placemark->role() == "K" || placemark->role() == "O" || placemark->role() == "S" )
-            {
-                qreal area = placemark->area();
-                if ( area >= 0.0 )
-                {
-                    hasPopularity = true;
-                    //                mDebug() << placemark->name() << " " << (qint64)(area);
-                    placemark->setPopularity( (qint64)(area * 100) );
-                    placemark->setZoomLevel( areaPopIdx( area ) );
+        } else {
+            qWarning() << Q_FUNC_INFO << "Unknown feature" << (*i)->nodeType() << ". Skipping.";
+        }
+    }
+}
+
+void FileLoader::createFilterProperties( GeoDataPlacemark *placemark )
+{
+    bool hasPopularity = false;
+
+    // Mountain (H), Volcano (V), Shipwreck (W)
+    if ( placemark->role() == "H" || placemark->role() == "V" || placemark->role() == "W" )
+    {
+        qreal altitude = placemark->coordinate().altitude();
+        if ( altitude != 0.0 )
+        {
+            hasPopularity = true;
+            placemark->setPopularity( (qint64)(altitude * 1000.0) );
+            placemark->setZoomLevel( FileLoaderPrivate::cityPopIdx( qAbs( (qint64)(altitude * 1000.0) ) ) );
+        }
+    }
+    // Continent (K), Ocean (O), Nation (S)
+    else if ( placemark->role() == "K" || placemark->role() == "O" || placemark->role() == "S" )
+    {
+        qreal area = placemark->area();
+        if ( area >= 0.0 )
+        {
+            hasPopularity = true;
+            //                mDebug() << placemark->name() << " " << (qint64)(area);
+            placemark->setPopularity( (qint64)(area * 100) );
+            placemark->setZoomLevel( FileLoaderPrivate::areaPopIdx( area ) );
+        }
+    }
+    // Pole (P)
+    else if ( placemark->role() == "P" )
+    {
+        placemark->setPopularity( 1000000000 );
+        placemark->setZoomLevel( 1 );
+    }
+    // Magnetic Pole (M)
+    else if ( placemark->role() == "M" )
+    {
+        placemark->setPopularity( 10000000 );
+        placemark->setZoomLevel( 3 );
+    }
+    // MannedLandingSite (h)
+    else if ( placemark->role() == "h" )
+    {
+        placemark->setPopularity( 1000000000 );
+        placemark->setZoomLevel( 1 );
+    }
+    // RoboticRover (r)
+    else if ( placemark->role() == "r" )
+    {
+        placemark->setPopularity( 10000000 );
+        placemark->setZoomLevel( 2 );
+    }
+    // UnmannedSoftLandingSite (u)
+    else if ( placemark->role() == "u" )
+    {
+        placemark->setPopularity( 1000000 );
+        placemark->setZoomLevel( 3 );
+    }
+    // UnmannedSoftLandingSite (i)
+    else if ( placemark->role() == "i" )
+    {
+        placemark->setPopularity( 1000000 );
+        placemark->setZoomLevel( 3 );
+    }
+    // Space Terrain: Craters, Maria, Montes, Valleys, etc.
+    else if (    placemark->role() == "m" || placemark->role() == "v"
+                 || placemark->role() == "o" || placemark->role() == "c"
+                 || placemark->role() == "a" )
+    {
+        qint64 diameter = placemark->population();
+        if ( diameter >= 0 )
+        {
+            hasPopularity = true;
+            placemark->setPopularity( diameter );
+            if ( placemark->role() == "c" ) {
+                placemark->setZoomLevel( FileLoaderPrivate::spacePopIdx( diameter ) );
+                if ( placemark->name() == "Tycho" || placemark->name() == "Copernicus" ) {
+                    placemark->setZoomLevel( 1 );
                 }
             }
-            // Pole (P)
-            else if ( placemark->role() == "P" )
-            {
-                placemark->setPopularity( 1000000000 );
-                placemark->setZoomLevel( 1 );
-            }
-            // Magnetic Pole (M)
-            else if ( placemark->role() == "M" )
-            {
-                placemark->setPopularity( 10000000 );
-                placemark->setZoomLevel( 3 );
+            else {
+                placemark->setZoomLevel( FileLoaderPrivate::spacePopIdx( diameter ) );
             }
-            // MannedLandingSite (h)
-            else if ( placemark->role() == "h" )
-            {
+
+            if ( placemark->role() == "a" && diameter == 0 ) {
                 placemark->setPopularity( 1000000000 );
                 placemark->setZoomLevel( 1 );
             }
-            // RoboticRover (r)
-            else if ( placemark->role() == "r" )
-            {
-                placemark->setPopularity( 10000000 );
-                placemark->setZoomLevel( 2 );
-            }
-            // UnmannedSoftLandingSite (u)
-            else if ( placemark->role() == "u" )
-            {
-                placemark->setPopularity( 1000000 );
-                placemark->setZoomLevel( 3 );
-            }
-            // UnmannedSoftLandingSite (i)
-            else if ( placemark->role() == "i" )
-            {
-                placemark->setPopularity( 1000000 );
-                placemark->setZoomLevel( 3 );
-            }
-            // Space Terrain: Craters, Maria, Montes, Valleys, etc.
-            else if (    placemark->role() == "m" || placemark->role() == "v"
-                         || placemark->role() == "o" || placemark->role() == "c"
-                         || placemark->role() == "a" )
-            {
-                qint64 diameter = placemark->population();
-                if ( diameter >= 0 )
-                {
-                    hasPopularity = true;
-                    placemark->setPopularity( diameter );
-                    if ( placemark->role() == "c" ) {
-                        placemark->setZoomLevel( spacePopIdx( diameter ) );
-                        if ( placemark->name() == "Tycho" || placemark->name() == "Copernicus" ) {
-                            placemark->setZoomLevel( 1 );
-                        }
-                    }
-                    else {
-                        placemark->setZoomLevel( spacePopIdx( diameter ) );
-                    }
-
-                    if ( placemark->role() == "a" && diameter == 0 ) {
-                        placemark->setPopularity( 1000000000 );
-                        placemark->setZoomLevel( 1 );
-                    }
-                }
-            }
-            else
-            {
-                qint64 population = placemark->population();
-                if ( population >= 0 )
-                {
-                    hasPopularity = true;
-                    placemark->setPopularity( population );
-                    placemark->setZoomLevel( cityPopIdx( population ) );
-                }
-            }
+        }
+    }
+    else
+    {
+        qint64 population = placemark->population();
+        if ( population >= 0 )
+        {
+            hasPopularity = true;
+            placemark->setPopularity( population );
+            placemark->setZoomLevel( FileLoaderPrivate::cityPopIdx( population ) );
+        }
+    }
 
-            //  Then we set the visual category:
-
-            if ( placemark->role() == "H" )      placemark->setVisualCategory( GeoDataPlacemark::Mountain );
-            else if ( placemark->role() == "V" ) placemark->setVisualCategory( GeoDataPlacemark::Volcano );
-
-            else if ( placemark->role() == "m" ) placemark->setVisualCategory( GeoDataPlacemark::Mons );
-            else if ( placemark->role() == "v" ) placemark->setVisualCategory( GeoDataPlacemark::Valley );
-            else if ( placemark->role() == "o" ) placemark->setVisualCategory( GeoDataPlacemark::OtherTerrain );
-            else if ( placemark->role() == "c" ) placemark->setVisualCategory( GeoDataPlacemark::Crater );
-            else if ( placemark->role() == "a" ) placemark->setVisualCategory( GeoDataPlacemark::Mare );
-
-            else if ( placemark->role() == "P" ) placemark->setVisualCategory( GeoDataPlacemark::GeographicPole );
-            else if ( placemark->role() == "M" ) placemark->setVisualCategory( GeoDataPlacemark::MagneticPole );
-            else if ( placemark->role() == "W" ) placemark->setVisualCategory( GeoDataPlacemark::ShipWreck );
-            else if ( placemark->role() == "F" ) placemark->setVisualCategory( GeoDataPlacemark::AirPort );
-            else if ( placemark->role() == "A" ) placemark->setVisualCategory( GeoDataPlacemark::Observatory );
-            else if ( placemark->role() == "K" ) placemark->setVisualCategory( GeoDataPlacemark::Continent );
-            else if ( placemark->role() == "O" ) placemark->setVisualCategory( GeoDataPlacemark::Ocean );
-            else if ( placemark->role() == "S" ) placemark->setVisualCategory( GeoDataPlacemark::Nation );
-            else
-                if (  placemark->role()=="PPL"
-                   || placemark->role()=="PPLF"
-                   || placemark->role()=="PPLG"
-                   || placemark->role()=="PPLL"
-                   || placemark->role()=="PPLQ"
-                   || placemark->role()=="PPLR"
-                   || placemark->role()=="PPLS"
-                   || placemark->role()=="PPLW" ) placemark->setVisualCategory(
-                        ( GeoDataPlacemark::GeoDataVisualCategory )( GeoDataPlacemark::SmallCity
-                                                                       + (( 20- ( 2*placemark->zoomLevel()) ) / 4 * 4 ) ) );
-            else if ( placemark->role() == "PPLA" ) placemark->setVisualCategory(
-                    ( GeoDataPlacemark::GeoDataVisualCategory )( GeoDataPlacemark::SmallStateCapital
-                                                                   + (( 20- ( 2*placemark->zoomLevel()) ) / 4 * 4 ) ) );
-            else if ( placemark->role()=="PPLC" ) placemark->setVisualCategory(
-                    ( GeoDataPlacemark::GeoDataVisualCategory )( GeoDataPlacemark::SmallNationCapital
-                                                                   + (( 20- ( 2*placemark->zoomLevel()) ) / 4 * 4 ) ) );
-            else if ( placemark->role()=="PPLA2" || placemark->role()=="PPLA3" ) placemark->setVisualCategory(
-                    ( GeoDataPlacemark::GeoDataVisualCategory )( GeoDataPlacemark::SmallCountyCapital
-                                                                   + (( 20- ( 2*placemark->zoomLevel()) ) / 4 * 4 ) ) );
-            else if ( placemark->role()==" " && !hasPopularity && placemark->visualCategory() == GeoDataPlacemark::Unknown ) {
-                placemark->setVisualCategory( GeoDataPlacemark::Unknown ); // default location
-                placemark->setZoomLevel(0);
-            }
-            else if ( placemark->role() == "h" ) placemark->setVisualCategory( GeoDataPlacemark::MannedLandingSite );
-            else if ( placemark->role() == "r" ) placemark->setVisualCategory( GeoDataPlacemark::RoboticRover );
-            else if ( placemark->role() == "u" ) placemark->setVisualCategory( GeoDataPlacemark::UnmannedSoftLandingSite );
-            else if ( placemark->role() == "i" ) placemark->setVisualCategory( GeoDataPlacemark::UnmannedHardLandingSite );
-
-            if ( placemark->role() == "W" && placemark->zoomLevel() < 4 )
-                placemark->setZoomLevel( 4 );
-            if ( placemark->role() == "O" )
-                placemark->setZoomLevel( 2 );
-            if ( placemark->role() == "K" )
-                placemark->setZoomLevel( 0 );
-            if ( !placemark->isVisible() ) {
-                placemark->setZoomLevel( 18 );
-            }
-            // Workaround: Emulate missing "setVisible" serialization by allowing for population
-            // values smaller than -1 which are considered invisible.
-            if ( placemark->population() < -1 ) {
-                placemark->setZoomLevel( 18 );
-            }
-        } else {
-            qWarning() << Q_FUNC_INFO << "Unknown feature" << (*i)->nodeType() << ". Skipping.";
+    //  Then we set the visual category:
+
+    if ( placemark->role() == "H" )      placemark->setVisualCategory( GeoDataPlacemark::Mountain );
+    else if ( placemark->role() == "V" ) placemark->setVisualCategory( GeoDataPlacemark::Volcano );
+
+    else if ( placemark->role() == "m" ) placemark->setVisualCategory( GeoDataPlacemark::Mons );
+    else if ( placemark->role() == "v" ) placemark->setVisualCategory( GeoDataPlacemark::Valley );
+    else if ( placemark->role() == "o" ) placemark->setVisualCategory( GeoDataPlacemark::OtherTerrain );
+    else if ( placemark->role() == "c" ) placemark->setVisualCategory( GeoDataPlacemark::Crater );
+    else if ( placemark->role() == "a" ) placemark->setVisualCategory( GeoDataPlacemark::Mare );
+
+    else if ( placemark->role() == "P" ) placemark->setVisualCategory( GeoDataPlacemark::GeographicPole );
+    else if ( placemark->role() == "M" ) placemark->setVisualCategory( GeoDataPlacemark::MagneticPole );
+    else if ( placemark->role() == "W" ) placemark->setVisualCategory( GeoDataPlacemark::ShipWreck );
+    else if ( placemark->role() == "F" ) placemark->setVisualCategory( GeoDataPlacemark::AirPort );
+    else if ( placemark->role() == "A" ) placemark->setVisualCategory( GeoDataPlacemark::Observatory );
+    else if ( placemark->role() == "K" ) placemark->setVisualCategory( GeoDataPlacemark::Continent );
+    else if ( placemark->role() == "O" ) placemark->setVisualCategory( GeoDataPlacemark::Ocean );
+    else if ( placemark->role() == "S" ) placemark->setVisualCategory( GeoDataPlacemark::Nation );
+    else
+        if (  placemark->role()=="PPL"
+           || placemark->role()=="PPLF"
+           || placemark->role()=="PPLG"
+           || placemark->role()=="PPLL"
+           || placemark->role()=="PPLQ"
+           || placemark->role()=="PPLR"
+           || placemark->role()=="PPLS"
+           || placemark->role()=="PPLW" ) placemark->setVisualCategory(
+                ( GeoDataPlacemark::GeoDataVisualCategory )( GeoDataPlacemark::SmallCity
+                                                               + (( 20- ( 2*placemark->zoomLevel()) ) / 4 * 4 ) ) );
+    else if ( placemark->role() == "PPLA" ) placemark->setVisualCategory(
+            ( GeoDataPlacemark::GeoDataVisualCategory )( GeoDataPlacemark::SmallStateCapital
+                                                           + (( 20- ( 2*placemark->zoomLevel()) ) / 4 * 4 ) ) );
+    else if ( placemark->role()=="PPLC" ) placemark->setVisualCategory(
+            ( GeoDataPlacemark::GeoDataVisualCategory )( GeoDataPlacemark::SmallNationCapital
+                                                           + (( 20- ( 2*placemark->zoomLevel()) ) / 4 * 4 ) ) );
+    else if ( placemark->role()=="PPLA2" || placemark->role()=="PPLA3" ) placemark->setVisualCategory(
+            ( GeoDataPlacemark::GeoDataVisualCategory )( GeoDataPlacemark::SmallCountyCapital
+                                                           + (( 20- ( 2*placemark->zoomLevel()) ) / 4 * 4 ) ) );
+    else if ( placemark->role()==" " && !hasPopularity && placemark->visualCategory() == GeoDataPlacemark::Unknown ) {
+        placemark->setVisualCategory( GeoDataPlacemark::Unknown ); // default location
+        placemark->setZoomLevel(0);
+    }
+    else if ( placemark->role() == "h" ) placemark->setVisualCategory( GeoDataPlacemark::MannedLandingSite );
+    else if ( placemark->role() == "r" ) placemark->setVisualCategory( GeoDataPlacemark::RoboticRover );
+    else if ( placemark->role() == "u" ) placemark->setVisualCategory( GeoDataPlacemark::UnmannedSoftLandingSite );
+    else if ( placemark->role() == "i" ) placemark->setVisualCategory( GeoDataPlacemark::UnmannedHardLandingSite );
+
+    if ( placemark->role() == "W" && placemark->zoomLevel() < 4 )
+        placemark->setZoomLevel( 4 );
+    if ( placemark->role() == "O" )
+        placemark->setZoomLevel( 2 );
+    if ( placemark->role() == "K" )
+        placemark->setZoomLevel( 0 );
+    if ( !placemark->isVisible() ) {
+        placemark->setZoomLevel( 18 );
+    }
+    // Workaround: Emulate missing "setVisible" serialization by allowing for population
+    // values smaller than -1 which are considered invisible.
+    if ( placemark->population() < -1 ) {
+        placemark->setZoomLevel( 18 );
+    }
+}
+
+void FileLoaderPrivate::compactGeometry( GeoDataGeometry *geometry )
+{
+    if ( geometry->nodeType() == GeoDataTypes::GeoDataLineStringType
+         || geometry->nodeType() == GeoDataTypes::GeoDataLinearRingType ) {
+        static_cast<GeoDataLineString*>( geometry )->compact();
+    } else if ( geometry->nodeType() == GeoDataTypes::GeoDataPolygonType ) {
+        GeoDataPolygon *polygon = static_cast<GeoDataPolygon*>( geometry );
+        polygon->outerBoundary().compact();
+        QVector<GeoDataLinearRing> &innerBoundaries = polygon->innerBoundaries();
+        for ( int i = 0; i < innerBoundaries.size(); ++i ) {
+            innerBoundaries[i].compact();
+        }
+    } else if ( geometry->nodeType() == GeoDataTypes::GeoDataMultiGeometryType ) {
+        GeoDataMultiGeometry *multiGeometry = static_cast<GeoDataMultiGeometry*>( geometry );
+        QVector<GeoDataGeometry*>::Iterator i = multiGeometry->begin();
+        QVector<GeoDataGeometry*>::Iterator const end = multiGeometry->end();
+        for (; i != end; ++i ) {
+            compactGeometry( *i );
         }
     }
 }
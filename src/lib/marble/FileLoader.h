@@ -19,6 +19,7 @@
 namespace Marble
 {
 class GeoDataContainer;
+class GeoDataPlacemark;
 class FileLoaderPrivate;
 class PluginManager;
 
@@ -38,6 +39,12 @@ class FileLoader : public QThread
         GeoDataDocument *document();
         QString error() const;
 
+        /**
+         * Sets the popularity, zoom level and visual category of @p placemark
+         * according to its role like for the placemarks of loaded files.
+         */
+        static void createFilterProperties( GeoDataPlacemark *placemark );
+
     Q_SIGNALS:
         void loaderFinished( FileLoader* );
         void newGeoDataDocumentAdded( GeoDataDocument* );
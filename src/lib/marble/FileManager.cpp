@@ -20,9 +20,12 @@
 #include "MarbleDebug.h"
 #include "MarbleModel.h"
 #include "GeoDataTreeModel.h"
+#include "PlacemarkSource.h"
 
 #include "GeoDataDocument.h"
+#include "GeoDataFolder.h"
 #include "GeoDataLatLonAltBox.h"
+#include "GeoDataPlacemark.h"
 #include "GeoDataStyle.h"
 #include "GeoWriter.h"
 #include <KmlElementDictionary.h>
@@ -54,6 +57,7 @@ public:
     void appendLoader( FileLoader *loader );
     void closeFile( const QString &key );
     void cleanupLoader( FileLoader *loader );
+    void createPlacemarks( GeoDataDocument *document );
 
     FileManager *const q;
     GeoDataTreeModel *const m_treeModel;
@@ -62,6 +66,7 @@ public:
     QList<FileLoader*> m_loaderList;
     QHash < QString, GeoDataDocument* > m_fileItemHash;
     GeoDataLatLonBox m_latLonBox;
+    GeoDataLatLonBox m_viewport;
     QTime m_timer;
 };
 }
@@ -186,6 +191,35 @@ int FileManager::pendingFiles() const
     return d->m_loaderList.size();
 }
 
+void FileManager::setViewport( const GeoDataLatLonBox &viewport )
+{
+    d->m_viewport = viewport;
+    foreach ( GeoDataDocument *document, d->m_fileItemHash ) {
+        d->createPlacemarks( document );
+    }
+}
+
+void FileManagerPrivate::createPlacemarks( GeoDataDocument *document )
+{
+    PlacemarkSource *source = dynamic_cast<PlacemarkSource*>( document );
+    if ( !source || m_viewport.isEmpty() ) {
+        return;
+    }
+
+    const QVector<GeoDataPlacemark*> placemarks = source->createPlacemarks( m_viewport );
+    if ( placemarks.isEmpty() ) {
+        return;
+    }
+
+    // add the placemarks at once so that the layers are updated once
+    GeoDataFolder *folder = new GeoDataFolder;
+    foreach ( GeoDataPlacemark *placemark, placemarks ) {
+        FileLoader::createFilterProperties( placemark );
+        folder->append( placemark );
+    }
+    m_treeModel->addFeature( document, folder );
+}
+
 void FileManagerPrivate::cleanupLoader( FileLoader* loader )
 {
     GeoDataDocument *doc = loader->document();
@@ -199,6 +233,7 @@ void FileManagerPrivate::cleanupLoader( FileLoader* loader )
             }
             m_treeModel->addDocument( doc );
             m_fileItemHash.insert( loader->path(), doc );
+            createPlacemarks( doc );
             emit q->fileAdded( loader->path() );
             if( loader->recenter() ) {
                 m_latLonBox |= doc->latLonAltBox();
@@ -76,6 +76,12 @@ class FileManager : public QObject
     /** Returns the number of files being opened at the moment */
     int pendingFiles() const;
 
+    /**
+     * Sets the visible region. Documents that create their placemarks on
+     * demand (see PlacemarkSource) are asked for the placemarks in it.
+     */
+    void setViewport( const GeoDataLatLonBox &viewport );
+
  Q_SIGNALS:
     void fileAdded( const QString &key );
     void fileRemoved( const QString &key );
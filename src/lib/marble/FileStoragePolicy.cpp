@@ -27,11 +27,9 @@ using namespace Marble;
 
 FileStoragePolicy::FileStoragePolicy( const QString &dataDirectory, QObject *parent )
     : StoragePolicy( parent ),
-      m_dataDirectory( dataDirectory )
+      m_dataDirectory( dataDirectory.isEmpty() ? MarbleDirs::localPath() + "/cache/" : dataDirectory ),
+      m_journal( m_dataDirectory )
 {
-    if ( m_dataDirectory.isEmpty() )
-        m_dataDirectory = MarbleDirs::localPath() + "/cache/";
-
     if ( !QDir( m_dataDirectory ).exists() ) 
         QDir::root().mkpath( m_dataDirectory );
 }
@@ -77,6 +75,10 @@ bool FileStoragePolicy::updateFile( const QString &fileName, const QByteArray &d
         return false;
     }
 
+    const QString relativePath = m_journal.relativePath( fullName );
+    if ( TileCacheJournal::isTileFile( relativePath ) )
+        m_journal.recordWrite( relativePath, file.size() );
+
     emit sizeChanged( file.size() - oldSize );
     file.close();
 
@@ -130,6 +132,7 @@ void FileStoragePolicy::clearCache()
                         QFile file( filePath );
                         emit sizeChanged( -file.size() );
                         file.remove();
+                        m_journal.recordRemoval( m_journal.relativePath( filePath ) );
                     }
                 }
             }
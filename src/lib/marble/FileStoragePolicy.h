@@ -12,6 +12,7 @@
 #define MARBLE_FILESTORAGEPOLICY_H
 
 #include "StoragePolicy.h"
+#include "TileCacheJournal.h"
 
 namespace Marble
 {
@@ -58,6 +59,7 @@ class FileStoragePolicy : public StoragePolicy
 	
         QString m_dataDirectory;
         QString m_errorMsg;
+        TileCacheJournal m_journal;
 };
 
 }
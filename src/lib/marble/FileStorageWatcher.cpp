@@ -14,8 +14,10 @@
 // Qt
 #include <QDir>
 #include <QDirIterator>
+#include <QDateTime>
 #include <QFileInfo>
 #include <QTimer>
+#include <QVector>
 
 // Marble
 #include "MarbleGlobal.h"
@@ -28,12 +30,18 @@ using namespace Marble;
 // changed cacheLimits and changed themes etc.
 static const int maxFilesDelete = 20;
 static const int softLimitPercent = 5;
+// Rewrite the journal once it holds this many times more records than files
+static const int journalCompactionFactor = 2;
 
 
 // Methods of FileStorageWatcherThread
 FileStorageWatcherThread::FileStorageWatcherThread( const QString &dataDirectory, QObject *parent )
     : QObject( parent ),
       m_dataDirectory( dataDirectory ),
+      m_journal( dataDirectory ),
+      m_journalAvailable( true ),
+      m_currentCacheSize( 0 ),
+      m_reportedSize( 0 ),
       m_deleting( false ),
       m_willQuit( false )
 {
@@ -66,21 +74,47 @@ void FileStorageWatcherThread::setCacheLimit( quint64 bytes )
 
 void FileStorageWatcherThread::addToCurrentSize( qint64 bytes )
 {
-//     mDebug() << "Current cache size changed by " << bytes;
-    qint64 changedSize = bytes + m_currentCacheSize;
-    if( changedSize >= 0 )
-	m_currentCacheSize = changedSize;
+    if ( bytes < 0 )
+        m_currentCacheSize -= qMin<quint64>( m_currentCacheSize, -bytes );
     else
-	m_currentCacheSize = 0;
+        m_currentCacheSize += bytes;
+    m_reportedSize += bytes;
+
     emit variableChanged();
 }
 
-void FileStorageWatcherThread::resetCurrentSize()
+void FileStorageWatcherThread::readJournal()
 {
-    m_currentCacheSize = 0;
+    updateFromJournal();
+
     emit variableChanged();
 }
 
+void FileStorageWatcherThread::updateFromJournal()
+{
+    if ( !m_journalAvailable )
+        return;
+
+    // The journal records the same changes that have been reported
+    if ( m_reportedSize < 0 )
+        m_currentCacheSize += -m_reportedSize;
+    else
+        m_currentCacheSize -= qMin<quint64>( m_currentCacheSize, m_reportedSize );
+    m_reportedSize = 0;
+
+    QVector<TileCacheJournal::Record> records;
+    if ( !m_journal.readRecords( records ) ) {
+        // The journal got lost, repair it
+        scanCache();
+    }
+    else {
+        foreach ( const TileCacheJournal::Record &record, records ) {
+            applyRecord( record );
+        }
+        compactJournal();
+    }
+}
+
 void FileStorageWatcherThread::prepareQuit()
 {
     m_willQuit = true;
@@ -88,35 +122,102 @@ void FileStorageWatcherThread::prepareQuit()
 
 void FileStorageWatcherThread::getCurrentCacheSize()
 {
-    mDebug() << "FileStorageWatcher: Creating cache size";
-    quint64 dataSize = 0;
+    m_files.clear();
+    m_filesCache.clear();
+    m_currentCacheSize = 0;
+    m_reportedSize = 0;
+
+    QVector<TileCacheJournal::Record> records;
+    if ( !m_journal.readRecords( records ) ) {
+        scanCache();
+        return;
+    }
+
+    foreach ( const TileCacheJournal::Record &record, records ) {
+        applyRecord( record );
+    }
+
+    compactJournal();
+}
+
+void FileStorageWatcherThread::compactJournal()
+{
+    if ( m_journal.recordCount() <= journalCompactionFactor * m_files.size() + maxFilesDelete )
+        return;
+
+    QVector<TileCacheJournal::Record> snapshot;
+    snapshot.reserve( m_files.size() );
+    QMultiMap<qint64, QString>::const_iterator it = m_filesCache.constBegin();
+    for ( ; it != m_filesCache.constEnd(); ++it ) {
+        TileCacheJournal::Record record;
+        record.type = TileCacheJournal::WriteRecord;
+        record.path = it.value();
+        record.size = m_files.value( it.value() ).second;
+        record.time = it.key();
+        snapshot.append( record );
+    }
+    m_journal.writeSnapshot( snapshot );
+}
+
+void FileStorageWatcherThread::scanCache()
+{
+    mDebug() << "FileStorageWatcher: Scanning the tile cache";
+    m_files.clear();
+    m_filesCache.clear();
+    m_currentCacheSize = 0;
+
+    QVector<TileCacheJournal::Record> snapshot;
     QString basePath = m_dataDirectory + "/maps";
     QDirIterator it( basePath,
                      QDir::Files | QDir::Writable,
                      QDirIterator::Subdirectories );
-    
-    int basePathDepth = basePath.split('/').size();
+
     while( it.hasNext() && !m_willQuit ) {
         it.next();
         QFileInfo file = it.fileInfo();
-        // We try to be very careful and just delete images
-        // FIXME, when vectortiling I suppose also vector tiles will have
-        // to be deleted
-        QString suffix = file.suffix().toLower();
-        QStringList path = file.path().split('/');
-
-        // planet/theme/tilelevel should be deeper than 4
-        if ( ( path.size() > basePathDepth + 3 ) &&
-             ( path[basePathDepth + 2].toInt() >= maxBaseTileLevel ) &&
-               ( ( suffix == "jpg"
-                || suffix == "png"
-                || suffix == "gif"
-                || suffix == "svg" ) ) ) {
-            dataSize += file.size();
-            m_filesCache.insert(file.lastModified(), file.absoluteFilePath());
+        const QString relativePath = m_journal.relativePath( file.absoluteFilePath() );
+
+        if ( TileCacheJournal::isTileFile( relativePath ) ) {
+            TileCacheJournal::Record record;
+            record.type = TileCacheJournal::WriteRecord;
+            record.path = relativePath;
+            record.size = file.size();
+            record.time = file.lastModified().toMSecsSinceEpoch();
+            applyRecord( record );
+            snapshot.append( record );
         }
     }
-    m_currentCacheSize = dataSize;
+
+    // An interrupted scan must not be taken for the full cache
+    if ( !m_willQuit ) {
+        m_journalAvailable = m_journal.writeSnapshot( snapshot );
+    }
+}
+
+void FileStorageWatcherThread::applyRecord( const TileCacheJournal::Record &record )
+{
+    switch ( record.type ) {
+    case TileCacheJournal::WriteRecord:
+        removeFile( record.path );
+        m_files.insert( record.path, qMakePair( record.time, record.size ) );
+        m_filesCache.insert( record.time, record.path );
+        m_currentCacheSize += record.size;
+        break;
+    case TileCacheJournal::RemoveRecord:
+        removeFile( record.path );
+        break;
+    }
+}
+
+void FileStorageWatcherThread::removeFile( const QString &relativePath )
+{
+    QHash<QString, QPair<qint64, qint64> >::iterator it = m_files.find( relativePath );
+    if ( it == m_files.end() )
+        return;
+
+    m_filesCache.remove( it.value().first, relativePath );
+    m_currentCacheSize -= qMin<quint64>( m_currentCacheSize, it.value().second );
+    m_files.erase( it );
 }
 
 void FileStorageWatcherThread::ensureCacheSize()
@@ -132,22 +233,25 @@ void FileStorageWatcherThread::ensureCacheSize()
 	&& ( m_cacheSoftLimit != 0 )
     && !m_willQuit ) {
 
+        // Learn which files have been written since the journal was read
+        if ( m_reportedSize != 0 ) {
+            updateFromJournal();
+        }
+
         mDebug() << "Deleting extra cached tiles";
         // The counter for deleted files
         m_filesDeleted = 0;
         // We have not reached our soft limit, yet.
         m_deleting = true;
 
-        QMultiMap<QDateTime, QString>::iterator it= m_filesCache.begin();
-        while ( it != m_filesCache.end() &&
+        while ( !m_filesCache.isEmpty() &&
                 keepDeleting() ) {
-            QString filePath = it.value();
-            QFileInfo info( filePath );
+            const QString relativePath = m_filesCache.begin().value();
 
             m_filesDeleted++;
-            m_currentCacheSize -= info.size();
-            it = m_filesCache.erase(it);
-            QFile::remove( filePath );
+            removeFile( relativePath );
+            QFile::remove( m_dataDirectory + '/' + relativePath );
+            m_journal.recordRemoval( relativePath );
         }
 
         // We have deleted enough files.
@@ -261,7 +365,7 @@ void FileStorageWatcher::run()
         connect( this, SIGNAL(sizeChanged(qint64)),
                  m_thread, SLOT(addToCurrentSize(qint64)) );
         connect( this, SIGNAL(cleared()),
-                 m_thread, SLOT(resetCurrentSize()) );
+                 m_thread, SLOT(readJournal()) );
 
         // Make sure that we don't want to stop process.
         // The thread wouldn't exit from event loop.
@@ -13,8 +13,11 @@
 
 #include <QThread>
 #include <QMutex>
+#include <QHash>
 #include <QMultiMap>
-#include <QDateTime>
+#include <QPair>
+
+#include "TileCacheJournal.h"
 
 namespace Marble
 {
@@ -44,15 +47,16 @@ class FileStorageWatcherThread : public QObject
 	void setCacheLimit( quint64 bytes );
 	
 	/**
-	 * Add @p bytes to the current cache size.
-	 * So FileStorageWatcher is aware of the current cache size.
+	 * Adds @p bytes to the current cache size. The written files are
+	 * only read from the tile cache journal when tiles have to be deleted.
 	 */
 	void addToCurrentSize( qint64 bytes );
-	
+
 	/**
-	 * Setting current cache size to 0.
+	 * Applies the changes recorded in the tile cache journal since the
+	 * last call to the current cache size.
 	 */
-	void resetCurrentSize();
+	void readJournal();
 	
 	/**
 	 * Stop doing things that take a long time to quit.
@@ -60,7 +64,9 @@ class FileStorageWatcherThread : public QObject
 	void prepareQuit();
 	
 	/**
-	 * Getting the current size of the data stored on the disc
+	 * Getting the current size of the data stored on the disc.
+	 * This reads the tile cache journal and only scans the cache if the
+	 * journal is missing or corrupt.
 	 */
 	void getCurrentCacheSize();
 
@@ -78,11 +84,39 @@ class FileStorageWatcherThread : public QObject
 	 */
 	bool keepDeleting() const;
 	
+	/**
+	 * Rebuilds the cached files and the journal by walking the cache.
+	 */
+	void scanCache();
+	
+	/**
+	 * Replaces the journal by a snapshot of the cached files if it
+	 * contains too many outdated records.
+	 */
+	void compactJournal();
+	
+	/**
+	 * Replaces the sizes reported by addToCurrentSize() by the records
+	 * of the journal.
+	 */
+	void updateFromJournal();
+
+	void applyRecord( const TileCacheJournal::Record &record );
+	void removeFile( const QString &relativePath );
+	
 	QString m_dataDirectory;
-    QMultiMap<QDateTime,QString> m_filesCache;
+	TileCacheJournal m_journal;
+	// cached tiles by their relative path, with their time and size
+	QHash<QString, QPair<qint64, qint64> > m_files;
+	// cached tiles by their time, oldest first
+	QMultiMap<qint64, QString> m_filesCache;
+	// false if the journal could not be written, changes are not tracked then
+	bool m_journalAvailable;
     quint64 m_cacheLimit;
 	quint64 m_cacheSoftLimit;
     quint64 m_currentCacheSize;
+	// bytes added by addToCurrentSize() since the journal was read
+	qint64  m_reportedSize;
 	int     m_filesDeleted;
 	bool 	m_deleting;
 	QMutex	m_limitMutex;
@@ -119,13 +153,12 @@ class FileStorageWatcher : public QThread
 	void setCacheLimit( quint64 bytes );
 	
 	/**
-	 * Add @p bytes to the current cache size.
-	 * So FileStorageWatcher is aware of the current cache size.
+	 * Notifies the watcher that @p bytes have been added to the cache.
 	 */
 	void addToCurrentSize( qint64 bytes );
 	
 	/**
-	 * Setting current cache size to 0.
+	 * Notifies the watcher that the cache has been cleared.
 	 */
 	void resetCurrentSize();
 	
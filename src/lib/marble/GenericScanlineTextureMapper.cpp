@@ -23,6 +23,8 @@
 #include "GeoPainter.h"
 #include "MarbleDirs.h"
 #include "MarbleDebug.h"
+#include "JobGroup.h"
+#include "MarbleGlobal.h"
 #include "ScanlineTextureMapperContext.h"
 #include "StackedTileLoader.h"
 #include "TextureColorizer.h"
@@ -66,7 +68,6 @@ GenericScanlineTextureMapper::GenericScanlineTextureMapper( StackedTileLoader *t
     : TextureMapperInterface()
     , m_tileLoader( tileLoader )
     , m_radius( 0 )
-    , m_threadPool()
 {
 }
 
@@ -125,16 +126,15 @@ void GenericScanlineTextureMapper::mapTexture( const ViewportParams *viewport, i
     const int yBottom = ( yTop == 0 ) ? imageHeight - skip
                                       : yTop + radius + radius - skip;
 
-    const int numThreads = m_threadPool.maxThreadCount();
-    const int yStep = qCeil(qreal( yBottom - yTop ) / qreal(numThreads));
-    for ( int i = 0; i < numThreads; ++i ) {
-        const int yStart = yTop +  i      * yStep;
-        const int yEnd   = qMin(yBottom, yTop + (i + 1) * yStep);
+    JobGroup jobs( MarbleGlobal::getInstance()->threadPool() );
+    const int yStep = ScanlineTextureMapperContext::rowBandHeight( yBottom - yTop, jobs.maxThreadCount() );
+    for ( int yStart = yTop; yStart < yBottom; yStart += yStep ) {
+        const int yEnd = qMin( yBottom, yStart + yStep );
         QRunnable *const job = new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, yStart, yEnd );
-        m_threadPool.start( job );
+        jobs.start( job );
     }
 
-    m_threadPool.waitForDone();
+    jobs.waitForDone();
 
     m_tileLoader->cleanupTilehash();
 }
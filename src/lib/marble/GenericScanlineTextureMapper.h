@@ -14,7 +14,6 @@
 
 #include "TextureMapperInterface.h"
 
-#include <QtCore/QThreadPool>
 #include <QtGui/QImage>
 
 #include <MarbleGlobal.h>
@@ -44,7 +43,6 @@ class GenericScanlineTextureMapper : public TextureMapperInterface
     StackedTileLoader *const m_tileLoader;
     int m_radius;
     QImage m_canvasImage;
-    QThreadPool m_threadPool;
 };
 
 }
@@ -35,6 +35,7 @@
 #include "GeoDataCamera.h"
 #include "GeoDataStyle.h"
 #include "GeoDataTypes.h"
+#include "FeatureRegistry.h"
 #include "FileManager.h"
 #include "MarbleDebug.h"
 #include "MarblePlacemarkModel.h"
@@ -51,6 +52,7 @@ class Q_DECL_HIDDEN GeoDataTreeModel::Private {
     GeoDataDocument* m_rootDocument;
     bool             m_ownsRootDocument;
     QItemSelectionModel m_selectionModel;
+    FeatureRegistry  m_featureRegistry;
 };
 
 GeoDataTreeModel::Private::Private( QAbstractItemModel *model ) :
@@ -787,6 +789,11 @@ QItemSelectionModel *GeoDataTreeModel::selectionModel()
     return &d->m_selectionModel;
 }
 
+const FeatureRegistry *GeoDataTreeModel::featureRegistry() const
+{
+    return &d->m_featureRegistry;
+}
+
 int GeoDataTreeModel::addFeature( GeoDataContainer *parent, GeoDataFeature *feature, int row )
 {
     if ( parent && feature ) {
@@ -806,6 +813,7 @@ int GeoDataTreeModel::addFeature( GeoDataContainer *parent, GeoDataFeature *feat
             parent->insert( row, feature );
             d->checkParenting( parent );
             endInsertRows();
+            d->m_featureRegistry.addFeature( feature );
             emit added(feature);
         }
         else
@@ -826,6 +834,7 @@ bool GeoDataTreeModel::removeFeature( GeoDataContainer *parent, int row )
     if ( row<parent->size() ) {
         beginRemoveRows( index( parent ), row , row );
         GeoDataFeature *feature = parent->child( row );
+        d->m_featureRegistry.removeFeature( feature );
         parent->remove( row );
         emit removed(feature);
         endRemoveRows();
@@ -884,12 +893,14 @@ void GeoDataTreeModel::removeDocument( GeoDataDocument *document )
 void GeoDataTreeModel::setRootDocument( GeoDataDocument* document )
 {
     beginResetModel();
+    d->m_featureRegistry.clear();
     if ( d->m_ownsRootDocument ) {
         delete d->m_rootDocument;
     }
 
     d->m_ownsRootDocument = ( document == 0 );
     d->m_rootDocument = document ? document : new GeoDataDocument;
+    d->m_featureRegistry.addFeature( d->m_rootDocument );
     endResetModel();
 }
 
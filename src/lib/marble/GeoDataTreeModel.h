@@ -23,6 +23,7 @@ class GeoDataObject;
 class GeoDataDocument;
 class GeoDataFeature;
 class GeoDataContainer;
+class FeatureRegistry;
 class GeoDataTourPrimitive;
 
 
@@ -75,6 +76,12 @@ class MARBLE_EXPORT GeoDataTreeModel : public QAbstractItemModel
 
     QItemSelectionModel *selectionModel();
 
+    /**
+     * Returns the placemarks and ground overlays of the model, which is
+     * kept up to date as features are added and removed.
+     */
+    const FeatureRegistry *featureRegistry() const;
+
     GeoDataDocument *rootDocument();
 
 public Q_SLOTS:
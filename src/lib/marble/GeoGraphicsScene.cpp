@@ -21,39 +21,273 @@
 #include "GeoDataTypes.h"
 #include "GeoGraphicsItem.h"
 #include "TileId.h"
-#include "TileCoordsPyramid.h"
 #include "MarbleDebug.h"
-#include <QMap>
+
+#include <QBitArray>
 
 namespace Marble
 {
 
+/**
+ * A node of the quadtree the items are stored in. The root node covers the
+ * whole planet, the children of a node cover its quarters, just like the
+ * tiles of the next zoom level (see TileId::fromCoordinates()).
+ */
+class GeoGraphicsSceneNode
+{
+public:
+    explicit GeoGraphicsSceneNode( GeoGraphicsSceneNode *parent ) :
+        m_parent( parent ),
+        m_itemCount( 0 )
+    {
+        for ( int i = 0; i < 4; ++i ) {
+            m_children[i] = 0;
+        }
+    }
+
+    ~GeoGraphicsSceneNode()
+    {
+        qDeleteAll( m_items );
+        for ( int i = 0; i < 4; ++i ) {
+            delete m_children[i];
+        }
+    }
+
+    GeoGraphicsSceneNode *const m_parent;
+    GeoGraphicsSceneNode *m_children[4];
+
+    // Items which fit into this node but not into one of its children, sorted by z value
+    QList<GeoGraphicsItem*> m_items;
+
+    // Number of items in this node and all of its descendants
+    int m_itemCount;
+};
+
 class GeoGraphicsScenePrivate
 {
 public:
     GeoGraphicsScene *q;
     GeoGraphicsScenePrivate(GeoGraphicsScene *parent) :
-        q(parent)
+        q(parent),
+        m_root( new GeoGraphicsSceneNode( 0 ) ),
+        m_removedCount( 0 )
     {
     }
 
     ~GeoGraphicsScenePrivate()
     {
         q->clear();
+        delete m_root;
     }
 
-    QMap<TileId, QList<GeoGraphicsItem*> > m_items;
-    QMultiHash<const GeoDataFeature*, TileId> m_features;
+    GeoGraphicsSceneNode *m_root;
+    QMultiHash<const GeoDataFeature*, GeoGraphicsSceneNode*> m_features;
 
     // Stores the items which have been clicked;
     QList<GeoGraphicsItem*> m_selectedItems;
 
+    // All items and their decorations, stably sorted by z value. Removed
+    // items leave a null entry until new items are merged in.
+    QVector<GeoGraphicsItem*> m_drawOrder;
+    // The z values the entries of m_drawOrder have been sorted by
+    QVector<qreal> m_drawZValues;
+    QHash<const GeoGraphicsItem*, int> m_drawIndex;
+    int m_removedCount;
+
+    // Items added since the last update of the draw order. Removed items
+    // leave a null entry, m_pendingIndex maps the others to their entry.
+    QVector<GeoGraphicsItem*> m_pendingItems;
+    QHash<const GeoGraphicsItem*, int> m_pendingIndex;
+
+    // The entries of m_drawOrder to be returned by sortedItems()
+    QBitArray m_drawMarks;
+
     GeoDataStyle *highlightStyle(const GeoDataDocument *document, const GeoDataStyleMap &styleMap);
 
     void selectItem( GeoGraphicsItem *item );
     void applyHighlightStyle( GeoGraphicsItem *item, GeoDataStyle *style );
+
+    GeoGraphicsSceneNode *node( const TileId &key );
+    void removeEmptyNodes( GeoGraphicsSceneNode *node, int removedItems );
+
+    void updateDrawOrder();
+    void insertIntoDrawOrder( QVector<GeoGraphicsItem*> &items );
+    void removeFromDrawOrder( GeoGraphicsItem *item );
+    void removeDrawIndex( const GeoGraphicsItem *item );
+
+    template<class Visitor>
+    static void visitItems( const GeoGraphicsSceneNode *node, int level, int x, int y,
+                            qreal north, qreal south, qreal east, qreal west,
+                            int zoomLevel, Visitor &visitor );
 };
 
+GeoGraphicsSceneNode *GeoGraphicsScenePrivate::node( const TileId &key )
+{
+    GeoGraphicsSceneNode *node = m_root;
+    for ( int level = 1; level <= key.zoomLevel(); ++level ) {
+        const int shift = key.zoomLevel() - level;
+        const int child = ( ( key.y() >> shift ) & 1 ) * 2 + ( ( key.x() >> shift ) & 1 );
+        if ( !node->m_children[child] ) {
+            node->m_children[child] = new GeoGraphicsSceneNode( node );
+        }
+        node = node->m_children[child];
+    }
+
+    return node;
+}
+
+void GeoGraphicsScenePrivate::removeEmptyNodes( GeoGraphicsSceneNode *node, int removedItems )
+{
+    while ( node ) {
+        node->m_itemCount -= removedItems;
+        GeoGraphicsSceneNode *const parent = node->m_parent;
+
+        if ( node->m_itemCount == 0 && parent ) {
+            for ( int i = 0; i < 4; ++i ) {
+                if ( parent->m_children[i] == node ) {
+                    parent->m_children[i] = 0;
+                }
+            }
+            delete node;
+        }
+
+        node = parent;
+    }
+}
+
+void GeoGraphicsScenePrivate::updateDrawOrder()
+{
+    // Decorations are created on demand, so only ask for them when painting
+    QVector<GeoGraphicsItem*> items;
+    items.reserve( m_pendingIndex.size() );
+    foreach ( GeoGraphicsItem *item, m_pendingItems ) {
+        if ( !item ) {
+            continue;
+        }
+        items.append( item );
+        foreach ( GeoGraphicsItem *decoration, item->decorations() ) {
+            items.append( decoration );
+        }
+    }
+    m_pendingItems.clear();
+    m_pendingIndex.clear();
+
+    insertIntoDrawOrder( items );
+}
+
+void GeoGraphicsScenePrivate::insertIntoDrawOrder( QVector<GeoGraphicsItem*> &items )
+{
+    qStableSort( items.begin(), items.end(), GeoGraphicsItem::zValueLessThan );
+
+    // Merge the new items behind the ones of the same z value, dropping
+    // the entries of removed items
+    QVector<GeoGraphicsItem*> drawOrder;
+    drawOrder.reserve( m_drawOrder.size() - m_removedCount + items.size() );
+    QVector<GeoGraphicsItem*>::const_iterator newItem = items.constBegin();
+    foreach ( GeoGraphicsItem *item, m_drawOrder ) {
+        if ( !item ) {
+            continue;
+        }
+        for ( ; newItem != items.constEnd() && GeoGraphicsItem::zValueLessThan( *newItem, item ); ++newItem ) {
+            drawOrder.append( *newItem );
+        }
+        drawOrder.append( item );
+    }
+    for ( ; newItem != items.constEnd(); ++newItem ) {
+        drawOrder.append( *newItem );
+    }
+
+    // The items in front of the first change keep their index
+    int unchanged = 0;
+    const int common = qMin( drawOrder.size(), m_drawOrder.size() );
+    while ( unchanged < common && drawOrder[unchanged] == m_drawOrder[unchanged] ) {
+        ++unchanged;
+    }
+
+    m_drawIndex.reserve( drawOrder.size() );
+    m_drawZValues.resize( drawOrder.size() );
+    for ( int i = unchanged; i < drawOrder.size(); ++i ) {
+        m_drawIndex.insert( drawOrder[i], i );
+        m_drawZValues[i] = drawOrder[i]->zValue();
+    }
+
+    m_drawOrder.swap( drawOrder );
+    m_removedCount = 0;
+}
+
+void GeoGraphicsScenePrivate::removeFromDrawOrder( GeoGraphicsItem *item )
+{
+    QHash<const GeoGraphicsItem*, int>::iterator const pending = m_pendingIndex.find( item );
+    if ( pending != m_pendingIndex.end() ) {
+        m_pendingItems[pending.value()] = 0;
+        m_pendingIndex.erase( pending );
+        return;
+    }
+
+    removeDrawIndex( item );
+    foreach ( const GeoGraphicsItem *decoration, item->decorations() ) {
+        removeDrawIndex( decoration );
+    }
+}
+
+void GeoGraphicsScenePrivate::removeDrawIndex( const GeoGraphicsItem *item )
+{
+    QHash<const GeoGraphicsItem*, int>::iterator const it = m_drawIndex.find( item );
+    if ( it == m_drawIndex.end() ) {
+        return;
+    }
+
+    m_drawOrder[it.value()] = 0;
+    m_drawIndex.erase( it );
+    ++m_removedCount;
+}
+
+template<class Visitor>
+void GeoGraphicsScenePrivate::visitItems( const GeoGraphicsSceneNode *node, int level, int x, int y,
+                                          qreal north, qreal south, qreal east, qreal west,
+                                          int zoomLevel, Visitor &visitor )
+{
+    if ( node->m_itemCount == 0 ) {
+        return;
+    }
+
+    const qreal nodeWidth = 2 * M_PI / ( 1 << level );
+    const qreal nodeHeight = M_PI / ( 1 << level );
+    const qreal nodeWest = -M_PI + x * nodeWidth;
+    const qreal nodeEast = nodeWest + nodeWidth;
+    const qreal nodeNorth = M_PI / 2 - y * nodeHeight;
+    const qreal nodeSouth = nodeNorth - nodeHeight;
+
+    if ( nodeSouth > north || nodeNorth < south ) {
+        return;
+    }
+
+    // boxes crossing the date line cover [west, M_PI] and [-M_PI, east]
+    const bool crossesDateLine = west > east;
+    const bool intersectsLon = crossesDateLine ? ( nodeEast >= west || nodeWest <= east )
+                                               : ( nodeEast >= west && nodeWest <= east );
+    if ( !intersectsLon ) {
+        return;
+    }
+
+    foreach ( GeoGraphicsItem *item, node->m_items ) {
+        if ( item->minZoomLevel() <= zoomLevel && item->visible() ) {
+            visitor( item );
+        }
+    }
+
+    if ( level >= zoomLevel ) {
+        return;
+    }
+
+    for ( int i = 0; i < 4; ++i ) {
+        if ( node->m_children[i] ) {
+            visitItems( node->m_children[i], level + 1, 2 * x + ( i & 1 ), 2 * y + ( i >> 1 ),
+                        north, south, east, west, zoomLevel, visitor );
+        }
+    }
+}
+
 GeoDataStyle *GeoGraphicsScenePrivate::highlightStyle( const GeoDataDocument *document,
                                                        const GeoDataStyleMap &styleMap )
 {
@@ -92,61 +326,132 @@ GeoGraphicsScene::~GeoGraphicsScene()
     delete d;
 }
 
-QList< GeoGraphicsItem* > GeoGraphicsScene::items( const GeoDataLatLonBox &box, int zoomLevel ) const
+namespace
+{
+
+class ItemCollector
 {
-    if ( box.west() > box.east() ) {
-        // Handle boxes crossing the IDL by splitting it into two separate boxes
-        GeoDataLatLonBox left;
-        left.setWest( -M_PI );
-        left.setEast( box.east() );
-        left.setNorth( box.north() );
-        left.setSouth( box.south() );
-
-        GeoDataLatLonBox right;
-        right.setWest( box.west() );
-        right.setEast( M_PI );
-        right.setNorth( box.north() );
-        right.setSouth( box.south() );
-
-        QList< GeoGraphicsItem* > allItems = items( left, zoomLevel );
-        foreach( GeoGraphicsItem* item, items( right, zoomLevel ) ) {
-            if ( !allItems.contains( item ) ) {
-                allItems << item;
+public:
+    explicit ItemCollector( QList<GeoGraphicsItem*> *result ) :
+        m_result( result )
+    {
+    }
+
+    void operator()( GeoGraphicsItem *item )
+    {
+        m_result->append( item );
+    }
+
+private:
+    QList<GeoGraphicsItem*> *const m_result;
+};
+
+class DrawOrderMarker
+{
+public:
+    DrawOrderMarker( const QHash<const GeoGraphicsItem*, int> &drawIndex, const QVector<qreal> &zValues,
+                     QBitArray *marks, bool decorations ) :
+        m_drawIndex( drawIndex ),
+        m_zValues( zValues ),
+        m_marks( marks ),
+        m_decorations( decorations ),
+        m_count( 0 )
+    {
+    }
+
+    void operator()( GeoGraphicsItem *item )
+    {
+        mark( item );
+
+        if ( m_decorations ) {
+            foreach ( GeoGraphicsItem *decoration, item->decorations() ) {
+                mark( decoration );
             }
         }
-        return allItems;
     }
 
+    int count() const { return m_count; }
+
+    // Items missing in the draw order, e.g. decorations which have been
+    // created after their item was added to the draw order
+    QVector<GeoGraphicsItem*> &missingItems() { return m_missingItems; }
+
+    // Items whose z value has changed since they were sorted
+    const QVector<GeoGraphicsItem*> &movedItems() const { return m_movedItems; }
+
+private:
+    void mark( GeoGraphicsItem *item )
+    {
+        const int index = m_drawIndex.value( item, -1 );
+        if ( index < 0 ) {
+            m_missingItems.append( item );
+            return;
+        }
+
+        if ( m_zValues[index] != item->zValue() ) {
+            m_movedItems.append( item );
+            m_missingItems.append( item );
+            return;
+        }
+
+        m_marks->setBit( index );
+        ++m_count;
+    }
+
+    const QHash<const GeoGraphicsItem*, int> &m_drawIndex;
+    const QVector<qreal> &m_zValues;
+    QBitArray *const m_marks;
+    const bool m_decorations;
+    int m_count;
+    QVector<GeoGraphicsItem*> m_missingItems;
+    QVector<GeoGraphicsItem*> m_movedItems;
+};
+
+}
+
+QList< GeoGraphicsItem* > GeoGraphicsScene::items( const GeoDataLatLonBox &box, int zoomLevel ) const
+{
     QList< GeoGraphicsItem* > result;
-    QRect rect;
+
     qreal north, south, east, west;
     box.boundaries( north, south, east, west );
-    TileId key;
-
-    key = TileId::fromCoordinates( GeoDataCoordinates(west, north, 0), zoomLevel );
-    rect.setLeft( key.x() );
-    rect.setTop( key.y() );
-
-    key = TileId::fromCoordinates( GeoDataCoordinates(east, south, 0), zoomLevel );
-    rect.setRight( key.x() );
-    rect.setBottom( key.y() );
-    
-    TileCoordsPyramid pyramid( 0, zoomLevel );
-    pyramid.setBottomLevelCoords( rect );
-
-    for ( int level = pyramid.topLevel(); level <= pyramid.bottomLevel(); ++level ) {
-        QRect const coords = pyramid.coords( level );
-        int x1, y1, x2, y2;
-        coords.getCoords( &x1, &y1, &x2, &y2 );
-        for ( int x = x1; x <= x2; ++x ) {
-            for ( int y = y1; y <= y2; ++y ) {
-                const TileId tileId = TileId( 0, level, x, y );
-                foreach(GeoGraphicsItem *object, d->m_items.value( tileId )) {
-                    if (object->minZoomLevel() <= zoomLevel && object->visible()) {
-                        result.push_back(object);
-                    }
-                }
-            }
+
+    // Every node is visited at most once, so boxes crossing the date line
+    // don't produce duplicates.
+    ItemCollector collector( &result );
+    GeoGraphicsScenePrivate::visitItems( d->m_root, 0, 0, 0, north, south, east, west, zoomLevel, collector );
+
+    return result;
+}
+
+QVector<GeoGraphicsItem*> GeoGraphicsScene::sortedItems( const GeoDataLatLonBox &box, int zoomLevel, bool decorations ) const
+{
+    qreal north, south, east, west;
+    box.boundaries( north, south, east, west );
+
+    // merging also drops the entries of removed items
+    if ( !d->m_pendingItems.isEmpty() || d->m_removedCount > d->m_drawOrder.size() / 2 ) {
+        d->updateDrawOrder();
+    }
+
+    d->m_drawMarks.fill( false, d->m_drawOrder.size() );
+    DrawOrderMarker marker( d->m_drawIndex, d->m_drawZValues, &d->m_drawMarks, decorations );
+    GeoGraphicsScenePrivate::visitItems( d->m_root, 0, 0, 0, north, south, east, west, zoomLevel, marker );
+
+    if ( !marker.missingItems().isEmpty() ) {
+        // items whose z value has changed are sorted in again
+        foreach ( const GeoGraphicsItem *item, marker.movedItems() ) {
+            d->removeDrawIndex( item );
+        }
+        d->insertIntoDrawOrder( marker.missingItems() );
+        return sortedItems( box, zoomLevel, decorations );
+    }
+
+    QVector<GeoGraphicsItem*> result;
+    result.reserve( marker.count() );
+    for ( int i = 0, n = d->m_drawOrder.size(); i < n && result.size() < marker.count(); ++i ) {
+        if ( d->m_drawMarks.testBit( i ) ) {
+            result.append( d->m_drawOrder[i] );
         }
     }
 
@@ -177,10 +482,9 @@ void GeoGraphicsScene::applyHighlight( const QVector< GeoDataPlacemark* > &selec
      * items to use highlight style
      */
     foreach( const GeoDataPlacemark *placemark, selectedPlacemarks ) {
-        QList<TileId> tiles = d->m_features.values( placemark );
-        foreach( const TileId &tileId, tiles ) {
-            QList<GeoGraphicsItem*> clickedItems = d->m_items[tileId];
-            foreach ( GeoGraphicsItem *item, clickedItems ) {
+        QList<GeoGraphicsSceneNode*> nodes = d->m_features.values( placemark );
+        foreach( const GeoGraphicsSceneNode *node, nodes ) {
+            foreach ( GeoGraphicsItem *item, node->m_items ) {
                 if ( item->feature() == placemark ) {
                     GeoDataObject *parent = placemark->parent();
                     if ( parent ) {
@@ -224,14 +528,17 @@ void GeoGraphicsScene::applyHighlight( const QVector< GeoDataPlacemark* > &selec
 
 void GeoGraphicsScene::removeItem( const GeoDataFeature* feature )
 {
-    QList<TileId> keys = d->m_features.values( feature );
-    foreach( TileId key, keys ) {
-        QList< GeoGraphicsItem* >& tileList = d->m_items[key];
+    QList<GeoGraphicsSceneNode*> nodes = d->m_features.values( feature );
+    d->m_features.remove( feature );
+
+    foreach( GeoGraphicsSceneNode *node, nodes ) {
+        QList< GeoGraphicsItem* >& tileList = node->m_items;
         foreach( GeoGraphicsItem* item, tileList ) {
             if( item->feature() == feature ) {
-                d->m_features.remove( feature );
                 tileList.removeAll( item );
+                d->removeFromDrawOrder( item );
                 delete item;
+                d->removeEmptyNodes( node, 1 );
                 break;
             }
         }
@@ -240,11 +547,15 @@ void GeoGraphicsScene::removeItem( const GeoDataFeature* feature )
 
 void GeoGraphicsScene::clear()
 {
-    foreach(const QList<GeoGraphicsItem*> &list, d->m_items.values()) {
-        qDeleteAll(list);
-    }
-    d->m_items.clear();
+    delete d->m_root;
+    d->m_root = new GeoGraphicsSceneNode( 0 );
     d->m_features.clear();
+    d->m_drawOrder.clear();
+    d->m_drawZValues.clear();
+    d->m_drawIndex.clear();
+    d->m_removedCount = 0;
+    d->m_pendingItems.clear();
+    d->m_pendingIndex.clear();
 }
 
 void GeoGraphicsScene::addItem( GeoGraphicsItem* item )
@@ -262,10 +573,18 @@ void GeoGraphicsScene::addItem( GeoGraphicsItem* item )
 
     const TileId key = TileId::fromCoordinates( GeoDataCoordinates(west, north, 0), zoomLevel ); // same as GeoDataCoordinates(east, south, 0), see above
 
-    QList< GeoGraphicsItem* >& tileList = d->m_items[key];
+    GeoGraphicsSceneNode *const node = d->node( key );
+
+    QList< GeoGraphicsItem* >& tileList = node->m_items;
     QList< GeoGraphicsItem* >::iterator position = qLowerBound( tileList.begin(), tileList.end(), item, GeoGraphicsItem::zValueLessThan );
     tileList.insert( position, item );
-    d->m_features.insert( item->feature(), key );
+    d->m_features.insert( item->feature(), node );
+    d->m_pendingIndex.insert( item, d->m_pendingItems.size() );
+    d->m_pendingItems.append( item );
+
+    for ( GeoGraphicsSceneNode *parent = node; parent; parent = parent->m_parent ) {
+        ++parent->m_itemCount;
+    }
 }
 
 }
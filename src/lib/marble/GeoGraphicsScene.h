@@ -17,6 +17,7 @@
 
 #include <QObject>
 #include <QList>
+#include <QVector>
 #include <QColor>
 
 namespace Marble
@@ -71,6 +72,20 @@ public:
      */
     QList<GeoGraphicsItem *> items( const GeoDataLatLonBox &box, int maxZoomLevel ) const;
 
+    /**
+     * @brief Get the items in the specified Box in the order they are painted
+     *
+     * The z-order of all items is kept between calls. Items added since the
+     * last call are merged into it and removed ones are dropped, so unlike
+     * sorting the result of items() this only sorts the new items.
+     *
+     * @param box The box around the items.
+     * @param maxZoomLevel The max zoom level of tiling
+     * @param decorations Whether to include the decorations of the items.
+     * @return The items in the specified box, stably sorted by z value.
+     */
+    QVector<GeoGraphicsItem *> sortedItems( const GeoDataLatLonBox &box, int maxZoomLevel, bool decorations ) const;
+
     /**
      * @brief Get the list of items which belong to a placemark
      * that has been clicked.
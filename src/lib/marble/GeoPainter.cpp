@@ -785,7 +785,7 @@ void GeoPainter::drawPolygon ( const GeoDataPolygon & polygon,
         outlines << outerPolygons;
         setPen( QPen( Qt::NoPen ) );
 
-        QVector<GeoDataLinearRing> innerBoundaries = polygon.innerBoundaries();
+        const QVector<GeoDataLinearRing> &innerBoundaries = polygon.innerBoundaries();
         foreach( const GeoDataLinearRing& itInnerBoundary, innerBoundaries ) {
             QVector<QPolygonF*> innerPolygons;
             d->m_viewport->screenCoordinates( itInnerBoundary, innerPolygons );
@@ -40,6 +40,8 @@ class Q_DECL_HIDDEN HttpDownloadManager::Private
     void finishJob( const QByteArray&, const QString&, const QString& id );
     void requeue();
     void startRetryTimer();
+    void updateBulkDownloads();
+    QList<DownloadQueueSet *> allQueueSets() const;
 
     DownloadQueueSet *findQueues( const QString& hostName, const DownloadUsage usage );
 
@@ -138,8 +140,22 @@ void HttpDownloadManager::addDownloadPolicy( const DownloadPolicy& policy )
                            ( queueSet->downloadPolicy().key(), queueSet ));
 }
 
+void HttpDownloadManager::setViewport( const GeoDataLatLonBox &latLonBox, int tileZoomLevel )
+{
+    foreach ( DownloadQueueSet *queueSet, d->allQueueSets() ) {
+        queueSet->setViewport( latLonBox, tileZoomLevel );
+    }
+}
+
 void HttpDownloadManager::addJob( const QUrl& sourceUrl, const QString& destFileName,
                                   const QString &id, const DownloadUsage usage )
+{
+    addJob( sourceUrl, destFileName, id, usage, GeoDataLatLonBox(), -1 );
+}
+
+void HttpDownloadManager::addJob( const QUrl& sourceUrl, const QString& destFileName,
+                                  const QString &id, const DownloadUsage usage,
+                                  const GeoDataLatLonBox &tileLatLonBox, int tileZoomLevel )
 {
     if ( !d->m_acceptJobs ) {
         mDebug() << Q_FUNC_INFO << "Working offline, not adding job";
@@ -151,6 +167,7 @@ void HttpDownloadManager::addJob( const QUrl& sourceUrl, const QString& destFile
         HttpJob * const job = new HttpJob( sourceUrl, destFileName, id, &d->m_networkAccessManager );
         job->setUserAgentPluginId( "QNamNetworkPlugin" );
         job->setDownloadUsage( usage );
+        job->setTileArea( tileLatLonBox, tileZoomLevel );
         mDebug() << "adding job " << sourceUrl;
         queueSet->addJob( job );
     }
@@ -189,6 +206,39 @@ void HttpDownloadManager::Private::startRetryTimer()
         m_requeueTimer.start();
 }
 
+void HttpDownloadManager::Private::updateBulkDownloads()
+{
+    // Downloads for the viewport take precedence over bulk downloads
+    const QList<DownloadQueueSet *> queueSets = allQueueSets();
+
+    bool browsing = false;
+    foreach ( const DownloadQueueSet *queueSet, queueSets ) {
+        if ( queueSet->downloadPolicy().key().usage() == DownloadBrowse && queueSet->isBusy() ) {
+            browsing = true;
+            break;
+        }
+    }
+
+    foreach ( DownloadQueueSet *queueSet, queueSets ) {
+        if ( queueSet->downloadPolicy().key().usage() == DownloadBulk ) {
+            queueSet->setSuspended( browsing );
+        }
+    }
+}
+
+QList<DownloadQueueSet *> HttpDownloadManager::Private::allQueueSets() const
+{
+    QList<DownloadQueueSet *> result = m_defaultQueueSets.values();
+
+    QList<QPair<DownloadPolicyKey, DownloadQueueSet*> >::const_iterator pos = m_queueSets.constBegin();
+    QList<QPair<DownloadPolicyKey, DownloadQueueSet*> >::const_iterator const end = m_queueSets.constEnd();
+    for (; pos != end; ++pos ) {
+        result << (*pos).second;
+    }
+
+    return result;
+}
+
 void HttpDownloadManager::Private::connectDefaultQueueSets()
 {
     QMap<DownloadUsage, DownloadQueueSet *>::iterator pos = m_defaultQueueSets.begin();
@@ -208,6 +258,8 @@ void HttpDownloadManager::Private::connectQueueSet( DownloadQueueSet * queueSet
     connect( queueSet, SIGNAL(jobAdded()), m_downloadManager, SIGNAL(jobAdded()));
     connect( queueSet, SIGNAL(jobRemoved()), m_downloadManager, SIGNAL(jobRemoved()));
     connect( queueSet, SIGNAL(progressChanged(int,int)), m_downloadManager, SIGNAL(progressChanged(int,int)) );
+    connect( queueSet, SIGNAL(progressChanged(int,int)), m_downloadManager, SLOT(updateBulkDownloads()) );
+    connect( queueSet, SIGNAL(jobDropped(QString)), m_downloadManager, SIGNAL(downloadDropped(QString)) );
 }
 
 bool HttpDownloadManager::Private::hasDownloadPolicy( const DownloadPolicy& policy ) const
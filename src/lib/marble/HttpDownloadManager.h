@@ -29,6 +29,7 @@ namespace Marble
 
 class DownloadPolicy;
 class DownloadQueueSet;
+class GeoDataLatLonBox;
 class StoragePolicy;
 
 /**
@@ -66,6 +67,14 @@ class MARBLE_EXPORT HttpDownloadManager : public QObject
     void setDownloadEnabled( const bool enable );
     void addDownloadPolicy( const DownloadPolicy& );
 
+    /**
+     * Sets the area that is currently visible and the zoom level of the
+     * tiles shown. Waiting tile downloads are prioritized by their zoom
+     * level and their distance to the visible area, downloads of tiles that
+     * are out of sight are held back.
+     */
+    void setViewport( const GeoDataLatLonBox &latLonBox, int tileZoomLevel );
+
     static QByteArray userAgent(const QString &platform, const QString &plugin);
 
  public Q_SLOTS:
@@ -76,6 +85,13 @@ class MARBLE_EXPORT HttpDownloadManager : public QObject
     void addJob( const QUrl& sourceUrl, const QString& destFilename, const QString &id,
                  const DownloadUsage usage );
 
+    /**
+     * Adds a new job for a tile covering @p tileLatLonBox at @p tileZoomLevel,
+     * see setViewport().
+     */
+    void addJob( const QUrl& sourceUrl, const QString& destFilename, const QString &id,
+                 const DownloadUsage usage, const GeoDataLatLonBox &tileLatLonBox, int tileZoomLevel );
+
 
  Q_SIGNALS:
     void downloadComplete( QString, QString );
@@ -103,6 +119,12 @@ class MARBLE_EXPORT HttpDownloadManager : public QObject
       */
     void progressChanged( int active, int queued );
 
+    /**
+     * A queued download was dropped because it was held back for too long,
+     * see setViewport(). The initiator needs to add it again when needed.
+     */
+    void downloadDropped( QString initiatorId );
+
  private:
     Q_DISABLE_COPY( HttpDownloadManager )
 
@@ -112,6 +134,7 @@ class MARBLE_EXPORT HttpDownloadManager : public QObject
     Q_PRIVATE_SLOT( d, void finishJob( const QByteArray&, const QString&, const QString& id ) )
     Q_PRIVATE_SLOT( d, void requeue() )
     Q_PRIVATE_SLOT( d, void startRetryTimer() )
+    Q_PRIVATE_SLOT( d, void updateBulkDownloads() )
 };
 
 }
@@ -32,6 +32,8 @@ class Marble::HttpJobPrivate
     QString        m_initiatorId;
     int            m_trialsLeft;
     DownloadUsage  m_downloadUsage;
+    GeoDataLatLonBox m_tileLatLonBox;
+    int            m_tileZoomLevel;
     QString m_userAgent;
     QNetworkAccessManager *const m_networkAccessManager;
     QNetworkReply *m_networkReply;
@@ -44,6 +46,8 @@ HttpJobPrivate::HttpJobPrivate( const QUrl & sourceUrl, const QString & destFile
       m_initiatorId( id ),
       m_trialsLeft( 3 ),
       m_downloadUsage( DownloadBrowse ),
+      m_tileLatLonBox(),
+      m_tileZoomLevel( -1 ),
       // FIXME: remove initialization depending on if empty pluginId
       // results in valid user agent string
       m_userAgent( "unknown" ),
@@ -114,6 +118,22 @@ void HttpJob::setDownloadUsage( const DownloadUsage usage )
     d->m_downloadUsage = usage;
 }
 
+GeoDataLatLonBox HttpJob::tileLatLonBox() const
+{
+    return d->m_tileLatLonBox;
+}
+
+int HttpJob::tileZoomLevel() const
+{
+    return d->m_tileZoomLevel;
+}
+
+void HttpJob::setTileArea( const GeoDataLatLonBox &latLonBox, int zoomLevel )
+{
+    d->m_tileLatLonBox = latLonBox;
+    d->m_tileZoomLevel = zoomLevel;
+}
+
 void HttpJob::setUserAgentPluginId( const QString & pluginId ) const
 {
     d->m_userAgent = pluginId;
@@ -21,6 +21,7 @@
 #include <QNetworkReply>
 
 #include "MarbleGlobal.h"
+#include "GeoDataLatLonBox.h"
 
 #include "marble_export.h"
 
@@ -52,6 +53,15 @@ class MARBLE_EXPORT HttpJob: public QObject
     DownloadUsage downloadUsage() const;
     void setDownloadUsage( const DownloadUsage );
 
+    /**
+     * The area covered by the tile that is downloaded, used to prioritize
+     * the job according to the viewport. Jobs that don't download a tile
+     * have an empty area and a zoom level of -1.
+     */
+    GeoDataLatLonBox tileLatLonBox() const;
+    int tileZoomLevel() const;
+    void setTileArea( const GeoDataLatLonBox &latLonBox, int zoomLevel );
+
     void setUserAgentPluginId( const QString & pluginId ) const;
 
     QByteArray userAgent() const;
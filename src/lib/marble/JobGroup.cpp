@@ -0,0 +1,132 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "JobGroup.h"
+
+#include <QMutex>
+#include <QQueue>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+namespace Marble
+{
+
+class JobGroupPrivate
+{
+ public:
+    JobGroupPrivate();
+
+    /**
+     * Runs the next queued job on the calling thread.
+     * Must be called with m_mutex locked, returns false if the queue is empty.
+     */
+    bool runNext();
+
+    QMutex m_mutex;
+    QWaitCondition m_done;
+    QQueue<QRunnable *> m_queue;
+    int m_runningCount;
+};
+
+/**
+ * Started on the thread pool once per job of a group. Runs whatever job of
+ * the group is next in line, if waitForDone() has not run it already.
+ */
+class JobGroupWorker : public QRunnable
+{
+ public:
+    explicit JobGroupWorker( const QSharedPointer<JobGroupPrivate> &group );
+
+    virtual void run();
+
+ private:
+    const QSharedPointer<JobGroupPrivate> m_group;
+};
+
+JobGroupPrivate::JobGroupPrivate()
+    : m_runningCount( 0 )
+{
+}
+
+bool JobGroupPrivate::runNext()
+{
+    if ( m_queue.isEmpty() ) {
+        return false;
+    }
+
+    QRunnable *const job = m_queue.dequeue();
+    ++m_runningCount;
+    m_mutex.unlock();
+
+    const bool autoDelete = job->autoDelete();
+    job->run();
+    if ( autoDelete ) {
+        delete job;
+    }
+
+    m_mutex.lock();
+    --m_runningCount;
+    if ( m_runningCount == 0 ) {
+        m_done.wakeAll();
+    }
+
+    return true;
+}
+
+JobGroupWorker::JobGroupWorker( const QSharedPointer<JobGroupPrivate> &group )
+    : m_group( group )
+{
+}
+
+void JobGroupWorker::run()
+{
+    QMutexLocker locker( &m_group->m_mutex );
+    m_group->runNext();
+}
+
+JobGroup::JobGroup( QThreadPool *threadPool )
+    : m_threadPool( threadPool ),
+      d( new JobGroupPrivate )
+{
+}
+
+JobGroup::~JobGroup()
+{
+    waitForDone();
+}
+
+int JobGroup::maxThreadCount() const
+{
+    return m_threadPool->maxThreadCount();
+}
+
+void JobGroup::start( QRunnable *job )
+{
+    {
+        QMutexLocker locker( &d->m_mutex );
+        d->m_queue.enqueue( job );
+    }
+
+    m_threadPool->start( new JobGroupWorker( d ) );
+}
+
+void JobGroup::waitForDone()
+{
+    QMutexLocker locker( &d->m_mutex );
+
+    // help with the jobs the pool has not got to yet instead of idling
+    while ( d->runNext() ) {
+    }
+
+    while ( d->m_runningCount > 0 ) {
+        d->m_done.wait( &d->m_mutex );
+    }
+}
+
+}
@@ -0,0 +1,72 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_JOBGROUP_H
+#define MARBLE_JOBGROUP_H
+
+#include "marble_export.h"
+
+#include <QSharedPointer>
+
+class QRunnable;
+class QThreadPool;
+
+namespace Marble
+{
+
+class JobGroupPrivate;
+
+/**
+ * @brief A set of jobs that is run on a thread pool shared with other clients.
+ *
+ * QThreadPool::waitForDone() waits for all jobs of the pool, including the
+ * ones started by unrelated clients, and deadlocks when it is called from
+ * a job of the same pool. waitForDone() of a job group only waits for the
+ * jobs started by start(): jobs which have not been picked up by the pool
+ * yet are run on the calling thread, then it waits for the running ones.
+ *
+ * Jobs are deleted after they have been run if QRunnable::autoDelete() is
+ * set, as with QThreadPool.
+ */
+class MARBLE_EXPORT JobGroup
+{
+ public:
+    explicit JobGroup( QThreadPool *threadPool );
+
+    /**
+     * Waits for all jobs of the group, see waitForDone().
+     */
+    ~JobGroup();
+
+    /**
+     * Returns the maximum number of threads the jobs of the group run on.
+     */
+    int maxThreadCount() const;
+
+    /**
+     * Schedules @p job to be run on the thread pool.
+     */
+    void start( QRunnable *job );
+
+    /**
+     * Returns when all jobs started so far have been run.
+     */
+    void waitForDone();
+
+ private:
+    Q_DISABLE_COPY( JobGroup )
+
+    QThreadPool *const m_threadPool;
+
+    // shared with the pool workers, which may outlive the group
+    const QSharedPointer<JobGroupPrivate> d;
+};
+
+}
+
+#endif
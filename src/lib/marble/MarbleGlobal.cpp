@@ -45,6 +45,11 @@ MarbleLocale * MarbleGlobal::locale() const
     return &d->m_locale; 
 }
 
+QThreadPool * MarbleGlobal::threadPool() const
+{
+    return &d->m_threadPool;
+}
+
 MarbleGlobal::Profiles MarbleGlobal::profiles() const {
     return d->m_profiles;
 }
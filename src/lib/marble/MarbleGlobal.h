@@ -20,6 +20,8 @@
 #include "marble_export.h"
 #include "MarbleColors.h"
 
+class QThreadPool;
+
 // #define QT_STRICT_ITERATORS
 
 
@@ -289,6 +291,14 @@ class  MARBLE_EXPORT MarbleGlobal
     ~MarbleGlobal();
 
     MarbleLocale * locale() const;
+
+    /**
+     * Returns the thread pool for the CPU bound work of the library and the
+     * plugins, e.g. texture mapping or projecting geometries. All of them
+     * share it so that the threads don't oversubscribe the CPU cores.
+     * Start jobs through a JobGroup to wait for them.
+     */
+    QThreadPool * threadPool() const;
     
     enum Profile {
         Default = 0x0,
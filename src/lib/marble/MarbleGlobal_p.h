@@ -16,6 +16,8 @@
 #ifndef MARBLE_GLOBAL_P_H
 #define MARBLE_GLOBAL_P_H
 
+#include <QThreadPool>
+
 #include "MarbleLocale.h"
 
 #include "MarbleGlobal.h"
@@ -32,6 +34,8 @@ class MarbleGlobalPrivate
     virtual ~MarbleGlobalPrivate();
 
     MarbleLocale m_locale;
+
+    QThreadPool m_threadPool;
     
     MarbleGlobal::Profiles m_profiles;
 };
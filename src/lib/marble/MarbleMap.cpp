@@ -57,6 +57,7 @@
 #include "GeoDataFeature.h"
 #include "GeoDataStyle.h"
 #include "GeoDataStyleMap.h"
+#include "HttpDownloadManager.h"
 #include "LayerManager.h"
 #include "MapThemeManager.h"
 #include "MarbleDebug.h"
@@ -124,6 +125,8 @@ public:
 
     void updateTileLevel();
 
+    void updateDownloadViewport();
+
     MarbleMap *const q;
 
     // The model we are showing.
@@ -159,8 +162,8 @@ MarbleMapPrivate::MarbleMapPrivate( MarbleMap *parent, MarbleModel *model ) :
     m_layerManager( model, parent ),
     m_customPaintLayer( parent ),
     m_geometryLayer( model->treeModel() ),
-    m_textureLayer( model->downloadManager(), model->pluginManager(), model->sunLocator(), model->groundOverlayModel() ),
-    m_placemarkLayer( model->placemarkModel(), model->placemarkSelectionModel(), model->clock() ),
+    m_textureLayer( model->downloadManager(), model->pluginManager(), model->sunLocator(), model->treeModel()->featureRegistry() ),
+    m_placemarkLayer( model->treeModel()->featureRegistry(), model->placemarkSelectionModel(), model->clock() ),
     m_vectorTileLayer( model->downloadManager(), model->pluginManager(), model->treeModel() ),
     m_isLockedToSubSolarPoint( false ),
     m_isSubSolarPointIconVisible( false )
@@ -213,6 +216,11 @@ MarbleMapPrivate::MarbleMapPrivate( MarbleMap *parent, MarbleModel *model ) :
 
     QObject::connect( parent, SIGNAL(visibleLatLonAltBoxChanged(GeoDataLatLonAltBox)),
                       parent, SIGNAL(repaintNeeded()) );
+
+    QObject::connect( parent, SIGNAL(visibleLatLonAltBoxChanged(GeoDataLatLonAltBox)),
+                      parent, SLOT(updateDownloadViewport()) );
+    QObject::connect( parent, SIGNAL(tileLevelChanged(int)),
+                      parent, SLOT(updateDownloadViewport()) );
 }
 
 void MarbleMapPrivate::updateProperty( const QString &name, bool show )
@@ -328,6 +336,10 @@ void MarbleMap::setViewContext( ViewContext viewContext )
     d->m_viewParams.setViewContext( viewContext );
     emit viewContextChanged(viewContext);
 
+    // Display scaled ancestor tiles instead of decoding missing tiles while
+    // the view is animated
+    d->m_textureLayer.setAsynchronousLoading( viewContext == Animation );
+
     if ( d->m_viewParams.mapQuality() != oldQuality ) {
         // Update texture map during the repaint that follows:
         d->m_textureLayer.setNeedsUpdate();
@@ -750,6 +762,12 @@ void MarbleMapPrivate::updateTileLevel()
     emit q->tileLevelChanged(q->tileZoomLevel());
 }
 
+void MarbleMapPrivate::updateDownloadViewport()
+{
+    m_model->downloadManager()->setViewport( m_viewport.viewLatLonAltBox(), q->tileZoomLevel() );
+    m_model->fileManager()->setViewport( m_viewport.viewLatLonAltBox() );
+}
+
 // Used to be paintEvent()
 void MarbleMap::paint( GeoPainter &painter, const QRect &dirtyRect )
 {
@@ -94,6 +94,7 @@ class MarbleModelPrivate
           m_descendantProxy(),
           m_placemarkProxyModel(),
           m_placemarkSelectionModel( 0 ),
+          m_proxyModelsConnected( false ),
           m_fileManager( &m_treeModel, &m_pluginManager ),
           m_positionTracking( &m_treeModel ),
           m_trackedPlacemark( 0 ),
@@ -103,8 +104,6 @@ class MarbleModelPrivate
           m_workOffline( false ),
           m_elevationModel( &m_downloadManager, &m_pluginManager )
     {
-        m_descendantProxy.setSourceModel( &m_treeModel );
-
         m_placemarkProxyModel.setFilterFixedString( GeoDataTypes::GeoDataPlacemarkType );
         m_placemarkProxyModel.setFilterKeyColumn( 1 );
         m_placemarkProxyModel.setSourceModel( &m_descendantProxy );
@@ -114,6 +113,20 @@ class MarbleModelPrivate
         m_groundOverlayProxyModel.setSourceModel( &m_descendantProxy );
     }
 
+    /**
+     * @brief Connects the placemark and ground overlay proxy models to the tree model
+     *
+     * The layers use the feature registry of the tree model, so the proxy
+     * models only need to follow the tree model once somebody asks for them.
+     */
+    void connectProxyModels()
+    {
+        if ( !m_proxyModelsConnected ) {
+            m_descendantProxy.setSourceModel( &m_treeModel );
+            m_proxyModelsConnected = true;
+        }
+    }
+
     ~MarbleModelPrivate()
     {
         delete m_mapTheme;
@@ -175,6 +188,7 @@ class MarbleModelPrivate
 
     // Selection handling
     QItemSelectionModel      m_placemarkSelectionModel;
+    bool                     m_proxyModelsConnected;
 
     FileManager              m_fileManager;
 
@@ -541,21 +555,25 @@ const GeoDataTreeModel *MarbleModel::treeModel() const
 
 QAbstractItemModel *MarbleModel::placemarkModel()
 {
+    d->connectProxyModels();
     return &d->m_placemarkProxyModel;
 }
 
 const QAbstractItemModel *MarbleModel::placemarkModel() const
 {
+    d->connectProxyModels();
     return &d->m_placemarkProxyModel;
 }
 
 QAbstractItemModel *MarbleModel::groundOverlayModel()
 {
+    d->connectProxyModels();
     return &d->m_groundOverlayProxyModel;
 }
 
 const QAbstractItemModel *MarbleModel::groundOverlayModel() const
 {
+    d->connectProxyModels();
     return &d->m_groundOverlayProxyModel;
 }
 
@@ -678,6 +678,128 @@ void MarbleZipWriterPrivate::addEntry(EntryType type, const QString &fileName, c
     dirtyFileTree = true;
 }
 
+/*
+    A sequential device which inflates the data of one file in the archive
+    while it is read, so the uncompressed content is never held in memory
+    as a whole. It reads from the device of the zip reader that created it.
+*/
+class MarbleZipFileDevice : public QIODevice
+{
+public:
+    MarbleZipFileDevice(QIODevice *source, qint64 position, qint64 compressedSize,
+                        qint64 uncompressedSize, bool compressed)
+        : m_source(source),
+          m_position(position),
+          m_remaining(compressedSize),
+          m_available(uncompressedSize),
+          m_compressed(compressed),
+          m_finished(false)
+    {
+        m_stream.zalloc = (alloc_func)0;
+        m_stream.zfree = (free_func)0;
+        m_stream.opaque = (voidpf)0;
+        m_stream.next_in = Z_NULL;
+        m_stream.avail_in = 0;
+        m_initialized = !m_compressed || inflateInit2(&m_stream, -MAX_WBITS) == Z_OK;
+    }
+
+    ~MarbleZipFileDevice()
+    {
+        if (m_compressed && m_initialized)
+            inflateEnd(&m_stream);
+    }
+
+    bool isSequential() const
+    {
+        return true;
+    }
+
+    qint64 bytesAvailable() const
+    {
+        return QIODevice::bytesAvailable() + (m_finished ? 0 : qMax<qint64>(m_available, 1));
+    }
+
+    bool open(OpenMode mode)
+    {
+        if (!m_initialized || (mode & WriteOnly))
+            return false;
+        return QIODevice::open(mode);
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize)
+    {
+        if (m_finished)
+            return 0;
+
+        const qint64 chunkSize = 64 * 1024;
+        if (!m_compressed) {
+            m_source->seek(m_position);
+            qint64 const read = m_source->read(data, qMin(maxSize, m_remaining));
+            if (read < 0)
+                return -1;
+            m_position += read;
+            m_remaining -= read;
+            m_available -= read;
+            m_finished = m_remaining == 0 || read == 0;
+            return read;
+        }
+
+        m_stream.next_out = (Bytef*)data;
+        m_stream.avail_out = (uInt)qMin<qint64>(maxSize, 0x7fffffff);
+        uInt const requested = m_stream.avail_out;
+        while (m_stream.avail_out > 0 && !m_finished) {
+            if (m_stream.avail_in == 0 && m_remaining > 0) {
+                m_source->seek(m_position);
+                m_input = m_source->read(qMin(chunkSize, m_remaining));
+                if (m_input.isEmpty()) {
+                    setErrorString("QZip: Failed to read compressed data");
+                    return -1;
+                }
+                m_position += m_input.size();
+                m_remaining -= m_input.size();
+                m_stream.next_in = (Bytef*)m_input.data();
+                m_stream.avail_in = m_input.size();
+            }
+
+            int const res = ::inflate(&m_stream, Z_NO_FLUSH);
+            if (res == Z_STREAM_END) {
+                m_finished = true;
+            } else if (res != Z_OK) {
+                qWarning("QZip: Z_DATA_ERROR: Input data is corrupted");
+                setErrorString("QZip: Input data is corrupted");
+                m_finished = true;
+                return -1;
+            }
+        }
+
+        qint64 const produced = requested - m_stream.avail_out;
+        m_available -= produced;
+        return produced;
+    }
+
+    qint64 writeData(const char *data, qint64 maxSize)
+    {
+        Q_UNUSED(data);
+        Q_UNUSED(maxSize);
+        return -1;
+    }
+
+private:
+    QIODevice *const m_source;
+    // position of the next compressed byte in the source device
+    qint64 m_position;
+    // compressed bytes not read from the source device yet
+    qint64 m_remaining;
+    // uncompressed bytes not delivered yet according to the header
+    qint64 m_available;
+    bool const m_compressed;
+    bool m_initialized;
+    bool m_finished;
+    z_stream m_stream;
+    QByteArray m_input;
+};
+
 //////////////////////////////  Reader
 
 /*!
@@ -927,6 +1049,57 @@ QByteArray MarbleZipReader::fileData(const QString &fileName) const
     return QByteArray();
 }
 
+/*!
+    Returns a sequential device which delivers the uncompressed content of
+    \a fileName while it is read, or 0 if there is no such file or its
+    compression method is not supported. The device is opened already.
+
+    Unlike fileData() the content is inflated in small chunks, so large
+    files can be processed with little memory. The caller takes ownership
+    of the device, which must not be used after the reader is destroyed.
+*/
+QIODevice *MarbleZipReader::fileDevice(const QString &fileName) const
+{
+    d->scanFiles();
+    int i;
+    for (i = 0; i < d->fileHeaders.size(); ++i) {
+        if (QString::fromLocal8Bit(d->fileHeaders.at(i).file_name) == fileName)
+            break;
+    }
+    if (i == d->fileHeaders.size())
+        return 0;
+
+    FileHeader header = d->fileHeaders.at(i);
+
+    qint64 compressed_size = readUInt(header.h.compressed_size);
+    qint64 uncompressed_size = readUInt(header.h.uncompressed_size);
+    int start = readUInt(header.h.offset_local_header);
+
+    d->device->seek(start);
+    LocalFileHeader lh;
+    d->device->read((char *)&lh, sizeof(LocalFileHeader));
+    uint skip = readUShort(lh.file_name_length) + readUShort(lh.extra_field_length);
+    qint64 const position = d->device->pos() + skip;
+
+    int compression_method = readUShort(lh.compression_method);
+    if (compression_method != 0 && compression_method != 8) {
+        qWarning() << "QZip: Unknown compression method";
+        return 0;
+    }
+
+    if (compression_method == 0) {
+        compressed_size = qMin(compressed_size, uncompressed_size);
+    }
+
+    QIODevice *device = new MarbleZipFileDevice(d->device, position, compressed_size,
+                                                uncompressed_size, compression_method == 8);
+    if (!device->open(QIODevice::ReadOnly)) {
+        delete device;
+        return 0;
+    }
+    return device;
+}
+
 /*!
     Extracts the full contents of the zip file into \a destinationDir on
     the local filesystem.
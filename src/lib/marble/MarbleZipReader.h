@@ -113,6 +113,7 @@ public:
 
     FileInfo entryInfoAt(int index) const;
     QByteArray fileData(const QString &fileName) const;
+    QIODevice *fileDevice(const QString &fileName) const;
     bool extractAll(const QString &destinationDir) const;
 
     enum Status {
@@ -21,11 +21,10 @@
 #include <QRunnable>
 
 // Marble
-#include "GeoPainter.h"
 #include "MarbleDebug.h"
+#include "MarbleGlobal.h"
 #include "ScanlineTextureMapperContext.h"
 #include "StackedTileLoader.h"
-#include "TextureColorizer.h"
 #include "ViewportParams.h"
 #include "MathHelper.h"
 #include "AbstractProjection.h"
@@ -35,7 +34,7 @@ using namespace Marble;
 class MercatorScanlineTextureMapper::RenderJob : public QRunnable
 {
 public:
-    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom );
+    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom, int xLeft, int xRight );
 
     virtual void run();
 
@@ -47,72 +46,38 @@ private:
     const MapQuality m_mapQuality;
     const int m_yPaintedTop;
     const int m_yPaintedBottom;
+    const int m_xPaintedLeft;
+    const int m_xPaintedRight;
 };
 
-MercatorScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom )
+MercatorScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom, int xLeft, int xRight )
     : m_tileLoader( tileLoader ),
       m_tileLevel( tileLevel ),
       m_canvasImage( canvasImage ),
       m_viewport( viewport ),
       m_mapQuality( mapQuality ),
       m_yPaintedTop( yTop ),
-      m_yPaintedBottom( yBottom )
+      m_yPaintedBottom( yBottom ),
+      m_xPaintedLeft( xLeft ),
+      m_xPaintedRight( xRight )
 {
 }
 
 MercatorScanlineTextureMapper::MercatorScanlineTextureMapper( StackedTileLoader *tileLoader )
-    : TextureMapperInterface(),
-      m_tileLoader( tileLoader ),
-      m_radius( 0 ),
-      m_oldYPaintedTop( 0 )
+    : CylindricalScanlineTextureMapper( tileLoader )
 {
 }
 
-void MercatorScanlineTextureMapper::mapTexture( GeoPainter *painter,
-                                                const ViewportParams *viewport,
-                                                int tileZoomLevel,
-                                                const QRect &dirtyRect,
-                                                TextureColorizer *texColorizer )
+int MercatorScanlineTextureMapper::yCenterOffset( const ViewportParams *viewport ) const
 {
-    if ( m_canvasImage.size() != viewport->size() || m_radius != viewport->radius() ) {
-        const QImage::Format optimalFormat = ScanlineTextureMapperContext::optimalCanvasImageFormat( viewport );
+    const float rad2Pixel = (float)( 2 * viewport->radius() ) / M_PI;
 
-        if ( m_canvasImage.size() != viewport->size() || m_canvasImage.format() != optimalFormat ) {
-            m_canvasImage = QImage( viewport->size(), optimalFormat );
-        }
-
-        if ( !viewport->mapCoversViewport() ) {
-            m_canvasImage.fill( 0 );
-        }
-
-        m_radius = viewport->radius();
-        m_repaintNeeded = true;
-    }
-
-    if ( m_repaintNeeded ) {
-        mapTexture( viewport, tileZoomLevel, painter->mapQuality() );
-
-        if ( texColorizer ) {
-            texColorizer->colorize( &m_canvasImage, viewport, painter->mapQuality() );
-        }
-
-        m_repaintNeeded = false;
-    }
-
-    painter->drawImage( dirtyRect, m_canvasImage, dirtyRect );
+    return (int)( asinh( tan( viewport->centerLatitude() ) ) * rad2Pixel );
 }
 
-void MercatorScanlineTextureMapper::mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality )
+void MercatorScanlineTextureMapper::paintedRows( const ViewportParams *viewport, int *yPaintedTop, int *yPaintedBottom ) const
 {
-    // Reset backend
-    m_tileLoader->resetTilehash();
-
-    // Initialize needed constants:
-
-    const int imageHeight = m_canvasImage.height();
-
-    // Calculate y-range the represented by the center point, yTop and
-    // what actually can be painted
+    const int imageHeight = viewport->height();
 
     qreal realYTop, realYBottom, dummyX;
     GeoDataCoordinates yNorth(0, viewport->currentProjection()->maxLat(), 0);
@@ -120,40 +85,31 @@ void MercatorScanlineTextureMapper::mapTexture( const ViewportParams *viewport,
     viewport->screenCoordinates(yNorth, dummyX, realYTop );
     viewport->screenCoordinates(ySouth, dummyX, realYBottom );
 
-    const int yTop     = qBound(qreal(0.0), realYTop, qreal(imageHeight));
-    int yPaintedTop    = yTop;
-    int yPaintedBottom = qBound(qreal(0.0), realYBottom, qreal(imageHeight));
- 
-    yPaintedTop = qBound(0, yPaintedTop, imageHeight);
-    yPaintedBottom = qBound(0, yPaintedBottom, imageHeight);
-
-    const int numThreads = m_threadPool.maxThreadCount();
-    const int yStep = ( yPaintedBottom - yPaintedTop ) / numThreads;
-    for ( int i = 0; i < numThreads; ++i ) {
-        const int yStart = yPaintedTop +  i      * yStep;
-        const int yEnd   = yPaintedTop + (i + 1) * yStep;
-        QRunnable *const job = new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, yStart, yEnd );
-        m_threadPool.start( job );
-    }
-
-    // Remove unused lines
-    const int clearStart = ( yPaintedTop - m_oldYPaintedTop <= 0 ) ? yPaintedBottom : 0;
-    const int clearStop  = ( yPaintedTop - m_oldYPaintedTop <= 0 ) ? imageHeight  : yTop;
-
-    QRgb * const itClearBegin = (QRgb*)( m_canvasImage.scanLine( clearStart ) );
-    QRgb * const itClearEnd   = (QRgb*)( m_canvasImage.scanLine( clearStop ) );
-
-    for ( QRgb * it = itClearBegin; it < itClearEnd; ++it ) {
-        *(it) = 0;
-    }
+    *yPaintedTop    = qBound(qreal(0.0), realYTop, qreal(imageHeight));
+    *yPaintedBottom = qBound(qreal(0.0), realYBottom, qreal(imageHeight));
+}
 
-    m_threadPool.waitForDone();
+void MercatorScanlineTextureMapper::latitudeRows( qreal latTop, qreal latBottom, const ViewportParams *viewport, int *y1, int *y2 ) const
+{
+    const qint64  radius  = viewport->radius();
+    const qreal rad2Pixel = (qreal)( 2 * radius ) / M_PI;
 
-    m_oldYPaintedTop = yPaintedTop;
+    // Mercator y values of the latitudes
+    const qreal maxLat = viewport->currentProjection()->maxLat();
+    const qreal mercatorTop = asinh( tan( qBound( -maxLat, latTop, maxLat ) ) );
+    const qreal mercatorBottom = asinh( tan( qBound( -maxLat, latBottom, maxLat ) ) );
 
-    m_tileLoader->cleanupTilehash();
+    const int yCenter = viewport->height() / 2 + yCenterOffset( viewport );
+    *y1 = yCenter - (int)ceil( mercatorTop * rad2Pixel ) - 1;
+    *y2 = yCenter - (int)floor( mercatorBottom * rad2Pixel ) + 1;
 }
 
+QRunnable *MercatorScanlineTextureMapper::createRenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage,
+                                                           const ViewportParams *viewport, MapQuality mapQuality,
+                                                           int yTop, int yBottom, int xLeft, int xRight ) const
+{
+    return new RenderJob( tileLoader, tileLevel, canvasImage, viewport, mapQuality, yTop, yBottom, xLeft, xRight );
+}
 
 void MercatorScanlineTextureMapper::RenderJob::run()
 {
@@ -180,11 +136,11 @@ void MercatorScanlineTextureMapper::RenderJob::run()
 
     const int yCenterOffset = (int)( asinh( tan( centerLat ) ) * rad2Pixel  );
 
-    qreal leftLon = + centerLon - ( imageWidth / 2 * pixel2Rad );
+    qreal leftLon = + centerLon - ( imageWidth / 2 * pixel2Rad ) + m_xPaintedLeft * pixel2Rad;
     while ( leftLon < -M_PI ) leftLon += 2 * M_PI;
     while ( leftLon >  M_PI ) leftLon -= 2 * M_PI;
 
-    const int maxInterpolationPointX = n * (int)( imageWidth / n - 1 ) + 1;
+    const int maxInterpolationPointX = m_xPaintedLeft + n * (int)( ( m_xPaintedRight - m_xPaintedLeft ) / n - 1 ) + 1;
 
 
     // initialize needed variables that are modified during texture mapping:
@@ -196,16 +152,16 @@ void MercatorScanlineTextureMapper::RenderJob::run()
 
     for ( int y = m_yPaintedTop; y < m_yPaintedBottom; ++y ) {
 
-        QRgb * scanLine = (QRgb*)( m_canvasImage->scanLine( y ) );
+        QRgb * scanLine = (QRgb*)( m_canvasImage->scanLine( y ) ) + m_xPaintedLeft;
 
         qreal lon = leftLon;
         const qreal lat = gd ( ( (imageHeight / 2 + yCenterOffset) - y )
                     * pixel2Rad );
 
-        for ( int x = 0; x < imageWidth; ++x ) {
+        for ( int x = m_xPaintedLeft; x < m_xPaintedRight; ++x ) {
             // Prepare for interpolation
             bool interpolate = false;
-            if ( x > 0 && x <= maxInterpolationPointX ) {
+            if ( x > m_xPaintedLeft && x <= maxInterpolationPointX ) {
                 x += n - 1;
                 lon += (n - 1) * pixel2Rad;
                 interpolate = !printQuality;
@@ -226,7 +182,7 @@ void MercatorScanlineTextureMapper::RenderJob::run()
                 scanLine += ( n - 1 );
             }
 
-            if ( x < imageWidth ) {
+            if ( x < m_xPaintedRight ) {
                 if ( highQuality )
                     context.pixelValueF( lon, lat, scanLine );
                 else
@@ -242,9 +198,9 @@ void MercatorScanlineTextureMapper::RenderJob::run()
 
             const int pixelByteSize = m_canvasImage->bytesPerLine() / imageWidth;
 
-            memcpy( m_canvasImage->scanLine( y + 1 ),
-                    m_canvasImage->scanLine( y     ),
-                    imageWidth * pixelByteSize );
+            memcpy( m_canvasImage->scanLine( y + 1 ) + m_xPaintedLeft * pixelByteSize,
+                    m_canvasImage->scanLine( y     ) + m_xPaintedLeft * pixelByteSize,
+                    ( m_xPaintedRight - m_xPaintedLeft ) * pixelByteSize );
             ++y;
         }
     }
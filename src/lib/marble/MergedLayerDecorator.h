@@ -65,6 +65,12 @@ class MergedLayerDecorator
 
     StackedTile *updateTile( const StackedTile &stackedTile, const TileId &tileId, const QImage &tileImage );
 
+    /**
+     * Creates a new stacked tile from the texture tiles of @p stackedTile,
+     * applying the current decorations such as the sun shading again.
+     */
+    StackedTile *redecorateTile( const StackedTile &stackedTile );
+
     void downloadStackedTile( const TileId &id, DownloadUsage usage );
 
     void setShowSunShading( bool show );
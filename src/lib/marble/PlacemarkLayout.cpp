@@ -12,7 +12,6 @@
 
 #include "PlacemarkLayout.h"
 
-#include <QAbstractItemModel>
 #include <QList>
 #include <QPoint>
 #include <QVector>
@@ -22,6 +21,9 @@
 #include <QItemSelectionModel>
 #include <qmath.h>
 
+#include <algorithm>
+
+#include "FeatureRegistry.h"
 #include "GeoDataPlacemark.h"
 #include "GeoDataStyle.h"
 #include "GeoDataTypes.h"
@@ -54,19 +56,21 @@ namespace
 }
 
 namespace
-{   //Helper function that checks for available room for the label
-    bool hasRoomFor(const QVector<Marble::VisiblePlacemark*> & placemarks, const QRectF &labelRect)
+{
+    typedef QList<const Marble::GeoDataPlacemark*>::const_iterator PlacemarkIterator;
+
+    // The position within one of the sorted placemark lists merged by generateLayout()
+    struct MergeCursor
     {
-        // Check if there is another label or symbol that overlaps.
-        QVector<Marble::VisiblePlacemark*>::const_iterator beforeItEnd = placemarks.constEnd();
-        for ( QVector<Marble::VisiblePlacemark*>::ConstIterator beforeIt = placemarks.constBegin();
-              beforeIt != beforeItEnd; ++beforeIt )
-        {
-            if ( labelRect.intersects( (*beforeIt)->labelRect() ) ) {
-                return false;
-            }
-        }
-        return true;
+        PlacemarkIterator current;
+        PlacemarkIterator end;
+    };
+
+    // The heap functions of the STL keep the greatest element first, so
+    // reverse the layout order to get the first placemark on top.
+    bool mergeCursorGreater( const MergeCursor &left, const MergeCursor &right )
+    {
+        return placemarkLayoutOrderCompare( *right.current, *left.current );
     }
 }
 
@@ -165,13 +169,17 @@ QSet<GeoDataFeature::GeoDataVisualCategory> acceptedVisualCategories()
 }
 
 
-PlacemarkLayout::PlacemarkLayout( QAbstractItemModel  *placemarkModel,
+PlacemarkLayout::PlacemarkLayout( const FeatureRegistry *featureRegistry,
                                   QItemSelectionModel *selectionModel,
                                   MarbleClock *clock,
                                   QObject* parent )
     : QObject( parent ),
+      m_featureRegistry( featureRegistry ),
       m_selectionModel( selectionModel ),
       m_clock( clock ),
+      m_labelGridCellSize( 0 ),
+      m_labelGridColumns( 0 ),
+      m_labelGridRows( 0 ),
       m_acceptedVisualCategories( acceptedVisualCategories() ),
       m_showPlaces( false ),
       m_showCities( false ),
@@ -183,23 +191,20 @@ PlacemarkLayout::PlacemarkLayout( QAbstractItemModel  *placemarkModel,
       m_maxLabelHeight( 0 ),
       m_styleResetRequested( true )
 {
-    m_placemarkModel.setSourceModel( placemarkModel );
-    m_placemarkModel.setDynamicSortFilter( true );
-    m_placemarkModel.setSortRole( MarblePlacemarkModel::PopularityIndexRole );
-    m_placemarkModel.sort( 0, Qt::AscendingOrder );
+    updateHiddenCategories();
 
     connect( m_selectionModel,  SIGNAL( selectionChanged( QItemSelection,
                                                            QItemSelection) ),
              this,               SLOT(requestStyleReset()) );
 
-    connect( &m_placemarkModel, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
-             this, SLOT(resetCacheData()) );
-    connect( &m_placemarkModel, SIGNAL(rowsInserted(QModelIndex,int,int)),
-             this, SLOT(addPlacemarks(QModelIndex,int,int)) );
-    connect( &m_placemarkModel, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
-             this, SLOT(removePlacemarks(QModelIndex,int,int)) );
-    connect( &m_placemarkModel, SIGNAL(modelReset()),
+    connect( m_featureRegistry, SIGNAL(placemarksAdded(QVector<const GeoDataPlacemark*>)),
+             this, SLOT(addPlacemarks(QVector<const GeoDataPlacemark*>)) );
+    connect( m_featureRegistry, SIGNAL(placemarksAboutToBeRemoved(QVector<const GeoDataPlacemark*>)),
+             this, SLOT(removePlacemarks(QVector<const GeoDataPlacemark*>)) );
+    connect( m_featureRegistry, SIGNAL(cleared()),
              this, SLOT(resetCacheData()) );
+
+    addPlacemarks( m_featureRegistry->placemarks() );
 }
 
 PlacemarkLayout::~PlacemarkLayout()
@@ -210,36 +215,72 @@ PlacemarkLayout::~PlacemarkLayout()
 void PlacemarkLayout::setShowPlaces( bool show )
 {
     m_showPlaces = show;
+    updateHiddenCategories();
 }
 
 void PlacemarkLayout::setShowCities( bool show )
 {
     m_showCities = show;
+    updateHiddenCategories();
 }
 
 void PlacemarkLayout::setShowTerrain( bool show )
 {
     m_showTerrain = show;
+    updateHiddenCategories();
 }
 
 void PlacemarkLayout::setShowOtherPlaces( bool show )
 {
     m_showOtherPlaces = show;
+    updateHiddenCategories();
 }
 
 void PlacemarkLayout::setShowLandingSites( bool show )
 {
     m_showLandingSites = show;
+    updateHiddenCategories();
 }
 
 void PlacemarkLayout::setShowCraters( bool show )
 {
     m_showCraters = show;
+    updateHiddenCategories();
 }
 
 void PlacemarkLayout::setShowMaria( bool show )
 {
     m_showMaria = show;
+    updateHiddenCategories();
+}
+
+void PlacemarkLayout::updateHiddenCategories()
+{
+    m_hiddenCategories.fill( false, GeoDataFeature::LastIndex );
+
+    // Skip city marks if we're not showing cities.
+    if ( !m_showCities )
+        m_hiddenCategories.fill( true, GeoDataFeature::SmallCity, GeoDataFeature::Nation + 1 );
+
+    // Skip terrain marks if we're not showing terrain.
+    if ( !m_showTerrain )
+        m_hiddenCategories.fill( true, GeoDataFeature::Mountain, GeoDataFeature::OtherTerrain + 1 );
+
+    // Skip other places if we're not showing other places.
+    if ( !m_showOtherPlaces || !m_showPlaces )
+        m_hiddenCategories.fill( true, GeoDataFeature::GeographicPole, GeoDataFeature::Observatory + 1 );
+
+    // Skip landing sites if we're not showing landing sites.
+    if ( !m_showLandingSites )
+        m_hiddenCategories.fill( true, GeoDataFeature::MannedLandingSite, GeoDataFeature::UnmannedHardLandingSite + 1 );
+
+    // Skip craters if we're not showing craters.
+    if ( !m_showCraters )
+        m_hiddenCategories.setBit( GeoDataFeature::Crater );
+
+    // Skip maria if we're not showing maria.
+    if ( !m_showMaria )
+        m_hiddenCategories.setBit( GeoDataFeature::Mare );
 }
 
 void PlacemarkLayout::requestStyleReset()
@@ -280,16 +321,12 @@ int PlacemarkLayout::maxLabelHeight() const
 {
     int maxLabelHeight = 0;
 
-    for ( int i = 0; i < m_placemarkModel.rowCount(); ++i ) {
-        QModelIndex index = m_placemarkModel.index( i, 0 );
-        const GeoDataPlacemark *placemark = dynamic_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>(index.data( MarblePlacemarkModel::ObjectPointerRole ) ));
-        if ( placemark ) {
-            const GeoDataStyle* style = placemark->style();
-            QFont labelFont = style->labelStyle().scaledFont();
-            int textHeight = QFontMetrics( labelFont ).height();
-            if ( textHeight > maxLabelHeight )
-                maxLabelHeight = textHeight;
-        }
+    foreach ( const GeoDataPlacemark *placemark, m_featureRegistry->placemarks() ) {
+        const GeoDataStyle* style = placemark->style();
+        QFont labelFont = style->labelStyle().scaledFont();
+        int textHeight = QFontMetrics( labelFont ).height();
+        if ( textHeight > maxLabelHeight )
+            maxLabelHeight = textHeight;
     }
 
     //mDebug() <<"Detected maxLabelHeight: " << maxLabelHeight;
@@ -297,14 +334,10 @@ int PlacemarkLayout::maxLabelHeight() const
 }
 
 /// feed an internal QMap of placemarks with TileId as key when model changes
-void PlacemarkLayout::addPlacemarks( QModelIndex parent, int first, int last )
-{
-    Q_ASSERT( first < m_placemarkModel.rowCount() );
-    Q_ASSERT( last < m_placemarkModel.rowCount() );
-    for( int i=first; i<=last; ++i ) {
-        QModelIndex index = m_placemarkModel.index( i, 0, parent );
-        Q_ASSERT( index.isValid() );
-        const GeoDataPlacemark *placemark = static_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>(index.data( MarblePlacemarkModel::ObjectPointerRole ) ));
+void PlacemarkLayout::addPlacemarks( const QVector<const GeoDataPlacemark *> &placemarks )
+{
+    QHash<TileId, QList<const GeoDataPlacemark*> > addedPlacemarks;
+    foreach ( const GeoDataPlacemark *placemark, placemarks ) {
         const GeoDataCoordinates coordinates = placemarkIconCoordinates( placemark );
         if ( !coordinates.isValid() ) {
             continue;
@@ -322,20 +355,31 @@ void PlacemarkLayout::addPlacemarks( QModelIndex parent, int first, int last )
 
         int zoomLevel = placemark->zoomLevel();
         TileId key = TileId::fromCoordinates( coordinates, zoomLevel );
-        m_placemarkCache[key].append( placemark );
+        addedPlacemarks[key].append( placemark );
     }
+
+    // keep the placemarks of each tile in layout order, so generateLayout()
+    // just needs to merge the lists of the visible tiles. Only the added
+    // placemarks are sorted and then merged into the sorted list of the tile.
+    QHash<TileId, QList<const GeoDataPlacemark*> >::iterator it = addedPlacemarks.begin();
+    for ( ; it != addedPlacemarks.end(); ++it ) {
+        QList<const GeoDataPlacemark*> &added = it.value();
+        qSort( added.begin(), added.end(), placemarkLayoutOrderCompare );
+
+        QList<const GeoDataPlacemark*> &tilePlacemarks = m_placemarkCache[it.key()];
+        const int sortedCount = tilePlacemarks.size();
+        tilePlacemarks.append( added );
+        std::inplace_merge( tilePlacemarks.begin(), tilePlacemarks.begin() + sortedCount, tilePlacemarks.end(),
+                            placemarkLayoutOrderCompare );
+    }
+
     requestStyleReset();
     emit repaintNeeded();
 }
 
-void PlacemarkLayout::removePlacemarks( QModelIndex parent, int first, int last )
+void PlacemarkLayout::removePlacemarks( const QVector<const GeoDataPlacemark *> &placemarks )
 {
-    Q_ASSERT( first < m_placemarkModel.rowCount() );
-    Q_ASSERT( last < m_placemarkModel.rowCount() );
-    for( int i=first; i<=last; ++i ) {
-        QModelIndex index = m_placemarkModel.index( i, 0, parent );
-        Q_ASSERT( index.isValid() );
-        const GeoDataPlacemark *placemark = static_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>( index.data( MarblePlacemarkModel::ObjectPointerRole ) ));
+    foreach ( const GeoDataPlacemark *placemark, placemarks ) {
         const GeoDataCoordinates coordinates = placemarkIconCoordinates( placemark );
         if ( !coordinates.isValid() ) {
             continue;
@@ -356,12 +400,10 @@ void PlacemarkLayout::removePlacemarks( QModelIndex parent, int first, int last
 
 void PlacemarkLayout::resetCacheData()
 {
-    const int rowCount = m_placemarkModel.rowCount();
-
     m_osmIds.clear();
     m_placemarkCache.clear();
     requestStyleReset();
-    addPlacemarks( m_placemarkModel.index( 0, 0 ), 0, rowCount );
+    addPlacemarks( m_featureRegistry->placemarks() );
     emit repaintNeeded();
 }
 
@@ -420,7 +462,7 @@ QSet<TileId> PlacemarkLayout::visibleTiles( const ViewportParams *viewport )
 QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParams *viewport )
 {
     m_runtimeTrace.clear();
-    if ( m_placemarkModel.rowCount() <= 0 )
+    if ( m_featureRegistry->placemarks().isEmpty() )
         return QVector<VisiblePlacemark *>();
 
     if ( m_styleResetRequested ) {
@@ -431,9 +473,7 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
         return QVector<VisiblePlacemark *>();
     }
 
-    const int secnumber = viewport->height() / m_maxLabelHeight + 1;
-    m_rowsection.clear();
-    m_rowsection.resize(secnumber);
+    resetLabelGrid( viewport->size() );
 
     m_paintOrder.clear();
     m_labelArea = 0;
@@ -441,11 +481,25 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
     // First handle the selected placemarks as they have the highest priority.
 
     const QModelIndexList selectedIndexes = m_selectionModel->selection().indexes();
+    QVector<const GeoDataPlacemark*> selectedPlacemarks;
+    selectedPlacemarks.reserve( selectedIndexes.count() );
 
     for ( int i = 0; i < selectedIndexes.count(); ++i ) {
         const QModelIndex index = selectedIndexes.at( i );
         const GeoDataPlacemark *placemark = dynamic_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>(index.data( MarblePlacemarkModel::ObjectPointerRole ) ));
         Q_ASSERT(placemark);
+        selectedPlacemarks.append( placemark );
+    }
+
+    // for skipping the selected placemarks below without a linear search
+    QSet<const GeoDataPlacemark*> selectedPlacemarkSet;
+    selectedPlacemarkSet.reserve( selectedPlacemarks.size() );
+
+    foreach ( const GeoDataPlacemark *placemark, selectedPlacemarks ) {
+        selectedPlacemarkSet.insert( placemark );
+    }
+
+    foreach ( const GeoDataPlacemark *placemark, selectedPlacemarks ) {
         const GeoDataCoordinates coordinates = placemarkIconCoordinates( placemark );
 
         if ( !coordinates.isValid() ) {
@@ -471,19 +525,33 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
 
     }
 
-    // Now handle all other placemarks...
-
-    const QItemSelection selection = m_selectionModel->selection();
-
-    QList<TileId> tileIdList = visibleTiles( viewport ).toList();
-    qSort( tileIdList );
-    QList<const GeoDataPlacemark*> placemarkList;
-    foreach ( const TileId &tileId, tileIdList ) {
-        placemarkList += m_placemarkCache.value( tileId );
+    // Now handle all other placemarks in layout order by merging the
+    // sorted lists of the visible tiles.
+
+    QVector<MergeCursor> cursors;
+    int placemarkCount = 0;
+    foreach ( const TileId &tileId, visibleTiles( viewport ) ) {
+        QMap<TileId, QList<const GeoDataPlacemark*> >::const_iterator it = m_placemarkCache.constFind( tileId );
+        if ( it != m_placemarkCache.constEnd() && !it.value().isEmpty() ) {
+            const MergeCursor cursor = { it.value().constBegin(), it.value().constEnd() };
+            cursors.append( cursor );
+            placemarkCount += it.value().size();
+        }
     }
-    qSort(placemarkList.begin(), placemarkList.end(), placemarkLayoutOrderCompare);
+    std::make_heap( cursors.begin(), cursors.end(), mergeCursorGreater );
+
+    while ( !cursors.isEmpty() ) {
+        std::pop_heap( cursors.begin(), cursors.end(), mergeCursorGreater );
+        MergeCursor &cursor = cursors.last();
+        const GeoDataPlacemark *const placemark = *cursor.current;
+        ++cursor.current;
+        if ( cursor.current == cursor.end ) {
+            cursors.removeLast();
+        }
+        else {
+            std::push_heap( cursors.begin(), cursors.end(), mergeCursorGreater );
+        }
 
-    foreach ( const GeoDataPlacemark *placemark, placemarkList ) {
         const GeoDataCoordinates coordinates = placemarkIconCoordinates( placemark );
         if ( !coordinates.isValid() ) {
             continue;
@@ -507,62 +575,16 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
             continue;
         }
 
-        const GeoDataFeature::GeoDataVisualCategory visualCategory = placemark->visualCategory();
-
-        // Skip city marks if we're not showing cities.
-        if ( !m_showCities
-             && visualCategory >= GeoDataFeature::SmallCity
-             && visualCategory <= GeoDataFeature::Nation )
-            continue;
-
-        // Skip terrain marks if we're not showing terrain.
-        if ( !m_showTerrain
-             && visualCategory >= GeoDataFeature::Mountain
-             && visualCategory <= GeoDataFeature::OtherTerrain )
-            continue;
-
-        // Skip other places if we're not showing other places.
-        if ( !m_showOtherPlaces
-             && visualCategory >= GeoDataFeature::GeographicPole
-             && visualCategory <= GeoDataFeature::Observatory )
-            continue;
-
-        // Skip landing sites if we're not showing landing sites.
-        if ( !m_showLandingSites
-             && visualCategory >= GeoDataFeature::MannedLandingSite
-             && visualCategory <= GeoDataFeature::UnmannedHardLandingSite )
-            continue;
-
-        // Skip craters if we're not showing craters.
-        if ( !m_showCraters
-             && visualCategory == GeoDataFeature::Crater )
-            continue;
-
-        // Skip maria if we're not showing maria.
-        if ( !m_showMaria
-             && visualCategory == GeoDataFeature::Mare )
-            continue;
-
-        if ( !m_showPlaces
-             && visualCategory >= GeoDataFeature::GeographicPole
-             && visualCategory <= GeoDataFeature::Observatory )
+        if ( m_hiddenCategories.testBit( placemark->visualCategory() ) ) {
             continue;
+        }
 
         // We handled selected placemarks already, so we skip them here...
-        // Assuming that only a small amount of places is selected
-        // we check for the selected state after all other filters
-        bool isSelected = false;
-        foreach ( const QModelIndex &index, selection.indexes() ) {
-            const GeoDataPlacemark *mark = dynamic_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>(index.data( MarblePlacemarkModel::ObjectPointerRole ) ));
-            if (mark == placemark ) {
-                isSelected = true;
-                break;
-            }
-        }
-        if ( isSelected )
+        if ( selectedPlacemarkSet.contains( placemark ) ) {
             continue;
+        }
 
-        if( layoutPlacemark( placemark, x, y, isSelected ) ) {
+        if( layoutPlacemark( placemark, x, y, false ) ) {
             // Make sure not to draw more placemarks on the screen than
             // specified by placemarksOnScreenLimit().
             if ( placemarksOnScreenLimit( viewport->size() ) )
@@ -570,7 +592,7 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
         }
     }
 
-    m_runtimeTrace = QString("Placemarks: %1 Drawn: %2").arg( placemarkList.count() ).arg( m_paintOrder.size() );
+    m_runtimeTrace = QString("Placemarks: %1 Drawn: %2").arg( placemarkCount ).arg( m_paintOrder.size() );
     return m_paintOrder;
 }
 
@@ -616,14 +638,7 @@ bool PlacemarkLayout::layoutPlacemark( const GeoDataPlacemark *placemark, qreal
     mark->setLabelRect( labelRect );
 
     if ( !labelRect.isEmpty() ) {
-        // Add the current placemark to the matching row and its
-        // direct neighbors.
-        int idx = y / m_maxLabelHeight;
-        if ( idx - 1 >= 0 )
-            m_rowsection[ idx - 1 ].append( mark );
-        m_rowsection[ idx ].append( mark );
-        if ( idx + 1 < m_rowsection.size() )
-            m_rowsection[ idx + 1 ].append( mark );
+        addToLabelGrid( labelRect );
     }
 
     m_paintOrder.append( mark );
@@ -662,8 +677,6 @@ QRectF PlacemarkLayout::roomForLabel( const GeoDataStyle * style,
         textWidth = ( QFontMetrics( labelFont ).width( labelText ) );
     }
 
-    const QVector<VisiblePlacemark*> currentsec = m_rowsection.at( y / m_maxLabelHeight );
-
     if ( style->labelStyle().alignment() == GeoDataLabelStyle::Corner ) {
         const int symbolWidth = style->iconStyle().scaledIcon().size().width();
 
@@ -675,7 +688,7 @@ QRectF PlacemarkLayout::roomForLabel( const GeoDataStyle * style,
                                               y - textHeight;
             const QRectF labelRect = QRectF( xPos, yPos, textWidth, textHeight );
 
-            if (hasRoomFor(currentsec, labelRect)) {
+            if (hasRoomFor( labelRect )) {
                 // claim the place immediately if it hasn't been used yet
                 return labelRect;
             }
@@ -686,7 +699,7 @@ QRectF PlacemarkLayout::roomForLabel( const GeoDataStyle * style,
         QRectF  labelRect( x - textWidth / 2, offsetY + y - textHeight / 2,
                           textWidth, textHeight );
 
-        if (hasRoomFor(currentsec, labelRect)) {
+        if (hasRoomFor( labelRect )) {
             // claim the place immediately if it hasn't been used yet 
             return labelRect;
         }
@@ -705,7 +718,7 @@ QRectF PlacemarkLayout::roomForLabel( const GeoDataStyle * style,
 
             const QRectF labelRect = QRectF(xPos, yPos, textWidth, textHeight);
 
-            if (hasRoomFor(currentsec, labelRect))
+            if (hasRoomFor( labelRect ))
             {
                 return labelRect;
             }
@@ -716,6 +729,65 @@ QRectF PlacemarkLayout::roomForLabel( const GeoDataStyle * style,
                      // for the rectangle anymore.
 }
 
+void PlacemarkLayout::resetLabelGrid( const QSize &screenSize )
+{
+    // Labels are about a line high and a few lines wide, so cells of two
+    // lines cover most labels with one to four cells.
+    m_labelGridCellSize = qMax( 1, 2 * m_maxLabelHeight );
+    m_labelGridColumns = screenSize.width() / m_labelGridCellSize + 1;
+    m_labelGridRows = screenSize.height() / m_labelGridCellSize + 1;
+
+    const int cellCount = m_labelGridColumns * m_labelGridRows;
+    if ( m_labelGrid.size() < cellCount ) {
+        m_labelGrid.resize( cellCount );
+    }
+
+    // resize() keeps the memory of the cells for the next layout
+    for ( int i = 0; i < cellCount; ++i ) {
+        m_labelGrid[i].resize( 0 );
+    }
+}
+
+QRect PlacemarkLayout::labelGridCells( const QRectF &labelRect ) const
+{
+    // Labels partially outside of the screen are sorted into the border cells.
+    const int left   = qBound( 0, int( labelRect.left() ) / m_labelGridCellSize, m_labelGridColumns - 1 );
+    const int right  = qBound( 0, int( labelRect.right() ) / m_labelGridCellSize, m_labelGridColumns - 1 );
+    const int top    = qBound( 0, int( labelRect.top() ) / m_labelGridCellSize, m_labelGridRows - 1 );
+    const int bottom = qBound( 0, int( labelRect.bottom() ) / m_labelGridCellSize, m_labelGridRows - 1 );
+
+    return QRect( QPoint( left, top ), QPoint( right, bottom ) );
+}
+
+void PlacemarkLayout::addToLabelGrid( const QRectF &labelRect )
+{
+    const QRect cells = labelGridCells( labelRect );
+
+    for ( int row = cells.top(); row <= cells.bottom(); ++row ) {
+        for ( int column = cells.left(); column <= cells.right(); ++column ) {
+            m_labelGrid[row * m_labelGridColumns + column].append( labelRect );
+        }
+    }
+}
+
+bool PlacemarkLayout::hasRoomFor( const QRectF &labelRect ) const
+{
+    // Check if there is another label that overlaps.
+    const QRect cells = labelGridCells( labelRect );
+
+    for ( int row = cells.top(); row <= cells.bottom(); ++row ) {
+        for ( int column = cells.left(); column <= cells.right(); ++column ) {
+            foreach ( const QRectF &otherRect, m_labelGrid[row * m_labelGridColumns + column] ) {
+                if ( labelRect.intersects( otherRect ) ) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
 bool PlacemarkLayout::placemarksOnScreenLimit( const QSize &screenSize ) const
 {
     int ratio = ( m_labelArea * 100 ) / ( screenSize.width() * screenSize.height() );
@@ -18,16 +18,15 @@
 #define MARBLE_PLACEMARKLAYOUT_H
 
 
+#include <QBitArray>
 #include <QHash>
 #include <QModelIndex>
 #include <QRect>
 #include <QSet>
 #include <QVector>
-#include <QSortFilterProxyModel>
 
 #include "GeoDataFeature.h"
 
-class QAbstractItemModel;
 class QItemSelectionModel;
 class QPoint;
 
@@ -35,6 +34,7 @@ class QPoint;
 namespace Marble
 {
 
+class FeatureRegistry;
 class GeoDataCoordinates;
 class GeoDataPlacemark;
 class GeoDataStyle;
@@ -59,7 +59,7 @@ class PlacemarkLayout : public QObject
     /**
      * Creates a new place mark layout.
      */
-    PlacemarkLayout( QAbstractItemModel  *placemarkModel,
+    PlacemarkLayout( const FeatureRegistry *featureRegistry,
                      QItemSelectionModel *selectionModel,
                      MarbleClock *clock,
                      QObject *parent = 0 );
@@ -94,8 +94,8 @@ class PlacemarkLayout : public QObject
     void setShowMaria( bool show );
 
     void requestStyleReset();
-    void addPlacemarks( QModelIndex index, int first, int last );
-    void removePlacemarks( QModelIndex index, int first, int last );
+    void addPlacemarks( const QVector<const GeoDataPlacemark *> &placemarks );
+    void removePlacemarks( const QVector<const GeoDataPlacemark *> &placemarks );
     void resetCacheData();
 
  Q_SIGNALS:
@@ -113,6 +113,8 @@ class PlacemarkLayout : public QObject
 
     void styleReset();
 
+    void updateHiddenCategories();
+
     static QSet<TileId> visibleTiles( const ViewportParams *viewport );
     bool layoutPlacemark( const GeoDataPlacemark *placemark, qreal x, qreal y, bool selected );
 
@@ -127,11 +129,16 @@ class PlacemarkLayout : public QObject
                          const qreal x, const qreal y,
                          const QString &labelText ) const;
 
+    void resetLabelGrid( const QSize &screenSize );
+    void addToLabelGrid( const QRectF &labelRect );
+    bool hasRoomFor( const QRectF &labelRect ) const;
+    QRect labelGridCells( const QRectF &labelRect ) const;
+
     bool    placemarksOnScreenLimit( const QSize &screenSize ) const;
 
  private:
     Q_DISABLE_COPY( PlacemarkLayout )
-    QSortFilterProxyModel  m_placemarkModel;
+    const FeatureRegistry *const m_featureRegistry;
     QItemSelectionModel *const m_selectionModel;
     MarbleClock *const m_clock;
 
@@ -139,9 +146,14 @@ class PlacemarkLayout : public QObject
     QString m_runtimeTrace;
     int m_labelArea;
     QHash<const GeoDataPlacemark*, VisiblePlacemark*> m_visiblePlacemarks;
-    QVector< QVector< VisiblePlacemark* > >  m_rowsection;
 
-    /// map providing the list of placemark belonging in TileId as key
+    /// label rects of the visible placemarks, sorted into the cells of a uniform grid
+    QVector< QVector<QRectF> > m_labelGrid;
+    int m_labelGridCellSize;
+    int m_labelGridColumns;
+    int m_labelGridRows;
+
+    /// map providing the list of placemark belonging in TileId as key, sorted in layout order
     QMap<TileId, QList<const GeoDataPlacemark*> > m_placemarkCache;
     QSet<qint64> m_osmIds;
 
@@ -158,6 +170,9 @@ class PlacemarkLayout : public QObject
     bool m_showCraters;
     bool m_showMaria;
 
+    /// visual categories of placemarks which are not shown
+    QBitArray m_hiddenCategories;
+
     int     m_maxLabelHeight;
     bool    m_styleResetRequested;
 };
@@ -0,0 +1,19 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "PlacemarkSource.h"
+
+namespace Marble
+{
+
+PlacemarkSource::~PlacemarkSource()
+{
+    // nothing to do
+}
+
+}
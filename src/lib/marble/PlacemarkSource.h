@@ -0,0 +1,44 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_PLACEMARKSOURCE_H
+#define MARBLE_PLACEMARKSOURCE_H
+
+#include "marble_export.h"
+
+#include <QVector>
+
+namespace Marble
+{
+
+class GeoDataLatLonBox;
+class GeoDataPlacemark;
+
+/**
+ * @brief Interface of documents that create their placemarks on demand.
+ *
+ * A parsing runner may return a GeoDataDocument that also implements this
+ * interface instead of creating all placemarks of a large file up front.
+ * The FileManager asks the document for the placemarks of the visible
+ * region whenever the viewport changes and adds them to the document.
+ */
+class MARBLE_EXPORT PlacemarkSource
+{
+public:
+    virtual ~PlacemarkSource();
+
+    /**
+     * Creates the placemarks in @p box that have not been created before.
+     * The caller takes ownership of the placemarks.
+     */
+    virtual QVector<GeoDataPlacemark*> createPlacemarks( const GeoDataLatLonBox &box ) = 0;
+};
+
+}
+
+#endif
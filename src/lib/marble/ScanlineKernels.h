@@ -0,0 +1,200 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_SCANLINEKERNELS_H
+#define MARBLE_SCANLINEKERNELS_H
+
+#include <cmath>
+
+#include "Quaternion.h"
+
+// The SSE2 code paths require qreal to be double
+#if defined( __SSE2__ ) && !defined( QT_COORD_TYPE )
+#define MARBLE_SCANLINE_SSE2
+#include <emmintrin.h>
+#endif
+
+/**
+ * Batch routines of the scanline texture mappers.
+ *
+ * Each routine processes a whole run of pixels of a scanline. Where SSE2 is
+ * available it handles two (coordinates) or four (tile positions) pixels at
+ * once, the ...Scalar() variants are the reference implementations which are
+ * used for the remaining pixels and on other architectures.
+ */
+
+namespace Marble
+{
+
+/**
+ * Converts the points ( qx[i], qy, qz ) on the unit sphere that share the
+ * same y coordinate qy into spherical coordinates after rotating them by
+ * planetAxisMatrix. This is equivalent to Quaternion::rotateAroundAxis()
+ * followed by Quaternion::getSpherical() for each point, except that the
+ * latitude is determined by atan2(), which is precise near the poles, too.
+ */
+inline void sphericalCoordinatesScalar( const qreal *qx, int count, qreal qy,
+                                        const matrix &planetAxisMatrix,
+                                        qreal *lon, qreal *lat )
+{
+    const qreal qr = 1.0 - qy * qy;
+
+    // the contribution of qy to the rotated vector is the same for all points
+    const qreal cx = planetAxisMatrix[1][0] * qy;
+    const qreal cy = planetAxisMatrix[1][1] * qy;
+    const qreal cz = planetAxisMatrix[1][2] * qy;
+
+    for ( int i = 0; i < count; ++i ) {
+        const qreal qr2z = qr - qx[i] * qx[i];
+        const qreal qz = ( qr2z > 0.0 ) ? sqrt( qr2z ) : 0.0;
+
+        const qreal rx = planetAxisMatrix[0][0] * qx[i] + cx + planetAxisMatrix[2][0] * qz;
+        const qreal ry = planetAxisMatrix[0][1] * qx[i] + cy + planetAxisMatrix[2][1] * qz;
+        const qreal rz = planetAxisMatrix[0][2] * qx[i] + cz + planetAxisMatrix[2][2] * qz;
+
+        const qreal rxz2 = rx * rx + rz * rz;
+        lat[i] = atan2( ry, sqrt( rxz2 ) );
+        lon[i] = ( rxz2 > 0.00005 ) ? atan2( rx, rz ) : 0.0;
+    }
+}
+
+#if defined( MARBLE_SCANLINE_SSE2 )
+
+// Selects a where mask is set and b otherwise
+inline __m128d blendSse2( __m128d mask, __m128d a, __m128d b )
+{
+    return _mm_or_pd( _mm_and_pd( mask, a ), _mm_andnot_pd( mask, b ) );
+}
+
+// atan2() of two pairs of values, the error is below 1e-15.
+// The arguments are reduced to [0, 0.66] and the arctangent is evaluated
+// by the rational approximation of the Cephes math library.
+inline __m128d atan2Sse2( __m128d y, __m128d x )
+{
+    const __m128d signMask = _mm_set1_pd( -0.0 );
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd( 1.0 );
+
+    const __m128d ax = _mm_andnot_pd( signMask, x );
+    const __m128d ay = _mm_andnot_pd( signMask, y );
+
+    // atan2( y, x ) = pi/2 - atan( x / y ) for |y| > |x|
+    const __m128d swap = _mm_cmpgt_pd( ay, ax );
+    const __m128d den = _mm_max_pd( ax, ay );
+    // 0 / 0 for x = y = 0 results in 0
+    const __m128d t = _mm_and_pd( _mm_cmpgt_pd( den, zero ), _mm_div_pd( _mm_min_pd( ax, ay ), den ) );
+
+    // atan( t ) = pi/4 + atan( ( t - 1 ) / ( t + 1 ) ) for t > 0.66
+    const __m128d large = _mm_cmpgt_pd( t, _mm_set1_pd( 0.66 ) );
+    const __m128d u = blendSse2( large, _mm_div_pd( _mm_sub_pd( t, one ), _mm_add_pd( t, one ) ), t );
+    const __m128d offset = _mm_and_pd( large, _mm_set1_pd( M_PI / 4 ) );
+
+    const __m128d z = _mm_mul_pd( u, u );
+    __m128d p = _mm_set1_pd( -8.750608600031904122785E-1 );
+    p = _mm_add_pd( _mm_mul_pd( p, z ), _mm_set1_pd( -1.615753718733365076637E1 ) );
+    p = _mm_add_pd( _mm_mul_pd( p, z ), _mm_set1_pd( -7.500855792314704667340E1 ) );
+    p = _mm_add_pd( _mm_mul_pd( p, z ), _mm_set1_pd( -1.228866684490136173410E2 ) );
+    p = _mm_add_pd( _mm_mul_pd( p, z ), _mm_set1_pd( -6.485021904942025371773E1 ) );
+    __m128d q = _mm_add_pd( z, _mm_set1_pd( 2.485846490142306297962E1 ) );
+    q = _mm_add_pd( _mm_mul_pd( q, z ), _mm_set1_pd( 1.650270098316988542046E2 ) );
+    q = _mm_add_pd( _mm_mul_pd( q, z ), _mm_set1_pd( 4.328810604912902668951E2 ) );
+    q = _mm_add_pd( _mm_mul_pd( q, z ), _mm_set1_pd( 4.853903996359136964868E2 ) );
+    q = _mm_add_pd( _mm_mul_pd( q, z ), _mm_set1_pd( 1.945506571482613964425E2 ) );
+
+    __m128d result = _mm_add_pd( offset, _mm_add_pd( u, _mm_div_pd( _mm_mul_pd( _mm_mul_pd( u, z ), p ), q ) ) );
+
+    result = blendSse2( swap, _mm_sub_pd( _mm_set1_pd( M_PI / 2 ), result ), result );
+    result = blendSse2( _mm_cmplt_pd( x, zero ), _mm_sub_pd( _mm_set1_pd( M_PI ), result ), result );
+
+    // the result is not negative so far
+    return _mm_or_pd( result, _mm_and_pd( signMask, y ) );
+}
+
+#endif
+
+/**
+ * Same as sphericalCoordinatesScalar(), but processes two points at once
+ * where SSE2 is available.
+ */
+inline void sphericalCoordinates( const qreal *qx, int count, qreal qy,
+                                  const matrix &planetAxisMatrix,
+                                  qreal *lon, qreal *lat )
+{
+    int i = 0;
+
+#if defined( MARBLE_SCANLINE_SSE2 )
+    const __m128d vqr = _mm_set1_pd( 1.0 - qy * qy );
+    const __m128d vzero = _mm_setzero_pd();
+    const __m128d vcx = _mm_set1_pd( planetAxisMatrix[1][0] * qy );
+    const __m128d vcy = _mm_set1_pd( planetAxisMatrix[1][1] * qy );
+    const __m128d vcz = _mm_set1_pd( planetAxisMatrix[1][2] * qy );
+    const __m128d m00 = _mm_set1_pd( planetAxisMatrix[0][0] );
+    const __m128d m01 = _mm_set1_pd( planetAxisMatrix[0][1] );
+    const __m128d m02 = _mm_set1_pd( planetAxisMatrix[0][2] );
+    const __m128d m20 = _mm_set1_pd( planetAxisMatrix[2][0] );
+    const __m128d m21 = _mm_set1_pd( planetAxisMatrix[2][1] );
+    const __m128d m22 = _mm_set1_pd( planetAxisMatrix[2][2] );
+    const __m128d minimumRxz2 = _mm_set1_pd( 0.00005 );
+
+    for ( ; i + 1 < count; i += 2 ) {
+        const __m128d vx = _mm_loadu_pd( qx + i );
+        const __m128d vz = _mm_sqrt_pd( _mm_max_pd( _mm_sub_pd( vqr, _mm_mul_pd( vx, vx ) ), vzero ) );
+
+        const __m128d rx = _mm_add_pd( _mm_add_pd( _mm_mul_pd( m00, vx ), vcx ), _mm_mul_pd( m20, vz ) );
+        const __m128d ry = _mm_add_pd( _mm_add_pd( _mm_mul_pd( m01, vx ), vcy ), _mm_mul_pd( m21, vz ) );
+        const __m128d rz = _mm_add_pd( _mm_add_pd( _mm_mul_pd( m02, vx ), vcz ), _mm_mul_pd( m22, vz ) );
+
+        const __m128d rxz2 = _mm_add_pd( _mm_mul_pd( rx, rx ), _mm_mul_pd( rz, rz ) );
+        _mm_storeu_pd( lat + i, atan2Sse2( ry, _mm_sqrt_pd( rxz2 ) ) );
+        _mm_storeu_pd( lon + i, _mm_and_pd( _mm_cmpgt_pd( rxz2, minimumRxz2 ), atan2Sse2( rx, rz ) ) );
+    }
+#endif
+
+    sphericalCoordinatesScalar( qx + i, count - i, qy, planetAxisMatrix, lon + i, lat + i );
+}
+
+/**
+ * Computes the tile pixel positions of the pixels 1 ... count along a line
+ * with the fixed point (7 fractional bits) start position @p start and the
+ * step @p step: position[j - 1] = ( ( ( start + j * step ) >> 7 ) + offset ) >> shift.
+ */
+inline void tilePositionsScalar( int start, int step, int offset, int shift, int count, int *position )
+{
+    for ( int j = 1; j <= count; ++j ) {
+        position[j - 1] = ( ( ( start + j * step ) >> 7 ) + offset ) >> shift;
+    }
+}
+
+/**
+ * Same as tilePositionsScalar(), but processes four pixels at once where
+ * SSE2 is available.
+ */
+inline void tilePositions( int start, int step, int offset, int shift, int count, int *position )
+{
+    int j = 0;
+
+#if defined( MARBLE_SCANLINE_SSE2 )
+    __m128i fixedPosition = _mm_add_epi32( _mm_set1_epi32( start ),
+                                           _mm_setr_epi32( step, 2 * step, 3 * step, 4 * step ) );
+    const __m128i fixedStep = _mm_set1_epi32( 4 * step );
+    const __m128i vOffset = _mm_set1_epi32( offset );
+    const __m128i vShift = _mm_cvtsi32_si128( shift );
+
+    for ( ; j + 3 < count; j += 4 ) {
+        const __m128i pixel = _mm_add_epi32( _mm_srai_epi32( fixedPosition, 7 ), vOffset );
+        _mm_storeu_si128( reinterpret_cast<__m128i *>( position + j ), _mm_sra_epi32( pixel, vShift ) );
+        fixedPosition = _mm_add_epi32( fixedPosition, fixedStep );
+    }
+#endif
+
+    tilePositionsScalar( start + j * step, step, offset, shift, count - j, position + j );
+}
+
+}
+
+#endif
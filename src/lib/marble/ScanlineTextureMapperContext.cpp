@@ -11,9 +11,13 @@
 
 #include "ScanlineTextureMapperContext.h"
 
+#include <cstring>
+
 #include <QImage>
+#include <QVarLengthArray>
 
 #include "MarbleDebug.h"
+#include "ScanlineKernels.h"
 #include "StackedTile.h"
 #include "StackedTileLoader.h"
 #include "TileId.h"
@@ -308,15 +312,13 @@ void ScanlineTextureMapperContext::pixelValueApprox( const qreal lon, const qrea
                 isOutOfTileRange( itLon, itLat, itStepLon, itStepLat, n );
                                   
         if ( !alwaysCheckTileRange ) {
-            int iPosXf = itLon;
-            int iPosYf = itLat;
-            for ( int j = 1; j < n; ++j ) {
-                iPosXf += itStepLon;
-                iPosYf += itStepLat;
-                *scanLine = m_tile->pixel( ( ( iPosXf >> 7 ) + m_vTileStartX ) >> m_deltaLevel,
-                                           ( ( iPosYf >> 7 ) + m_vTileStartY ) >> m_deltaLevel );
-                ++scanLine;
-            }
+            // The whole run lies on the current tile: determine all tile
+            // positions at once and fetch the pixels in a single pass
+            QVarLengthArray<int, 64> posX( n - 1 );
+            QVarLengthArray<int, 64> posY( n - 1 );
+            tilePositions( itLon, itStepLon, m_vTileStartX, m_deltaLevel, n - 1, posX.data() );
+            tilePositions( itLat, itStepLat, m_vTileStartY, m_deltaLevel, n - 1, posY.data() );
+            m_tile->pixels( posX.constData(), posY.constData(), n - 1, scanLine );
         }        
         else {
             for ( int j = 1; j < n; ++j ) {
@@ -439,6 +441,59 @@ QImage::Format ScanlineTextureMapperContext::optimalCanvasImageFormat( const Vie
 }
 
 
+int ScanlineTextureMapperContext::rowBandHeight( int rowCount, int threadCount )
+{
+    const int bandsPerThread = 8;
+    const int minimumBandHeight = 8;
+
+    const int bandHeight = qMax( minimumBandHeight, rowCount / ( qMax( 1, threadCount ) * bandsPerThread ) );
+
+    return bandHeight + ( bandHeight % 2 );
+}
+
+
+void ScanlineTextureMapperContext::scrollImage( QImage *image, int dx, int dy )
+{
+    const int imageWidth = image->width();
+    const int imageHeight = image->height();
+
+    if ( qAbs( dx ) >= imageWidth || qAbs( dy ) >= imageHeight ) {
+        image->fill( 0 );
+        return;
+    }
+
+    const int pixelByteSize = image->bytesPerLine() / imageWidth;
+    const int copyWidth = imageWidth - qAbs( dx );
+    const int sourceX = qMax( 0, -dx );
+    const int targetX = qMax( 0, dx );
+    const int clearX = ( dx > 0 ) ? 0 : copyWidth;
+
+    // Iterate against the direction of the shift, so that no row is
+    // overwritten before it has been moved.
+    const int yFirst = ( dy > 0 ) ? imageHeight - 1 : 0;
+    const int yLast  = ( dy > 0 ) ? 0 : imageHeight - 1;
+    const int yInc   = ( dy > 0 ) ? -1 : 1;
+
+    for ( int y = yFirst; y != yLast + yInc; y += yInc ) {
+        uchar *const target = image->scanLine( y );
+        const int sourceY = y - dy;
+
+        if ( sourceY < 0 || sourceY >= imageHeight ) {
+            memset( target, 0, imageWidth * pixelByteSize );
+            continue;
+        }
+
+        if ( sourceY != y || dx != 0 ) {
+            const uchar *const source = image->constScanLine( sourceY );
+            memmove( target + targetX * pixelByteSize,
+                     source + sourceX * pixelByteSize,
+                     copyWidth * pixelByteSize );
+            memset( target + clearX * pixelByteSize, 0, qAbs( dx ) * pixelByteSize );
+        }
+    }
+}
+
+
 void ScanlineTextureMapperContext::nextTile( int &posX, int &posY )
 {
     // Move from tile coordinates to global texture coordinates 
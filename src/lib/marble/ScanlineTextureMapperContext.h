@@ -46,6 +46,23 @@ public:
 
     static QImage::Format optimalCanvasImageFormat( const ViewportParams *viewport );
 
+    /**
+     * Returns the number of scanlines that should be rendered by a single job.
+     *
+     * The canvas is split into many more bands than there are threads, so that
+     * threads which are done with cheap bands (e.g. off the globe or near the
+     * poles) pick up remaining bands instead of idling. The band height is
+     * even, so interlaced rendering never splits a pair of scanlines.
+     */
+    static int rowBandHeight( int rowCount, int threadCount );
+
+    /**
+     * Moves the content of @p image by @p dx pixels to the right and @p dy
+     * pixels downwards. The area that is uncovered is filled with
+     * transparent black.
+     */
+    static void scrollImage( QImage *image, int dx, int dy );
+
     int globalWidth() const;
     int globalHeight() const;
 
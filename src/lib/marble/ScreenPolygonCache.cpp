@@ -0,0 +1,135 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "ScreenPolygonCache.h"
+
+#include <algorithm>
+
+#include <QRunnable>
+
+#include "AbstractProjection.h"
+#include "GeoDataLineString.h"
+#include "JobGroup.h"
+#include "MarbleGlobal.h"
+#include "ViewportParams.h"
+
+namespace Marble
+{
+
+class ScreenPolygonCache::ProjectionJob : public QRunnable
+{
+public:
+    ProjectionJob( ScreenPolygonCache *cache, const ViewportParams *viewport, int begin, int end )
+        : m_cache( cache ),
+          m_viewport( viewport ),
+          m_begin( begin ),
+          m_end( end )
+    {
+    }
+
+    virtual void run()
+    {
+        m_cache->projectRange( m_viewport, m_begin, m_end );
+    }
+
+private:
+    ScreenPolygonCache *const m_cache;
+    const ViewportParams *const m_viewport;
+    const int m_begin;
+    const int m_end;
+};
+
+ScreenPolygonCache::ScreenPolygonCache()
+    : m_size( 0 )
+{
+}
+
+ScreenPolygonCache::~ScreenPolygonCache()
+{
+}
+
+void ScreenPolygonCache::clear()
+{
+    // resize() keeps the allocated memory, clear() would release it
+    m_lineStrings.resize( 0 );
+    m_size = 0;
+}
+
+void ScreenPolygonCache::addLineString( const GeoDataLineString *lineString )
+{
+    // The bounding box is calculated on demand, make sure this happens
+    // here rather than concurrently in the projection jobs.
+    lineString->latLonAltBox();
+
+    m_lineStrings.append( lineString );
+}
+
+void ScreenPolygonCache::project( const ViewportParams *viewport )
+{
+    std::sort( m_lineStrings.begin(), m_lineStrings.end() );
+    m_size = std::unique( m_lineStrings.begin(), m_lineStrings.end() ) - m_lineStrings.begin();
+    m_lineStrings.resize( m_size );
+
+    if ( m_entries.size() < m_size ) {
+        m_entries.resize( m_size );
+    }
+
+    JobGroup jobs( MarbleGlobal::getInstance()->threadPool() );
+    const int jobsPerThread = 4;
+    const int minimumJobSize = 16;
+    const int jobSize = qMax( minimumJobSize, m_size / ( qMax( 1, jobs.maxThreadCount() ) * jobsPerThread ) );
+
+    if ( m_size <= jobSize ) {
+        projectRange( viewport, 0, m_size );
+        return;
+    }
+
+    for ( int begin = 0; begin < m_size; begin += jobSize ) {
+        jobs.start( new ProjectionJob( this, viewport, begin, qMin( begin + jobSize, m_size ) ) );
+    }
+
+    jobs.waitForDone();
+}
+
+bool ScreenPolygonCache::screenCoordinates( const GeoDataLineString &lineString, QVector<QPolygonF*> &polygons, bool &result ) const
+{
+    const GeoDataLineString *const *const end = m_lineStrings.constData() + m_size;
+    const GeoDataLineString *const *const position = std::lower_bound( m_lineStrings.constData(), end, &lineString );
+    if ( position == end || *position != &lineString ) {
+        return false;
+    }
+
+    const Entry &entry = m_entries.at( position - m_lineStrings.constData() );
+    foreach ( const QPolygonF &polygon, entry.polygons ) {
+        polygons << new QPolygonF( polygon );
+    }
+    result = entry.result;
+
+    return true;
+}
+
+void ScreenPolygonCache::projectRange( const ViewportParams *viewport, int begin, int end )
+{
+    const AbstractProjection *const projection = viewport->currentProjection();
+    QVector<QPolygonF*> polygons;
+
+    for ( int i = begin; i < end; ++i ) {
+        Entry &entry = m_entries[i];
+
+        polygons.resize( 0 );
+        entry.result = projection->screenCoordinates( *m_lineStrings.at( i ), viewport, polygons );
+
+        entry.polygons.resize( 0 );
+        foreach ( QPolygonF *polygon, polygons ) {
+            entry.polygons.append( *polygon );
+        }
+        qDeleteAll( polygons );
+    }
+}
+
+}
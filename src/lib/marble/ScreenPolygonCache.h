@@ -0,0 +1,85 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_SCREENPOLYGONCACHE_H
+#define MARBLE_SCREENPOLYGONCACHE_H
+
+#include <QPolygonF>
+#include <QVector>
+
+namespace Marble
+{
+
+class GeoDataLineString;
+class ViewportParams;
+
+/**
+ * @brief Screen polygons of line strings, projected in advance on several threads.
+ *
+ * The line strings to be painted in a frame are collected by addLineString()
+ * and projected at once by project(). While the cache is set on the
+ * viewport (see ViewportParams::setScreenPolygonCache()), painting a
+ * collected line string just copies its polygons, which are implicitly
+ * shared, instead of projecting it again.
+ *
+ * The entries and their polygon vectors are kept by clear(), so their
+ * memory is reused from frame to frame.
+ */
+class ScreenPolygonCache
+{
+ public:
+    ScreenPolygonCache();
+    ~ScreenPolygonCache();
+
+    /**
+     * Removes all line strings from the cache.
+     */
+    void clear();
+
+    /**
+     * Adds @p lineString to the line strings to be projected by project().
+     * Line strings may be added several times.
+     */
+    void addLineString( const GeoDataLineString *lineString );
+
+    /**
+     * Projects all line strings added since the last clear() for @p viewport
+     * and returns when all of them are done.
+     */
+    void project( const ViewportParams *viewport );
+
+    /**
+     * Appends copies of the screen polygons of @p lineString to @p polygons.
+     * @return false if @p lineString has not been projected by project(),
+     *         otherwise @p result is set to the result of the projection.
+     */
+    bool screenCoordinates( const GeoDataLineString &lineString, QVector<QPolygonF*> &polygons, bool &result ) const;
+
+ private:
+    Q_DISABLE_COPY( ScreenPolygonCache )
+
+    class ProjectionJob;
+
+    struct Entry
+    {
+        QVector<QPolygonF> polygons;
+        bool result;
+    };
+
+    void projectRange( const ViewportParams *viewport, int begin, int end );
+
+    // the line strings to be projected, sorted and unique after project()
+    QVector<const GeoDataLineString *> m_lineStrings;
+    // the projections of the first m_size line strings
+    QVector<Entry> m_entries;
+    int m_size;
+};
+
+}
+
+#endif
@@ -16,13 +16,16 @@
 
 #include <QtCore/qmath.h>
 #include <QRunnable>
+#include <QVector>
 
 #include "MarbleGlobal.h"
 #include "GeoPainter.h"
 #include "GeoDataPolygon.h"
 #include "GeoDataDocument.h"
+#include "JobGroup.h"
 #include "MarbleDebug.h"
 #include "Quaternion.h"
+#include "ScanlineKernels.h"
 #include "ScanlineTextureMapperContext.h"
 #include "StackedTileLoader.h"
 #include "StackedTile.h"
@@ -65,7 +68,6 @@ SphericalScanlineTextureMapper::SphericalScanlineTextureMapper( StackedTileLoade
     : TextureMapperInterface()
     , m_tileLoader( tileLoader )
     , m_radius( 0 )
-    , m_threadPool()
 {
 }
 
@@ -126,16 +128,15 @@ void SphericalScanlineTextureMapper::mapTexture( const ViewportParams *viewport,
     const int yBottom = ( yTop == 0 ) ? imageHeight - skip
                                       : yTop + radius + radius - skip;
 
-    const int numThreads = m_threadPool.maxThreadCount();
-    const int yStep = qCeil(qreal( yBottom - yTop ) / qreal(numThreads));
-    for ( int i = 0; i < numThreads; ++i ) {
-        const int yStart = yTop +  i      * yStep;
-        const int yEnd   = qMin(yBottom, yTop + (i + 1) * yStep);
+    JobGroup jobs( MarbleGlobal::getInstance()->threadPool() );
+    const int yStep = ScanlineTextureMapperContext::rowBandHeight( yBottom - yTop, jobs.maxThreadCount() );
+    for ( int yStart = yTop; yStart < yBottom; yStart += yStep ) {
+        const int yEnd = qMin( yBottom, yStart + yStep );
         QRunnable *const job = new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, yStart, yEnd );
-        m_threadPool.start( job );
+        jobs.start( job );
     }
 
-    m_threadPool.waitForDone();
+    jobs.waitForDone();
 
     m_tileLoader->cleanupTilehash();
 }
@@ -168,15 +169,19 @@ void SphericalScanlineTextureMapper::RenderJob::run()
     // initialize needed variables that are modified during texture mapping:
 
     ScanlineTextureMapperContext context( m_tileLoader, m_tileLevel );
-    qreal  lon = 0.0;
-    qreal  lat = 0.0;
+
+    // Buffers for the pixels of a scanline that get evaluated precisely
+    QVector<int>   evalX( imageWidth + 1 );
+    QVector<bool>  evalInterpolate( imageWidth + 1 );
+    QVector<qreal> evalQx( imageWidth + 1 );
+    QVector<qreal> evalLon( imageWidth + 1 );
+    QVector<qreal> evalLat( imageWidth + 1 );
 
     // Scanline based algorithm to texture map a sphere
     for ( int y = m_yTop; y < m_yBottom ; ++y ) {
 
         // Evaluate coordinates for the 3D position vector of the current pixel
         const qreal qy = inverseRadius * (qreal)( imageHeight / 2 - y );
-        const qreal qr = 1.0 - qy * qy;
 
         // rx is the radius component in x direction
         const int rx = (int)sqrt( (qreal)( radius * radius
@@ -216,6 +221,9 @@ void SphericalScanlineTextureMapper::RenderJob::run()
             crossingPoleArea = true;
         }
 
+        // First determine the pixels of the scanline whose coordinates need to get
+        // evaluated precisely. All other pixels get interpolated in between.
+        int evalCount = 0;
         int ncount = 0;
 
         for ( int x = xLeft; x < xRight; ++x ) {
@@ -244,23 +252,26 @@ void SphericalScanlineTextureMapper::RenderJob::run()
             else
                 interpolate = false;
 
-            // Evaluate more coordinates for the 3D position vector of
-            // the current pixel.
-            const qreal qx = (qreal)( x - imageWidth / 2 ) * inverseRadius;
-            const qreal qr2z = qr - qx * qx;
-            const qreal qz = ( qr2z > 0.0 ) ? sqrt( qr2z ) : 0.0;
+            evalX[evalCount] = x;
+            evalQx[evalCount] = (qreal)( x - imageWidth / 2 ) * inverseRadius;
+            evalInterpolate[evalCount] = interpolate;
+            ++evalCount;
+        }
 
-            // Create Quaternion from vector coordinates and rotate it
-            // around globe axis
-            Quaternion qpos( 0.0, qx, qy, qz );
-            qpos.rotateAroundAxis( planetAxisMatrix );
+        // Rotate the 3D position vectors of all evaluated pixels around
+        // the globe axis at once and convert them to spherical coordinates
+        sphericalCoordinates( evalQx.data(), evalCount, qy, planetAxisMatrix,
+                              evalLon.data(), evalLat.data() );
 
-            qpos.getSpherical( lon, lat );
+        for ( int i = 0; i < evalCount; ++i ) {
+            const int x = evalX[i];
+            const qreal lon = evalLon[i];
+            const qreal lat = evalLat[i];
 //            mDebug() << QString("lon: %1 lat: %2").arg(lon).arg(lat);
             // Approx for n-1 out of n pixels within the boundary of
             // xIpLeft to xIpRight
 
-            if ( interpolate ) {
+            if ( evalInterpolate[i] ) {
                 if (highQuality)
                     context.pixelValueApproxF( lon, lat, scanLine, n );
                 else
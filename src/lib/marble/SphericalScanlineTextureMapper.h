@@ -17,7 +17,6 @@
 
 #include "MarbleGlobal.h"
 
-#include <QThreadPool>
 #include <QImage>
 
 
@@ -55,7 +54,6 @@ class SphericalScanlineTextureMapper : public TextureMapperInterface
     StackedTileLoader *const m_tileLoader;
     int m_radius;
     QImage m_canvasImage;
-    QThreadPool m_threadPool;
 };
 
 }
@@ -56,6 +56,20 @@ static const uchar **jumpTableFromQImage8( const QImage &img )
 }
 
 
+// Linear interpolation between the colors a and b with the given weight of b
+// in the range [0..256]. The red/blue and the alpha/green channel pairs are
+// processed in parallel within a single 32 bit integer each.
+static inline QRgb interpolatePixel( QRgb a, QRgb b, uint weight )
+{
+    const uint inverseWeight = 256 - weight;
+
+    const uint rb = ( ( ( a & 0xff00ff ) * inverseWeight + ( b & 0xff00ff ) * weight ) >> 8 ) & 0xff00ff;
+    const uint ag = ( ( ( a >> 8 ) & 0xff00ff ) * inverseWeight + ( ( b >> 8 ) & 0xff00ff ) * weight ) & 0xff00ff00;
+
+    return rb | ag;
+}
+
+
 StackedTile::StackedTile( const TileId &id, const QImage &resultImage, QVector<QSharedPointer<TextureTile> > const &tiles ) :
       Tile( id ),
       m_resultImage( resultImage ),
@@ -97,6 +111,22 @@ uint StackedTile::pixel( int x, int y ) const
     return m_resultImage.pixel( x, y );
 }
 
+void StackedTile::pixels( const int *x, const int *y, int count, QRgb *scanLine ) const
+{
+    if ( m_depth == 32 ) {
+        for ( int i = 0; i < count; ++i )
+            scanLine[i] = (jumpTable32)[y[i]][x[i]];
+    }
+    else if ( m_depth == 8 && m_isGrayscale ) {
+        for ( int i = 0; i < count; ++i )
+            scanLine[i] = (jumpTable8)[y[i]][x[i]];
+    }
+    else {
+        for ( int i = 0; i < count; ++i )
+            scanLine[i] = pixel( x[i], y[i] );
+    }
+}
+
 uint StackedTile::pixelF( qreal x, qreal y, const QRgb& topLeftValue ) const
 {
     // Bilinear interpolation to determine the color of a subpixel 
@@ -122,9 +152,8 @@ uint StackedTile::pixelF( qreal x, qreal y, const QRgb& topLeftValue ) const
             leftValue = bottomLeftValue;
 #else
         // blending the color values of the top left and bottom left point
-        qreal ml_red   = ( 1.0 - fY ) * qRed  ( topLeftValue  ) + fY * qRed  ( bottomLeftValue  );
-        qreal ml_green = ( 1.0 - fY ) * qGreen( topLeftValue  ) + fY * qGreen( bottomLeftValue  );
-        qreal ml_blue  = ( 1.0 - fY ) * qBlue ( topLeftValue  ) + fY * qBlue ( bottomLeftValue  );
+        const uint weightY = (uint)( fY * 256.0 );
+        const QRgb leftValue = interpolatePixel( topLeftValue, bottomLeftValue, weightY );
 #endif
         // Interpolation in x-direction
         if ( iX + 1 < m_resultImage.width() ) {
@@ -156,24 +185,18 @@ uint StackedTile::pixelF( qreal x, qreal y, const QRgb& topLeftValue ) const
             return averageValue;
 #else
             // blending the color values of the top right and bottom right point
-            qreal mr_red   = ( 1.0 - fY ) * qRed  ( topRightValue ) + fY * qRed  ( bottomRightValue );
-            qreal mr_green = ( 1.0 - fY ) * qGreen( topRightValue ) + fY * qGreen( bottomRightValue );
-            qreal mr_blue  = ( 1.0 - fY ) * qBlue ( topRightValue ) + fY * qBlue ( bottomRightValue );
-    
+            const QRgb rightValue = interpolatePixel( topRightValue, bottomRightValue, weightY );
+
             // blending the color values of the resulting middle left 
             // and middle right points
-            int mm_red   = (int)( ( 1.0 - fX ) * ml_red   + fX * mr_red   );
-            int mm_green = (int)( ( 1.0 - fX ) * ml_green + fX * mr_green );
-            int mm_blue  = (int)( ( 1.0 - fX ) * ml_blue  + fX * mr_blue  );
-    
-            return qRgb( mm_red, mm_green, mm_blue );
+            return interpolatePixel( leftValue, rightValue, (uint)( fX * 256.0 ) ) | 0xff000000;
 #endif
         }
         else {
 #ifdef CHEAPHIGH
             return leftValue;
 #else
-            return qRgb( ml_red, ml_green, ml_blue );
+            return leftValue | 0xff000000;
 #endif
         }
     }
@@ -200,11 +223,7 @@ uint StackedTile::pixelF( qreal x, qreal y, const QRgb& topLeftValue ) const
             return topValue;
 #else
             // blending the color values of the top left and top right point
-            int tm_red   = (int)( ( 1.0 - fX ) * qRed  ( topLeftValue ) + fX * qRed  ( topRightValue ) );
-            int tm_green = (int)( ( 1.0 - fX ) * qGreen( topLeftValue ) + fX * qGreen( topRightValue ) );
-            int tm_blue  = (int)( ( 1.0 - fX ) * qBlue ( topLeftValue ) + fX * qBlue ( topRightValue ) );
-
-            return qRgb( tm_red, tm_green, tm_blue );
+            return interpolatePixel( topLeftValue, topRightValue, (uint)( fX * 256.0 ) ) | 0xff000000;
 #endif
         }
     }
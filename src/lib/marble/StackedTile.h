@@ -85,6 +85,14 @@ class StackedTile : public Tile
     via a uchar (1 byte) while for RGB(A) images uint (4 bytes) are used.
 */
     uint pixel( int x, int y ) const;
+
+/*!
+    \brief Writes the color values of the given integer positions to @p scanLine.
+
+    Same as calling pixel() for each position ( x[i], y[i] ), but the
+    color depth of the tile is only evaluated once.
+*/
+    void pixels( const int *x, const int *y, int count, QRgb *scanLine ) const;
     
 /*!
     \brief Returns the color value of the result tile at a given floating point position.
@@ -33,7 +33,11 @@
 
 #include <QCache>
 #include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QReadWriteLock>
+#include <QRunnable>
+#include <QThreadPool>
 #include <QImage>
 
 
@@ -43,26 +47,207 @@ namespace Marble
 class StackedTileLoaderPrivate
 {
 public:
-    StackedTileLoaderPrivate( MergedLayerDecorator *mergedLayerDecorator )
-        : m_layerDecorator( mergedLayerDecorator )
+    struct LoadedTile
+    {
+        TileId m_id;
+        StackedTile *m_tile;
+        int m_serial;
+    };
+
+    StackedTileLoaderPrivate( MergedLayerDecorator *mergedLayerDecorator, StackedTileLoader *parent )
+        : q( parent ),
+          m_layerDecorator( mergedLayerDecorator ),
+          m_asynchronous( false ),
+          m_serial( 0 )
     {
         m_tileCache.setMaxCost( 20000 * 1024 ); // Cache size measured in bytes
+        // the decorator is not reentrant, so a single worker is enough
+        m_threadPool.setMaxThreadCount( 1 );
     }
 
+    StackedTile *createPlaceholderTile( const TileId &stackedTileId );
+    void requestTile( const TileId &stackedTileId );
+    void finishTile( const TileId &stackedTileId, StackedTile *stackedTile, int serial );
+    void cancelPendingTiles();
+
+    void applyLoadedTiles();
+
+    StackedTileLoader *const q;
     MergedLayerDecorator *const m_layerDecorator;
     QHash <TileId, StackedTile*>  m_tilesOnDisplay;
     QCache <TileId, StackedTile>  m_tileCache;
     QReadWriteLock m_cacheLock;
+    // serializes the calls of m_layerDecorator, which are made by the
+    // render threads and by the worker thread
+    QMutex m_decoratorLock;
+
+    bool m_asynchronous;
+    QThreadPool m_threadPool;
+    int m_serial;
+    // tiles currently represented by a placeholder, mapped to the serial of their request
+    QHash<TileId, int> m_pendingTiles;
+    // texture tiles downloaded while their stacked tile was still pending
+    QHash<TileId, QList<QPair<TileId, QImage> > > m_pendingUpdates;
+
+    QMutex m_loadedTilesLock;
+    QList<LoadedTile> m_loadedTiles;
 };
 
+class StackedTileJob : public QRunnable
+{
+public:
+    StackedTileJob( StackedTileLoaderPrivate *loader, const TileId &stackedTileId, int serial ) :
+        m_loader( loader ),
+        m_id( stackedTileId ),
+        m_serial( serial )
+    {
+    }
+
+    void run()
+    {
+        m_loader->m_decoratorLock.lock();
+        StackedTile *const stackedTile = m_loader->m_layerDecorator->loadTile( m_id );
+        m_loader->m_decoratorLock.unlock();
+        m_loader->finishTile( m_id, stackedTile, m_serial );
+    }
+
+private:
+    StackedTileLoaderPrivate *const m_loader;
+    const TileId m_id;
+    const int m_serial;
+};
+
+StackedTile *StackedTileLoaderPrivate::createPlaceholderTile( const TileId &stackedTileId )
+{
+    // Look for the closest ancestor tile in memory and scale up the part
+    // covering the requested tile, similar to TileLoader::scaledLowerLevelTile()
+    for ( int level = stackedTileId.zoomLevel() - 1; level >= 0; --level ) {
+        const int deltaLevel = stackedTileId.zoomLevel() - level;
+        const TileId ancestorId( 0, level, stackedTileId.x() >> deltaLevel, stackedTileId.y() >> deltaLevel );
+
+        const StackedTile *ancestor = m_tilesOnDisplay.value( ancestorId, 0 );
+        if ( !ancestor ) {
+            ancestor = m_tileCache.object( ancestorId );
+        }
+        if ( !ancestor ) {
+            continue;
+        }
+
+        const QImage *const toScale = ancestor->resultImage();
+        const int restTileX = stackedTileId.x() % ( 1 << deltaLevel );
+        const int restTileY = stackedTileId.y() % ( 1 << deltaLevel );
+        const int partWidth = qMax( 1, toScale->width() >> deltaLevel );
+        const int partHeight = qMax( 1, toScale->height() >> deltaLevel );
+        const QImage part = toScale->copy( restTileX * partWidth, restTileY * partHeight, partWidth, partHeight );
+
+        return new StackedTile( stackedTileId, part.scaled( toScale->size() ), ancestor->tiles() );
+    }
+
+    return 0;
+}
+
+void StackedTileLoaderPrivate::requestTile( const TileId &stackedTileId )
+{
+    const int serial = ++m_serial;
+    m_pendingTiles[ stackedTileId ] = serial;
+    m_threadPool.start( new StackedTileJob( this, stackedTileId, serial ) );
+}
+
+void StackedTileLoaderPrivate::finishTile( const TileId &stackedTileId, StackedTile *stackedTile, int serial )
+{
+    // called from a worker thread
+    QMutexLocker locker( &m_loadedTilesLock );
+
+    const bool notify = m_loadedTiles.isEmpty();
+
+    LoadedTile loadedTile;
+    loadedTile.m_id = stackedTileId;
+    loadedTile.m_tile = stackedTile;
+    loadedTile.m_serial = serial;
+    m_loadedTiles.append( loadedTile );
+
+    if ( notify ) {
+        QMetaObject::invokeMethod( q, "applyLoadedTiles", Qt::QueuedConnection );
+    }
+}
+
+void StackedTileLoaderPrivate::cancelPendingTiles()
+{
+    m_threadPool.clear();
+    m_threadPool.waitForDone();
+
+    m_pendingTiles.clear();
+    m_pendingUpdates.clear();
+
+    QMutexLocker locker( &m_loadedTilesLock );
+    foreach ( const LoadedTile &loadedTile, m_loadedTiles ) {
+        delete loadedTile.m_tile;
+    }
+    m_loadedTiles.clear();
+}
+
+void StackedTileLoaderPrivate::applyLoadedTiles()
+{
+    m_loadedTilesLock.lock();
+    const QList<LoadedTile> loadedTiles = m_loadedTiles;
+    m_loadedTiles.clear();
+    m_loadedTilesLock.unlock();
+
+    QList<TileId> replacedTiles;
+
+    m_cacheLock.lockForWrite();
+
+    foreach ( const LoadedTile &loadedTile, loadedTiles ) {
+        const TileId &id = loadedTile.m_id;
+        StackedTile *stackedTile = loadedTile.m_tile;
+
+        if ( m_pendingTiles.value( id, 0 ) != loadedTile.m_serial ) {
+            // the request was superseded or cancelled in the meantime
+            delete stackedTile;
+            continue;
+        }
+
+        m_pendingTiles.remove( id );
+
+        typedef QPair<TileId, QImage> TileUpdate;
+        foreach ( const TileUpdate &update, m_pendingUpdates.take( id ) ) {
+            m_decoratorLock.lock();
+            StackedTile *const updatedTile = m_layerDecorator->updateTile( *stackedTile, update.first, update.second );
+            m_decoratorLock.unlock();
+            delete stackedTile;
+            stackedTile = updatedTile;
+        }
+
+        StackedTile *const placeholder = m_tilesOnDisplay.value( id, 0 );
+        if ( placeholder ) {
+            stackedTile->setUsed( true );
+            m_tilesOnDisplay[ id ] = stackedTile;
+            delete placeholder;
+        } else {
+            // replaces (and deletes) the placeholder if it is still cached
+            m_tileCache.insert( id, stackedTile, stackedTile->byteCount() );
+        }
+
+        replacedTiles << id;
+    }
+
+    m_cacheLock.unlock();
+
+    foreach ( const TileId &id, replacedTiles ) {
+        emit q->tileLoaded( id );
+        emit q->pendingTileLoaded( id );
+    }
+}
+
 StackedTileLoader::StackedTileLoader( MergedLayerDecorator *mergedLayerDecorator, QObject *parent )
     : QObject( parent ),
-      d( new StackedTileLoaderPrivate( mergedLayerDecorator ) )
+      d( new StackedTileLoaderPrivate( mergedLayerDecorator, this ) )
 {
 }
 
 StackedTileLoader::~StackedTileLoader()
 {
+    d->cancelPendingTiles();
     qDeleteAll( d->m_tilesOnDisplay );
     delete d;
 }
@@ -147,12 +332,29 @@ const StackedTile* StackedTileLoader::loadTile( TileId const & stackedTileId )
         return stackedTile;
     }
 
+    // in asynchronous mode, display a scaled ancestor tile while
+    // the tile itself is loaded in the background
+    if ( d->m_asynchronous ) {
+        stackedTile = d->createPlaceholderTile( stackedTileId );
+        if ( stackedTile ) {
+            stackedTile->setUsed( true );
+            d->m_tilesOnDisplay[ stackedTileId ] = stackedTile;
+            if ( !d->m_pendingTiles.contains( stackedTileId ) ) {
+                d->requestTile( stackedTileId );
+            }
+            d->m_cacheLock.unlock();
+            return stackedTile;
+        }
+    }
+
     // tile (valid) has not been found in hash or cache, so load it from disk
     // and place it in the hash from where it will get transferred to the cache
 
     mDebug() << "load tile from disk:" << stackedTileId;
 
+    d->m_decoratorLock.lock();
     stackedTile = d->m_layerDecorator->loadTile( stackedTileId );
+    d->m_decoratorLock.unlock();
     Q_ASSERT( stackedTile );
     stackedTile->setUsed( true );
 
@@ -189,11 +391,20 @@ void StackedTileLoader::updateTile( TileId const &tileId, QImage const &tileImag
 {
     const TileId stackedTileId( 0, tileId.zoomLevel(), tileId.x(), tileId.y() );
 
+    if ( d->m_pendingTiles.contains( stackedTileId ) ) {
+        // the placeholder does not contain the texture tile, so apply the
+        // update once the background load of the stacked tile has finished
+        d->m_pendingUpdates[ stackedTileId ] << qMakePair( tileId, tileImage );
+        return;
+    }
+
     StackedTile * displayedTile = d->m_tilesOnDisplay.take( stackedTileId );
     if ( displayedTile ) {
         Q_ASSERT( !d->m_tileCache.contains( stackedTileId ) );
 
+        d->m_decoratorLock.lock();
         StackedTile *const stackedTile = d->m_layerDecorator->updateTile( *displayedTile, tileId, tileImage );
+        d->m_decoratorLock.unlock();
         stackedTile->setUsed( true );
         d->m_tilesOnDisplay.insert( stackedTileId, stackedTile );
 
@@ -206,6 +417,23 @@ void StackedTileLoader::updateTile( TileId const &tileId, QImage const &tileImag
     }
 }
 
+void StackedTileLoader::discardTile( TileId const &tileId )
+{
+    const TileId stackedTileId( 0, tileId.zoomLevel(), tileId.x(), tileId.y() );
+
+    d->m_tileCache.remove( stackedTileId );
+}
+
+void StackedTileLoader::setAsynchronousLoading( bool enabled )
+{
+    d->m_asynchronous = enabled;
+}
+
+bool StackedTileLoader::asynchronousLoading() const
+{
+    return d->m_asynchronous;
+}
+
 RenderState StackedTileLoader::renderState() const
 {
     RenderState renderState( "Stacked Tiles" );
@@ -221,6 +449,8 @@ void StackedTileLoader::clear()
 {
     mDebug() << Q_FUNC_INFO;
 
+    d->cancelPendingTiles();
+
     qDeleteAll( d->m_tilesOnDisplay );
     d->m_tilesOnDisplay.clear();
     d->m_tileCache.clear(); // clear the tile cache in physical memory
@@ -228,6 +458,37 @@ void StackedTileLoader::clear()
     emit cleared();
 }
 
+void StackedTileLoader::redecorateTiles()
+{
+    mDebug() << Q_FUNC_INFO;
+
+    d->m_cacheLock.lockForWrite();
+
+    QHash<TileId, StackedTile*>::iterator it = d->m_tilesOnDisplay.begin();
+    const QHash<TileId, StackedTile*>::iterator end = d->m_tilesOnDisplay.end();
+    for ( ; it != end; ++it ) {
+        if ( d->m_pendingTiles.contains( it.key() ) ) {
+            // the placeholder is replaced by a tile that is loaded with the
+            // new decoration
+            d->requestTile( it.key() );
+            continue;
+        }
+
+        d->m_decoratorLock.lock();
+        StackedTile *const stackedTile = d->m_layerDecorator->redecorateTile( *it.value() );
+        d->m_decoratorLock.unlock();
+        stackedTile->setUsed( true );
+        delete it.value();
+        it.value() = stackedTile;
+    }
+
+    d->m_tileCache.clear();
+
+    d->m_cacheLock.unlock();
+
+    emit cleared();
+}
+
 }
 
 #include "moc_StackedTileLoader.cpp"
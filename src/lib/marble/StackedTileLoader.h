@@ -127,16 +127,60 @@ class StackedTileLoader : public QObject
          */
         void clear();
 
+        /**
+         * Recreates the tiles that are currently in use from their texture
+         * tiles, without loading them again, and clears the tile cache in
+         * physical memory.
+         *
+         * Use this instead of clear() if only the decoration of the tiles
+         * changed, e.g. the sun shading.
+         */
+        void redecorateTiles();
+
         /**
          */
         void updateTile(TileId const & tileId, QImage const &tileImage );
 
+        /**
+         * Removes the stacked tile containing the texture tile @p tileId from
+         * the tile cache, so that it is loaded again when it is needed.
+         * Tiles on display are kept.
+         */
+        void discardTile( TileId const &tileId );
+
+        /**
+         * @brief Enables or disables asynchronous tile loading.
+         *
+         * In asynchronous mode a tile that is neither on display nor in the
+         * volatile cache is not decoded on the calling (render) thread.
+         * Instead, the best ancestor tile available in memory is scaled up
+         * and returned immediately while the real tile is loaded on a worker
+         * thread. Once it is ready it replaces the placeholder and
+         * tileLoaded() is emitted. If no ancestor tile is in memory the tile
+         * is loaded synchronously.
+         *
+         * The worker thread and the render threads never use the decorator
+         * at the same time. MarbleMap enables this mode while the view is
+         * animated, so that panning and zooming never waits for tiles.
+         */
+        void setAsynchronousLoading( bool enabled );
+        bool asynchronousLoading() const;
+
         RenderState renderState() const;
 
     Q_SIGNALS:
         void tileLoaded( TileId const &tileId );
         void cleared();
 
+        /**
+         * Emitted after a tile that was loaded asynchronously has replaced
+         * its placeholder.
+         */
+        void pendingTileLoaded( TileId const &tileId );
+
+    private:
+        Q_PRIVATE_SLOT( d, void applyLoadedTiles() )
+
     private:
         Q_DISABLE_COPY( StackedTileLoader )
 
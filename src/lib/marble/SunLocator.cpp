@@ -108,15 +108,7 @@ qreal SunLocator::shading(qreal lon, qreal a, qreal c) const
       theta = 2*asin(sqrt(h))
     */
 
-    qreal twilightZone = 0.0;
-
-    QString planetId = d->m_planet->id();
-    if ( planetId == "earth" || planetId == "venus") {
-        twilightZone = 0.1; // this equals 18 deg astronomical twilight.
-    }
-    else if ( planetId == "mars" ) {
-        twilightZone = 0.05;
-    }
+    const qreal twilightZone = this->twilightZone();
 
     qreal brightness;
     if ( h <= 0.5 - twilightZone / 2.0 )
@@ -129,6 +121,19 @@ qreal SunLocator::shading(qreal lon, qreal a, qreal c) const
     return brightness;
 }
 
+qreal SunLocator::twilightZone() const
+{
+    QString planetId = d->m_planet->id();
+    if ( planetId == "earth" || planetId == "venus") {
+        return 0.1; // this equals 18 deg astronomical twilight.
+    }
+    else if ( planetId == "mars" ) {
+        return 0.05;
+    }
+
+    return 0.0;
+}
+
 void SunLocator::shadePixel(QRgb& pixcol, qreal brightness) const
 {
     // daylight - no change
@@ -39,6 +39,12 @@ class MARBLE_EXPORT SunLocator : public QObject
     virtual ~SunLocator();
 
     qreal shading(qreal lon, qreal a, qreal c) const;
+
+    /**
+     * Returns the width of the twilight zone of the current planet in terms
+     * of the haversine of the angular distance to the sun, as used by shading().
+     */
+    qreal twilightZone() const;
     void  shadePixel(QRgb& pixcol, qreal shade) const;
     void  shadePixelComposite(QRgb& pixcol, const QRgb& dpixcol, qreal shade) const;
 
@@ -0,0 +1,211 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "SunShadingMask.h"
+
+#include <cmath>
+#include <cstring>
+
+#include <QImage>
+
+#include "MarbleGlobal.h"
+#include "SunLocator.h"
+#include "TileId.h"
+#include "TileLoaderHelper.h"
+
+namespace Marble
+{
+
+// Scales the color of an opaque pixel by factor / 256, processing red and
+// blue resp. green at once.
+static inline QRgb scaleColor( QRgb color, uint factor )
+{
+    const uint redBlue = ( ( color & 0xff00ff ) * factor ) >> 8;
+    const uint green   = ( ( color & 0x00ff00 ) * factor ) >> 8;
+
+    return 0xff000000 | ( redBlue & 0xff00ff ) | ( green & 0x00ff00 );
+}
+
+// Blends two opaque pixels, dayWeight ranges from 0 to 256.
+static inline QRgb blendColors( QRgb nightColor, QRgb dayColor, uint dayWeight )
+{
+    const uint redBlue = ( ( dayColor & 0xff00ff ) * dayWeight + ( nightColor & 0xff00ff ) * ( 256 - dayWeight ) ) >> 8;
+    const uint green   = ( ( dayColor & 0x00ff00 ) * dayWeight + ( nightColor & 0x00ff00 ) * ( 256 - dayWeight ) ) >> 8;
+
+    return 0xff000000 | ( redBlue & 0xff00ff ) | ( green & 0x00ff00 );
+}
+
+// The factor of SunLocator::shadePixel() ( 0.35 at night, 1.0 at daylight )
+// in units of 1/256.
+static inline uint shadeFactor( uint brightness )
+{
+    return 90 + ( 166 * brightness ) / 255;
+}
+
+SunShadingMask::SunShadingMask( const SunLocator *sunLocator, const TileId &id, const QSize &tileSize,
+                                int levelZeroColumns, int levelZeroRows )
+    : m_tileSize( tileSize ),
+      m_rowShading( tileSize.height(), RowLit ),
+      m_fullyLit( true ),
+      m_fullyDark( true )
+{
+    const int tileWidth = tileSize.width();
+    const int tileHeight = tileSize.height();
+
+    const qreal  global_width  = tileWidth
+            * TileLoaderHelper::levelToColumn( levelZeroColumns, id.zoomLevel() );
+    const qreal  global_height = tileHeight
+            * TileLoaderHelper::levelToRow( levelZeroRows, id.zoomLevel() );
+    const qreal lon_scale = 2*M_PI / global_width;
+    const qreal lat_scale = -M_PI / global_height;
+
+    const qreal sunLon = DEG2RAD * sunLocator->getLon();
+    const qreal sunLat = DEG2RAD * sunLocator->getLat();
+
+    const qreal twilightZone = sunLocator->twilightZone();
+    const qreal litLimit  = 0.5 - twilightZone / 2.0;
+    const qreal darkLimit = 0.5 + twilightZone / 2.0;
+
+    // The haversine of the distance to the sun is h = a*a + c*b*b, where b
+    // only depends on the longitude and a, c only on the latitude
+    // (see SunLocator::shading()). So evaluate b*b once per column.
+    QVector<qreal> bb( tileWidth );
+    qreal bbMin = 1.0;
+    qreal bbMax = 0.0;
+    for ( int x = 0; x < tileWidth; ++x ) {
+        const qreal lon = lon_scale * ( id.x() * tileWidth + x );
+        const qreal b = sin( ( lon - sunLon ) / 2.0 );
+        bb[x] = b * b;
+        bbMin = qMin( bbMin, bb[x] );
+        bbMax = qMax( bbMax, bb[x] );
+    }
+
+    for ( int y = 0; y < tileHeight; ++y ) {
+        const qreal lat = lat_scale * ( id.y() * tileHeight + y ) - 0.5*M_PI;
+        const qreal a = sin( ( lat + sunLat ) / 2.0 );
+        const qreal c = cos( lat ) * cos( -sunLat );
+
+        // range of h within the row
+        const qreal hMin = a * a + qMin( c * bbMin, c * bbMax );
+        const qreal hMax = a * a + qMax( c * bbMin, c * bbMax );
+
+        if ( hMax <= litLimit ) {
+            m_rowShading[y] = RowLit;
+            m_fullyDark = false;
+        }
+        else if ( hMin >= darkLimit ) {
+            m_rowShading[y] = RowDark;
+            m_fullyLit = false;
+        }
+        else {
+            m_rowShading[y] = RowMixed;
+            m_fullyLit = false;
+            m_fullyDark = false;
+
+            const int offset = m_brightness.size();
+            m_brightness.resize( offset + tileWidth );
+            uchar *const brightness = m_brightness.data() + offset;
+
+            for ( int x = 0; x < tileWidth; ++x ) {
+                const qreal h = a * a + c * bb[x];
+
+                if ( h <= litLimit )
+                    brightness[x] = 255;
+                else if ( h >= darkLimit )
+                    brightness[x] = 0;
+                else
+                    brightness[x] = (uchar)( 255 * ( darkLimit - h ) / twilightZone );
+            }
+        }
+    }
+}
+
+bool SunShadingMask::isFullyLit() const
+{
+    return m_fullyLit;
+}
+
+bool SunShadingMask::isFullyDark() const
+{
+    return m_fullyDark;
+}
+
+void SunShadingMask::shade( QImage *tileImage ) const
+{
+    Q_ASSERT( tileImage->size() == m_tileSize );
+    Q_ASSERT( tileImage->depth() == 32 );
+
+    if ( m_fullyLit )
+        return;
+
+    const int tileWidth = m_tileSize.width();
+    const uchar *brightness = m_brightness.constData();
+    const uint nightFactor = shadeFactor( 0 );
+
+    for ( int y = 0; y < m_tileSize.height(); ++y ) {
+        QRgb *const scanLine = (QRgb*)tileImage->scanLine( y );
+
+        switch ( m_rowShading[y] ) {
+        case RowLit:
+            break;
+        case RowDark:
+            for ( int x = 0; x < tileWidth; ++x ) {
+                scanLine[x] = scaleColor( scanLine[x], nightFactor );
+            }
+            break;
+        case RowMixed:
+            for ( int x = 0; x < tileWidth; ++x ) {
+                if ( brightness[x] != 255 ) {
+                    scanLine[x] = scaleColor( scanLine[x], shadeFactor( brightness[x] ) );
+                }
+            }
+            brightness += tileWidth;
+            break;
+        }
+    }
+}
+
+void SunShadingMask::blend( QImage *tileImage, const QImage &nightImage ) const
+{
+    Q_ASSERT( tileImage->size() == m_tileSize );
+    Q_ASSERT( nightImage.size() == m_tileSize );
+    Q_ASSERT( tileImage->depth() == 32 && nightImage.depth() == 32 );
+
+    if ( m_fullyLit )
+        return;
+
+    const int tileWidth = m_tileSize.width();
+    const uchar *brightness = m_brightness.constData();
+
+    for ( int y = 0; y < m_tileSize.height(); ++y ) {
+        QRgb *const scanLine = (QRgb*)tileImage->scanLine( y );
+        const QRgb *const nightScanLine = (const QRgb*)nightImage.constScanLine( y );
+
+        switch ( m_rowShading[y] ) {
+        case RowLit:
+            break;
+        case RowDark:
+            memcpy( scanLine, nightScanLine, tileWidth * sizeof( QRgb ) );
+            break;
+        case RowMixed:
+            for ( int x = 0; x < tileWidth; ++x ) {
+                const uint dayWeight = brightness[x];
+                if ( dayWeight == 0 ) {
+                    scanLine[x] = nightScanLine[x];
+                }
+                else if ( dayWeight != 255 ) {
+                    scanLine[x] = blendColors( nightScanLine[x], scanLine[x], dayWeight + ( dayWeight >> 7 ) );
+                }
+            }
+            brightness += tileWidth;
+            break;
+        }
+    }
+}
+
+}
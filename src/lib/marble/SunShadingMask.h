@@ -0,0 +1,79 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_SUNSHADINGMASK_H
+#define MARBLE_SUNSHADINGMASK_H
+
+#include <QSize>
+#include <QVector>
+
+class QImage;
+
+namespace Marble
+{
+
+class SunLocator;
+class TileId;
+
+/**
+ * @brief The brightness of the pixels of a tile according to the sun position.
+ *
+ * The mask is computed once per tile: The longitude dependent part of the
+ * shading is evaluated once per column and combined with the latitude
+ * dependent part of each row. Rows that are fully lit or fully dark are
+ * detected analytically and stored as a single flag, so only rows crossing
+ * the twilight zone carry per-pixel brightness values.
+ *
+ * The tiles are expected to use the equirectangular projection.
+ */
+class SunShadingMask
+{
+ public:
+    SunShadingMask( const SunLocator *sunLocator, const TileId &id, const QSize &tileSize,
+                    int levelZeroColumns, int levelZeroRows );
+
+    /**
+     * Returns true if no pixel of the tile is in the twilight zone or on
+     * the night side.
+     */
+    bool isFullyLit() const;
+
+    /**
+     * Returns true if all pixels of the tile are on the night side.
+     */
+    bool isFullyDark() const;
+
+    /**
+     * Darkens the pixels of @p tileImage on the night side of the planet.
+     */
+    void shade( QImage *tileImage ) const;
+
+    /**
+     * Replaces the pixels of @p tileImage on the night side of the planet
+     * by the ones of @p nightImage, blending both in the twilight zone.
+     */
+    void blend( QImage *tileImage, const QImage &nightImage ) const;
+
+ private:
+    enum RowShading {
+        RowLit,
+        RowDark,
+        RowMixed
+    };
+
+    QSize m_tileSize;
+    QVector<uchar> m_rowShading;
+    // brightness of the pixels in mixed rows, from 0 (dark) to 255 (lit)
+    QVector<uchar> m_brightness;
+    bool m_fullyLit;
+    bool m_fullyDark;
+};
+
+}
+
+#endif
@@ -22,6 +22,7 @@
 #include <QColor>
 #include <QImage>
 #include <QPainter>
+#include <QRunnable>
 
 #include "MarbleGlobal.h"
 #include "GeoPainter.h"
@@ -34,6 +35,8 @@
 #include "GeoDataPlacemark.h"
 #include "GeoDataDocument.h"
 #include "AbstractProjection.h"
+#include "JobGroup.h"
+#include "ScanlineTextureMapperContext.h"
 
 namespace Marble
 {
@@ -67,10 +70,79 @@ private:
     uchar  x4;
 };
 
+// Blends two opaque colors with integer arithmetic, processing red and blue
+// resp. green of both colors at once. landWeight ranges from 0 to 255.
+static inline QRgb blendColors( QRgb seaColor, QRgb landColor, uint landWeight )
+{
+    const uint weight = landWeight + ( landWeight >> 7 );
+
+    const uint redBlue = ( ( landColor & 0xff00ff ) * weight + ( seaColor & 0xff00ff ) * ( 256 - weight ) ) >> 8;
+    const uint green   = ( ( landColor & 0x00ff00 ) * weight + ( seaColor & 0x00ff00 ) * ( 256 - weight ) ) >> 8;
+
+    return 0xff000000 | ( redBlue & 0xff00ff ) | ( green & 0x00ff00 );
+}
+
+
+class TextureColorizer::ColorizeJob : public QRunnable
+{
+public:
+    ColorizeJob( const TextureColorizer *colorizer, QImage *canvasImage, int yTop, int yBottom, qint64 globeRadius )
+        : m_colorizer( colorizer ),
+          m_canvasImage( canvasImage ),
+          m_yTop( yTop ),
+          m_yBottom( yBottom ),
+          m_globeRadius( globeRadius )
+    {
+    }
+
+    virtual void run();
+
+private:
+    const TextureColorizer *const m_colorizer;
+    QImage *const m_canvasImage;
+    const int m_yTop;
+    const int m_yBottom;
+    const qint64 m_globeRadius;
+};
+
+void TextureColorizer::ColorizeJob::run()
+{
+    const int imgwidth = m_canvasImage->width();
+    const int imgrx    = imgwidth / 2;
+    const int imgry    = m_canvasImage->height() / 2;
+
+    for ( int y = m_yTop; y < m_yBottom; ++y ) {
+        int  xLeft  = 0;
+        int  xRight = imgwidth;
+
+        // only colorize the visible part of the globe
+        if ( m_globeRadius > 0 ) {
+            const int  dy = imgry - y;
+            const int  rx = (int)sqrt( (qreal)( m_globeRadius * m_globeRadius - dy * dy ) );
+
+            if ( imgrx-rx > 0 ) {
+                xLeft  = imgrx - rx;
+                xRight = imgrx + rx;
+            }
+        }
+
+        QRgb *const scanLine        = (QRgb*)( m_canvasImage->scanLine( y ) ) + xLeft;
+        const QRgb *const coastLine = (const QRgb*)( m_colorizer->m_coastImage.constScanLine( y ) ) + xLeft;
+
+        m_colorizer->colorizeScanLine( scanLine, coastLine, xRight - xLeft, m_globeRadius > 0 );
+    }
+}
+
 
 TextureColorizer::TextureColorizer( const QString &seafile,
                                     const QString &landfile )
-    : m_showRelief( false ),
+    : m_coastImageDirty( true ),
+      m_coastProjection( Spherical ),
+      m_coastRadius( 0 ),
+      m_coastCenterLon( 0.0 ),
+      m_coastCenterLat( 0.0 ),
+      m_coastMapQuality( NormalQuality ),
+      m_showRelief( false ),
       m_landColor(qRgb( 255, 0, 0 ) ),
       m_seaColor( qRgb( 0, 255, 0 ) )
 {
@@ -151,11 +223,13 @@ TextureColorizer::TextureColorizer( const QString &seafile,
 void TextureColorizer::addSeaDocument( const GeoDataDocument *seaDocument )
 {
     m_seaDocuments.append( seaDocument );
+    m_coastImageDirty = true;
 }
 
 void TextureColorizer::addLandDocument( const GeoDataDocument *landDocument )
 {
     m_landDocuments.append( landDocument );
+    m_coastImageDirty = true;
 }
 
 void TextureColorizer::setShowRelief( bool show )
@@ -226,8 +300,25 @@ void TextureColorizer::drawTextureMap( GeoPainter *painter )
     }
 }
 
-void TextureColorizer::colorize( QImage *origimg, const ViewportParams *viewport, MapQuality mapQuality )
+void TextureColorizer::updateCoastImage( const ViewportParams *viewport, MapQuality mapQuality )
 {
+    QVector<bool> seaVisibility;
+    seaVisibility.reserve( m_seaDocuments.size() );
+    foreach( const GeoDataDocument *doc, m_seaDocuments ) {
+        seaVisibility << doc->isVisible();
+    }
+
+    if ( !m_coastImageDirty
+         && m_coastImage.size() == viewport->size()
+         && m_coastProjection == viewport->projection()
+         && m_coastRadius == viewport->radius()
+         && m_coastCenterLon == viewport->centerLongitude()
+         && m_coastCenterLat == viewport->centerLatitude()
+         && m_coastMapQuality == mapQuality
+         && m_coastSeaVisibility == seaVisibility ) {
+        return;
+    }
+
     if ( m_coastImage.size() != viewport->size() )
         m_coastImage = QImage( viewport->size(), QImage::Format_RGB32 );
 
@@ -242,6 +333,19 @@ void TextureColorizer::colorize( QImage *origimg, const ViewportParams *viewport
 
     drawTextureMap( &painter );
 
+    m_coastImageDirty = false;
+    m_coastProjection = viewport->projection();
+    m_coastRadius = viewport->radius();
+    m_coastCenterLon = viewport->centerLongitude();
+    m_coastCenterLat = viewport->centerLatitude();
+    m_coastMapQuality = mapQuality;
+    m_coastSeaVisibility = seaVisibility;
+}
+
+void TextureColorizer::colorize( QImage *origimg, const ViewportParams *viewport, MapQuality mapQuality )
+{
+    updateCoastImage( viewport, mapQuality );
+
     const qint64 radius = viewport->radius() * viewport->currentProjection()->clippingRadius();
 
     const int  imgheight = origimg->height();
@@ -251,14 +355,13 @@ void TextureColorizer::colorize( QImage *origimg, const ViewportParams *viewport
     // This variable is not used anywhere..
     const int  imgradius = imgrx * imgrx + imgry * imgry;
 
-    int     bump = 8;
+    int yTop = 0;
+    int yBottom = imgheight;
+    qint64 globeRadius = 0;
 
     if ( radius * radius > imgradius
          || !viewport->currentProjection()->isClippedToSphere() )
     {
-        int yTop = 0;
-        int yBottom = imgheight;
-
         if( !viewport->currentProjection()->isClippedToSphere() && !viewport->currentProjection()->traversablePoles() )
         {
             qreal realYTop, realYBottom, dummyX;
@@ -269,103 +372,52 @@ void TextureColorizer::colorize( QImage *origimg, const ViewportParams *viewport
             yTop = qBound(qreal(0.0), realYTop, qreal(imgheight));
             yBottom = qBound(qreal(0.0), realYBottom, qreal(imgheight));
         }
-
-        const int itEnd = yBottom;
-
-        for (int y = yTop; y < itEnd; ++y) {
-
-            QRgb  *writeData         = (QRgb*)( origimg->scanLine( y ) );
-            const QRgb  *coastData   = (QRgb*)( m_coastImage.scanLine( y ) );
-
-            uchar *readDataStart     = origimg->scanLine( y );
-            const uchar *readDataEnd = readDataStart + imgwidth*4;
-
-            EmbossFifo  emboss;
-
-            for ( uchar* readData = readDataStart; 
-                  readData < readDataEnd;
-                  readData += 4, ++writeData, ++coastData )
-            {
-
-                // Cheap Emboss / Bumpmapping
-                uchar&  grey = *readData; // qBlue(*data);
-
-                if ( m_showRelief ) {
-                    emboss << grey;
-                    bump = ( emboss.head() + 8 - grey );
-                    if ( bump  < 0 )  bump = 0;
-                    if ( bump  > 15 ) bump = 15;
-                }
-                setPixel( coastData, writeData, bump, grey );
-            }
-        }
     }
     else {
-        int yTop    = ( imgry-radius < 0 ) ? 0 : imgry-radius;
-        const int yBottom = ( yTop == 0 ) ? imgheight : imgry + radius;
-
-        EmbossFifo  emboss;
-
-        for ( int y = yTop; y < yBottom; ++y ) {
-            const int  dy = imgry - y;
-            int  rx = (int)sqrt( (qreal)( radius * radius - dy * dy ) );
-            int  xLeft  = 0; 
-            int  xRight = imgwidth;
-
-            if ( imgrx-rx > 0 ) {
-                xLeft  = imgrx - rx; 
-                xRight = imgrx + rx;
-            }
+        yTop    = ( imgry-radius < 0 ) ? 0 : imgry-radius;
+        yBottom = ( yTop == 0 ) ? imgheight : imgry + radius;
+        globeRadius = radius;
+    }
 
-            QRgb  *writeData         = (QRgb*)( origimg->scanLine( y ) )  + xLeft;
-            const QRgb *coastData    = (QRgb*)( m_coastImage.scanLine( y ) ) + xLeft;
+    JobGroup jobs( MarbleGlobal::getInstance()->threadPool() );
+    const int yStep = ScanlineTextureMapperContext::rowBandHeight( yBottom - yTop, jobs.maxThreadCount() );
+    for ( int yStart = yTop; yStart < yBottom; yStart += yStep ) {
+        const int yEnd = qMin( yBottom, yStart + yStep );
+        jobs.start( new ColorizeJob( this, origimg, yStart, yEnd, globeRadius ) );
+    }
 
-            uchar *readDataStart     = origimg->scanLine( y ) + xLeft * 4;
-            const uchar *readDataEnd = origimg->scanLine( y ) + xRight * 4;
+    jobs.waitForDone();
+}
 
- 
-            for ( uchar* readData = readDataStart;
-                  readData < readDataEnd;
-                  readData += 4, ++writeData, ++coastData )
-            {
-                // Cheap Emboss / Bumpmapping
+void TextureColorizer::colorizeScanLine( QRgb *scanLine, const QRgb *coastLine, int count, bool globe ) const
+{
+    EmbossFifo  emboss;
+    int  bump = 8;
+
+    for ( int x = 0; x < count; ++x ) {
+        // Cheap Emboss / Bumpmapping
+        const uchar grey = qBlue( scanLine[x] );
+
+        if ( m_showRelief ) {
+            emboss << grey;
+            bump = globe ? ( emboss.head() + 16 - grey ) >> 1
+                         : ( emboss.head() + 8 - grey );
+            if ( bump < 0 )  bump = 0;
+            if ( bump > 15 ) bump = 15;
+        }
 
-                uchar& grey = *readData; // qBlue(*data);
+        const uint *const palette = texturepalette[bump];
+        const uint alpha = qRed( coastLine[x] );
 
-                if ( m_showRelief ) {
-                    emboss << grey;
-                    bump = ( emboss.head() + 16 - grey ) >> 1;
-                    if ( bump > 15 ) bump = 15;
-                    if ( bump < 0 )  bump = 0;
-                }
-                setPixel( coastData, writeData, bump, grey );
-            }
+        if ( alpha == 0 ) {
+            scanLine[x] = palette[grey];
+        }
+        else if ( alpha == 255 ) {
+            scanLine[x] = palette[grey + 0x100];
+        }
+        else {
+            scanLine[x] = blendColors( palette[grey], palette[grey + 0x100], alpha );
         }
-    }
-}
-
-void TextureColorizer::setPixel( const QRgb *coastData, QRgb *writeData, int bump, uchar grey )
-{
-    int alpha = qRed( *coastData );
-    if ( alpha == 255 )
-        *writeData = texturepalette[bump][grey + 0x100];
-    else if( alpha == 0 ){
-        *writeData = texturepalette[bump][grey];
-    }
-    else {
-        qreal c = 1.0 / 255.0;
-
-        QRgb landcolor  = (QRgb)(texturepalette[bump][grey + 0x100]);
-        QRgb watercolor = (QRgb)(texturepalette[bump][grey]);
-
-        *writeData = qRgb(
-                    (int) ( c * ( alpha * qRed( landcolor )
-                                  + ( 255 - alpha ) * qRed( watercolor ) ) ),
-                    (int) ( c * ( alpha * qGreen( landcolor )
-                                  + ( 255 - alpha ) * qGreen( watercolor ) ) ),
-                    (int) ( c * ( alpha * qBlue( landcolor )
-                                  + ( 255 - alpha ) * qBlue( watercolor ) ) )
-                    );
     }
 }
 }
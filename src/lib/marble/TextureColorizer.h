@@ -24,6 +24,7 @@
 #include <QImage>
 #include <QPen>
 #include <QBrush>
+#include <QVector>
 
 namespace Marble
 {
@@ -50,7 +51,16 @@ class TextureColorizer
 
     void colorize( QImage *origimg, const ViewportParams *viewport, MapQuality mapQuality );
 
-    void setPixel( const QRgb *coastData, QRgb *writeData, int bump, uchar grey );
+ private:
+    class ColorizeJob;
+
+    /**
+     * Redraws the land/sea mask unless it was already drawn for the same
+     * view, map quality and visible sea documents.
+     */
+    void updateCoastImage( const ViewportParams *viewport, MapQuality mapQuality );
+
+    void colorizeScanLine( QRgb *scanLine, const QRgb *coastLine, int count, bool globe ) const;
 
  private:
     QString m_seafile;
@@ -58,6 +68,13 @@ class TextureColorizer
     QList<const GeoDataDocument*> m_seaDocuments;
     QList<const GeoDataDocument*> m_landDocuments;
     QImage m_coastImage;
+    bool m_coastImageDirty;
+    Projection m_coastProjection;
+    int m_coastRadius;
+    qreal m_coastCenterLon;
+    qreal m_coastCenterLat;
+    MapQuality m_coastMapQuality;
+    QVector<bool> m_coastSeaVisibility;
     uint texturepalette[16][512];
     bool m_showRelief;
     QRgb      m_landColor;
@@ -21,6 +21,7 @@ class GeoPainter;
 class StackedTile;
 class StackedTileLoader;
 class TextureColorizer;
+class TileId;
 class ViewportParams;
 
 
@@ -38,6 +39,22 @@ public:
 
     void setRepaintNeeded();
 
+    /**
+     * @brief Notifies the texture mapper that the center of the map has moved.
+     *
+     * Texture mappers that can reuse their previous canvas when the map is
+     * panned reimplement this. The default implementation requests a full repaint.
+     */
+    virtual void setCenterMoved();
+
+    /**
+     * @brief Notifies the texture mapper that the given stacked tile has changed.
+     *
+     * Texture mappers that can update parts of their canvas reimplement this.
+     * The default implementation requests a full repaint.
+     */
+    virtual void setTileRepaintNeeded( const TileId &stackedTileId );
+
 protected:
     bool m_repaintNeeded;
 };
@@ -0,0 +1,220 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "TileCacheJournal.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStringList>
+
+#include "MarbleDebug.h"
+#include "MarbleGlobal.h"
+
+namespace Marble
+{
+
+// "MTCJ", followed by the version of the journal format
+static const quint32 journalMagic = 0x4d54434a;
+static const quint32 journalVersion = 1;
+
+Q_GLOBAL_STATIC( QMutex, s_journalMutex )
+
+static QDataStream &operator<<( QDataStream &stream, const TileCacheJournal::Record &record )
+{
+    stream << quint8( record.type ) << record.path << record.size << record.time;
+    return stream;
+}
+
+static QDataStream &operator>>( QDataStream &stream, TileCacheJournal::Record &record )
+{
+    quint8 type;
+    stream >> type >> record.path >> record.size >> record.time;
+    record.type = TileCacheJournal::RecordType( type );
+    return stream;
+}
+
+TileCacheJournal::TileCacheJournal( const QString &dataDirectory )
+    : m_dataDirectory( dataDirectory ),
+      m_fileName( dataDirectory + "/cache_journal.bin" ),
+      m_readPosition( 0 ),
+      m_recordCount( 0 )
+{
+}
+
+bool TileCacheJournal::isTileFile( const QString &relativePath )
+{
+    // maps/planet/theme/level/.../tile
+    const QStringList path = relativePath.split( '/' );
+    if ( path.size() < 6 || path.first() != QLatin1String( "maps" ) ) {
+        return false;
+    }
+
+    if ( path.at( 3 ).toInt() < maxBaseTileLevel ) {
+        return false;
+    }
+
+    // We try to be very careful and just delete images
+    const QString fileName = path.last().toLower();
+    return fileName.endsWith( QLatin1String( ".jpg" ) )
+        || fileName.endsWith( QLatin1String( ".png" ) )
+        || fileName.endsWith( QLatin1String( ".gif" ) )
+        || fileName.endsWith( QLatin1String( ".svg" ) );
+}
+
+QString TileCacheJournal::relativePath( const QString &fileName ) const
+{
+    return QDir( m_dataDirectory ).relativeFilePath( fileName );
+}
+
+void TileCacheJournal::recordWrite( const QString &relativePath, qint64 size )
+{
+    Record record;
+    record.type = WriteRecord;
+    record.path = relativePath;
+    record.size = size;
+    record.time = QDateTime::currentMSecsSinceEpoch();
+    append( record );
+}
+
+void TileCacheJournal::recordRemoval( const QString &relativePath )
+{
+    Record record;
+    record.type = RemoveRecord;
+    record.path = relativePath;
+    record.size = 0;
+    record.time = QDateTime::currentMSecsSinceEpoch();
+    append( record );
+}
+
+bool TileCacheJournal::readRecords( QVector<Record> &records )
+{
+    QMutexLocker locker( s_journalMutex() );
+    return readUnlocked( records );
+}
+
+bool TileCacheJournal::readUnlocked( QVector<Record> &records )
+{
+    QFile file( m_fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return false;
+    }
+
+    // The journal has been replaced behind our back
+    if ( file.size() < m_readPosition ) {
+        return false;
+    }
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_4_8 );
+
+    if ( m_readPosition == 0 ) {
+        quint32 magic;
+        quint32 version;
+        stream >> magic >> version;
+        if ( stream.status() != QDataStream::Ok || magic != journalMagic || version != journalVersion ) {
+            mDebug() << "Ignoring invalid tile cache journal" << m_fileName;
+            return false;
+        }
+        m_readPosition = file.pos();
+        m_recordCount = 0;
+    }
+    else {
+        file.seek( m_readPosition );
+    }
+
+    while ( !stream.atEnd() ) {
+        Record record;
+        stream >> record;
+
+        // A record that is cut off was still being written, read it next time
+        if ( stream.status() != QDataStream::Ok ) {
+            break;
+        }
+
+        if ( record.type != WriteRecord && record.type != RemoveRecord ) {
+            mDebug() << "Corrupt tile cache journal" << m_fileName;
+            return false;
+        }
+
+        records.append( record );
+        m_readPosition = file.pos();
+        ++m_recordCount;
+    }
+
+    return true;
+}
+
+int TileCacheJournal::recordCount() const
+{
+    return m_recordCount;
+}
+
+bool TileCacheJournal::writeSnapshot( const QVector<Record> &entries )
+{
+    QMutexLocker locker( s_journalMutex() );
+
+    // Records appended since the caller read the journal last are not part
+    // of the entries yet, keep them behind the snapshot to be read next time
+    const qint64 readPosition = m_readPosition;
+    const int recordCount = m_recordCount;
+    QVector<Record> unread;
+    if ( !readUnlocked( unread ) ) {
+        unread.clear();
+    }
+    m_readPosition = readPosition;
+    m_recordCount = recordCount;
+
+    QSaveFile file( m_fileName );
+    if ( !file.open( QIODevice::WriteOnly ) ) {
+        mDebug() << "Unable to write tile cache journal" << m_fileName;
+        return false;
+    }
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_4_8 );
+
+    stream << journalMagic << journalVersion;
+    foreach ( const Record &record, entries ) {
+        stream << record;
+    }
+
+    const qint64 size = file.pos();
+    foreach ( const Record &record, unread ) {
+        stream << record;
+    }
+
+    if ( !file.commit() ) {
+        mDebug() << "Unable to write tile cache journal" << m_fileName;
+        return false;
+    }
+
+    m_readPosition = size;
+    m_recordCount = entries.size();
+    return true;
+}
+
+void TileCacheJournal::append( const Record &record )
+{
+    QMutexLocker locker( s_journalMutex() );
+
+    QFile file( m_fileName );
+    if ( !file.exists() || !file.open( QIODevice::WriteOnly | QIODevice::Append ) ) {
+        return;
+    }
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_4_8 );
+    stream << record;
+}
+
+}
@@ -0,0 +1,103 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_TILECACHEJOURNAL_H
+#define MARBLE_TILECACHEJOURNAL_H
+
+#include <QString>
+#include <QVector>
+
+namespace Marble
+{
+
+/**
+ * @brief An append-only log of the tiles written to and removed from the cache.
+ *
+ * FileStoragePolicy records every tile it writes, FileStorageWatcher replays
+ * the journal to know the size and the age of the cached tiles without
+ * walking the cache directory. The watcher rewrites the journal as a
+ * snapshot of the current entries from time to time, which keeps it from
+ * growing without bounds.
+ *
+ * Several journal objects may be used for the same data directory in
+ * different threads, the file accesses are serialized.
+ */
+class TileCacheJournal
+{
+ public:
+    enum RecordType {
+        WriteRecord = 1,
+        RemoveRecord = 2
+    };
+
+    struct Record
+    {
+        RecordType type;
+        // relative to the data directory
+        QString path;
+        qint64 size;
+        // milliseconds since the epoch
+        qint64 time;
+    };
+
+    explicit TileCacheJournal( const QString &dataDirectory );
+
+    /**
+     * Returns whether the file at @p relativePath is a tile that is tracked
+     * by the journal and may be deleted to enforce the cache limit.
+     */
+    static bool isTileFile( const QString &relativePath );
+
+    /**
+     * Returns @p fileName relative to the data directory.
+     */
+    QString relativePath( const QString &fileName ) const;
+
+    /**
+     * Records that the tile at @p relativePath has been written.
+     * Nothing is recorded as long as the journal has not been created by
+     * writeSnapshot(), a repair scan of the cache will find the tile then.
+     */
+    void recordWrite( const QString &relativePath, qint64 size );
+
+    void recordRemoval( const QString &relativePath );
+
+    /**
+     * Appends the records written since the last call to @p records.
+     * @return false if the journal does not exist or is corrupt, in this
+     *         case the cache needs to be scanned.
+     */
+    bool readRecords( QVector<Record> &records );
+
+    /**
+     * Returns the number of records read by readRecords() since the last
+     * snapshot, including the ones of the snapshot.
+     */
+    int recordCount() const;
+
+    /**
+     * Replaces the journal by the write records @p entries. Records that
+     * were appended after the last call to readRecords() are kept, the next
+     * call to readRecords() returns them.
+     * @return false if the journal could not be written.
+     */
+    bool writeSnapshot( const QVector<Record> &entries );
+
+ private:
+    bool readUnlocked( QVector<Record> &records );
+    void append( const Record &record );
+
+    const QString m_dataDirectory;
+    const QString m_fileName;
+    qint64 m_readPosition;
+    int m_recordCount;
+};
+
+}
+
+#endif
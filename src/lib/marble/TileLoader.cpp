@@ -47,12 +47,15 @@ TileLoader::TileLoader(HttpDownloadManager * const downloadManager, const Plugin
     m_pluginManager(pluginManager)
 {
     qRegisterMetaType<DownloadUsage>( "DownloadUsage" );
-    connect( this, SIGNAL(downloadTile(QUrl,QString,QString,DownloadUsage)),
-             downloadManager, SLOT(addJob(QUrl,QString,QString,DownloadUsage)));
+    qRegisterMetaType<GeoDataLatLonBox>( "GeoDataLatLonBox" );
+    connect( this, SIGNAL(downloadTile(QUrl,QString,QString,DownloadUsage,GeoDataLatLonBox,int)),
+             downloadManager, SLOT(addJob(QUrl,QString,QString,DownloadUsage,GeoDataLatLonBox,int)));
     connect( downloadManager, SIGNAL(downloadComplete(QString,QString)),
              SLOT(updateTile(QString,QString)));
     connect( downloadManager, SIGNAL(downloadComplete(QByteArray,QString)),
              SLOT(updateTile(QByteArray,QString)));
+    connect( downloadManager, SIGNAL(downloadDropped(QString)),
+             SLOT(dropTile(QString)));
 }
 
 TileLoader::~TileLoader()
@@ -252,6 +255,23 @@ void TileLoader::updateTile(const QString &fileName, const QString &idStr)
     }
 }
 
+void TileLoader::dropTile( QString const & idStr )
+{
+    QStringList const components = idStr.split( ':', QString::SkipEmptyParts );
+    if ( components.size() != 5 )
+        return;
+
+    QString const origin = components[0];
+    QString const sourceDir = components[ 1 ];
+    int const zoomLevel = components[ 2 ].toInt();
+    int const tileX = components[ 3 ].toInt();
+    int const tileY = components[ 4 ].toInt();
+
+    if ( origin == GeoSceneTypes::GeoSceneTextureTileType ) {
+        emit tileDropped( TileId( sourceDir, zoomLevel, tileX, tileY ) );
+    }
+}
+
 QString TileLoader::tileFileName( GeoSceneTileDataset const * tileData, TileId const & tileId )
 {
     QString const fileName = tileData->relativeTileFileName( tileId );
@@ -272,7 +292,7 @@ void TileLoader::triggerDownload( GeoSceneTileDataset const *tileData, TileId co
     QUrl const sourceUrl = tileData->downloadUrl( id );
     QString const destFileName = tileData->relativeTileFileName( id );
     QString const idStr = QString( "%1:%2:%3:%4:%5" ).arg( tileData->nodeType()).arg( tileData->sourceDir() ).arg( id.zoomLevel() ).arg( id.x() ).arg( id.y() );
-    emit downloadTile( sourceUrl, destFileName, idStr, usage );
+    emit downloadTile( sourceUrl, destFileName, idStr, usage, id.toLatLonBox( tileData ), id.zoomLevel() );
 }
 
 QImage TileLoader::scaledLowerLevelTile( const GeoSceneTextureTileDataset * textureData, TileId const & id )
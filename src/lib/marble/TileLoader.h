@@ -76,20 +76,32 @@ class TileLoader: public QObject
       */
     static TileStatus tileStatus( GeoSceneTileDataset const *tileData, const TileId &tileId );
 
+    /**
+      * Returns the absolute path of the file of the tile @p tileId, whether it exists or not.
+      */
+    static QString tileFileName( GeoSceneTileDataset const * tileData, TileId const & );
+
  public Q_SLOTS:
     void updateTile( QByteArray const & imageData, QString const & tileId );
     void updateTile( QString const & fileName, QString const & idStr );
+    void dropTile( QString const & idStr );
 
  Q_SIGNALS:
     void downloadTile( QUrl const & sourceUrl, QString const & destinationFileName,
-                       QString const & id, DownloadUsage );
+                       QString const & id, DownloadUsage,
+                       GeoDataLatLonBox const & tileLatLonBox, int tileZoomLevel );
 
     void tileCompleted( TileId const & tileId, QImage const & tileImage );
 
     void tileCompleted( TileId const & tileId, GeoDataDocument * document );
 
+    /**
+     * The download of the texture tile @p tileId was dropped, the tile
+     * needs to be loaded again to request it.
+     */
+    void tileDropped( TileId const & tileId );
+
  private:
-    static QString tileFileName( GeoSceneTileDataset const * tileData, TileId const & );
     void triggerDownload( GeoSceneTileDataset const *tileData, TileId const &, DownloadUsage const );
     static QImage scaledLowerLevelTile( GeoSceneTextureTileDataset const * textureData, TileId const & );
     GeoDataDocument* openVectorFile(const QString &filename) const;
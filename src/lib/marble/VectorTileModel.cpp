@@ -13,6 +13,11 @@
 
 #include "GeoDataDocument.h"
 #include "GeoDataLatLonBox.h"
+#include "GeoDataLineString.h"
+#include "GeoDataLinearRing.h"
+#include "GeoDataMultiGeometry.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPolygon.h"
 #include "GeoDataTreeModel.h"
 #include "GeoDataTypes.h"
 #include "GeoSceneVectorTileDataset.h"
@@ -23,35 +28,117 @@
 #include "TileLoader.h"
 
 #include <qmath.h>
+#include <QSet>
 #include <QThreadPool>
 
 using namespace Marble;
 
-TileRunner::TileRunner( TileLoader *loader, const GeoSceneVectorTileDataset *texture, const TileId &id ) :
+// Documents of tiles which are not displayed are kept up to this size
+static const int cacheByteCount = 64 * 1024 * 1024;
+
+// Rough memory usage of a placemark without its geometry and of a coordinate
+static const int placemarkByteCount = 1024;
+static const int coordinatesByteCount = 96;
+
+// The tiles ahead of a panning motion are loaded for this time span
+static const qreal prefetchMilliseconds = 500.0;
+// Motions are considered to have stopped after this time without a viewport change
+static const qint64 motionTimeout = 1000;
+// Tiles to load in advance are not requested while more tiles are pending
+static const int maxPendingTiles = 64;
+
+// Background jobs loading the visible tiles are run first
+static const int visibleTilePriority = 1;
+static const int prefetchTilePriority = 0;
+
+// Tiles loaded in advance are out of sight or more detailed than the current
+// tile level, so their downloads would be held back as browse downloads
+// until the viewport reaches them. Bulk downloads are not held back, but wait
+// for the downloads of the visible tiles to finish.
+static DownloadUsage downloadUsage( int priority )
+{
+    return priority == visibleTilePriority ? DownloadBrowse : DownloadBulk;
+}
+
+// The latitudes covered by the tiles of the Mercator projection
+static const qreal maxLatitude = 85.0511287798;
+
+static int geometryCoordinateCount( const GeoDataGeometry *geometry )
+{
+    if ( !geometry ) {
+        return 0;
+    }
+
+    const char *const nodeType = geometry->nodeType();
+    if ( nodeType == GeoDataTypes::GeoDataLineStringType || nodeType == GeoDataTypes::GeoDataLinearRingType ) {
+        return static_cast<const GeoDataLineString *>( geometry )->size();
+    }
+
+    if ( nodeType == GeoDataTypes::GeoDataPolygonType ) {
+        const GeoDataPolygon *const polygon = static_cast<const GeoDataPolygon *>( geometry );
+        int count = polygon->outerBoundary().size();
+        foreach ( const GeoDataLinearRing &ring, polygon->innerBoundaries() ) {
+            count += ring.size();
+        }
+        return count;
+    }
+
+    if ( nodeType == GeoDataTypes::GeoDataMultiGeometryType ) {
+        const GeoDataMultiGeometry *const multiGeometry = static_cast<const GeoDataMultiGeometry *>( geometry );
+        int count = 0;
+        QVector<GeoDataGeometry *>::ConstIterator it = multiGeometry->constBegin();
+        QVector<GeoDataGeometry *>::ConstIterator const end = multiGeometry->constEnd();
+        for ( ; it != end; ++it ) {
+            count += geometryCoordinateCount( *it );
+        }
+        return count;
+    }
+
+    return 1;
+}
+
+TileRunner::TileRunner( TileLoader *loader, const GeoSceneVectorTileDataset *texture, const TileId &id, DownloadUsage usage ) :
     m_loader( loader ),
     m_texture( texture ),
-    m_id( id )
+    m_id( id ),
+    m_usage( usage )
 {
 }
 
 void TileRunner::run()
 {
-    GeoDataDocument *const document = m_loader->loadTileVectorData( m_texture, m_id, DownloadBrowse );
+    GeoDataDocument *const document = m_loader->loadTileVectorData( m_texture, m_id, m_usage );
 
     emit documentLoaded( m_id, document );
 }
 
-VectorTileModel::CacheDocument::CacheDocument(GeoDataDocument *doc, VectorTileModel *vectorTileModel, const GeoDataLatLonBox &boundingBox) :
+VectorTileModel::CacheDocument::CacheDocument( GeoDataDocument *doc, VectorTileModel *vectorTileModel ) :
     m_document( doc ),
-    m_vectorTileModel(vectorTileModel),
-    m_boundingBox(boundingBox)
+    m_vectorTileModel( vectorTileModel ),
+    m_byteCount( byteCount( doc ) ),
+    m_displayed( false )
 {
     // nothing to do
 }
 
 VectorTileModel::CacheDocument::~CacheDocument()
 {
-    m_vectorTileModel->removeTile(m_document);
+    if ( m_displayed ) {
+        // deleted by cleanupTile() once it is removed from the tree
+        m_vectorTileModel->m_garbageQueue << m_document;
+        m_vectorTileModel->removeTile( m_document );
+    } else {
+        delete m_document;
+    }
+}
+
+int VectorTileModel::CacheDocument::byteCount( const GeoDataDocument *document )
+{
+    int count = sizeof( GeoDataDocument );
+    foreach ( const GeoDataPlacemark *placemark, document->placemarkList() ) {
+        count += placemarkByteCount + coordinatesByteCount * geometryCoordinateCount( placemark->geometry() );
+    }
+    return count;
 }
 
 VectorTileModel::VectorTileModel( TileLoader *loader, const GeoSceneVectorTileDataset *layer, GeoDataTreeModel *treeModel, QThreadPool *threadPool ) :
@@ -60,13 +147,24 @@ VectorTileModel::VectorTileModel( TileLoader *loader, const GeoSceneVectorTileDa
     m_treeModel( treeModel ),
     m_threadPool( threadPool ),
     m_tileLoadLevel( -1 ),
-    m_tileZoomLevel(-1)
+    m_tileZoomLevel( -1 ),
+    m_radius( 0 ),
+    m_cache( cacheByteCount ),
+    m_centerLon( 0.0 ),
+    m_centerLat( 0.0 ),
+    m_lonVelocity( 0.0 ),
+    m_latVelocity( 0.0 )
 {
     connect(this, SIGNAL(tileAdded(GeoDataDocument*)), treeModel, SLOT(addDocument(GeoDataDocument*)) );
     connect(this, SIGNAL(tileRemoved(GeoDataDocument*)), treeModel, SLOT(removeDocument(GeoDataDocument*)) );
     connect(treeModel, SIGNAL(removed(GeoDataObject*)), this, SLOT(cleanupTile(GeoDataObject*)) );
 }
 
+VectorTileModel::~VectorTileModel()
+{
+    clear();
+}
+
 void VectorTileModel::setViewport( const GeoDataLatLonBox &bbox, int radius )
 {
     // choose the smaller dimension for selecting the tile level, leading to higher-resolution results
@@ -89,93 +187,52 @@ void VectorTileModel::setViewport( const GeoDataLatLonBox &bbox, int radius )
     // roughly equals the global texture width
     m_tileZoomLevel = tileZoomLevel;
 
-    QVector<int> tileLevels = m_layer->tileLevels();
-    if (tileLevels.isEmpty() || tileZoomLevel < tileLevels.first()) {
-        m_documents.clear();
-        return;
-    }
-    int tileLevel = tileLevels.first();
-    for (int i=1, n=tileLevels.size(); i<n; ++i) {
-        if (tileLevels[i] > tileZoomLevel) {
+    // the tile level to load and its neighbors, -1 if there is none
+    int previousTileLevel = -1;
+    int tileLevel = -1;
+    int nextTileLevel = -1;
+    foreach ( int level, m_layer->tileLevels() ) {
+        if ( level > tileZoomLevel ) {
+            nextTileLevel = level;
             break;
         }
-        tileLevel = tileLevels[i];
+        previousTileLevel = tileLevel;
+        tileLevel = level;
     }
-    tileZoomLevel = tileLevel;
 
-    // if zoom level has changed, empty vectortile cache
-    if ( tileZoomLevel != m_tileLoadLevel ) {
-        m_tileLoadLevel = tileZoomLevel;
-        m_documents.clear();
+    const qreal lon = bbox.center().longitude( GeoDataCoordinates::Degree );
+    const qreal lat = bbox.center().latitude( GeoDataCoordinates::Degree );
+    const qreal width = bbox.width( GeoDataCoordinates::Degree );
+    const qreal height = bbox.height( GeoDataCoordinates::Degree );
+
+    updateMotion( bbox, tileLevel );
+    m_tileLoadLevel = tileLevel;
+
+    m_visibleTiles.clear();
+    if ( tileLevel >= 0 ) {
+        m_visibleTiles = tiles( tileLevel, lon, lat, width, height );
+        requestTiles( m_visibleTiles, visibleTilePriority );
+
+        // load the tiles ahead of a panning motion
+        if ( m_lonVelocity != 0.0 || m_latVelocity != 0.0 ) {
+            requestTiles( tiles( tileLevel,
+                                 lon + m_lonVelocity * prefetchMilliseconds,
+                                 lat + m_latVelocity * prefetchMilliseconds,
+                                 width, height ), prefetchTilePriority );
+        }
     }
 
-    const unsigned int maxTileX = ( 1 << tileZoomLevel ) * m_layer->levelZeroColumns();
-    const unsigned int maxTileY = ( 1 << tileZoomLevel ) * m_layer->levelZeroRows();
-
-    /** LOGIC FOR DOWNLOADING ALL THE TILES THAT ARE INSIDE THE SCREEN AT THE CURRENT ZOOM LEVEL **/
-
-    // New tiles X and Y for moved screen coordinates
-    // More info: http://wiki.openstreetmap.org/wiki/Slippy_map_tilenames#Subtiles
-    // More info: http://wiki.openstreetmap.org/wiki/Slippy_map_tilenames#C.2FC.2B.2B
-    // Sometimes the formula returns wrong huge values, x and y have to be between 0 and 2^ZoomLevel
-    unsigned int minX = qMin<unsigned int>( maxTileX,
-                              qMax<unsigned int>( lon2tileX( bbox.west(GeoDataCoordinates::Degree), maxTileX ),
-                                    0 ) );
-
-    unsigned int minY = qMin<unsigned int>( maxTileY,
-                              qMax<unsigned int>( lat2tileY( bbox.north(GeoDataCoordinates::Degree), maxTileY ),
-                                    0 ) );
-
-    unsigned int maxX = qMax<unsigned int>( 0,
-                              qMin<unsigned int>( lon2tileX( bbox.east(GeoDataCoordinates::Degree), maxTileX ),
-                                    maxTileX ) );
-
-    unsigned int maxY = qMax<unsigned int>( 0,
-                              qMin<unsigned int>( lat2tileY( bbox.south(GeoDataCoordinates::Degree), maxTileY ),
-                                    maxTileY ) );
-
-    bool left  = minX < maxTileX;
-    bool right = maxX > 0;
-    bool up    = minY < maxTileY;
-    bool down  = maxY > 0 ;
-
-    // Download tiles and send them to VectorTileLayer
-    // When changing zoom, download everything inside the screen
-    if ( left && right && up && down )
-
-                setViewport( tileZoomLevel, minX, minY, maxX, maxY );
-
-    // When only moving screen, just download the new tiles
-    else if ( left || right || up || down ){
-
-        if ( left )
-            setViewport( tileZoomLevel, minX, maxTileY, maxTileX, 0 );
-        if ( right )
-            setViewport( tileZoomLevel, 0, maxTileY, maxX, 0 );
-        if ( up )
-            setViewport( tileZoomLevel, maxTileX, minY, 0, maxTileY );
-        if ( down )
-            setViewport( tileZoomLevel, maxTileX, 0, 0, maxY );
-
-        // During testing discovered that this code above does not request the "corner" tiles
-
+    // When zooming in close to the next tile level, load the tiles it shows
+    // at half the size of the current viewport. When zooming out of the
+    // current tile level, load the ones of the previous level.
+    if ( radius > m_radius && nextTileLevel >= 0 && tileZoomLevel + 1 >= nextTileLevel ) {
+        requestTiles( tiles( nextTileLevel, lon, lat, 0.5 * width, 0.5 * height ), prefetchTilePriority );
+    } else if ( radius < m_radius && previousTileLevel >= 0 && tileZoomLevel == tileLevel ) {
+        requestTiles( tiles( previousTileLevel, lon, lat, 2.0 * width, 2.0 * height ), prefetchTilePriority );
     }
+    m_radius = radius;
 
-    removeTilesOutOfView(bbox);
-}
-
-void VectorTileModel::removeTilesOutOfView(const GeoDataLatLonBox &boundingBox)
-{
-    GeoDataLatLonBox const extendedViewport = boundingBox.scaled(2.0, 2.0);
-    for (auto iter = m_documents.begin(); iter != m_documents.end();) {
-        bool const isOutOfView = !extendedViewport.intersects(iter.value()->m_boundingBox);
-        if (isOutOfView) {
-            iter = m_documents.erase(iter);
-        }
-        else {
-            ++iter;
-        }
-    }
+    updateDisplayedTiles();
 }
 
 QString VectorTileModel::name() const
@@ -195,7 +252,7 @@ int VectorTileModel::tileZoomLevel() const
 
 int VectorTileModel::cachedDocuments() const
 {
-    return m_documents.size();
+    return m_documents.size() + m_cache.count();
 }
 
 void VectorTileModel::updateTile( const TileId &id, GeoDataDocument *document )
@@ -205,42 +262,175 @@ void VectorTileModel::updateTile( const TileId &id, GeoDataDocument *document )
         return;
     }
 
-    if ( m_tileLoadLevel != id.zoomLevel() ) {
-        delete document;
-        return;
-    }
-
     document->setName(QString("%1/%2/%3").arg(id.zoomLevel()).arg(id.x()).arg(id.y()));
-    m_garbageQueue << document;
-    if (m_documents.contains(id)) {
-        m_documents.remove(id);
+
+    // a tile downloaded again replaces the one loaded before
+    delete m_documents.take( id );
+    m_cache.remove( id );
+
+    CacheDocument *const tile = new CacheDocument( document, this );
+    if ( m_visibleTiles.contains( id ) ) {
+        showTile( id, tile );
+    } else {
+        m_cache.insert( id, tile, tile->m_byteCount );
     }
 
-    GeoDataLatLonBox const boundingBox = id.toLatLonBox(m_layer);
-    m_documents[id] = QSharedPointer<CacheDocument>(new CacheDocument(document, this, boundingBox));
-    emit tileAdded(document);
+    updateDisplayedTiles();
 }
 
 void VectorTileModel::clear()
 {
+    qDeleteAll( m_documents );
     m_documents.clear();
+    m_cache.clear();
 }
 
-void VectorTileModel::setViewport( int tileZoomLevel,
-                                   unsigned int minTileX, unsigned int minTileY, unsigned int maxTileX, unsigned int maxTileY )
+void VectorTileModel::updateMotion( const GeoDataLatLonBox &bbox, int tileLevel )
 {
-    // Download all the tiles inside the given indexes
-    for ( unsigned int x = minTileX; x <= maxTileX; ++x ) {
-        for ( unsigned int y = minTileY; y <= maxTileY; ++y ) {
-           const TileId tileId = TileId( 0, tileZoomLevel, x, y );
-           if ( !m_documents.contains( tileId ) && !m_pendingDocuments.contains( tileId ) ) {
-               m_pendingDocuments << tileId;
-               TileRunner *job = new TileRunner( m_loader, m_layer, tileId );
-               connect( job, SIGNAL(documentLoaded(TileId,GeoDataDocument*)), this, SLOT(updateTile(TileId,GeoDataDocument*)) );
-               m_threadPool->start( job );
-           }
+    const qreal lon = bbox.center().longitude( GeoDataCoordinates::Degree );
+    const qreal lat = bbox.center().latitude( GeoDataCoordinates::Degree );
+
+    // The viewport is usually moved by KineticModel or an animation in small
+    // steps, estimate the velocity from the steps during the same tile level
+    const qint64 elapsed = m_motionTimer.isValid() ? m_motionTimer.restart() : 0;
+    if ( tileLevel != m_tileLoadLevel || elapsed <= 0 || elapsed > motionTimeout ) {
+        m_lonVelocity = 0.0;
+        m_latVelocity = 0.0;
+    } else {
+        qreal deltaLon = lon - m_centerLon;
+        if ( deltaLon > 180.0 ) {
+            deltaLon -= 360.0;
+        } else if ( deltaLon < -180.0 ) {
+            deltaLon += 360.0;
+        }
+
+        // smooth out the uneven intervals between repaints
+        m_lonVelocity = 0.5 * ( m_lonVelocity + deltaLon / elapsed );
+        m_latVelocity = 0.5 * ( m_latVelocity + ( lat - m_centerLat ) / elapsed );
+    }
+
+    if ( !m_motionTimer.isValid() ) {
+        m_motionTimer.start();
+    }
+    m_centerLon = lon;
+    m_centerLat = lat;
+}
+
+void VectorTileModel::requestTiles( const QVector<TileId> &tileIds, int priority )
+{
+    foreach ( const TileId &tileId, tileIds ) {
+        if ( priority != visibleTilePriority && m_pendingDocuments.size() >= maxPendingTiles ) {
+            return;
+        }
+
+        if ( !isInMemory( tileId ) && !m_pendingDocuments.contains( tileId ) ) {
+            m_pendingDocuments << tileId;
+            TileRunner *job = new TileRunner( m_loader, m_layer, tileId, downloadUsage( priority ) );
+            connect( job, SIGNAL(documentLoaded(TileId,GeoDataDocument*)), this, SLOT(updateTile(TileId,GeoDataDocument*)) );
+            m_threadPool->start( job, priority );
+        }
+    }
+}
+
+void VectorTileModel::updateDisplayedTiles()
+{
+    QSet<TileId> displayedTiles;
+    foreach ( const TileId &id, m_visibleTiles ) {
+        if ( isInMemory( id ) ) {
+            displayedTiles << id;
+            continue;
+        }
+
+        // Display the closest ancestor in memory while the tile is loaded
+        bool hasPlaceholder = false;
+        for ( int level = id.zoomLevel() - 1; level >= 0 && !hasPlaceholder; --level ) {
+            const int deltaLevel = id.zoomLevel() - level;
+            const TileId ancestorId( 0, level, id.x() >> deltaLevel, id.y() >> deltaLevel );
+            if ( isInMemory( ancestorId ) ) {
+                displayedTiles << ancestorId;
+                hasPlaceholder = true;
+            }
+        }
+
+        // Otherwise keep the descendants displayed already, e.g. after zooming out
+        if ( !hasPlaceholder ) {
+            QHash<TileId, CacheDocument*>::ConstIterator it = m_documents.constBegin();
+            QHash<TileId, CacheDocument*>::ConstIterator const end = m_documents.constEnd();
+            for ( ; it != end; ++it ) {
+                const int deltaLevel = it.key().zoomLevel() - id.zoomLevel();
+                if ( deltaLevel > 0 && ( it.key().x() >> deltaLevel ) == id.x() && ( it.key().y() >> deltaLevel ) == id.y() ) {
+                    displayedTiles << it.key();
+                }
+            }
+        }
+    }
+
+    // Show the new tiles before hiding the others, hidden tiles may evict cached ones
+    foreach ( const TileId &id, displayedTiles ) {
+        if ( !m_documents.contains( id ) ) {
+            showTile( id, m_cache.take( id ) );
         }
     }
+
+    foreach ( const TileId &id, m_documents.keys() ) {
+        if ( !displayedTiles.contains( id ) ) {
+            hideTile( id );
+        }
+    }
+}
+
+void VectorTileModel::showTile( const TileId &id, CacheDocument *tile )
+{
+    m_documents[id] = tile;
+    tile->m_displayed = true;
+    emit tileAdded( tile->m_document );
+}
+
+void VectorTileModel::hideTile( const TileId &id )
+{
+    CacheDocument *const tile = m_documents.take( id );
+    tile->m_displayed = false;
+    emit tileRemoved( tile->m_document );
+
+    // If the tile is larger than the cache, QCache deletes it right away
+    m_cache.insert( id, tile, tile->m_byteCount );
+}
+
+bool VectorTileModel::isInMemory( const TileId &id ) const
+{
+    return m_documents.contains( id ) || m_cache.contains( id );
+}
+
+QVector<TileId> VectorTileModel::tiles( int tileLevel, qreal lon, qreal lat, qreal width, qreal height ) const
+{
+    const int maxTileX = ( 1 << tileLevel ) * m_layer->levelZeroColumns();
+    const int maxTileY = ( 1 << tileLevel ) * m_layer->levelZeroRows();
+
+    // More info: http://wiki.openstreetmap.org/wiki/Slippy_map_tilenames#Subtiles
+    // More info: http://wiki.openstreetmap.org/wiki/Slippy_map_tilenames#C.2FC.2B.2B
+    const qreal north = qBound( -maxLatitude, lat + 0.5 * height, maxLatitude );
+    const qreal south = qBound( -maxLatitude, lat - 0.5 * height, maxLatitude );
+    const int minY = qBound( 0, lat2tileY( north, maxTileY ), maxTileY - 1 );
+    const int maxY = qBound( 0, lat2tileY( south, maxTileY ), maxTileY - 1 );
+
+    // The columns may extend beyond the date line and are wrapped around
+    int minX = lon2tileX( lon - 0.5 * width, maxTileX );
+    int maxX = lon2tileX( lon + 0.5 * width, maxTileX );
+    if ( maxX - minX >= maxTileX ) {
+        minX = 0;
+        maxX = maxTileX - 1;
+    }
+
+    QVector<TileId> result;
+    result.reserve( ( maxX - minX + 1 ) * ( maxY - minY + 1 ) );
+    for ( int x = minX; x <= maxX; ++x ) {
+        const int tileX = ( x % maxTileX + maxTileX ) % maxTileX;
+        for ( int y = minY; y <= maxY; ++y ) {
+            result << TileId( 0, tileLevel, tileX, y );
+        }
+    }
+
+    return result;
 }
 
 void VectorTileModel::cleanupTile(GeoDataObject *object)
@@ -254,14 +444,14 @@ void VectorTileModel::cleanupTile(GeoDataObject *object)
     }
 }
 
-unsigned int VectorTileModel::lon2tileX( qreal lon, unsigned int maxTileX )
+int VectorTileModel::lon2tileX( qreal lon, int maxTileX )
 {
-    return (unsigned int)floor((lon + 180.0) / 360.0 * maxTileX);
+    return (int)floor((lon + 180.0) / 360.0 * maxTileX);
 }
 
-unsigned int VectorTileModel::lat2tileY( qreal lat, unsigned int maxTileY )
+int VectorTileModel::lat2tileY( qreal lat, int maxTileY )
 {
-    return (unsigned int)floor((1.0 - log( tan(lat * M_PI/180.0) + 1.0 / cos(lat * M_PI/180.0)) / M_PI) / 2.0 * maxTileY);
+    return (int)floor((1.0 - log( tan(lat * M_PI/180.0) + 1.0 / cos(lat * M_PI/180.0)) / M_PI) / 2.0 * maxTileY);
 }
 
 #include "moc_VectorTileModel.cpp"
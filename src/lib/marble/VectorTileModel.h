@@ -15,8 +15,12 @@
 #include <QObject>
 #include <QRunnable>
 
-#include <QMap>
+#include <QCache>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
 
+#include "MarbleGlobal.h"
 #include "TileId.h"
 
 class QThreadPool;
@@ -36,7 +40,7 @@ class TileRunner : public QObject, public QRunnable
     Q_OBJECT
 
 public:
-    TileRunner( TileLoader *loader, const GeoSceneVectorTileDataset *texture, const TileId &id );
+    TileRunner( TileLoader *loader, const GeoSceneVectorTileDataset *texture, const TileId &id, DownloadUsage usage );
     void run();
 
 Q_SIGNALS:
@@ -46,14 +50,32 @@ private:
     TileLoader *const m_loader;
     const GeoSceneVectorTileDataset *const m_texture;
     const TileId m_id;
+    const DownloadUsage m_usage;
 };
 
+/**
+ * Loads the vector tiles of a dataset and passes the documents of the tiles
+ * that cover the viewport to the tree model.
+ *
+ * Tiles that are no longer displayed are kept in a cache limited by the
+ * estimated memory usage of their documents, so panning back or changing
+ * the zoom level does not load and parse them again. While a tile is
+ * loaded, its closest ancestor in memory is displayed instead, or the
+ * descendants displayed already when zooming out.
+ *
+ * Besides the visible tiles, the tiles the viewport is moving to are
+ * loaded in advance: the ones ahead of a panning motion, the ones of the
+ * next tile level when zooming in close to it and those of the previous
+ * tile level when zooming out. Their downloads are bulk downloads, which
+ * are not held back outside of the viewport but wait for the visible tiles.
+ */
 class VectorTileModel : public QObject
 {
     Q_OBJECT
 
 public:
     explicit VectorTileModel( TileLoader *loader, const GeoSceneVectorTileDataset *layer, GeoDataTreeModel *treeModel, QThreadPool *threadPool );
+    ~VectorTileModel();
 
     void setViewport( const GeoDataLatLonBox &bbox, int radius );
 
@@ -79,24 +101,40 @@ private Q_SLOTS:
     void cleanupTile(GeoDataObject* feature);
 
 private:
-    void removeTilesOutOfView(const GeoDataLatLonBox &boundingBox);
-    void setViewport( int tileZoomLevel, unsigned int minX, unsigned int minY, unsigned int maxX, unsigned int maxY );
+    struct CacheDocument;
 
-    static unsigned int lon2tileX( qreal lon, unsigned int maxTileX );
-    static unsigned int lat2tileY( qreal lat, unsigned int maxTileY );
+    void updateMotion( const GeoDataLatLonBox &bbox, int tileLevel );
+    void requestTiles( const QVector<TileId> &tileIds, int priority );
+    void updateDisplayedTiles();
+    void showTile( const TileId &id, CacheDocument *tile );
+    void hideTile( const TileId &id );
+    bool isInMemory( const TileId &id ) const;
+
+    /**
+     * Returns the tiles of level @p tileLevel covering the area of @p width
+     * and @p height degrees around @p lon and @p lat.
+     */
+    QVector<TileId> tiles( int tileLevel, qreal lon, qreal lat, qreal width, qreal height ) const;
+
+    static int lon2tileX( qreal lon, int maxTileX );
+    static int lat2tileY( qreal lat, int maxTileY );
 
 private:
     struct CacheDocument
     {
         /** The CacheDocument takes ownership of doc */
-        CacheDocument(GeoDataDocument *doc, VectorTileModel* vectorTileModel, const GeoDataLatLonBox &boundingBox);
+        CacheDocument( GeoDataDocument *doc, VectorTileModel* vectorTileModel );
 
-        /** Remove the document from the tree and delete the document */
+        /** Remove the document from the tree if it is displayed and delete the document */
         ~CacheDocument();
 
+        /** A rough estimate of the memory used by the document */
+        static int byteCount( const GeoDataDocument *document );
+
         GeoDataDocument *const m_document;
         VectorTileModel *m_vectorTileModel;
-        GeoDataLatLonBox m_boundingBox;
+        const int m_byteCount;
+        bool m_displayed;
 
     private:
         Q_DISABLE_COPY( CacheDocument )
@@ -108,9 +146,23 @@ private:
     QThreadPool *const m_threadPool;
     int m_tileLoadLevel;
     int m_tileZoomLevel;
-    QMap<TileId, QSharedPointer<CacheDocument> > m_documents;
+    int m_radius;
+
+    // the tiles covering the viewport, at the tile level to load
+    QVector<TileId> m_visibleTiles;
+    // documents in the tree model, including placeholders of visible tiles
+    QHash<TileId, CacheDocument*> m_documents;
+    // documents not in the tree model, the cost is their estimated byte count
+    QCache<TileId, CacheDocument> m_cache;
     QList<TileId> m_pendingDocuments;
     QList<GeoDataDocument*> m_garbageQueue;
+
+    // the center of the last viewport and its motion in degrees per millisecond
+    qreal m_centerLon;
+    qreal m_centerLat;
+    qreal m_lonVelocity;
+    qreal m_latVelocity;
+    QElapsedTimer m_motionTimer;
 };
 
 }
@@ -20,6 +20,7 @@
 #include <QRegion>
 
 #include "MarbleDebug.h"
+#include "ScreenPolygonCache.h"
 #include "SphericalProjection.h"
 #include "EquirectProjection.h"
 #include "MercatorProjection.h"
@@ -72,6 +73,8 @@ public:
     static const VerticalPerspectiveProjection   s_verticalPerspectiveProjection;
 
     GeoDataCoordinates   m_focusPoint;
+
+    const ScreenPolygonCache *m_screenPolygonCache;
 };
 
 const SphericalProjection  ViewportParamsPrivate::s_sphericalProjection;
@@ -97,7 +100,8 @@ ViewportParamsPrivate::ViewportParamsPrivate( Projection projection,
       m_angularResolution( 4 / fabs( (qreal)( m_radius ) ) ),
       m_size( size ),
       m_dirtyBox( true ),
-      m_viewLatLonAltBox()
+      m_viewLatLonAltBox(),
+      m_screenPolygonCache( 0 )
 {
 }
 
@@ -410,6 +414,11 @@ bool ViewportParams::screenCoordinates( const GeoDataCoordinates &coordinates,
 bool ViewportParams::screenCoordinates( const GeoDataLineString &lineString,
                         QVector<QPolygonF*> &polygons ) const
 {
+    bool result;
+    if ( d->m_screenPolygonCache && d->m_screenPolygonCache->screenCoordinates( lineString, polygons, result ) ) {
+        return result;
+    }
+
     return d->m_currentProjection->screenCoordinates( lineString, this, polygons );
 }
 
@@ -459,4 +468,9 @@ void ViewportParams::resetFocusPoint()
     d->m_focusPoint = GeoDataCoordinates();
 }
 
+void ViewportParams::setScreenPolygonCache( const ScreenPolygonCache *cache )
+{
+    d->m_screenPolygonCache = cache;
+}
+
 }
@@ -34,6 +34,7 @@ namespace Marble
 {
 
 class AbstractProjection;
+class ScreenPolygonCache;
 class ViewportParamsPrivate;
 
 /** 
@@ -212,6 +213,14 @@ class MARBLE_EXPORT ViewportParams
       */
     void resetFocusPoint();
 
+    /**
+      * @brief Use screen polygons that were projected in advance.
+      * While set, screenCoordinates() takes the polygons of line strings
+      * contained in @p cache from there. The cache must have been projected
+      * for the current state of the viewport. Pass 0 to unset it.
+      */
+    void setScreenPolygonCache( const ScreenPolygonCache *cache );
+
  private:
     Q_DISABLE_COPY( ViewportParams )
     ViewportParamsPrivate * const d;
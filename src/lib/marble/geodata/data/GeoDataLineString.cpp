@@ -279,17 +279,20 @@ void GeoDataLineStringPrivate::optimize (GeoDataLineString& lineString) const
 
 bool GeoDataLineString::isEmpty() const
 {
-    return p()->m_vector.isEmpty();
+    return size() == 0;
 }
 
 int GeoDataLineString::size() const
 {
-    return p()->m_vector.size();
+    const GeoDataLineStringPrivate* d = p();
+    // m_compactSize stays valid until the line string is modified
+    return d->m_compact.loadAcquire() ? d->m_compactSize : d->m_vector.size();
 }
 
 GeoDataCoordinates& GeoDataLineString::at( int pos )
 {
     GeoDataGeometry::detach();
+    p()->expand();
     p()->m_dirtyRange = true;
     p()->m_dirtyBox = true;
     return p()->m_vector[ pos ];
@@ -297,12 +300,14 @@ GeoDataCoordinates& GeoDataLineString::at( int pos )
 
 const GeoDataCoordinates& GeoDataLineString::at( int pos ) const
 {
+    p()->expand();
     return p()->m_vector.at( pos );
 }
 
 GeoDataCoordinates& GeoDataLineString::operator[]( int pos )
 {
     GeoDataGeometry::detach();
+    p()->expand();
     p()->m_dirtyRange = true;
     p()->m_dirtyBox = true;
     return p()->m_vector[ pos ];
@@ -310,12 +315,14 @@ GeoDataCoordinates& GeoDataLineString::operator[]( int pos )
 
 const GeoDataCoordinates& GeoDataLineString::operator[]( int pos ) const
 {
+    p()->expand();
     return p()->m_vector[ pos ];
 }
 
 GeoDataCoordinates& GeoDataLineString::last()
 {
     GeoDataGeometry::detach();
+    p()->expand();
     p()->m_dirtyRange = true;
     p()->m_dirtyBox = true;
     return p()->m_vector.last();
@@ -324,48 +331,57 @@ GeoDataCoordinates& GeoDataLineString::last()
 GeoDataCoordinates& GeoDataLineString::first()
 {
     GeoDataGeometry::detach();
+    p()->expand();
     return p()->m_vector.first();
 }
 
 const GeoDataCoordinates& GeoDataLineString::last() const
 {
+    p()->expand();
     return p()->m_vector.last();
 }
 
 const GeoDataCoordinates& GeoDataLineString::first() const
 {
+    p()->expand();
     return p()->m_vector.first();
 }
 
 QVector<GeoDataCoordinates>::Iterator GeoDataLineString::begin()
 {
     GeoDataGeometry::detach();
+    p()->expand();
     return p()->m_vector.begin();
 }
 
 QVector<GeoDataCoordinates>::ConstIterator GeoDataLineString::begin() const
 {
+    p()->expand();
     return p()->m_vector.constBegin();
 }
 
 QVector<GeoDataCoordinates>::Iterator GeoDataLineString::end()
 {
     GeoDataGeometry::detach();
+    p()->expand();
     return p()->m_vector.end();
 }
 
 QVector<GeoDataCoordinates>::ConstIterator GeoDataLineString::end() const
 {
+    p()->expand();
     return p()->m_vector.constEnd();
 }
 
 QVector<GeoDataCoordinates>::ConstIterator GeoDataLineString::constBegin() const
 {
+    p()->expand();
     return p()->m_vector.constBegin();
 }
 
 QVector<GeoDataCoordinates>::ConstIterator GeoDataLineString::constEnd() const
 {
+    p()->expand();
     return p()->m_vector.constEnd();
 }
 
@@ -373,6 +389,7 @@ void GeoDataLineString::insert( int index, const GeoDataCoordinates& value )
 {
     GeoDataGeometry::detach();
     GeoDataLineStringPrivate* d = p();
+    d->expand();
     delete d->m_rangeCorrected;
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
@@ -384,6 +401,7 @@ void GeoDataLineString::append ( const GeoDataCoordinates& value )
 {
     GeoDataGeometry::detach();
     GeoDataLineStringPrivate* d = p();
+    d->expand();
     delete d->m_rangeCorrected;
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
@@ -395,6 +413,7 @@ GeoDataLineString& GeoDataLineString::operator << ( const GeoDataCoordinates& va
 {
     GeoDataGeometry::detach();
     GeoDataLineStringPrivate* d = p();
+    d->expand();
     delete d->m_rangeCorrected;
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
@@ -407,6 +426,7 @@ GeoDataLineString& GeoDataLineString::operator << ( const GeoDataLineString& val
 {
     GeoDataGeometry::detach();
     GeoDataLineStringPrivate* d = p();
+    d->expand();
     delete d->m_rangeCorrected;
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
@@ -432,6 +452,8 @@ bool GeoDataLineString::operator==( const GeoDataLineString &other ) const
 
     const GeoDataLineStringPrivate* d = p();
     const GeoDataLineStringPrivate* other_d = other.p();
+    d->expand();
+    other_d->expand();
 
     QVector<GeoDataCoordinates>::const_iterator itCoords = d->m_vector.constBegin();
     QVector<GeoDataCoordinates>::const_iterator otherItCoords = other_d->m_vector.constBegin();
@@ -457,6 +479,7 @@ void GeoDataLineString::clear()
 {
     GeoDataGeometry::detach();
     GeoDataLineStringPrivate* d = p();
+    d->expand();
     delete d->m_rangeCorrected;
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
@@ -513,6 +536,7 @@ GeoDataLineString GeoDataLineString::toNormalized() const
 
     // FIXME: Think about how we can avoid unnecessary copies
     //        if the linestring stays the same.
+    p()->expand();
     QVector<GeoDataCoordinates>::const_iterator end = p()->m_vector.constEnd();
     for( QVector<GeoDataCoordinates>::const_iterator itCoords
           = p()->m_vector.constBegin();
@@ -573,6 +597,7 @@ GeoDataLineString GeoDataLineString::toPoleCorrected() const
 void GeoDataLineStringPrivate::toPoleCorrected( const GeoDataLineString& q, GeoDataLineString& poleCorrected ) const
 {
     poleCorrected.setTessellationFlags( q.tessellationFlags() );
+    expand();
 
     GeoDataCoordinates previousCoords;
     GeoDataCoordinates currentCoords;
@@ -755,6 +780,7 @@ qreal GeoDataLineString::length( qreal planetRadius, int offset ) const
         return 0;
     }
 
+    p()->expand();
     qreal length = 0.0;
     QVector<GeoDataCoordinates> const & vector = p()->m_vector;
     int const start = qMax(offset+1, 1);
@@ -771,6 +797,7 @@ QVector<GeoDataCoordinates>::Iterator GeoDataLineString::erase ( QVector<GeoData
 {
     GeoDataGeometry::detach();
     GeoDataLineStringPrivate* d = p();
+    d->expand();
     delete d->m_rangeCorrected;
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
@@ -783,6 +810,7 @@ QVector<GeoDataCoordinates>::Iterator GeoDataLineString::erase ( QVector<GeoData
 {
     GeoDataGeometry::detach();
     GeoDataLineStringPrivate* d = p();
+    d->expand();
     delete d->m_rangeCorrected;
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
@@ -794,6 +822,7 @@ void GeoDataLineString::remove ( int i )
 {
     GeoDataGeometry::detach();
     GeoDataLineStringPrivate* d = p();
+    d->expand();
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
     d->m_vector.remove( i );
@@ -812,6 +841,169 @@ GeoDataLineString GeoDataLineString::optimized () const
     }
 }
 
+void GeoDataLineString::compact( CompactPrecision precision )
+{
+    GeoDataGeometry::detach();
+
+    // The box stays valid while the line string is compact.
+    latLonAltBox();
+
+    p()->compact( precision == SinglePrecision );
+}
+
+bool GeoDataLineString::isCompact() const
+{
+    return p()->m_compact.loadAcquire();
+}
+
+void GeoDataLineString::resolvedNodes( qreal angularResolution, int maximumDetail,
+                                       GeoDataLineString &lineString ) const
+{
+    const GeoDataLineStringPrivate* d = p();
+
+    lineString.clear();
+    lineString.setTessellationFlags( tessellationFlags() );
+
+    QMutexLocker locker( &d->m_compactMutex );
+
+    if ( !d->m_compact.load() ) {
+        locker.unlock();
+
+        // Same criteria as in the loop below, applied to regular nodes
+        QVector<GeoDataCoordinates>::const_iterator itCoords = d->m_vector.constBegin();
+        QVector<GeoDataCoordinates>::const_iterator itPrevious = itCoords;
+        QVector<GeoDataCoordinates>::const_iterator itEnd = d->m_vector.constEnd();
+        const bool isLong = d->m_vector.size() > 10;
+        const bool hasDetail = itCoords != itEnd && itCoords->detail() != 0;
+
+        for ( ; itCoords != itEnd; ++itCoords ) {
+            const bool skipNode = hasDetail ? itCoords->detail() > maximumDetail
+                                            : itCoords != d->m_vector.constBegin() && isLong &&
+                                              fabs( itCoords->longitude() - itPrevious->longitude() )
+                                              + fabs( itCoords->latitude() - itPrevious->latitude() ) <= angularResolution;
+            if ( !skipNode ) {
+                lineString.p()->m_vector.append( *itCoords );
+                itPrevious = itCoords;
+            }
+        }
+
+        return;
+    }
+
+    // Read the compact arrays directly and only create GeoDataCoordinates
+    // objects for the nodes which are not skipped.
+    const int size = d->m_compactSize;
+    const bool isLong = size > 10;
+    const bool hasDetail = size > 0 && d->compactDetail( 0 ) != 0;
+
+    qreal previousLon = 0.0;
+    qreal previousLat = 0.0;
+
+    for ( int i = 0; i < size; ++i ) {
+        const qreal lon = d->compactLongitude( i );
+        const qreal lat = d->compactLatitude( i );
+
+        // The projections skip the same nodes, see ViewportParams::resolves()
+        const bool skipNode = hasDetail ? d->compactDetail( i ) > maximumDetail
+                                        : i > 0 && isLong &&
+                                          fabs( lon - previousLon ) + fabs( lat - previousLat ) <= angularResolution;
+        if ( !skipNode ) {
+            lineString.p()->m_vector.append( GeoDataCoordinates( lon, lat, d->compactAltitude( i ),
+                                                                 GeoDataCoordinates::Radian,
+                                                                 d->compactDetail( i ) ) );
+            previousLon = lon;
+            previousLat = lat;
+        }
+    }
+}
+
+void GeoDataLineStringPrivate::compact( bool singlePrecision )
+{
+    expand();
+
+    delete m_rangeCorrected;
+    m_rangeCorrected = 0;
+    m_dirtyRange = true;
+
+    const int size = m_vector.size();
+
+    bool hasAltitudes = false;
+    bool hasDetails = false;
+    QVector<GeoDataCoordinates>::const_iterator itCoords = m_vector.constBegin();
+    QVector<GeoDataCoordinates>::const_iterator itEnd = m_vector.constEnd();
+    for ( ; itCoords != itEnd; ++itCoords ) {
+        hasAltitudes = hasAltitudes || itCoords->altitude() != 0.0;
+        hasDetails = hasDetails || itCoords->detail() != 0;
+    }
+
+    if ( singlePrecision ) {
+        m_floatLongitudes.resize( size );
+        m_floatLatitudes.resize( size );
+    }
+    else {
+        m_longitudes.resize( size );
+        m_latitudes.resize( size );
+    }
+    if ( hasAltitudes ) {
+        m_altitudes.resize( size );
+    }
+    if ( hasDetails ) {
+        m_details.resize( size );
+    }
+
+    for ( int i = 0; i < size; ++i ) {
+        const GeoDataCoordinates &coords = m_vector.at( i );
+        if ( singlePrecision ) {
+            m_floatLongitudes[i] = float( coords.longitude() );
+            m_floatLatitudes[i] = float( coords.latitude() );
+        }
+        else {
+            m_longitudes[i] = coords.longitude();
+            m_latitudes[i] = coords.latitude();
+        }
+        if ( hasAltitudes ) {
+            m_altitudes[i] = coords.altitude();
+        }
+        if ( hasDetails ) {
+            m_details[i] = coords.detail();
+        }
+    }
+
+    m_compactSize = size;
+    // clear() releases the memory, unlike resize()
+    m_vector.clear();
+    m_compact.storeRelease( 1 );
+}
+
+void GeoDataLineStringPrivate::expandCompact() const
+{
+    QMutexLocker locker( &m_compactMutex );
+
+    // another thread may have restored the nodes meanwhile
+    if ( !m_compact.load() ) {
+        return;
+    }
+
+    // The nodes are restored on first access, which may happen in const methods.
+    QVector<GeoDataCoordinates> &vector = const_cast<QVector<GeoDataCoordinates> &>( m_vector );
+
+    vector.reserve( m_compactSize );
+    for ( int i = 0; i < m_compactSize; ++i ) {
+        vector.append( GeoDataCoordinates( compactLongitude( i ), compactLatitude( i ), compactAltitude( i ),
+                                           GeoDataCoordinates::Radian, compactDetail( i ) ) );
+    }
+
+    m_longitudes.clear();
+    m_latitudes.clear();
+    m_floatLongitudes.clear();
+    m_floatLatitudes.clear();
+    m_altitudes.clear();
+    m_details.clear();
+
+    // m_compactSize is kept, size() may still read it
+    m_compact.storeRelease( 0 );
+}
+
 void GeoDataLineString::pack( QDataStream& stream ) const
 {
     GeoDataGeometry::pack( stream );
@@ -819,6 +1011,8 @@ void GeoDataLineString::pack( QDataStream& stream ) const
     stream << size();
     stream << (qint32)(p()->m_tessellationFlags);
 
+    p()->expand();
+
     for( QVector<GeoDataCoordinates>::const_iterator iterator
           = p()->m_vector.constBegin();
          iterator != p()->m_vector.constEnd();
@@ -834,6 +1028,7 @@ void GeoDataLineString::unpack( QDataStream& stream )
 {
     GeoDataGeometry::detach();
     GeoDataGeometry::unpack( stream );
+    p()->expand();
     qint32 size;
     qint32 tessellationFlags;
 
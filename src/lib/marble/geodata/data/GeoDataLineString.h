@@ -359,6 +359,57 @@ class GEODATA_EXPORT GeoDataLineString : public GeoDataGeometry
     */
     GeoDataLineString optimized() const;
 
+    enum CompactPrecision {
+        DoublePrecision, ///< longitudes and latitudes are kept as double values
+        SinglePrecision  ///< longitudes and latitudes are kept as float values
+    };
+
+/*!
+    \brief Stores the nodes of the LineString in a compact form.
+
+    Instead of one GeoDataCoordinates object per node the longitudes,
+    latitudes and, if needed, the altitudes and detail levels are stored in
+    contiguous arrays, which requires a fraction of the memory. This is meant
+    for large amounts of line strings that are loaded once and mostly
+    rendered afterwards.
+
+    The bounding box is calculated before the nodes are compacted, so
+    latLonAltBox(), size(), isEmpty() and resolvedNodes() work without
+    restoring the nodes. Any other access to the nodes restores them
+    transparently, leaving the LineString in its regular form.
+    SinglePrecision reduces the accuracy of the nodes to about a
+    meter on the surface of the earth.
+
+    \see isCompact()
+*/
+    void compact( CompactPrecision precision = DoublePrecision );
+
+
+/*!
+    \brief Returns whether the nodes are currently stored in a compact form.
+
+    \see compact()
+*/
+    bool isCompact() const;
+
+
+/*!
+    \brief Copies the nodes which are distinguishable at a resolution.
+
+    Nodes are skipped like the projections skip them: if the first node
+    has a detail level, all nodes with a detail level above
+    @p maximumDetail are skipped. Otherwise, in line strings of more than
+    10 nodes, nodes within @p angularResolution (in radians, measured as
+    the manhattan length) of the previous copied node are skipped.
+    Compact nodes are read without being restored, so only the copied
+    nodes are created as GeoDataCoordinates.
+
+    \param lineString receives the nodes and the tessellation flags; it
+           is cleared before.
+*/
+    void resolvedNodes( qreal angularResolution, int maximumDetail,
+                        GeoDataLineString &lineString ) const;
+
     // Serialization
 /*!
     \brief Serialize the LineString to a stream.
@@ -15,6 +15,10 @@
 
 #include "GeoDataTypes.h"
 
+#include <QAtomicInt>
+#include <QMutex>
+#include <QVector>
+
 namespace Marble
 {
 
@@ -27,14 +31,18 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
            m_dirtyBox( true ),
            m_tessellationFlags( f ),
            m_previousResolution( -1 ),
-           m_level( -1 )
+           m_level( -1 ),
+           m_compact( 0 ),
+           m_compactSize( 0 )
     {
     }
 
     GeoDataLineStringPrivate()
          : m_rangeCorrected( 0 ),
            m_dirtyRange( true ),
-           m_dirtyBox( true )
+           m_dirtyBox( true ),
+           m_compact( 0 ),
+           m_compactSize( 0 )
     {
     }
 
@@ -46,7 +54,20 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
     GeoDataLineStringPrivate& operator=( const GeoDataLineStringPrivate &other)
     {
         GeoDataGeometryPrivate::operator=( other );
+
+        // the nodes of other may be restored concurrently
+        QMutexLocker locker( &other.m_compactMutex );
         m_vector = other.m_vector;
+        m_compact.storeRelease( other.m_compact.load() );
+        m_compactSize = other.m_compactSize;
+        m_longitudes = other.m_longitudes;
+        m_latitudes = other.m_latitudes;
+        m_floatLongitudes = other.m_floatLongitudes;
+        m_floatLatitudes = other.m_floatLatitudes;
+        m_altitudes = other.m_altitudes;
+        m_details = other.m_details;
+        locker.unlock();
+
         m_rangeCorrected = 0;
         m_dirtyRange = true;
         m_dirtyBox = other.m_dirtyBox;
@@ -91,6 +112,42 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
     qreal resolutionForLevel(int level) const;
     void optimize(GeoDataLineString& lineString) const;
 
+    void compact( bool singlePrecision );
+
+    /**
+     * Restores the nodes of a compact line string, see GeoDataLineString::compact().
+     * Needs to be called before m_vector is accessed.
+     */
+    void expand() const
+    {
+        if ( m_compact.loadAcquire() ) {
+            expandCompact();
+        }
+    }
+
+    void expandCompact() const;
+
+    // Accessors of the compact representation, m_compactMutex needs to be locked
+    qreal compactLongitude( int i ) const
+    {
+        return m_longitudes.isEmpty() ? qreal( m_floatLongitudes.at( i ) ) : m_longitudes.at( i );
+    }
+
+    qreal compactLatitude( int i ) const
+    {
+        return m_latitudes.isEmpty() ? qreal( m_floatLatitudes.at( i ) ) : m_latitudes.at( i );
+    }
+
+    qreal compactAltitude( int i ) const
+    {
+        return m_altitudes.isEmpty() ? 0.0 : m_altitudes.at( i );
+    }
+
+    int compactDetail( int i ) const
+    {
+        return m_details.isEmpty() ? 0 : m_details.at( i );
+    }
+
     QVector<GeoDataCoordinates> m_vector;
 
     mutable GeoDataLineString*  m_rangeCorrected;
@@ -101,7 +158,23 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
                                             // been calculated. Saves performance. 
     TessellationFlags           m_tessellationFlags;
     mutable qreal  m_previousResolution;
-    mutable qreal  m_level;};
+    mutable qreal  m_level;
+
+    // The compact representation of the nodes, m_vector is empty while
+    // m_compact is set. Either the double or the float arrays are used,
+    // altitudes and details are only stored if any of them is not 0.
+    // The nodes may be restored by const methods on several threads at
+    // once, so the compact representation is guarded by m_compactMutex.
+    mutable QMutex              m_compactMutex;
+    mutable QAtomicInt          m_compact;
+    int                         m_compactSize;
+    mutable QVector<double>     m_longitudes;
+    mutable QVector<double>     m_latitudes;
+    mutable QVector<float>      m_floatLongitudes;
+    mutable QVector<float>      m_floatLatitudes;
+    mutable QVector<double>     m_altitudes;
+    mutable QVector<int>        m_details;
+};
 
 } // namespace Marble
 
@@ -47,6 +47,11 @@ void GeoLineStringGraphicsItem::setLineString( const GeoDataLineString* lineStri
     m_lineString = lineString;
 }
 
+const GeoDataLineString *GeoLineStringGraphicsItem::lineString() const
+{
+    return m_lineString;
+}
+
 const GeoDataLatLonAltBox& GeoLineStringGraphicsItem::latLonAltBox() const
 {
     return m_lineString->latLonAltBox();
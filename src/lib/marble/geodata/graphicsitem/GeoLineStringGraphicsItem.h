@@ -27,6 +27,8 @@ public:
 
     void setLineString( const GeoDataLineString* lineString );
 
+    const GeoDataLineString *lineString() const;
+
     virtual const GeoDataLatLonAltBox& latLonAltBox() const;
 
     virtual void paint( GeoPainter* painter, const ViewportParams *viewport );
@@ -167,6 +167,16 @@ double GeoPolygonGraphicsItem::extractBuildingHeight(double defaultValue) const
     return defaultValue;
 }
 
+const GeoDataPolygon *GeoPolygonGraphicsItem::polygon() const
+{
+    return m_polygon;
+}
+
+const GeoDataLinearRing *GeoPolygonGraphicsItem::ring() const
+{
+    return m_ring;
+}
+
 const GeoDataLatLonAltBox& GeoPolygonGraphicsItem::latLonAltBox() const
 {
     if( m_polygon ) {
@@ -425,7 +435,7 @@ void GeoPolygonGraphicsItem::screenPolygons(const ViewportParams *viewport, cons
 
     bool const hasInnerBoundaries = !m_polygon->innerBoundaries().isEmpty();
 
-    QVector<GeoDataLinearRing> innerBoundaries = polygon->innerBoundaries();
+    const QVector<GeoDataLinearRing> &innerBoundaries = polygon->innerBoundaries();
     foreach( const GeoDataLinearRing& itInnerBoundary, innerBoundaries ) {
         QVector<QPolygonF*> innerPolygons;
         viewport->screenCoordinates( itInnerBoundary, innerPolygons );
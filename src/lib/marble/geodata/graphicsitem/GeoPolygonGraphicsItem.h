@@ -30,6 +30,9 @@ public:
     explicit GeoPolygonGraphicsItem( const GeoDataFeature *feature, const GeoDataPolygon* polygon );
     explicit GeoPolygonGraphicsItem( const GeoDataFeature *feature, const GeoDataLinearRing* ring );
 
+    const GeoDataPolygon *polygon() const;
+    const GeoDataLinearRing *ring() const;
+
     virtual const GeoDataLatLonAltBox& latLonAltBox() const;
 
     virtual void paint( GeoPainter* painter, const ViewportParams *viewport );
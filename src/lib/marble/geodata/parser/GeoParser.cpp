@@ -81,6 +81,9 @@ bool GeoParser::read( QIODevice* device )
     // Set data source
     setDevice( device );
 
+    m_internedTags.clear();
+    m_internedTagIndex.clear();
+
     // Start parsing
     while ( !atEnd() ) {
         readNext();
@@ -139,14 +142,14 @@ void GeoParser::parseDocument()
     }
 
     bool processChildren = true;
-    QualifiedName qName( name().toString(), namespaceUri().toString() );
+    const InternedTag &tag = internCurrentTag();
 
     if( tokenType() == QXmlStreamReader::Invalid )
         raiseWarning( QString( "%1: %2" ).arg( error() ).arg( errorString() ) );
 
-    GeoStackItem stackItem( qName, 0 );
+    GeoStackItem stackItem( tag.qualifiedName, 0 );
 
-    if ( const GeoTagHandler* handler = GeoTagHandler::recognizes( qName )) {
+    if ( const GeoTagHandler* handler = tag.handler ) {
         stackItem.assignNode( handler->parse( *this ));
         processChildren = !isEndElement();
     }
@@ -190,6 +193,30 @@ void GeoParser::parseDocument()
 #endif
 }
 
+const GeoParser::InternedTag &GeoParser::internCurrentTag()
+{
+    const QStringRef tagName = name();
+    const QStringRef tagNamespace = namespaceUri();
+    const uint key = qHash( tagName ) ^ ( 31 * qHash( tagNamespace ) );
+
+    QMultiHash<uint, int>::const_iterator it = m_internedTagIndex.constFind( key );
+    for ( ; it != m_internedTagIndex.constEnd() && it.key() == key; ++it ) {
+        const InternedTag &tag = m_internedTags.at( it.value() );
+        if ( tag.qualifiedName.first == tagName && tag.qualifiedName.second == tagNamespace ) {
+            return tag;
+        }
+    }
+
+    InternedTag tag;
+    tag.qualifiedName = QualifiedName( tagName.toString(), tagNamespace.toString() );
+    tag.handler = GeoTagHandler::recognizes( tag.qualifiedName );
+
+    m_internedTagIndex.insert( key, m_internedTags.size() );
+    m_internedTags.append( tag );
+
+    return m_internedTags.last();
+}
+
 void GeoParser::raiseWarning( const QString& warning )
 {
     // TODO: Maybe introduce a strict parsing mode where we feed the warning to
@@ -199,7 +226,7 @@ void GeoParser::raiseWarning( const QString& warning )
 
 QString GeoParser::attribute( const char* attributeName ) const
 {
-    return attributes().value( QString::fromLatin1( attributeName )).toString();
+    return attributes().value( QLatin1String( attributeName ) ).toString();
 }
 
 GeoDocument* GeoParser::releaseDocument()
@@ -22,8 +22,10 @@
 #ifndef MARBLE_GEOPARSER_H
 #define MARBLE_GEOPARSER_H
 
+#include <QMultiHash>
 #include <QPair>
 #include <QStack>
+#include <QVector>
 #include <QXmlStreamReader>
 
 #include "geodata_export.h"
@@ -36,6 +38,7 @@ typedef int GeoDataGenericSourceType;
 class GeoDocument;
 class GeoNode;
 class GeoStackItem;
+class GeoTagHandler;
 
 class GEODATA_EXPORT GeoParser : public QXmlStreamReader
 {
@@ -90,8 +93,23 @@ protected:
     GeoDataGenericSourceType m_source;
 
 private:
+    struct InternedTag
+    {
+        QualifiedName qualifiedName;
+        const GeoTagHandler *handler;
+    };
+
     void parseDocument();
+    const InternedTag &internCurrentTag();
+
     QStack<GeoStackItem> m_nodeStack;
+
+    // The distinct element names of the current document and their tag
+    // handlers, looked up by the hash of the name and the namespace. This
+    // way the names are only converted to strings and the handlers are only
+    // looked up once per document rather than once per element.
+    QVector<InternedTag> m_internedTags;
+    QMultiHash<uint, int> m_internedTagIndex;
 };
 
 class GeoStackItem
@@ -112,7 +130,7 @@ class GeoStackItem
     // Fast path for tag handlers
     bool represents( const char* tagName ) const
     {
-        return m_node && tagName == m_qualifiedName.first;
+        return m_node && m_qualifiedName.first == QLatin1String( tagName );
     }
 
     // Helper for tag handlers. Does NOT guard against miscasting. Use with care.
@@ -129,7 +147,7 @@ class GeoStackItem
         return 0 != dynamic_cast<T*>(m_node);
     }
 
-    GeoParser::QualifiedName qualifiedName() const { return m_qualifiedName; }
+    const GeoParser::QualifiedName& qualifiedName() const { return m_qualifiedName; }
     GeoNode* associatedNode() const { return m_node; }
 
 private:
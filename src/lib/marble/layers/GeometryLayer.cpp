@@ -39,6 +39,7 @@
 #include "GeoDataScreenOverlay.h"
 #include "GeoPhotoGraphicsItem.h"
 #include "ScreenOverlayGraphicsItem.h"
+#include "ScreenPolygonCache.h"
 #include "TileId.h"
 #include "MarbleGraphicsItem.h"
 #include "MarblePlacemarkModel.h"
@@ -64,11 +65,14 @@ public:
     void createGraphicsItemFromGeometry( const GeoDataGeometry *object, const GeoDataPlacemark *placemark, bool avoidOsmDuplicates );
     void createGraphicsItemFromOverlay( const GeoDataOverlay *overlay );
     void removeGraphicsItems( const GeoDataFeature *feature );
+    void updateScreenPolygons( const ViewportParams *viewport );
 
     static int maximumZoomLevel();
 
     const QAbstractItemModel *const m_model;
     GeoGraphicsScene m_scene;
+    QVector<GeoGraphicsItem*> m_visibleItems;
+    ScreenPolygonCache m_screenPolygons;
     QString m_runtimeTrace;
     QList<ScreenOverlayGraphicsItem*> m_items;
 
@@ -103,6 +107,35 @@ int GeometryLayerPrivate::maximumZoomLevel()
     return s_maximumZoomLevel;
 }
 
+void GeometryLayerPrivate::updateScreenPolygons( const ViewportParams *viewport )
+{
+    m_screenPolygons.clear();
+
+    foreach( const GeoGraphicsItem *item, m_visibleItems ) {
+        // tracks update their line string while painting
+        if ( dynamic_cast<const GeoTrackGraphicsItem*>( item ) ) {
+            continue;
+        }
+
+        if ( const GeoLineStringGraphicsItem *lineStringItem = dynamic_cast<const GeoLineStringGraphicsItem*>( item ) ) {
+            m_screenPolygons.addLineString( lineStringItem->lineString() );
+        }
+        else if ( const GeoPolygonGraphicsItem *polygonItem = dynamic_cast<const GeoPolygonGraphicsItem*>( item ) ) {
+            if ( polygonItem->polygon() ) {
+                m_screenPolygons.addLineString( &polygonItem->polygon()->outerBoundary() );
+                foreach( const GeoDataLinearRing &innerBoundary, polygonItem->polygon()->innerBoundaries() ) {
+                    m_screenPolygons.addLineString( &innerBoundary );
+                }
+            }
+            else if ( polygonItem->ring() ) {
+                m_screenPolygons.addLineString( polygonItem->ring() );
+            }
+        }
+    }
+
+    m_screenPolygons.project( viewport );
+}
+
 GeometryLayer::GeometryLayer( const QAbstractItemModel *model )
         : d( new GeometryLayerPrivate( model ) )
 {
@@ -308,34 +341,42 @@ bool GeometryLayer::render( GeoPainter *painter, ViewportParams *viewport,
     painter->save();
 
     int maxZoomLevel = qMin<int>( qMax<int>( qLn( viewport->radius() *4 / 256 ) / qLn( 2.0 ), 1), GeometryLayerPrivate::maximumZoomLevel() );
-    QList<GeoGraphicsItem*> items = d->m_scene.items( viewport->viewLatLonAltBox(), maxZoomLevel );
 
+    bool decorations = false;
     switch ( painter->mapQuality() ) {
     case Marble::MapQuality::LowQuality :
     case Marble::MapQuality::NormalQuality :
     case Marble::MapQuality::HighQuality :
     case Marble::MapQuality::PrintQuality :
-        for ( int i = 0, n = items.size(); i < n; ++i ) {
-            items << items[i]->decorations();
-        }
-
+        decorations = true;
         break;
     default:
         break;
     }
 
-    // Needs sorting by z-value
-    qStableSort(items.begin(), items.end(), GeoGraphicsItem::zValueLessThan);
+    // Already sorted by z-value
+    const QVector<GeoGraphicsItem*> items = d->m_scene.sortedItems( viewport->viewLatLonAltBox(), maxZoomLevel, decorations );
 
-    int painted = 0;
+    d->m_visibleItems.resize( 0 );
     foreach( GeoGraphicsItem* item, items )
     {
         if ( item->latLonAltBox().intersects( viewport->viewLatLonAltBox() ) ) {
-            item->paint( painter, viewport );
-            ++painted;
+            d->m_visibleItems.append( item );
         }
     }
 
+    // Project the line strings and polygons on all cores, leaving just the
+    // painting to this thread.
+    d->updateScreenPolygons( viewport );
+    viewport->setScreenPolygonCache( &d->m_screenPolygons );
+
+    foreach( GeoGraphicsItem* item, d->m_visibleItems )
+    {
+        item->paint( painter, viewport );
+    }
+
+    viewport->setScreenPolygonCache( 0 );
+
     foreach( ScreenOverlayGraphicsItem* item, d->m_items ) {
         item->paintEvent( painter, viewport );
     }
@@ -343,7 +384,7 @@ bool GeometryLayer::render( GeoPainter *painter, ViewportParams *viewport,
     painter->restore();
     d->m_runtimeTrace = QString( "Geometries: %1 Drawn: %2 Zoom: %3")
                 .arg( items.size() )
-                .arg( painted )
+                .arg( d->m_visibleItems.size() )
                 .arg( maxZoomLevel );
     return true;
 }
@@ -28,12 +28,12 @@ using namespace Marble;
 
 bool PlacemarkLayer::m_useXWorkaround = false;
 
-PlacemarkLayer::PlacemarkLayer( QAbstractItemModel *placemarkModel,
+PlacemarkLayer::PlacemarkLayer( const FeatureRegistry *featureRegistry,
                                 QItemSelectionModel *selectionModel,
                                 MarbleClock *clock,
                                 QObject *parent ) :
     QObject( parent ),
-    m_layout( placemarkModel, selectionModel, clock )
+    m_layout( featureRegistry, selectionModel, clock )
 {
     m_useXWorkaround = testXBug();
     mDebug() << "Use workaround: " << ( m_useXWorkaround ? "1" : "0" );
@@ -26,13 +26,13 @@
 
 #include "PlacemarkLayout.h"
 
-class QAbstractItemModel;
 class QItemSelectionModel;
 class QString;
 
 namespace Marble
 {
 
+class FeatureRegistry;
 class GeoPainter;
 class GeoSceneLayer;
 class MarbleClock;
@@ -44,7 +44,7 @@ class PlacemarkLayer : public QObject, public LayerInterface
     Q_OBJECT
 
  public:
-    PlacemarkLayer( QAbstractItemModel *placemarkModel,
+    PlacemarkLayer( const FeatureRegistry *featureRegistry,
                     QItemSelectionModel *selectionModel,
                     MarbleClock *clock,
                     QObject *parent = 0 );
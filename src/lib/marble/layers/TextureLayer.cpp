@@ -15,13 +15,13 @@
 #include <qmath.h>
 #include <QTimer>
 #include <QList>
-#include <QSortFilterProxyModel>
 
 #include "SphericalScanlineTextureMapper.h"
 #include "EquirectScanlineTextureMapper.h"
 #include "MercatorScanlineTextureMapper.h"
 #include "GenericScanlineTextureMapper.h"
 #include "TileScalingTextureMapper.h"
+#include "FeatureRegistry.h"
 #include "GeoDataGroundOverlay.h"
 #include "GeoPainter.h"
 #include "GeoSceneGroup.h"
@@ -29,7 +29,6 @@
 #include "MergedLayerDecorator.h"
 #include "MarbleDebug.h"
 #include "MarbleDirs.h"
-#include "MarblePlacemarkModel.h"
 #include "StackedTile.h"
 #include "StackedTileLoader.h"
 #include "SunLocator.h"
@@ -41,6 +40,8 @@ namespace Marble
 {
 
 const int REPAINT_SCHEDULING_INTERVAL = 1000;
+// Minimum time between two redecorations of the tiles when the sun moves
+const int REDECORATION_INTERVAL = 1000;
 
 class Q_DECL_HIDDEN TextureLayer::Private
 {
@@ -48,15 +49,18 @@ public:
     Private( HttpDownloadManager *downloadManager,
              PluginManager* pluginManager,
              const SunLocator *sunLocator,
-             QAbstractItemModel *groundOverlayModel,
+             const FeatureRegistry *featureRegistry,
              TextureLayer *parent );
 
-    void requestDelayedRepaint();
+    void scheduleTileRepaint( const TileId &stackedTileId );
+    void scheduleRedecoration();
+    void redecorateTiles();
     void updateTextureLayers();
     void updateTile( const TileId &tileId, const QImage &tileImage );
+    void discardTile( const TileId &tileId );
 
-    void addGroundOverlays( QModelIndex parent, int first, int last );
-    void removeGroundOverlays( QModelIndex parent, int first, int last );
+    void addGroundOverlays( const QVector<const GeoDataGroundOverlay *> &groundOverlays );
+    void removeGroundOverlays( const QVector<const GeoDataGroundOverlay *> &groundOverlays );
     void resetGroundOverlaysCache();
 
     void updateGroundOverlays();
@@ -77,18 +81,21 @@ public:
     QVector<const GeoSceneTextureTileDataset *> m_textures;
     const GeoSceneGroup *m_textureLayerSettings;
     QString m_runtimeTrace;
-    QSortFilterProxyModel m_groundOverlayModel;
+    const FeatureRegistry *const m_featureRegistry;
     QList<const GeoDataGroundOverlay *> m_groundOverlayCache;
     QMap<QString, GeoSceneTextureTileDataset *> m_customTextures;
     // For scheduling repaints
     QTimer           m_repaintTimer;
+    // Redecorating blends every tile on display, so sun movements are
+    // collected for a while
+    QTimer           m_redecorationTimer;
     RenderState m_renderState;
 };
 
 TextureLayer::Private::Private( HttpDownloadManager *downloadManager,
                                 PluginManager* pluginManager,
                                 const SunLocator *sunLocator,
-                                QAbstractItemModel *groundOverlayModel,
+                                const FeatureRegistry *featureRegistry,
                                 TextureLayer *parent )
     : m_parent( parent )
     , m_sunLocator( sunLocator )
@@ -100,32 +107,33 @@ TextureLayer::Private::Private( HttpDownloadManager *downloadManager,
     , m_texmapper( 0 )
     , m_texcolorizer( 0 )
     , m_textureLayerSettings( 0 )
+    , m_featureRegistry( featureRegistry )
     , m_repaintTimer()
+    , m_redecorationTimer()
 {
-    m_groundOverlayModel.setSourceModel( groundOverlayModel );
-    m_groundOverlayModel.setDynamicSortFilter( true );
-    m_groundOverlayModel.setSortRole ( MarblePlacemarkModel::PopularityIndexRole );
-    m_groundOverlayModel.sort (0, Qt::AscendingOrder );
+    connect( m_featureRegistry, SIGNAL(groundOverlaysAdded(QVector<const GeoDataGroundOverlay*>)),
+             m_parent,          SLOT(addGroundOverlays(QVector<const GeoDataGroundOverlay*>)) );
 
-    connect( &m_groundOverlayModel, SIGNAL(rowsInserted(QModelIndex,int,int)),
-             m_parent,              SLOT(addGroundOverlays(QModelIndex,int,int)) );
+    connect( m_featureRegistry, SIGNAL(groundOverlaysAboutToBeRemoved(QVector<const GeoDataGroundOverlay*>)),
+             m_parent,          SLOT(removeGroundOverlays(QVector<const GeoDataGroundOverlay*>)) );
 
-    connect( &m_groundOverlayModel, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
-             m_parent,              SLOT(removeGroundOverlays(QModelIndex,int,int)) );
+    connect( m_featureRegistry, SIGNAL(cleared()),
+             m_parent,          SLOT(resetGroundOverlaysCache()) );
 
-    connect( &m_groundOverlayModel, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
-             m_parent,              SLOT(resetGroundOverlaysCache()) );
-
-    connect( &m_groundOverlayModel, SIGNAL(modelReset()),
-             m_parent,              SLOT(resetGroundOverlaysCache()) );
+    foreach ( const GeoDataGroundOverlay *overlay, m_featureRegistry->groundOverlays() ) {
+        if ( !overlay->icon().isNull() ) {
+            int pos = qLowerBound( m_groundOverlayCache.begin(), m_groundOverlayCache.end(), overlay, drawOrderLessThan ) - m_groundOverlayCache.begin();
+            m_groundOverlayCache.insert( pos, overlay );
+        }
+    }
 
     updateGroundOverlays();
 }
 
-void TextureLayer::Private::requestDelayedRepaint()
+void TextureLayer::Private::scheduleTileRepaint( const TileId &stackedTileId )
 {
     if ( m_texmapper ) {
-        m_texmapper->setRepaintNeeded();
+        m_texmapper->setTileRepaintNeeded( stackedTileId );
     }
 
     if ( !m_repaintTimer.isActive() ) {
@@ -133,6 +141,19 @@ void TextureLayer::Private::requestDelayedRepaint()
     }
 }
 
+void TextureLayer::Private::scheduleRedecoration()
+{
+    if ( !m_redecorationTimer.isActive() ) {
+        m_redecorationTimer.start();
+    }
+}
+
+void TextureLayer::Private::redecorateTiles()
+{
+    m_tileLoader.redecorateTiles();
+    m_parent->setNeedsUpdate();
+}
+
 void TextureLayer::Private::updateTextureLayers()
 {
     QVector<GeoSceneTextureTileDataset const *> result;
@@ -151,10 +172,12 @@ void TextureLayer::Private::updateTextureLayers()
         }
     }
 
+    // finish pending tile loads before the decorator is reconfigured
+    m_tileLoader.clear();
+
     updateGroundOverlays();
 
     m_layerDecorator.setTextureLayers( result );
-    m_tileLoader.clear();
 
     m_tileZoomLevel = -1;
     m_parent->setNeedsUpdate();
@@ -167,7 +190,13 @@ void TextureLayer::Private::updateTile( const TileId &tileId, const QImage &tile
 
     m_tileLoader.updateTile( tileId, tileImage );
 
-    requestDelayedRepaint();
+    scheduleTileRepaint( TileId( 0, tileId.zoomLevel(), tileId.x(), tileId.y() ) );
+}
+
+void TextureLayer::Private::discardTile( const TileId &tileId )
+{
+    // the placeholder would keep the tile from being downloaded again
+    m_tileLoader.discardTile( tileId );
 }
 
 bool TextureLayer::Private::drawOrderLessThan( const GeoDataGroundOverlay* o1, const GeoDataGroundOverlay* o2 )
@@ -175,12 +204,9 @@ bool TextureLayer::Private::drawOrderLessThan( const GeoDataGroundOverlay* o1, c
     return o1->drawOrder() < o2->drawOrder();
 }
 
-void TextureLayer::Private::addGroundOverlays( QModelIndex parent, int first, int last )
+void TextureLayer::Private::addGroundOverlays( const QVector<const GeoDataGroundOverlay *> &groundOverlays )
 {
-    for ( int i = first; i <= last; ++i ) {
-        QModelIndex index = m_groundOverlayModel.index( i, 0, parent );
-        const GeoDataGroundOverlay *overlay = static_cast<GeoDataGroundOverlay *>( qvariant_cast<GeoDataObject *>( index.data( MarblePlacemarkModel::ObjectPointerRole ) ) );
-
+    foreach ( const GeoDataGroundOverlay *overlay, groundOverlays ) {
         if ( overlay->icon().isNull() ) {
             continue;
         }
@@ -189,35 +215,30 @@ void TextureLayer::Private::addGroundOverlays( QModelIndex parent, int first, in
         m_groundOverlayCache.insert( pos, overlay );
     }
 
-    updateGroundOverlays();
-
     m_parent->reset();
+
+    updateGroundOverlays();
 }
 
-void TextureLayer::Private::removeGroundOverlays( QModelIndex parent, int first, int last )
+void TextureLayer::Private::removeGroundOverlays( const QVector<const GeoDataGroundOverlay *> &groundOverlays )
 {
-    for ( int i = first; i <= last; ++i ) {
-        QModelIndex index = m_groundOverlayModel.index( i, 0, parent );
-        const GeoDataGroundOverlay *overlay = static_cast<GeoDataGroundOverlay *>( qvariant_cast<GeoDataObject *>( index.data( MarblePlacemarkModel::ObjectPointerRole ) ) );
-
-        int pos = qLowerBound( m_groundOverlayCache.begin(), m_groundOverlayCache.end(), overlay, drawOrderLessThan ) - m_groundOverlayCache.begin();
-        if (pos >= 0 && pos < m_groundOverlayCache.size() ) {
-            m_groundOverlayCache.removeAt( pos );
-        }
+    foreach ( const GeoDataGroundOverlay *overlay, groundOverlays ) {
+        // overlays without icon have not been added
+        m_groundOverlayCache.removeOne( overlay );
     }
 
-    updateGroundOverlays();
-
     m_parent->reset();
+
+    updateGroundOverlays();
 }
 
 void TextureLayer::Private::resetGroundOverlaysCache()
 {
     m_groundOverlayCache.clear();
 
-    updateGroundOverlays();
-
     m_parent->reset();
+
+    updateGroundOverlays();
 }
 
 void TextureLayer::Private::updateGroundOverlays()
@@ -241,18 +262,27 @@ void TextureLayer::Private::addCustomTextures()
 TextureLayer::TextureLayer( HttpDownloadManager *downloadManager,
                             PluginManager* pluginManager,
                             const SunLocator *sunLocator,
-                            QAbstractItemModel *groundOverlayModel )
+                            const FeatureRegistry *featureRegistry )
     : QObject()
-    , d( new Private( downloadManager, pluginManager, sunLocator, groundOverlayModel, this ) )
+    , d( new Private( downloadManager, pluginManager, sunLocator, featureRegistry, this ) )
 {
     connect( &d->m_loader, SIGNAL(tileCompleted(TileId,QImage)),
              this, SLOT(updateTile(TileId,QImage)) );
+    connect( &d->m_loader, SIGNAL(tileDropped(TileId)),
+             this, SLOT(discardTile(TileId)) );
+    connect( &d->m_tileLoader, SIGNAL(pendingTileLoaded(TileId)),
+             this, SLOT(scheduleTileRepaint(TileId)) );
 
     // Repaint timer
     d->m_repaintTimer.setSingleShot( true );
     d->m_repaintTimer.setInterval( REPAINT_SCHEDULING_INTERVAL );
     connect( &d->m_repaintTimer, SIGNAL(timeout()),
              this, SIGNAL(repaintNeeded()) );
+
+    d->m_redecorationTimer.setSingleShot( true );
+    d->m_redecorationTimer.setInterval( REDECORATION_INTERVAL );
+    connect( &d->m_redecorationTimer, SIGNAL(timeout()),
+             this, SLOT(redecorateTiles()) );
 }
 
 TextureLayer::~TextureLayer()
@@ -322,7 +352,7 @@ bool TextureLayer::render( GeoPainter *painter, ViewportParams *viewport,
          d->m_centerCoordinates.latitude() != viewport->centerLatitude() ) {
         d->m_centerCoordinates.setLongitude( viewport->centerLongitude() );
         d->m_centerCoordinates.setLatitude( viewport->centerLatitude() );
-        d->m_texmapper->setRepaintNeeded();
+        d->m_texmapper->setCenterMoved();
     }
 
     // choose the smaller dimension for selecting the tile level, leading to higher-resolution results
@@ -368,30 +398,31 @@ void TextureLayer::setShowRelief( bool show )
 void TextureLayer::setShowSunShading( bool show )
 {
     disconnect( d->m_sunLocator, SIGNAL(positionChanged(qreal,qreal)),
-                this, SLOT(reset()) );
+                this, SLOT(scheduleRedecoration()) );
+    d->m_redecorationTimer.stop();
 
     if ( show ) {
         connect( d->m_sunLocator, SIGNAL(positionChanged(qreal,qreal)),
-                 this,       SLOT(reset()) );
+                 this,       SLOT(scheduleRedecoration()) );
     }
 
-    d->m_layerDecorator.setShowSunShading( show );
-
     reset();
+
+    d->m_layerDecorator.setShowSunShading( show );
 }
 
 void TextureLayer::setShowCityLights( bool show )
 {
-    d->m_layerDecorator.setShowCityLights( show );
-
     reset();
+
+    d->m_layerDecorator.setShowCityLights( show );
 }
 
 void TextureLayer::setShowTileId( bool show )
 {
-    d->m_layerDecorator.setShowTileId( show );
-
     reset();
+
+    d->m_layerDecorator.setShowTileId( show );
 }
 
 void TextureLayer::setProjection( Projection projection )
@@ -439,6 +470,16 @@ void TextureLayer::setNeedsUpdate()
     emit repaintNeeded();
 }
 
+void TextureLayer::setAsynchronousLoading( bool enabled )
+{
+    d->m_tileLoader.setAsynchronousLoading( enabled );
+}
+
+bool TextureLayer::asynchronousLoading() const
+{
+    return d->m_tileLoader.asynchronousLoading();
+}
+
 void TextureLayer::setVolatileCacheLimit( quint64 kilobytes )
 {
     d->m_tileLoader.setVolatileCacheLimit( kilobytes );
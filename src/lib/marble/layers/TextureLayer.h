@@ -19,7 +19,6 @@
 
 #include <QSize>
 
-class QAbstractItemModel;
 class QImage;
 class QRegion;
 class QRect;
@@ -27,8 +26,10 @@ class QRect;
 namespace Marble
 {
 
+class FeatureRegistry;
 class GeoPainter;
 class GeoDataDocument;
+class GeoDataGroundOverlay;
 class GeoSceneGroup;
 class GeoSceneTextureTileDataset;
 class HttpDownloadManager;
@@ -44,7 +45,7 @@ class MARBLE_EXPORT TextureLayer : public QObject, public LayerInterface
     TextureLayer( HttpDownloadManager *downloadManager,
                   PluginManager* pluginManager,
                   const SunLocator *sunLocator,
-                  QAbstractItemModel *groundOverlayModel );
+                  const FeatureRegistry *featureRegistry );
 
     ~TextureLayer();
 
@@ -89,6 +90,12 @@ class MARBLE_EXPORT TextureLayer : public QObject, public LayerInterface
 
     qint64 volatileCacheLimit() const;
 
+    /**
+     * @brief Returns whether tiles missing in memory are loaded in the background
+     * @see StackedTileLoader::setAsynchronousLoading()
+     */
+    bool asynchronousLoading() const;
+
     int preferredRadiusCeil( int radius ) const;
     int preferredRadiusFloor( int radius ) const;
 
@@ -121,6 +128,8 @@ public Q_SLOTS:
 
     void setVolatileCacheLimit( quint64 kilobytes );
 
+    void setAsynchronousLoading( bool enabled );
+
     void reset();
 
     void reload();
@@ -132,11 +141,14 @@ public Q_SLOTS:
     void repaintNeeded();
 
  private:
-    Q_PRIVATE_SLOT( d, void requestDelayedRepaint() )
+    Q_PRIVATE_SLOT( d, void scheduleTileRepaint( const TileId & ) )
+    Q_PRIVATE_SLOT( d, void scheduleRedecoration() )
+    Q_PRIVATE_SLOT( d, void redecorateTiles() )
     Q_PRIVATE_SLOT( d, void updateTextureLayers() )
     Q_PRIVATE_SLOT( d, void updateTile( const TileId &tileId, const QImage &tileImage ) )
-    Q_PRIVATE_SLOT( d, void addGroundOverlays( QModelIndex parent, int first, int last ) )
-    Q_PRIVATE_SLOT( d, void removeGroundOverlays( QModelIndex parent, int first, int last ) )
+    Q_PRIVATE_SLOT( d, void discardTile( const TileId &tileId ) )
+    Q_PRIVATE_SLOT( d, void addGroundOverlays( const QVector<const GeoDataGroundOverlay *> &groundOverlays ) )
+    Q_PRIVATE_SLOT( d, void removeGroundOverlays( const QVector<const GeoDataGroundOverlay *> &groundOverlays ) )
     Q_PRIVATE_SLOT( d, void resetGroundOverlaysCache() )
 
  private:
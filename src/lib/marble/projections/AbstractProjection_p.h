@@ -28,8 +28,6 @@ class AbstractProjectionPrivate
 
     qreal  m_maxLat;
     qreal  m_minLat;
-    mutable qreal  m_previousResolution;
-    mutable qreal  m_level;
 
     AbstractProjection * const q_ptr;
     Q_DECLARE_PUBLIC( AbstractProjection )
@@ -54,7 +54,19 @@ bool AzimuthalProjection::screenCoordinates( const GeoDataLineString &lineString
         return false;
     }
 
-    d->lineStringToPolygon( lineString, viewport, polygons );
+    if ( lineString.isCompact() ) {
+        // Only create the nodes which are resolved at the current resolution
+        // instead of restoring all nodes of the compact line string.
+        GeoDataLinearRing resolvedRing;
+        GeoDataLineString resolvedLineString;
+        GeoDataLineString &resolved = lineString.isClosed() ? resolvedRing : resolvedLineString;
+        lineString.resolvedNodes( viewport->angularResolution(),
+                                  d->levelForResolution( viewport->angularResolution() ), resolved );
+        d->lineStringToPolygon( resolved, viewport, polygons );
+    }
+    else {
+        d->lineStringToPolygon( lineString, viewport, polygons );
+    }
     return true;
 }
 
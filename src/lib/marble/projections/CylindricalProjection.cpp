@@ -92,7 +92,19 @@ bool CylindricalProjection::screenCoordinates( const GeoDataLineString &lineStri
     }
 
     QVector<QPolygonF *> subPolygons;
-    d->lineStringToPolygon( lineString, viewport, subPolygons );
+    if ( lineString.isCompact() ) {
+        // Only create the nodes which are resolved at the current resolution
+        // instead of restoring all nodes of the compact line string.
+        GeoDataLinearRing resolvedRing;
+        GeoDataLineString resolvedLineString;
+        GeoDataLineString &resolved = lineString.isClosed() ? resolvedRing : resolvedLineString;
+        lineString.resolvedNodes( viewport->angularResolution(),
+                                  d->levelForResolution( viewport->angularResolution() ), resolved );
+        d->lineStringToPolygon( resolved, viewport, subPolygons );
+    }
+    else {
+        d->lineStringToPolygon( lineString, viewport, subPolygons );
+    }
 
     polygons << subPolygons;
     return polygons.isEmpty();
@@ -34,13 +34,20 @@ class VerticalPerspectiveProjectionPrivate : public AzimuthalProjectionPrivate
   public:
     explicit VerticalPerspectiveProjectionPrivate( VerticalPerspectiveProjection * parent );
 
-    void calculateConstants(qreal radius) const;
+    /**
+     * The constants of the projection for a globe radius. They are derived
+     * on each call rather than cached in the projection, so that points can
+     * be projected on several threads at once.
+     */
+    struct Constants
+    {
+        explicit Constants( qreal radius );
 
-    mutable qreal m_P; ///< Distance of the point of perspective in earth diameters
-    mutable qreal m_previousRadius;
-    mutable qreal m_altitudeToPixel;
-    mutable qreal m_perspectiveRadius;
-    mutable qreal m_pPfactor;
+        qreal m_P; ///< Distance of the point of perspective in earth diameters
+        qreal m_altitudeToPixel;
+        qreal m_perspectiveRadius;
+        qreal m_pPfactor;
+    };
 
     Q_DECLARE_PUBLIC( VerticalPerspectiveProjection )
 };
@@ -65,12 +72,7 @@ VerticalPerspectiveProjection::~VerticalPerspectiveProjection()
 
 
 VerticalPerspectiveProjectionPrivate::VerticalPerspectiveProjectionPrivate( VerticalPerspectiveProjection * parent )
-        : AzimuthalProjectionPrivate( parent ),
-          m_P(1),
-          m_previousRadius(1),
-          m_altitudeToPixel(1),
-          m_perspectiveRadius(1),
-          m_pPfactor(1)
+        : AzimuthalProjectionPrivate( parent )
 {
 }
 
@@ -90,10 +92,8 @@ QIcon VerticalPerspectiveProjection::icon() const
     return QIcon(":/icons/map-globe.png");
 }
 
-void VerticalPerspectiveProjectionPrivate::calculateConstants(qreal radius) const
+VerticalPerspectiveProjectionPrivate::Constants::Constants(qreal radius)
 {
-    if (radius == m_previousRadius)  return;
-    m_previousRadius = radius;
     m_P = 1.5 + 3 * 1000 * 0.4 / radius / qTan(0.5 * 110 * DEG2RAD);
     m_altitudeToPixel = radius / (EARTH_RADIUS * qSqrt((m_P-1)/(m_P+1)));
     m_perspectiveRadius = radius / qSqrt((m_P-1)/(m_P+1));
@@ -109,9 +109,8 @@ bool VerticalPerspectiveProjection::screenCoordinates( const GeoDataCoordinates
                                              const ViewportParams *viewport,
                                              qreal &x, qreal &y, bool &globeHidesPoint ) const
 {
-    Q_D(const VerticalPerspectiveProjection);
-    d->calculateConstants(viewport->radius());
-    const qreal P =  d->m_P;
+    const VerticalPerspectiveProjectionPrivate::Constants constants(viewport->radius());
+    const qreal P =  constants.m_P;
     const qreal deltaLambda = coordinates.longitude() - viewport->centerLongitude();
     const qreal phi = coordinates.latitude();
     const qreal phi1 = viewport->centerLatitude();
@@ -132,7 +131,7 @@ bool VerticalPerspectiveProjection::screenCoordinates( const GeoDataCoordinates
     y = ( qCos( phi1 ) * qSin( phi ) - qSin( phi1 ) * qCos( phi ) * qCos( deltaLambda ) ) * k;
 
     // Transform to screen coordinates
-    qreal pixelAltitude = (coordinates.altitude() + EARTH_RADIUS) * d->m_altitudeToPixel;
+    qreal pixelAltitude = (coordinates.altitude() + EARTH_RADIUS) * constants.m_altitudeToPixel;
     x *= pixelAltitude;
     y *= pixelAltitude;
 
@@ -187,9 +186,8 @@ bool VerticalPerspectiveProjection::geoCoordinates( const int x, const int y,
                                           qreal& lon, qreal& lat,
                                           GeoDataCoordinates::Unit unit ) const
 {
-    Q_D(const VerticalPerspectiveProjection);
-    d->calculateConstants(viewport->radius());
-    const qreal P = d->m_P;
+    const VerticalPerspectiveProjectionPrivate::Constants constants(viewport->radius());
+    const qreal P = constants.m_P;
     const qreal rx = ( - viewport->width()  / 2 + x );
     const qreal ry = (   viewport->height() / 2 - y );
     const qreal p2 = rx*rx + ry*ry;
@@ -200,12 +198,12 @@ bool VerticalPerspectiveProjection::geoCoordinates( const int x, const int y,
         return true;
     }
 
-    const qreal pP = p2*d->m_pPfactor;
+    const qreal pP = p2*constants.m_pPfactor;
 
     if ( pP > 1) return false;
 
     const qreal p = qSqrt(p2);
-    const qreal fract = d->m_perspectiveRadius*(P-1)/p;
+    const qreal fract = constants.m_perspectiveRadius*(P-1)/p;
     const qreal c = qAsin((P-qSqrt(1-pP))/(fract+1/fract));
     const qreal sinc = qSin(c);
 
@@ -16,11 +16,122 @@
 #include "GeoDataPlacemark.h"
 #include "MarbleMath.h"
 
+#include <QHash>
+#include <QPolygonF>
 #include <QTimer>
-#include <QPainter>
+#include <qmath.h>
 
 namespace Marble {
 
+// routes which are more similar are considered duplicates
+static const qreal duplicateSimilarity = 0.8;
+
+/**
+  * The segments of a polyline in a uniform grid, for finding the segments near a point
+  */
+class SegmentGrid
+{
+public:
+    SegmentGrid( const QPolygonF &polyline, qreal cellSize );
+
+    /**
+      * Returns true if a segment of the polyline is not farther from @p point than the cell size
+      */
+    bool isNear( const QPointF &point ) const;
+
+    qreal cellSize() const;
+
+    /**
+      * Returns the distance between @p point and the line segment from @p a to @p b
+      */
+    static qreal distance( const QPointF &point, const QPointF &a, const QPointF &b );
+
+private:
+    int cell( qreal value ) const;
+
+    static quint64 key( int x, int y );
+
+    const QPolygonF m_polyline;
+
+    const qreal m_cellSize;
+
+    // the segments, given by the index of their first point, touching each cell
+    QHash<quint64, QVector<int> > m_cells;
+};
+
+SegmentGrid::SegmentGrid( const QPolygonF &polyline, qreal cellSize ) :
+    m_polyline( polyline ),
+    m_cellSize( cellSize )
+{
+    // A polyline of a single point has a single segment of zero length
+    const int segments = qMax( 1, m_polyline.size() - 1 );
+    for ( int i = 0; i < segments && i < m_polyline.size(); ++i ) {
+        const QPointF &a = m_polyline.at( i );
+        const QPointF &b = m_polyline.at( qMin( i + 1, m_polyline.size() - 1 ) );
+        const int right = cell( qMax( a.x(), b.x() ) );
+        const int bottom = cell( qMax( a.y(), b.y() ) );
+        for ( int x = cell( qMin( a.x(), b.x() ) ); x <= right; ++x ) {
+            for ( int y = cell( qMin( a.y(), b.y() ) ); y <= bottom; ++y ) {
+                m_cells[key( x, y )] << i;
+            }
+        }
+    }
+}
+
+bool SegmentGrid::isNear( const QPointF &point ) const
+{
+    // Segments within the cell size touch the cell of the point or one of its neighbors
+    const int cellX = cell( point.x() );
+    const int cellY = cell( point.y() );
+    for ( int x = cellX - 1; x <= cellX + 1; ++x ) {
+        for ( int y = cellY - 1; y <= cellY + 1; ++y ) {
+            QHash<quint64, QVector<int> >::const_iterator const segments = m_cells.constFind( key( x, y ) );
+            if ( segments == m_cells.constEnd() ) {
+                continue;
+            }
+
+            foreach( int i, segments.value() ) {
+                const QPointF &a = m_polyline.at( i );
+                const QPointF &b = m_polyline.at( qMin( i + 1, m_polyline.size() - 1 ) );
+                if ( distance( point, a, b ) <= m_cellSize ) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+qreal SegmentGrid::distance( const QPointF &point, const QPointF &a, const QPointF &b )
+{
+    const QPointF ab = b - a;
+    const qreal length = ab.x() * ab.x() + ab.y() * ab.y();
+    qreal t = 0.0;
+    if ( length > 0.0 ) {
+        t = qBound<qreal>( 0.0, ( ( point.x() - a.x() ) * ab.x() + ( point.y() - a.y() ) * ab.y() ) / length, 1.0 );
+    }
+
+    const QPointF nearest = a + t * ab;
+    const QPointF delta = point - nearest;
+    return sqrt( delta.x() * delta.x() + delta.y() * delta.y() );
+}
+
+qreal SegmentGrid::cellSize() const
+{
+    return m_cellSize;
+}
+
+int SegmentGrid::cell( qreal value ) const
+{
+    return qFloor( value / m_cellSize );
+}
+
+quint64 SegmentGrid::key( int x, int y )
+{
+    return ( quint64( quint32( x ) ) << 32 ) | quint32( y );
+}
+
 class Q_DECL_HIDDEN AlternativeRoutesModel::Private
 {
 public:
@@ -36,9 +147,12 @@ public:
       * be treated as totally different (e.g. different route requests), two routes with a similarity
       * of 1 are considered equal. Otherwise the routes overlap to an extent indicated by the
       * similarity value -- the higher, the more they do overlap.
-      * @note: The direction of routes is important; reversed routes are not considered equal
+      * @note: The direction of routes is not taken into account
+      *
+      * The calculation stops early once the similarity is known to be below @p threshold,
+      * values below it are not exact then.
       */
-    static qreal similarity( const GeoDataDocument* routeA, const GeoDataDocument* routeB );
+    static qreal similarity( const GeoDataDocument* routeA, const GeoDataDocument* routeB, qreal threshold );
 
     /**
       * Returns the distance between the given polygon and the given point
@@ -63,10 +177,18 @@ public:
     static GeoDataCoordinates coordinates( const GeoDataCoordinates &start, qreal distance, qreal bearing );
 
     /**
-      * Returns the similarity between routeA and routeB. This method is not symmetric, i.e. in
-      * general unidirectionalSimilarity(a,b) != unidirectionalSimilarity(b,a)
+      * Returns the fraction of the length of @p polyline which is not farther than the cell size of
+      * @p grid from the polyline of the grid. This method is not symmetric, i.e. in general
+      * coverage(a,grid(b)) != coverage(b,grid(a)). Stops early once the result is below @p threshold.
+      */
+    static qreal coverage( const QPolygonF &polyline, const SegmentGrid &grid, qreal threshold );
+
+    /**
+      * Returns the points of @p lineString projected with the scale @p scaleX for longitudes and
+      * simplified such that no point is farther than @p tolerance from the result
+      * (Douglas-Peucker algorithm)
       */
-    static qreal unidirectionalSimilarity( const GeoDataDocument* routeA, const GeoDataDocument* routeB );
+    static QPolygonF simplified( const GeoDataLineString &lineString, qreal scaleX, qreal tolerance );
 
     /**
       * (Primitive) scoring for routes
@@ -80,10 +202,6 @@ public:
 
     static const GeoDataLineString* waypoints( const GeoDataDocument* document );
 
-    static int nonZero( const QImage &image );
-
-    static QPolygonF polygon( const GeoDataLineString &lineString, qreal x, qreal y, qreal sx, qreal sy );
-
     /** The currently shown alternative routes (model data) */
     QVector<GeoDataDocument*> m_routes;
 
@@ -103,34 +221,11 @@ AlternativeRoutesModel::Private::Private() :
     // nothing to do
 }
 
-int AlternativeRoutesModel::Private::nonZero( const QImage &image )
-{
-  QRgb const black = qRgb( 0, 0, 0 );
-  int count = 0;
-  for ( int y = 0; y < image.height(); ++y ) {
-      QRgb* destLine = (QRgb*) image.scanLine( y );
-      for ( int x = 0; x < image.width(); ++x ) {
-          count += destLine[x] == black ? 0 : 1;
-      }
-  }
-  return count;
-}
-
-QPolygonF AlternativeRoutesModel::Private::polygon( const GeoDataLineString &lineString, qreal x, qreal y, qreal sx, qreal sy )
-{
-    QPolygonF poly;
-    for ( int i = 0; i < lineString.size(); ++i ) {
-        poly << QPointF( qAbs( ( lineString)[i].longitude() - x ) * sx,
-                         qAbs( ( lineString)[i].latitude()  - y ) * sy );
-    }
-    return poly;
-}
-
 bool AlternativeRoutesModel::Private::filter( const GeoDataDocument* document ) const
 {
     for ( int i=0; i<m_routes.size(); ++i ) {
-        qreal similarity = Private::similarity( document, m_routes.at( i ) );
-        if ( similarity > 0.8 ) {
+        qreal similarity = Private::similarity( document, m_routes.at( i ), duplicateSimilarity );
+        if ( similarity > duplicateSimilarity ) {
             return true;
         }
     }
@@ -138,10 +233,34 @@ bool AlternativeRoutesModel::Private::filter( const GeoDataDocument* document )
     return false;
 }
 
-qreal AlternativeRoutesModel::Private::similarity( const GeoDataDocument* routeA, const GeoDataDocument* routeB )
+qreal AlternativeRoutesModel::Private::similarity( const GeoDataDocument* routeA, const GeoDataDocument* routeB, qreal threshold )
 {
-    return qMax<qreal>( unidirectionalSimilarity( routeA, routeB ),
-                        unidirectionalSimilarity( routeB, routeA ) );
+    const GeoDataLineString* waypointsA = waypoints( routeA );
+    const GeoDataLineString* waypointsB = waypoints( routeB );
+    if ( !waypointsA || !waypointsB || waypointsA->isEmpty() || waypointsB->isEmpty() )
+    {
+        return 0.0;
+    }
+
+    GeoDataLatLonBox box = GeoDataLatLonBox::fromLineString( *waypointsA );
+    box = box.united( GeoDataLatLonBox::fromLineString( *waypointsB ) );
+    if ( !box.width() || !box.height() ) {
+      return 0.0;
+    }
+
+    // Points closer than 1/64 of the extent of both routes are considered equal
+    qreal const scaleX = cos( box.center().latitude() );
+    qreal const tolerance = qMax( box.width() * scaleX, box.height() ) / 64;
+
+    QPolygonF const polylineA = simplified( *waypointsA, scaleX, tolerance / 2 );
+    QPolygonF const polylineB = simplified( *waypointsB, scaleX, tolerance / 2 );
+
+    qreal const coverageA = coverage( polylineA, SegmentGrid( polylineB, tolerance ), threshold );
+    if ( coverageA > threshold ) {
+        return coverageA;
+    }
+
+    return qMax( coverageA, coverage( polylineB, SegmentGrid( polylineA, tolerance ), threshold ) );
 }
 
 qreal AlternativeRoutesModel::Private::distance( const GeoDataLineString &wayPoints, const GeoDataCoordinates &position )
@@ -195,36 +314,93 @@ qreal AlternativeRoutesModel::Private::distance( const GeoDataCoordinates &satel
     }
 }
 
-qreal AlternativeRoutesModel::Private::unidirectionalSimilarity( const GeoDataDocument* routeA, const GeoDataDocument* routeB )
+qreal AlternativeRoutesModel::Private::coverage( const QPolygonF &polyline, const SegmentGrid &grid, qreal threshold )
 {
-    const GeoDataLineString* waypointsA = waypoints( routeA );
-    const GeoDataLineString* waypointsB = waypoints( routeB );
-    if ( !waypointsA || !waypointsB )
-    {
-        return 0.0;
+    Q_ASSERT( !polyline.isEmpty() );
+
+    qreal total = 0.0;
+    for ( int i = 1; i < polyline.size(); ++i ) {
+        const QPointF delta = polyline.at( i ) - polyline.at( i - 1 );
+        total += sqrt( delta.x() * delta.x() + delta.y() * delta.y() );
     }
 
-    QImage image( 64, 64, QImage::Format_ARGB32_Premultiplied );
-    image.fill( qRgb( 0, 0, 0 ) );
-    GeoDataLatLonBox box = GeoDataLatLonBox::fromLineString( *waypointsA );
-    box = box.united( GeoDataLatLonBox::fromLineString( *waypointsB ) );
-    if ( !box.width() || !box.height() ) {
-      return 0.0;
+    if ( total <= 0.0 ) {
+        return grid.isNear( polyline.first() ) ? 1.0 : 0.0;
+    }
+
+    // The walk along the polyline can stop once too much of it is off the other one
+    qreal const maxUncovered = ( 1.0 - threshold ) * total;
+    qreal covered = 0.0;
+    qreal uncovered = 0.0;
+    for ( int i = 1; i < polyline.size(); ++i ) {
+        const QPointF &a = polyline.at( i - 1 );
+        const QPointF &b = polyline.at( i );
+        const QPointF delta = b - a;
+        const qreal length = sqrt( delta.x() * delta.x() + delta.y() * delta.y() );
+
+        // Sample the segment in steps of half the tolerance
+        const int steps = qMax( 1, qCeil( 2 * length / grid.cellSize() ) );
+        for ( int s = 0; s < steps; ++s ) {
+            if ( grid.isNear( a + ( s + 0.5 ) / steps * delta ) ) {
+                covered += length / steps;
+            } else {
+                uncovered += length / steps;
+                if ( uncovered > maxUncovered ) {
+                    return covered / total;
+                }
+            }
+        }
+    }
+
+    return covered / total;
+}
+
+QPolygonF AlternativeRoutesModel::Private::simplified( const GeoDataLineString &lineString, qreal scaleX, qreal tolerance )
+{
+    QPolygonF points;
+    points.reserve( lineString.size() );
+    for ( int i = 0; i < lineString.size(); ++i ) {
+        points << QPointF( lineString.at( i ).longitude() * scaleX, lineString.at( i ).latitude() );
     }
 
-    qreal const sw = image.width() / box.width();
-    qreal const sh = image.height() / box.height();
+    if ( points.size() < 3 ) {
+        return points;
+    }
 
-    QPainter painter( &image );
-    painter.setPen( QColor( Qt::white ) );
+    QVector<bool> keep( points.size(), false );
+    keep.first() = true;
+    keep.last() = true;
+
+    QVector<QPair<int, int> > ranges;
+    ranges << qMakePair( 0, points.size() - 1 );
+    while ( !ranges.isEmpty() ) {
+        const QPair<int, int> range = ranges.last();
+        ranges.pop_back();
+
+        qreal maxDistance = 0.0;
+        int farthest = -1;
+        for ( int i = range.first + 1; i < range.second; ++i ) {
+            const qreal distance = SegmentGrid::distance( points.at( i ), points.at( range.first ), points.at( range.second ) );
+            if ( distance > maxDistance ) {
+                maxDistance = distance;
+                farthest = i;
+            }
+        }
 
-    painter.drawPoints( Private::polygon( *waypointsA, box.west(), box.north(), sw, sh ) );
-    int const countA = Private::nonZero( image );
+        if ( maxDistance > tolerance ) {
+            keep[farthest] = true;
+            ranges << qMakePair( range.first, farthest ) << qMakePair( farthest, range.second );
+        }
+    }
+
+    QPolygonF result;
+    for ( int i = 0; i < points.size(); ++i ) {
+        if ( keep.at( i ) ) {
+            result << points.at( i );
+        }
+    }
 
-    painter.drawPoints( Private::polygon( *waypointsB, box.west(), box.north(), sw, sh ) );
-    int const countB = Private::nonZero( image );
-    Q_ASSERT( countA <= countB );
-    return countB ? 1.0 - qreal( countB - countA ) / countB : 0;
+    return result;
 }
 
 bool AlternativeRoutesModel::Private::higherScore( const GeoDataDocument* one, const GeoDataDocument* two )
@@ -383,8 +559,8 @@ void AlternativeRoutesModel::addRoute( GeoDataDocument* document, WritePolicy po
         d->m_restrainedRoutes.push_back( document );
     } else {
         for ( int i=0; i<d->m_routes.size(); ++i ) {
-            qreal similarity = Private::similarity( document, d->m_routes.at( i ) );
-            if ( similarity > 0.8 ) {
+            qreal similarity = Private::similarity( document, d->m_routes.at( i ), duplicateSimilarity );
+            if ( similarity > duplicateSimilarity ) {
                 if ( Private::higherScore( document, d->m_routes.at( i ) ) ) {
                     d->m_routes[i] = document;
                     QModelIndex changed = index( i );
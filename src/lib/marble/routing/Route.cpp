@@ -10,6 +10,8 @@
 
 #include "Route.h"
 
+#include "RoutePathIndex.h"
+
 namespace Marble
 {
 
@@ -17,7 +19,8 @@ Route::Route() :
     m_distance( 0.0 ),
     m_travelTime( 0 ),
     m_positionDirty( true ),
-    m_closestSegmentIndex( -1 )
+    m_closestSegmentIndex( -1 ),
+    m_closestEdge( -1 )
 {
     // nothing to do
 }
@@ -36,6 +39,7 @@ void Route::addRouteSegment( const RouteSegment &segment )
         }
         m_segments.push_back( segment );
         m_positionDirty = true;
+        m_pathIndex.clear();
 
         for ( int i=1; i<m_segments.size(); ++i ) {
             m_segments[i-1].setNextRouteSegment(&m_segments[i]);
@@ -97,32 +101,37 @@ GeoDataCoordinates Route::position() const
 void Route::updatePosition() const
 {
     if ( !m_segments.isEmpty() ) {
-        if ( m_closestSegmentIndex < 0 || m_closestSegmentIndex >= m_segments.size() ) {
-            m_closestSegmentIndex = 0;
+        const RoutePathIndex &index = pathIndex();
+
+        qreal distance = 0.0;
+        GeoDataCoordinates interpolated;
+        const int edge = index.closestEdge( m_position, m_closestEdge, distance, interpolated );
+        if ( edge >= 0 ) {
+            m_closestEdge = edge;
+            m_closestSegmentIndex = index.segment( edge );
+            m_positionOnRoute = interpolated;
+
+            // Same as RouteSegment::distanceTo(), the end of the edge
+            const bool hasNext = edge + 1 < m_path.size() && index.segment( edge + 1 ) == m_closestSegmentIndex;
+            m_currentWaypoint = m_path.at( hasNext ? edge + 1 : edge );
         }
+    }
 
-        qreal distance = m_segments[m_closestSegmentIndex].distanceTo( m_position, m_currentWaypoint, m_positionOnRoute );
-        QList<int> candidates;
-
-        for ( int i=0; i<m_segments.size(); ++i ) {
-            if ( i != m_closestSegmentIndex && m_segments[i].minimalDistanceTo( m_position ) <= distance ) {
-                candidates << i;
-            }
-        }
+    m_positionDirty = false;
+}
 
-        GeoDataCoordinates closest, interpolated;
-        foreach( int i, candidates ) {
-            qreal const dist = m_segments[i].distanceTo( m_position, closest, interpolated );
-            if ( distance < 0.0 || dist < distance ) {
-                distance = dist;
-                m_closestSegmentIndex = i;
-                m_positionOnRoute = interpolated;
-                m_currentWaypoint = closest;
-            }
-        }
+const RoutePathIndex &Route::pathIndex() const
+{
+    if ( !m_pathIndex ) {
+        m_pathIndex = QSharedPointer<const RoutePathIndex>( new RoutePathIndex( m_segments ) );
     }
 
-    m_positionDirty = false;
+    return *m_pathIndex;
+}
+
+int Route::closestPathPoint( const GeoDataCoordinates &position, int first ) const
+{
+    return pathIndex().closestPoint( position, first );
 }
 
 const RouteSegment & Route::currentSegment() const
@@ -14,9 +14,13 @@
 #include "RouteSegment.h"
 #include "GeoDataLatLonBox.h"
 
+#include <QSharedPointer>
+
 namespace Marble
 {
 
+class RoutePathIndex;
+
 class MARBLE_EXPORT Route
 {
 public:
@@ -50,7 +54,15 @@ public:
 
     GeoDataCoordinates positionOnRoute() const;
 
+    /**
+     * Returns the index of the point of path() closest to @p position,
+     * ignoring the points before @p first, or -1 if there is no such point.
+     */
+    int closestPathPoint( const GeoDataCoordinates &position, int first = 0 ) const;
+
 private:
+    const RoutePathIndex &pathIndex() const;
+
     void updatePosition() const;
 
     GeoDataLatLonBox m_bounds;
@@ -71,6 +83,12 @@ private:
 
     mutable int m_closestSegmentIndex;
 
+    // the first point of the closest edge of m_path
+    mutable int m_closestEdge;
+
+    // built on first use, shared by the copies of the route
+    mutable QSharedPointer<const RoutePathIndex> m_pathIndex;
+
     mutable GeoDataCoordinates m_positionOnRoute;
 
     mutable GeoDataCoordinates m_currentWaypoint;
@@ -0,0 +1,256 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "RoutePathIndex.h"
+
+#include "MarbleGlobal.h"
+#include "MarbleMath.h"
+#include "RouteSegment.h"
+
+namespace Marble
+{
+
+// the maximum number of points of a leaf
+static const int leafSize = 8;
+
+// the number of edges before and after the hint tried by closestEdge()
+static const int hintWindow = 8;
+
+RoutePathIndex::RoutePathIndex( const QVector<RouteSegment> &segments )
+{
+    for ( int s = 0; s < segments.size(); ++s ) {
+        const GeoDataLineString &path = segments.at( s ).path();
+        for ( int i = 0; i < path.size(); ++i ) {
+            m_lons << path.at( i ).longitude();
+            m_lats << path.at( i ).latitude();
+            m_segments << s;
+        }
+    }
+
+    if ( !m_lons.isEmpty() ) {
+        build( 0, m_lons.size() );
+    }
+}
+
+int RoutePathIndex::closestEdge( const GeoDataCoordinates &position, int hint, qreal &distance, GeoDataCoordinates &interpolated ) const
+{
+    const qreal lon = position.longitude();
+    const qreal lat = position.latitude();
+
+    int best = -1;
+    qreal bestDistance = 0.0;
+    if ( hint >= 0 ) {
+        const int end = qMin( hint + hintWindow, m_lons.size() - 1 );
+        for ( int i = qMax( 0, hint - hintWindow ); i <= end; ++i ) {
+            const qreal edge = edgeDistance( i, lon, lat );
+            if ( edge >= 0.0 && ( best < 0 || edge < bestDistance ) ) {
+                best = i;
+                bestDistance = edge;
+            }
+        }
+    }
+
+    if ( !m_nodes.isEmpty() ) {
+        closestEdge( 0, lon, lat, best, bestDistance );
+    }
+
+    if ( best < 0 ) {
+        return -1;
+    }
+
+    distance = bestDistance;
+
+    // Same as RouteSegment::distanceTo()
+    const int next = best + 1 < m_lons.size() && m_segments.at( best + 1 ) == m_segments.at( best ) ? best + 1 : best;
+    qreal const x1 = m_lons.at( best );
+    qreal const y1 = m_lats.at( best );
+    qreal const x2 = m_lons.at( next );
+    qreal const y2 = m_lats.at( next );
+    qreal const len = ( x1 - x2 ) * ( x1 - x2 ) + ( y1 - y2 ) * ( y1 - y2 );
+    qreal const t = len > 0.0 ? ( ( lat - y1 ) * ( y2 - y1 ) + ( lon - x1 ) * ( x2 - x1 ) ) / len : 0.0;
+    if ( t <= 0.0 ) {
+        interpolated = GeoDataCoordinates( x1, y1 );
+    } else if ( t > 1.0 ) {
+        interpolated = GeoDataCoordinates( x2, y2 );
+    } else {
+        interpolated = GeoDataCoordinates( x1 + t * ( x2 - x1 ), y1 + t * ( y2 - y1 ) );
+    }
+
+    return best;
+}
+
+int RoutePathIndex::closestPoint( const GeoDataCoordinates &position, int first ) const
+{
+    int best = -1;
+    qreal bestDistance = 0.0;
+    if ( !m_nodes.isEmpty() ) {
+        closestPoint( 0, position.longitude(), position.latitude(), qMax( 0, first ), best, bestDistance );
+    }
+
+    return best;
+}
+
+int RoutePathIndex::segment( int index ) const
+{
+    return m_segments.at( index );
+}
+
+int RoutePathIndex::build( int begin, int end )
+{
+    const int index = m_nodes.size();
+    m_nodes.append( Node() );
+
+    Node node;
+    node.begin = begin;
+    node.end = end;
+    node.right = -1;
+
+    if ( end - begin > leafSize ) {
+        const int middle = ( begin + end ) / 2;
+        build( begin, middle );
+        node.right = build( middle, end );
+
+        const Node &left = m_nodes.at( index + 1 );
+        const Node &right = m_nodes.at( node.right );
+        node.west = qMin( left.west, right.west );
+        node.east = qMax( left.east, right.east );
+        node.south = qMin( left.south, right.south );
+        node.north = qMax( left.north, right.north );
+    } else {
+        // The last edge of the node ends at the first point of the next node
+        const int last = qMin( end, m_lons.size() - 1 );
+        node.west = node.east = m_lons.at( begin );
+        node.south = node.north = m_lats.at( begin );
+        for ( int i = begin + 1; i <= last; ++i ) {
+            node.west = qMin( node.west, m_lons.at( i ) );
+            node.east = qMax( node.east, m_lons.at( i ) );
+            node.south = qMin( node.south, m_lats.at( i ) );
+            node.north = qMax( node.north, m_lats.at( i ) );
+        }
+    }
+
+    m_nodes[index] = node;
+    return index;
+}
+
+qreal RoutePathIndex::minimalDistance( const Node &node, qreal lon, qreal lat ) const
+{
+    const qreal closestLon = qBound( node.west, lon, node.east );
+    const qreal closestLat = qBound( node.south, lat, node.north );
+
+    // The distances of the edges mix planar and spherical measures, keep
+    // the bound slightly below both of them
+    return 0.99 * EARTH_RADIUS * distanceSphere( lon, lat, closestLon, closestLat );
+}
+
+qreal RoutePathIndex::edgeDistance( int index, qreal lon, qreal lat ) const
+{
+    const bool hasNext = index + 1 < m_lons.size() && m_segments.at( index + 1 ) == m_segments.at( index );
+    if ( !hasNext ) {
+        const bool hasPrevious = index > 0 && m_segments.at( index - 1 ) == m_segments.at( index );
+        if ( hasPrevious ) {
+            // the last point of a segment does not start an edge
+            return -1.0;
+        }
+
+        return EARTH_RADIUS * distanceSphere( lon, lat, m_lons.at( index ), m_lats.at( index ) );
+    }
+
+    // Same as RouteSegment::distancePointToLine()
+    qreal const y0 = lat;
+    qreal const x0 = lon;
+    qreal const y1 = m_lats.at( index );
+    qreal const x1 = m_lons.at( index );
+    qreal const y2 = m_lats.at( index + 1 );
+    qreal const x2 = m_lons.at( index + 1 );
+    qreal const y01 = x0 - x1;
+    qreal const x01 = y0 - y1;
+    qreal const y10 = x1 - x0;
+    qreal const x10 = y1 - y0;
+    qreal const y21 = x2 - x1;
+    qreal const x21 = y2 - y1;
+    qreal const len = ( x1 - x2 ) * ( x1 - x2 ) + ( y1 - y2 ) * ( y1 - y2 );
+    if ( len == 0.0 ) {
+        return EARTH_RADIUS * distanceSphere( x0, y0, x1, y1 );
+    }
+
+    qreal const t = ( x01 * x21 + y01 * y21 ) / len;
+    if ( t < 0.0 ) {
+        return EARTH_RADIUS * distanceSphere( x0, y0, x1, y1 );
+    } else if ( t > 1.0 ) {
+        return EARTH_RADIUS * distanceSphere( x0, y0, x2, y2 );
+    } else {
+        qreal const nom = qAbs( x21 * y10 - x10 * y21 );
+        qreal const den = sqrt( x21 * x21 + y21 * y21 );
+        return EARTH_RADIUS * nom / den;
+    }
+}
+
+void RoutePathIndex::closestEdge( int index, qreal lon, qreal lat, int &best, qreal &bestDistance ) const
+{
+    const Node &node = m_nodes.at( index );
+    if ( best >= 0 && minimalDistance( node, lon, lat ) >= bestDistance ) {
+        return;
+    }
+
+    if ( node.right < 0 ) {
+        for ( int i = node.begin; i < node.end; ++i ) {
+            const qreal distance = edgeDistance( i, lon, lat );
+            if ( distance >= 0.0 && ( best < 0 || distance < bestDistance ) ) {
+                best = i;
+                bestDistance = distance;
+            }
+        }
+        return;
+    }
+
+    // Descend into the closer child first, it probably prunes the other one
+    const int left = index + 1;
+    if ( minimalDistance( m_nodes.at( left ), lon, lat ) <= minimalDistance( m_nodes.at( node.right ), lon, lat ) ) {
+        closestEdge( left, lon, lat, best, bestDistance );
+        closestEdge( node.right, lon, lat, best, bestDistance );
+    } else {
+        closestEdge( node.right, lon, lat, best, bestDistance );
+        closestEdge( left, lon, lat, best, bestDistance );
+    }
+}
+
+void RoutePathIndex::closestPoint( int index, qreal lon, qreal lat, int first, int &best, qreal &bestDistance ) const
+{
+    const Node &node = m_nodes.at( index );
+    if ( node.end <= first ) {
+        return;
+    }
+
+    if ( best >= 0 && minimalDistance( node, lon, lat ) > bestDistance ) {
+        return;
+    }
+
+    if ( node.right < 0 ) {
+        for ( int i = qMax( node.begin, first ); i < node.end; ++i ) {
+            const qreal distance = EARTH_RADIUS * distanceSphere( lon, lat, m_lons.at( i ), m_lats.at( i ) );
+            // Prefer the first of several points in the same distance
+            if ( best < 0 || distance < bestDistance || ( distance == bestDistance && i < best ) ) {
+                best = i;
+                bestDistance = distance;
+            }
+        }
+        return;
+    }
+
+    const int left = index + 1;
+    if ( minimalDistance( m_nodes.at( left ), lon, lat ) <= minimalDistance( m_nodes.at( node.right ), lon, lat ) ) {
+        closestPoint( left, lon, lat, first, best, bestDistance );
+        closestPoint( node.right, lon, lat, first, best, bestDistance );
+    } else {
+        closestPoint( node.right, lon, lat, first, best, bestDistance );
+        closestPoint( left, lon, lat, first, best, bestDistance );
+    }
+}
+
+}
@@ -0,0 +1,85 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_ROUTEPATHINDEX_H
+#define MARBLE_ROUTEPATHINDEX_H
+
+#include <QVector>
+
+namespace Marble
+{
+
+class GeoDataCoordinates;
+class RouteSegment;
+
+/**
+ * @brief A bounding volume hierarchy over the path of a route.
+ *
+ * The points of the path are numbered like in Route::path(). The tree
+ * splits the path into halves recursively, which keeps neighboring points
+ * together as the path is continuous. Closest point and closest edge
+ * queries only descend into the nodes whose bounding box is closer than the
+ * best candidate found so far.
+ */
+class RoutePathIndex
+{
+public:
+    explicit RoutePathIndex( const QVector<RouteSegment> &segments );
+
+    /**
+     * Returns the index of the first point of the edge of the path which is
+     * closest to @p position, or -1 if the path is empty. Edges connect the
+     * points within a route segment, a segment with a single point is an
+     * edge by itself. The edges around @p hint, usually the result for the
+     * previous position, are tried first to narrow down the search.
+     * @p distance is set to the distance in meters and @p interpolated to the
+     * closest position on the edge.
+     */
+    int closestEdge( const GeoDataCoordinates &position, int hint, qreal &distance, GeoDataCoordinates &interpolated ) const;
+
+    /**
+     * Returns the index of the point of the path closest to @p position,
+     * ignoring the points before @p first, or -1 if there is no such point.
+     */
+    int closestPoint( const GeoDataCoordinates &position, int first ) const;
+
+    /**
+     * Returns the index of the route segment containing the point @p index.
+     */
+    int segment( int index ) const;
+
+private:
+    struct Node
+    {
+        qreal west;
+        qreal east;
+        qreal south;
+        qreal north;
+        // the range of points, edges start at these points
+        int begin;
+        int end;
+        // the left child follows the node, -1 for leaves
+        int right;
+    };
+
+    int build( int begin, int end );
+    qreal minimalDistance( const Node &node, qreal lon, qreal lat ) const;
+    qreal edgeDistance( int index, qreal lon, qreal lat ) const;
+    void closestEdge( int node, qreal lon, qreal lat, int &best, qreal &bestDistance ) const;
+    void closestPoint( int node, qreal lon, qreal lat, int first, int &best, qreal &bestDistance ) const;
+
+    // in radians
+    QVector<qreal> m_lons;
+    QVector<qreal> m_lats;
+    QVector<int> m_segments;
+    QVector<Node> m_nodes;
+};
+
+}
+
+#endif
@@ -237,36 +237,21 @@ int RoutingModel::rightNeighbor( const GeoDataCoordinates &position, RouteReques
         return route->size() - 1;
     }
 
-    // Generate an ordered list of all waypoints
-    GeoDataLineString points = d->m_route.path();
+    // The waypoints are the points of the route path, see Route::closestPathPoint()
+    const GeoDataLineString &points = d->m_route.path();
     QMap<int,int> mapping;
 
     // Force first mapping point to match the route start
     mapping[0] = 0;
 
     // Calculate the mapping between waypoints and via points
-    // Need two for loops to avoid getting stuck in local minima
+    // Search each via point after the previous one to avoid getting stuck in local minima
     for ( int j=1; j<route->size()-1; ++j ) {
-        qreal minDistance = -1.0;
-        for ( int i=mapping[j-1]; i<points.size(); ++i ) {
-            qreal distance = distanceSphere( points[i], route->at(j) );
-            if (minDistance < 0.0 || distance < minDistance ) {
-                mapping[j] = i;
-                minDistance = distance;
-            }
-        }
+        mapping[j] = qMax( mapping[j-1], d->m_route.closestPathPoint( route->at(j), mapping[j-1] ) );
     }
 
     // Determine waypoint with minimum distance to the provided position
-    qreal minWaypointDistance = -1.0;
-    int waypoint=0;
-    for ( int i=0; i<points.size(); ++i ) {
-        qreal waypointDistance = distanceSphere( points[i], position );
-        if ( minWaypointDistance < 0.0 || waypointDistance < minWaypointDistance ) {
-            minWaypointDistance = waypointDistance;
-            waypoint = i;
-        }
-    }
+    const int waypoint = qMax( 0, d->m_route.closestPathPoint( position ) );
 
     // Force last mapping point to match the route destination
     mapping[route->size()-1] = points.size()-1;
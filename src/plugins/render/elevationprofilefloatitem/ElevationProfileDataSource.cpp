@@ -42,9 +42,11 @@ QList<QPointF> ElevationProfileDataSource::calculateElevationData( const GeoData
     QList<QPointF> result;
     qreal distance = 0;
 
+    const QVector<qreal> elevations = getElevations( lineString );
+
     //GeoDataLineString path;
     for ( int i = 0; i < lineString.size(); i++ ) {
-        const qreal ele = getElevation( lineString[i] );
+        const qreal ele = elevations.at( i );
 
         if ( i ) {
             distance += EARTH_RADIUS * distanceSphere( lineString[i-1], lineString[i] );
@@ -107,9 +109,14 @@ bool ElevationProfileTrackDataSource::isDataAvailable() const
     return !m_trackHash.isEmpty();
 }
 
-qreal ElevationProfileTrackDataSource::getElevation(const GeoDataCoordinates &coordinates) const
+QVector<qreal> ElevationProfileTrackDataSource::getElevations(const GeoDataLineString &lineString) const
 {
-    return coordinates.altitude();
+    QVector<qreal> elevations;
+    elevations.reserve( lineString.size() );
+    for ( int i = 0; i < lineString.size(); ++i ) {
+        elevations << lineString[i].altitude();
+    }
+    return elevations;
 }
 
 void ElevationProfileTrackDataSource::handleObjectAdded(GeoDataObject *object)
@@ -225,7 +232,13 @@ void ElevationProfileRouteDataSource::requestUpdate()
         m_routeAvailable = isDataAvailable();
     }
 
-    const GeoDataLineString routePoints = m_routingModel->route().path();
+    // Sample the heights along the great circles between the route points,
+    // the route points alone are too far apart on straight roads
+    GeoDataLineString routePoints;
+    foreach ( const GeoDataCoordinates &coordinates, m_elevationModel->heightProfile( m_routingModel->route().path() ) ) {
+        routePoints << coordinates;
+    }
+
     const QList<QPointF> elevationData = calculateElevationData( routePoints );
     emit dataUpdated( routePoints, elevationData );
 }
@@ -235,15 +248,15 @@ bool ElevationProfileRouteDataSource::isDataAvailable() const
     return m_routingModel && m_routingModel->rowCount() > 0;
 }
 
-qreal ElevationProfileRouteDataSource::getElevation(const GeoDataCoordinates &coordinates) const
+QVector<qreal> ElevationProfileRouteDataSource::getElevations(const GeoDataLineString &lineString) const
 {
-    const qreal lat = coordinates.latitude ( GeoDataCoordinates::Degree );
-    const qreal lon = coordinates.longitude( GeoDataCoordinates::Degree );
-    qreal ele = m_elevationModel->height( lon, lat );
-    if ( ele == invalidElevationData ) { // no data
-        ele = 0;
+    // the samples of ElevationModel::heightProfile() carry their height
+    QVector<qreal> elevations;
+    elevations.reserve( lineString.size() );
+    for ( int i = 0; i < lineString.size(); ++i ) {
+        elevations << lineString[i].altitude();
     }
-    return ele;
+    return elevations;
 }
 // end of impl of ElevationProfileRouteDataSource
 
@@ -19,6 +19,7 @@
 #include <QList>
 #include <QPointF>
 #include <QStringList>
+#include <QVector>
 
 namespace Marble
 {
@@ -54,7 +55,10 @@ Q_SIGNALS:
 
 protected:
     QList<QPointF> calculateElevationData(const GeoDataLineString &lineString) const;
-    virtual qreal getElevation(const GeoDataCoordinates &coordinates) const = 0;
+    /**
+     * @brief returns the elevations of all points of @p lineString at once
+     */
+    virtual QVector<qreal> getElevations(const GeoDataLineString &lineString) const = 0;
 };
 
 /**
@@ -79,7 +83,7 @@ public Q_SLOTS:
     virtual void requestUpdate();
 
 protected:
-    virtual qreal getElevation(const GeoDataCoordinates &coordinates) const;
+    virtual QVector<qreal> getElevations(const GeoDataLineString &lineString) const;
 
 private Q_SLOTS:
     void handleObjectAdded( GeoDataObject *object );
@@ -108,7 +112,7 @@ public Q_SLOTS:
     virtual void requestUpdate();
 
 protected:
-    virtual qreal getElevation(const GeoDataCoordinates &coordinates) const;
+    virtual QVector<qreal> getElevations(const GeoDataLineString &lineString) const;
 
 private:
     const RoutingModel *const m_routingModel;
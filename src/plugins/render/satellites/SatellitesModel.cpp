@@ -32,7 +32,7 @@ SatellitesModel::SatellitesModel( GeoDataTreeModel *treeModel,
       m_currentColorIndex( 0 )
 {
     setupColors();
-    connect(m_clock, SIGNAL(timeChanged()), this, SLOT(update()));
+    connect(m_clock, SIGNAL(timeChanged()), this, SLOT(updateSatellites()));
 }
 
 void SatellitesModel::setupColors()
@@ -108,14 +108,30 @@ void SatellitesModel::updateVisibility()
             eItem->setEnabled( enabled );
 
             if( enabled ) {
-                eItem->update();
+                m_propagator.addItem( eItem );
             }
         }
     }
 
+    m_propagator.propagate();
+
     endUpdateItems();
 }
 
+void SatellitesModel::updateSatellites()
+{
+    foreach( TrackerPluginItem *obj, items() ) {
+        SatellitesTLEItem *eItem = dynamic_cast<SatellitesTLEItem*>(obj);
+        if( eItem != NULL ) {
+            m_propagator.addItem( eItem );
+        } else {
+            obj->update();
+        }
+    }
+
+    m_propagator.propagate();
+}
+
 void SatellitesModel::parseFile( const QString &id,
                                  const QByteArray &data )
 {
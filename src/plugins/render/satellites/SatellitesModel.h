@@ -16,6 +16,7 @@
 #include <QVector>
 
 #include "TrackerPluginModel.h"
+#include "SatellitesPropagator.h"
 
 namespace Marble {
 
@@ -49,12 +50,19 @@ protected:
      */
     void parseTLE( const QString &id, const QByteArray &data );
 
+private Q_SLOTS:
+    /**
+     * Updates all items, the TLE satellites are propagated at once.
+     */
+    void updateSatellites();
+
 private:
     void setupColors();
     QColor nextColor();
 
 private:
     const MarbleClock *m_clock;
+    SatellitesPropagator m_propagator;
     QStringList m_enabledIds;
     QString m_lcPlanet;
     QVector<QColor> m_colorList;
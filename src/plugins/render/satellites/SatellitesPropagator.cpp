@@ -0,0 +1,119 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "SatellitesPropagator.h"
+
+#include "JobGroup.h"
+#include "MarbleGlobal.h"
+#include "SatellitesTLEItem.h"
+
+#include <QRunnable>
+
+namespace Marble {
+
+class SatellitesPropagator::PropagationJob : public QRunnable
+{
+public:
+    PropagationJob( SatellitesPropagator *propagator, int begin, int end )
+        : m_propagator( propagator ),
+          m_begin( begin ),
+          m_end( end )
+    {
+    }
+
+    virtual void run()
+    {
+        m_propagator->propagateRange( m_begin, m_end );
+    }
+
+private:
+    SatellitesPropagator *const m_propagator;
+    const int m_begin;
+    const int m_end;
+};
+
+SatellitesPropagator::SatellitesPropagator()
+{
+    m_offsets << 0;
+}
+
+SatellitesPropagator::~SatellitesPropagator()
+{
+}
+
+void SatellitesPropagator::addItem( SatellitesTLEItem *item )
+{
+    if ( item->missingPoints( m_times ) > 0 ) {
+        m_items << item;
+        m_offsets << m_times.size();
+    }
+}
+
+void SatellitesPropagator::propagate()
+{
+    const int size = m_times.size();
+    m_longitudes.resize( size );
+    m_latitudes.resize( size );
+    m_altitudes.resize( size );
+    m_valid.resize( size );
+
+    JobGroup jobs( MarbleGlobal::getInstance()->threadPool() );
+    const int jobsPerThread = 4;
+    const int minimumJobSize = 256;
+    const int jobSize = qMax( minimumJobSize, size / ( qMax( 1, jobs.maxThreadCount() ) * jobsPerThread ) );
+
+    if ( size <= jobSize ) {
+        propagateRange( 0, m_items.size() );
+    } else {
+        // Jobs consist of whole items with about jobSize points in total
+        int begin = 0;
+        for ( int i = 0; i < m_items.size(); ++i ) {
+            if ( m_offsets.at( i + 1 ) - m_offsets.at( begin ) >= jobSize || i + 1 == m_items.size() ) {
+                jobs.start( new PropagationJob( this, begin, i + 1 ) );
+                begin = i + 1;
+            }
+        }
+        jobs.waitForDone();
+    }
+
+    // The tracks are not thread-safe
+    for ( int i = 0; i < m_items.size(); ++i ) {
+        const int offset = m_offsets.at( i );
+        m_items.at( i )->addPoints( m_longitudes.constData() + offset,
+                                    m_latitudes.constData() + offset,
+                                    m_altitudes.constData() + offset,
+                                    m_valid.constData() + offset );
+    }
+
+    clear();
+}
+
+void SatellitesPropagator::propagateRange( int begin, int end )
+{
+    qreal *const longitudes = m_longitudes.data();
+    qreal *const latitudes = m_latitudes.data();
+    qreal *const altitudes = m_altitudes.data();
+    bool *const valid = m_valid.data();
+
+    for ( int i = begin; i < end; ++i ) {
+        SatellitesTLEItem *const item = m_items.at( i );
+        for ( int j = m_offsets.at( i ); j < m_offsets.at( i + 1 ); ++j ) {
+            valid[j] = item->position( m_times.at( j ), longitudes[j], latitudes[j], altitudes[j] );
+        }
+    }
+}
+
+void SatellitesPropagator::clear()
+{
+    // resize() keeps the allocated memory, clear() would release it
+    m_items.resize( 0 );
+    m_offsets.resize( 1 );
+    m_times.resize( 0 );
+}
+
+}
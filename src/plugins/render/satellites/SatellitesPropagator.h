@@ -0,0 +1,66 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_SATELLITESPROPAGATOR_H
+#define MARBLE_SATELLITESPROPAGATOR_H
+
+#include <QVector>
+
+namespace Marble {
+
+class SatellitesTLEItem;
+
+/**
+ * Calculates the missing track points of many TLE satellites at once.
+ *
+ * The times of the points are collected from the items by addItem() into
+ * flat arrays, the results are stored the same way. propagate() distributes
+ * the satellites on several threads, each satellite is propagated by one
+ * thread for all of its times. The results are added to the tracks of the
+ * items on the calling thread afterwards.
+ */
+class SatellitesPropagator
+{
+public:
+    SatellitesPropagator();
+    ~SatellitesPropagator();
+
+    /**
+     * Adds the missing track points of @p item, see
+     * SatellitesTLEItem::missingPoints().
+     */
+    void addItem( SatellitesTLEItem *item );
+
+    /**
+     * Calculates the points of all items added since the last call and adds
+     * them to the tracks of the items.
+     */
+    void propagate();
+
+private:
+    Q_DISABLE_COPY( SatellitesPropagator )
+
+    class PropagationJob;
+
+    void propagateRange( int begin, int end );
+    void clear();
+
+    QVector<SatellitesTLEItem *> m_items;
+    // the index of the first time of each item, followed by the number of times
+    QVector<int> m_offsets;
+    // in minutes after the epoch of the item
+    QVector<double> m_times;
+    QVector<qreal> m_longitudes;
+    QVector<qreal> m_latitudes;
+    QVector<qreal> m_altitudes;
+    QVector<bool> m_valid;
+};
+
+}
+
+#endif // MARBLE_SATELLITESPROPAGATOR_H
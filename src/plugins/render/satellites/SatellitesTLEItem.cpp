@@ -10,6 +10,8 @@
 
 #include "SatellitesTLEItem.h"
 
+#include "SatellitesPropagator.h"
+
 #include "MarbleClock.h"
 #include "MarbleDebug.h"
 #include "MarbleGlobal.h"
@@ -48,6 +50,7 @@ SatellitesTLEItem::SatellitesTLEItem( const QString &name,
     double radiusearthkm;
     getgravconst( wgs84, tumin, mu, radiusearthkm, xke, j2, j3, j4, j3oj2 );
     m_earthSemiMajorAxis = radiusearthkm;
+    m_epoch = timeAtEpoch();
 
     setDescription();
 
@@ -80,11 +83,20 @@ void SatellitesTLEItem::setDescription()
 
 void SatellitesTLEItem::update()
 {
+    SatellitesPropagator propagator;
+    propagator.addItem( this );
+    propagator.propagate();
+}
+
+int SatellitesTLEItem::missingPoints( QVector<double> &minutes )
+{
+    m_missingPoints.resize( 0 );
     if( !isEnabled() ) {
-        return;
+        return 0;
     }
 
-    QDateTime startTime = m_clock->dateTime();
+    const QDateTime currentTime = m_clock->dateTime();
+    QDateTime startTime = currentTime;
     QDateTime endTime = startTime;
     if( isTrackVisible() ) {
         startTime = startTime.addSecs( -2 * 60 );
@@ -94,37 +106,51 @@ void SatellitesTLEItem::update()
     m_track->removeBefore( startTime );
     m_track->removeAfter( endTime );
 
-    addPointAt( m_clock->dateTime() );
+    m_missingPoints << currentTime;
 
     // time interval between each point in the track, in seconds
-    double step = period() / 100.0;
-
-    for ( double i = startTime.toTime_t(); i < endTime.toTime_t(); i += step ) {
-        // No need to add points in this interval
-        if ( i >= m_track->firstWhen().toTime_t() ) {
-            i = m_track->lastWhen().toTime_t() + step;
+    const double step = period() / 100.0;
+    const qint64 epoch = m_epoch.toTime_t();
+    const qint64 start = startTime.toTime_t();
+    const qint64 end = endTime.toTime_t();
+    const qint64 first = m_track->size() > 0 ? m_track->firstWhen().toTime_t() : end;
+    const qint64 last = m_track->size() > 0 ? m_track->lastWhen().toTime_t() : start;
+
+    // No need to add points in the interval covered by the track already
+    for ( double i = ceil( ( start - epoch ) / step ); epoch + i * step < end; ++i ) {
+        const qint64 time = epoch + qint64( i * step );
+        if ( time < first || time > last ) {
+            m_missingPoints << QDateTime::fromTime_t( time );
         }
+    }
 
-        addPointAt( QDateTime::fromTime_t( i ) );
+    foreach ( const QDateTime &time, m_missingPoints ) {
+        minutes << ( time.toTime_t() - epoch ) / 60.0;
     }
+
+    return m_missingPoints.size();
 }
 
-void SatellitesTLEItem::addPointAt( const QDateTime &dateTime )
+bool SatellitesTLEItem::position( double minutes, qreal &lon, qreal &lat, qreal &alt )
 {
-    // in minutes
-    double timeSinceEpoch = (double)( dateTime.toTime_t() -
-        timeAtEpoch().toTime_t() ) / 60.0;
-
     double r[3], v[3];
-    sgp4( wgs84, m_satrec, timeSinceEpoch, r, v );
-
-    GeoDataCoordinates coordinates = fromTEME(
-        r[0], r[1], r[2], gmst( timeSinceEpoch ) );
+    sgp4( wgs84, m_satrec, minutes, r, v );
     if ( m_satrec.error != 0 ) {
-        return;
+        return false;
     }
 
-    m_track->addPoint( dateTime, coordinates);
+    fromTEME( r[0], r[1], r[2], gmst( minutes ), lon, lat, alt );
+    return true;
+}
+
+void SatellitesTLEItem::addPoints( const qreal *lon, const qreal *lat, const qreal *alt, const bool *valid )
+{
+    for ( int i = 0; i < m_missingPoints.size(); ++i ) {
+        if ( valid[i] ) {
+            m_track->addPoint( m_missingPoints.at( i ), GeoDataCoordinates( lon[i], lat[i], alt[i] ) );
+        }
+    }
+    m_missingPoints.resize( 0 );
 }
 
 QDateTime SatellitesTLEItem::timeAtEpoch() const
@@ -169,17 +195,20 @@ double SatellitesTLEItem::inclination() const
     return m_satrec.inclo / M_PI * 180;
 }
 
-GeoDataCoordinates SatellitesTLEItem::fromTEME( double x,
-                                                double y,
-                                                double z,
-                                                double gmst ) const
+void SatellitesTLEItem::fromTEME( double x,
+                                  double y,
+                                  double z,
+                                  double gmst,
+                                  qreal &lon,
+                                  qreal &lat,
+                                  qreal &alt ) const
 {
-    double lon = atan2( y, x );
+    lon = atan2( y, x );
     // Rotate the angle by gmst (the origin goes from the vernal equinox
     // point to the Greenwich Meridian)
     lon = GeoDataCoordinates::normalizeLon( fmod(lon - gmst, 2 * M_PI) );
 
-    double lat = atan2( z, sqrt( x*x + y*y ) );
+    lat = atan2( z, sqrt( x*x + y*y ) );
 
     //TODO: determine if this is worth the extra precision
     // Algorithm from http://celestrak.com/columns/v02n03/
@@ -193,11 +222,9 @@ GeoDataCoordinates SatellitesTLEItem::fromTEME( double x,
         lat = atan2( z + a * C * square( m_satrec.ecco ) * sin( latp ), planetRadius );
     }
 
-    double alt = planetRadius / cos( lat ) - a * C;
+    alt = ( planetRadius / cos( lat ) - a * C ) * 1000;
 
     lat = GeoDataCoordinates::normalizeLat( lat );
-
-    return GeoDataCoordinates( lon, lat, alt * 1000 );
 }
 
 double SatellitesTLEItem::gmst( double minutesP ) const
@@ -18,6 +18,9 @@
 
 #include <sgp4unit.h>
 
+#include <QDateTime>
+#include <QVector>
+
 class QColor;
 
 namespace Marble {
@@ -38,29 +41,54 @@ public:
 
     void update();
 
+    /**
+     * Removes the track points outside of the time window around the clock
+     * time and appends the times of the points missing in the window to
+     * @p minutes, in minutes after the epoch. The track points are sampled
+     * at fixed steps after the epoch, so the points calculated for earlier
+     * clock times stay valid and only the new ones are missing.
+     * @return the number of missing points
+     *
+     * @see addPoints(), SatellitesPropagator
+     */
+    int missingPoints( QVector<double> &minutes );
+
+    /**
+     * Calculates the coordinates of the satellite @p minutes after the epoch.
+     * Only the orbital elements of this item are modified, so the positions
+     * of different items can be calculated on different threads.
+     * @return false if the propagation failed
+     */
+    bool position( double minutes, qreal &lon, qreal &lat, qreal &alt );
+
+    /**
+     * Adds the points returned by the last call to missingPoints() to the
+     * track, @p valid tells which of them could be calculated.
+     */
+    void addPoints( const qreal *lon, const qreal *lat, const qreal *alt, const bool *valid );
+
 private:
     double m_earthSemiMajorAxis; // in km
     elsetrec m_satrec;
+    QDateTime m_epoch;
 
     GeoDataTrack *m_track;
+    // the times of the points returned by missingPoints()
+    QVector<QDateTime> m_missingPoints;
 
     const MarbleClock *m_clock;
 
     void setDescription();
 
     /**
-     * Add a point in the GeoDataTrack geometry of the placemark with time
-     * dateTime and coordinates of the satellite determined from m_satrec.
-     */
-    void addPointAt( const QDateTime &dateTime );
-
-    /**
-     * Create a GeoDataCoordinates object from the cartesian coordinates
+     * Calculate the longitude and latitude in radians and the altitude in m
+     * from the cartesian coordinates
      * @p x, @p y and @p z in km in the Earth-centered inertial frame known
      * as TEME (True equator, Mean equinox) with Greenwich Mean Sidereal Time
      * @p gmst in radians at time of observation.
      */
-    GeoDataCoordinates fromTEME( double x, double y, double z, double gmst ) const;
+    void fromTEME( double x, double y, double z, double gmst,
+                   qreal &lon, qreal &lat, qreal &alt ) const;
 
     /**
      * @return The time at the satellite epoch determined from m_satrec
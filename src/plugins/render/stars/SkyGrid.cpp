@@ -0,0 +1,126 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "SkyGrid.h"
+
+#include <qmath.h>
+
+#include "MarbleGlobal.h"
+#include "ViewportParams.h"
+
+namespace Marble
+{
+
+static const int bandCount = 18;
+static const qreal bandHeight = M_PI / bandCount;
+
+static qreal angularDistance( const Quaternion &a, const Quaternion &b )
+{
+    const qreal dot = a.v[Q_X] * b.v[Q_X] + a.v[Q_Y] * b.v[Q_Y] + a.v[Q_Z] * b.v[Q_Z];
+    return acos( qBound( qreal( -1.0 ), dot, qreal( 1.0 ) ) );
+}
+
+SkyGrid::SkyGrid()
+{
+    m_bandOffsets << 0;
+
+    for ( int band = 0; band < bandCount; ++band ) {
+        const qreal south = -M_PI / 2 + band * bandHeight;
+        const qreal north = south + bandHeight;
+        const int cellCount = qMax( 1, qRound( 2 * M_PI * cos( ( north + south ) / 2 ) / bandHeight ) );
+        const qreal cellWidth = 2 * M_PI / cellCount;
+
+        for ( int i = 0; i < cellCount; ++i ) {
+            const qreal west = i * cellWidth;
+            const qreal east = west + cellWidth;
+
+            Cell cell;
+            cell.center = Quaternion::fromSpherical( ( west + east ) / 2, ( north + south ) / 2 );
+
+            // The points farthest from the center lie on the border of the cell
+            const int steps = 8;
+            qreal radius = 0;
+            for ( int s = 0; s <= steps; ++s ) {
+                const qreal lon = west + s * cellWidth / steps;
+                const qreal lat = south + s * bandHeight / steps;
+                radius = qMax( radius, angularDistance( cell.center, Quaternion::fromSpherical( lon, south ) ) );
+                radius = qMax( radius, angularDistance( cell.center, Quaternion::fromSpherical( lon, north ) ) );
+                radius = qMax( radius, angularDistance( cell.center, Quaternion::fromSpherical( west, lat ) ) );
+                radius = qMax( radius, angularDistance( cell.center, Quaternion::fromSpherical( east, lat ) ) );
+            }
+            // leave some room for the sampling
+            radius *= 1.05;
+
+            cell.sinRadius = sin( radius );
+            cell.chord = 2 * sin( radius / 2 );
+            m_cells << cell;
+        }
+
+        m_bandOffsets << m_cells.size();
+    }
+}
+
+int SkyGrid::size() const
+{
+    return m_cells.size();
+}
+
+int SkyGrid::cell( const Quaternion &position ) const
+{
+    const qreal lat = asin( qBound( qreal( -1.0 ), position.v[Q_Y], qreal( 1.0 ) ) );
+    qreal lon = atan2( position.v[Q_X], position.v[Q_Z] );
+    if ( lon < 0 ) {
+        lon += 2 * M_PI;
+    }
+
+    const int band = qBound( 0, int( ( lat + M_PI / 2 ) / bandHeight ), bandCount - 1 );
+    const int cellCount = m_bandOffsets.at( band + 1 ) - m_bandOffsets.at( band );
+    const int i = qBound( 0, int( lon / ( 2 * M_PI ) * cellCount ), cellCount - 1 );
+
+    return m_bandOffsets.at( band ) + i;
+}
+
+void SkyGrid::visibleCells( const matrix &skyAxisMatrix, qreal skyRadius,
+                            const ViewportParams *viewport, QVector<int> &cells ) const
+{
+    cells.resize( 0 );
+
+    const qreal earthRadius = viewport->radius();
+    const qreal width = viewport->width();
+    const qreal height = viewport->height();
+
+    for ( int c = 0; c < m_cells.size(); ++c ) {
+        const Cell &cell = m_cells.at( c );
+        Quaternion center = cell.center;
+        center.rotateAroundAxis( skyAxisMatrix );
+
+        // Points are visible if z <= 0
+        if ( center.v[Q_Z] > cell.sinRadius ) {
+            continue;
+        }
+
+        const qreal x = center.v[Q_X] * skyRadius;
+        const qreal y = center.v[Q_Y] * skyRadius;
+        const qreal extent = cell.chord * skyRadius;
+
+        if ( width / 2 + x + extent < 0 || width / 2 + x - extent >= width
+             || height / 2 - y + extent < 0 || height / 2 - y - extent >= height ) {
+            continue;
+        }
+
+        // Hidden behind the planet
+        if ( center.v[Q_Z] < -cell.sinRadius
+             && sqrt( x * x + y * y ) + extent < earthRadius ) {
+            continue;
+        }
+
+        cells << c;
+    }
+}
+
+}
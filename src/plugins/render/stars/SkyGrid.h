@@ -0,0 +1,102 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_SKYGRID_H
+#define MARBLE_SKYGRID_H
+
+#include <QVector>
+
+#include "Quaternion.h"
+
+namespace Marble
+{
+
+class ViewportParams;
+
+/**
+ * @short A partition of the celestial sphere into cells of about the same area.
+ *
+ * The sky is divided into bands of declination, each band into cells of
+ * right ascension. The number of cells of a band decreases towards the poles,
+ * so all cells cover about 10 by 10 degrees. Objects sorted into the cells
+ * by sortIntoCells() can be culled a cell at a time by visibleCells().
+ */
+class SkyGrid
+{
+public:
+    SkyGrid();
+
+    /**
+     * Returns the number of cells.
+     */
+    int size() const;
+
+    /**
+     * Returns the index of the cell containing @p position, which is
+     * a unit vector as created by Quaternion::fromSpherical().
+     */
+    int cell( const Quaternion &position ) const;
+
+    /**
+     * Sorts @p points by their cells and sets @p offsets to the index of the
+     * first point of each cell, followed by the number of points. The order
+     * of the points within a cell is kept.
+     */
+    template<class T>
+    void sortIntoCells( QVector<T> &points, QVector<int> &offsets ) const;
+
+    /**
+     * Sets @p cells to the cells which may contain points that are on the
+     * visible side of the sky, on the screen and not hidden by the planet,
+     * for the sky rotated by @p skyAxisMatrix and projected onto a sphere of
+     * @p skyRadius pixels.
+     */
+    void visibleCells( const matrix &skyAxisMatrix, qreal skyRadius,
+                       const ViewportParams *viewport, QVector<int> &cells ) const;
+
+private:
+    struct Cell
+    {
+        Quaternion center;
+        // of the largest angular distance of a point of the cell to the center
+        qreal sinRadius;
+        // the largest distance of a point of the cell to the center on the unit sphere
+        qreal chord;
+    };
+
+    // the first cell of each band, followed by the number of cells
+    QVector<int> m_bandOffsets;
+    QVector<Cell> m_cells;
+};
+
+template<class T>
+void SkyGrid::sortIntoCells( QVector<T> &points, QVector<int> &offsets ) const
+{
+    QVector<int> cells( points.size() );
+    offsets.fill( 0, m_cells.size() + 1 );
+    for ( int i = 0; i < points.size(); ++i ) {
+        cells[i] = cell( points.at( i ).quaternion() );
+        ++offsets[cells.at( i ) + 1];
+    }
+
+    for ( int c = 0; c < m_cells.size(); ++c ) {
+        offsets[c + 1] += offsets.at( c );
+    }
+
+    QVector<int> positions = offsets;
+    QVector<T> sorted( points.size() );
+    for ( int i = 0; i < points.size(); ++i ) {
+        sorted[positions[cells.at( i )]++] = points.at( i );
+    }
+
+    points = sorted;
+}
+
+}
+
+#endif // MARBLE_SKYGRID_H
@@ -21,6 +21,8 @@
 #include <QColorDialog>
 #include <qmath.h>
 
+#include <algorithm>
+
 #include "MarbleClock.h"
 #include "MarbleDebug.h"
 #include "MarbleDirs.h"
@@ -529,11 +531,17 @@ void StarsPlugin::celestialPoleGetColor()
     }
 }
 
+static bool isBrighter( const StarPoint &a, const StarPoint &b )
+{
+    return a.magnitude() < b.magnitude();
+}
+
 void StarsPlugin::loadStars()
 {
     //mDebug() << Q_FUNC_INFO;
     // Load star data
     m_stars.clear();
+    m_starCellOffsets.fill( 0, m_skyGrid.size() + 1 );
 
     QFile starFile( MarbleDirs::path( "stars/stars.dat" ) );
     starFile.open( QIODevice::ReadOnly );
@@ -561,7 +569,6 @@ void StarsPlugin::loadStars()
 
     int maxid = 0;
     int id = 0;
-    int starIndex = 0;
     double ra;
     double de;
     double mag;
@@ -587,13 +594,39 @@ void StarsPlugin::loadStars()
         StarPoint star( id, ( qreal )( ra ), ( qreal )( de ), ( qreal )( mag ), colorId );
         // Create entry in stars database
         m_stars << star;
+    }
+
+    // Render only needs to look at the stars of the visible sky cells,
+    // up to the first star that is too faint
+    m_skyGrid.sortIntoCells( m_stars, m_starCellOffsets );
+    int maxCellSize = 0;
+    for ( int c = 0; c < m_skyGrid.size(); ++c ) {
+        const int begin = m_starCellOffsets.at( c );
+        const int end = m_starCellOffsets.at( c + 1 );
+        std::stable_sort( m_stars.begin() + begin, m_stars.begin() + end, isBrighter );
+        maxCellSize = qMax( maxCellSize, end - begin );
+    }
+
+    m_idHash.clear();
+    m_starX.resize( m_stars.size() );
+    m_starY.resize( m_stars.size() );
+    m_starZ.resize( m_stars.size() );
+    m_starMagnitudes.resize( m_stars.size() );
+    for ( int s = 0; s < m_stars.size(); ++s ) {
+        const StarPoint &star = m_stars.at( s );
         // Create key,value pair in idHash table to map from star id to
         // index in star database vector
-        m_idHash[id] = starIndex;
-        // Increment Index for use in hash
-        ++starIndex;
+        m_idHash[star.id()] = s;
+        m_starX[s] = star.quaternion().v[Q_X];
+        m_starY[s] = star.quaternion().v[Q_Y];
+        m_starZ[s] = star.quaternion().v[Q_Z];
+        m_starMagnitudes[s] = star.magnitude();
     }
 
+    m_rotatedX.resize( maxCellSize );
+    m_rotatedY.resize( maxCellSize );
+    m_rotatedZ.resize( maxCellSize );
+
     // load the Sun pixmap
     // TODO: adjust pixmap size according to distance
     m_pixmapSun.load( MarbleDirs::path( "svg/sun.png" ) );
@@ -602,6 +635,25 @@ void StarsPlugin::loadStars()
     m_starsLoaded = true;
 }
 
+void StarsPlugin::rotateStars( const matrix &skyAxisMatrix, int begin, int end )
+{
+    // Same as Quaternion::rotateAroundAxis(), written as a plain loop over
+    // the arrays so that the compiler can vectorize it
+    const qreal *const x = m_starX.constData() + begin;
+    const qreal *const y = m_starY.constData() + begin;
+    const qreal *const z = m_starZ.constData() + begin;
+    qreal *const rotatedX = m_rotatedX.data();
+    qreal *const rotatedY = m_rotatedY.data();
+    qreal *const rotatedZ = m_rotatedZ.data();
+    const int count = end - begin;
+
+    for ( int i = 0; i < count; ++i ) {
+        rotatedX[i] = skyAxisMatrix[0][0] * x[i] + skyAxisMatrix[1][0] * y[i] + skyAxisMatrix[2][0] * z[i];
+        rotatedY[i] = skyAxisMatrix[0][1] * x[i] + skyAxisMatrix[1][1] * y[i] + skyAxisMatrix[2][1] * z[i];
+        rotatedZ[i] = skyAxisMatrix[0][2] * x[i] + skyAxisMatrix[1][2] * y[i] + skyAxisMatrix[2][2] * z[i];
+    }
+}
+
 void StarsPlugin::createStarPixmaps()
 {
     // Load star pixmaps
@@ -774,6 +826,8 @@ void StarsPlugin::loadDsos()
         m_dsos << dso;
     }
 
+    m_skyGrid.sortIntoCells( m_dsos, m_dsoCellOffsets );
+
     m_dsoImage.load( MarbleDirs::path( "stars/deepsky.png" ) );
     m_dsosLoaded = true;
 }
@@ -933,45 +987,49 @@ bool StarsPlugin::render( GeoPainter *painter, ViewportParams *viewport,
             }
         }
 
+        m_skyGrid.visibleCells( skyAxisMatrix, skyRadius, viewport, m_visibleCells );
+
         if ( m_renderDsos ) {
             painter->setPen(dsoLabelPen);
             // Render Deep Space Objects
-            for ( int d = 0; d < m_dsos.size(); ++d ) {
-                Quaternion qpos = m_dsos.at( d ).quaternion();
-                qpos.rotateAroundAxis( skyAxisMatrix );
+            foreach ( int c, m_visibleCells ) {
+                for ( int d = m_dsoCellOffsets.at( c ); d < m_dsoCellOffsets.at( c + 1 ); ++d ) {
+                    Quaternion qpos = m_dsos.at( d ).quaternion();
+                    qpos.rotateAroundAxis( skyAxisMatrix );
 
-                if ( qpos.v[Q_Z] > 0 ) {
-                    continue;
-                }
+                    if ( qpos.v[Q_Z] > 0 ) {
+                        continue;
+                    }
 
-                qreal earthCenteredX = qpos.v[Q_X] * skyRadius;
-                qreal earthCenteredY = qpos.v[Q_Y] * skyRadius;
+                    qreal earthCenteredX = qpos.v[Q_X] * skyRadius;
+                    qreal earthCenteredY = qpos.v[Q_Y] * skyRadius;
 
-                // Don't draw high placemarks (e.g. satellites) that aren't visible.
-                if ( qpos.v[Q_Z] < 0
-                        && ( ( earthCenteredX * earthCenteredX
-                               + earthCenteredY * earthCenteredY )
-                             < earthRadius * earthRadius ) ) {
-                    continue;
-                }
+                    // Don't draw high placemarks (e.g. satellites) that aren't visible.
+                    if ( qpos.v[Q_Z] < 0
+                            && ( ( earthCenteredX * earthCenteredX
+                                   + earthCenteredY * earthCenteredY )
+                                 < earthRadius * earthRadius ) ) {
+                        continue;
+                    }
 
-                // Let (x, y) be the position on the screen of the placemark..
-                const int x = ( int )( viewport->width()  / 2 + skyRadius * qpos.v[Q_X] );
-                const int y = ( int )( viewport->height() / 2 - skyRadius * qpos.v[Q_Y] );
+                    // Let (x, y) be the position on the screen of the placemark..
+                    const int x = ( int )( viewport->width()  / 2 + skyRadius * qpos.v[Q_X] );
+                    const int y = ( int )( viewport->height() / 2 - skyRadius * qpos.v[Q_Y] );
 
-                // Skip placemarks that are outside the screen area
-                if ( x < 0 || x >= viewport->width() ||
-                     y < 0 || y >= viewport->height() ) {
-                    continue;
-                }
+                    // Skip placemarks that are outside the screen area
+                    if ( x < 0 || x >= viewport->width() ||
+                         y < 0 || y >= viewport->height() ) {
+                        continue;
+                    }
 
-                // Hard Code DSO Size for now
-                qreal size = 20;
+                    // Hard Code DSO Size for now
+                    qreal size = 20;
 
-                // Center Image on x,y location
-                painter->drawImage( QRectF( x-size/2, y-size/2, size, size ),m_dsoImage );
-                if (m_renderDsoLabels) {
-                    painter->drawText( x+8, y+12, m_dsos.at( d ).id() );
+                    // Center Image on x,y location
+                    painter->drawImage( QRectF( x-size/2, y-size/2, size, size ),m_dsoImage );
+                    if (m_renderDsoLabels) {
+                        painter->drawText( x+8, y+12, m_dsos.at( d ).id() );
+                    }
                 }
             }
         }
@@ -1065,41 +1123,48 @@ bool StarsPlugin::render( GeoPainter *painter, ViewportParams *viewport,
 
         // Render Stars
 
-        for ( int s = 0; s < m_stars.size(); ++s  ) {
-            Quaternion  qpos = m_stars.at(s).quaternion();
+        foreach ( int c, m_visibleCells ) {
+            const int begin = m_starCellOffsets.at( c );
+            // The stars of a cell are sorted by magnitude, stop at the first
+            // one that is not brighter than the magnitude threshold
+            const int end = std::lower_bound( m_starMagnitudes.constData() + begin,
+                                              m_starMagnitudes.constData() + m_starCellOffsets.at( c + 1 ),
+                                              qreal( m_magnitudeLimit ) ) - m_starMagnitudes.constData();
 
-            qpos.rotateAroundAxis( skyAxisMatrix );
+            rotateStars( skyAxisMatrix, begin, end );
 
-            if ( qpos.v[Q_Z] > 0 ) {
-                continue;
-            }
+            for ( int i = 0; i < end - begin; ++i ) {
+                const qreal qx = m_rotatedX.at( i );
+                const qreal qy = m_rotatedY.at( i );
+                const qreal qz = m_rotatedZ.at( i );
 
-            qreal  earthCenteredX = qpos.v[Q_X] * skyRadius;
-            qreal  earthCenteredY = qpos.v[Q_Y] * skyRadius;
+                if ( qz > 0 ) {
+                    continue;
+                }
 
-            // Don't draw high placemarks (e.g. satellites) that aren't visible.
-            if ( qpos.v[Q_Z] < 0
-                    && ( ( earthCenteredX * earthCenteredX
-                           + earthCenteredY * earthCenteredY )
-                         < earthRadius * earthRadius ) ) {
-                continue;
-            }
+                qreal  earthCenteredX = qx * skyRadius;
+                qreal  earthCenteredY = qy * skyRadius;
 
-            // Let (x, y) be the position on the screen of the placemark..
-            const int x = ( int )( viewport->width()  / 2 + skyRadius * qpos.v[Q_X] );
-            const int y = ( int )( viewport->height() / 2 - skyRadius * qpos.v[Q_Y] );
+                // Don't draw high placemarks (e.g. satellites) that aren't visible.
+                if ( qz < 0
+                        && ( ( earthCenteredX * earthCenteredX
+                               + earthCenteredY * earthCenteredY )
+                             < earthRadius * earthRadius ) ) {
+                    continue;
+                }
 
-            // Skip placemarks that are outside the screen area
-            if ( x < 0 || x >= viewport->width()
-                    || y < 0 || y >= viewport->height() )
-                continue;
+                // Let (x, y) be the position on the screen of the placemark..
+                const int x = ( int )( viewport->width()  / 2 + skyRadius * qx );
+                const int y = ( int )( viewport->height() / 2 - skyRadius * qy );
 
-            // Show star if it is brighter than magnitude threshold
-            if ( m_stars.at(s).magnitude() < m_magnitudeLimit ) {
+                // Skip placemarks that are outside the screen area
+                if ( x < 0 || x >= viewport->width()
+                        || y < 0 || y >= viewport->height() )
+                    continue;
 
                 // colorId is used to select which pixmap in vector to display
-                int colorId = m_stars.at(s).colorId();
-                QPixmap s_pixmap = starPixmap(m_stars.at(s).magnitude(), colorId);
+                const StarPoint &star = m_stars.at( begin + i );
+                QPixmap s_pixmap = starPixmap(star.magnitude(), star.colorId());
                 int sizeX = s_pixmap.width();
                 int sizeY = s_pixmap.height();
                 painter->drawPixmap( x-sizeX/2, y-sizeY/2 ,s_pixmap );
@@ -24,6 +24,7 @@
 #include "RenderPlugin.h"
 #include "Quaternion.h"
 #include "DialogConfigurationInterface.h"
+#include "SkyGrid.h"
 
 class QDateTime;
 class QMenu;
@@ -220,6 +221,7 @@ private:
     void loadStars();
     void loadConstellations();
     void loadDsos();
+    void rotateStars( const matrix &skyAxisMatrix, int begin, int end );
     QPointer<QDialog> m_configDialog;
     Ui::StarsConfigWidget *ui_configWidget;
     bool m_renderStars;
@@ -239,11 +241,27 @@ private:
     bool m_dsosLoaded;
     bool m_zoomSunMoon;
     bool m_viewSolarSystemLabel;
+    SkyGrid m_skyGrid;
+    // the cells of m_skyGrid which are visible in the current frame
+    QVector<int> m_visibleCells;
+    // sorted by sky cell and by magnitude within a cell
     QVector<StarPoint> m_stars;
+    // the index of the first star of each sky cell, followed by the number of stars
+    QVector<int> m_starCellOffsets;
+    // the positions and magnitudes of m_stars, laid out for rotating whole cells
+    QVector<qreal> m_starX;
+    QVector<qreal> m_starY;
+    QVector<qreal> m_starZ;
+    QVector<qreal> m_starMagnitudes;
+    QVector<qreal> m_rotatedX;
+    QVector<qreal> m_rotatedY;
+    QVector<qreal> m_rotatedZ;
     QPixmap m_pixmapSun;
     QPixmap m_pixmapMoon;
     QVector<Constellation> m_constellations;
+    // sorted by sky cell
     QVector<DsoPoint> m_dsos;
+    QVector<int> m_dsoCellOffsets;
     QHash<int,int> m_idHash;
     QImage m_dsoImage;
     int m_magnitudeLimit;
@@ -0,0 +1,42 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "CacheDocument.h"
+
+#include "GeoDataLatLonBox.h"
+#include "GeoDataPlacemark.h"
+
+namespace Marble
+{
+
+CacheDocument::CacheDocument( const QString &fileName )
+    : m_cacheFile( fileName ),
+      m_createdTiles( CacheFile::tileCount() )
+{
+    setFileName( fileName );
+}
+
+bool CacheDocument::open( QString &error )
+{
+    return m_cacheFile.open( error );
+}
+
+QVector<GeoDataPlacemark*> CacheDocument::createPlacemarks( const GeoDataLatLonBox &box )
+{
+    QVector<GeoDataPlacemark*> result;
+    foreach ( int tile, CacheFile::tiles( box ) ) {
+        if ( !m_createdTiles.testBit( tile ) ) {
+            m_createdTiles.setBit( tile );
+            result << m_cacheFile.tilePlacemarks( tile );
+        }
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,52 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_CACHEDOCUMENT_H
+#define MARBLE_CACHEDOCUMENT_H
+
+#include "CacheFile.h"
+
+#include "GeoDataDocument.h"
+#include "PlacemarkSource.h"
+
+#include <QBitArray>
+
+namespace Marble
+{
+
+/**
+ * @brief A document of a version 16 cache file that creates its placemarks
+ * tile by tile.
+ *
+ * The file stays mapped while the document exists. The placemarks of a
+ * tile of the index are created the first time the tile becomes visible,
+ * the other records of the file are not touched.
+ */
+class CacheDocument : public GeoDataDocument, public PlacemarkSource
+{
+public:
+    explicit CacheDocument( const QString &fileName );
+
+    /**
+     * Opens the cache file.
+     * @return false if the file is not a valid version 16 cache file
+     */
+    bool open( QString &error );
+
+    virtual QVector<GeoDataPlacemark*> createPlacemarks( const GeoDataLatLonBox &box );
+
+private:
+    Q_DISABLE_COPY( CacheDocument )
+
+    CacheFile m_cacheFile;
+    QBitArray m_createdTiles;
+};
+
+}
+
+#endif
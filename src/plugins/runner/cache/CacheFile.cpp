@@ -0,0 +1,399 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "CacheFile.h"
+
+#include "GeoDataExtendedData.h"
+#include "GeoDataLatLonBox.h"
+#include "GeoDataPlacemark.h"
+#include "MarbleDebug.h"
+#include "MarbleGlobal.h"
+
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Marble
+{
+
+const quint32 CacheFile::MagicNumber = 0x31415926;
+const qint32 CacheFile::Version = 16;
+
+// The index divides the globe into 32 x 16 tiles of 11.25 degrees
+static const int indexColumns = 32;
+static const int indexRows = 16;
+
+// magic number and version (big endian), record count, index columns and
+// rows, offsets of the index, the records and the string pool, size of
+// the string pool
+static const int headerSize = 40;
+// first record and record count
+static const int indexEntrySize = 8;
+
+// lon, lat, alt, area (doubles), population (qint64), offsets of name,
+// role, description, country code and state, gmt (qint16), dst (qint8)
+static const int recordSize = 64;
+enum RecordField {
+    LonField = 0,
+    LatField = 8,
+    AltField = 16,
+    AreaField = 24,
+    PopulationField = 32,
+    NameField = 40,
+    RoleField = 44,
+    DescriptionField = 48,
+    CountryCodeField = 52,
+    StateField = 56,
+    GmtField = 60,
+    DstField = 62
+};
+
+static double readDouble( const uchar *data )
+{
+    const quint64 bits = qFromLittleEndian<quint64>( data );
+    double value;
+    memcpy( &value, &bits, sizeof( value ) );
+    return value;
+}
+
+static void writeDouble( double value, uchar *data )
+{
+    quint64 bits;
+    memcpy( &bits, &value, sizeof( bits ) );
+    qToLittleEndian<quint64>( bits, data );
+}
+
+static int column( qreal lon )
+{
+    return qBound( 0, int( ( lon + M_PI ) / ( 2 * M_PI ) * indexColumns ), indexColumns - 1 );
+}
+
+static int row( qreal lat )
+{
+    return qBound( 0, int( ( M_PI / 2 - lat ) / M_PI * indexRows ), indexRows - 1 );
+}
+
+static int tile( const GeoDataPlacemark *placemark )
+{
+    const GeoDataCoordinates coordinates = placemark->coordinate();
+    return row( coordinates.latitude() ) * indexColumns + column( coordinates.longitude() );
+}
+
+// groups the placemarks by tile, the most populated first
+static bool isBefore( const GeoDataPlacemark *a, const GeoDataPlacemark *b )
+{
+    const int tileA = tile( a );
+    const int tileB = tile( b );
+    return tileA < tileB || ( tileA == tileB && a->population() > b->population() );
+}
+
+static quint32 addString( const QString &string, QByteArray &stringPool, QHash<QString, quint32> &stringOffsets )
+{
+    if ( string.isEmpty() ) {
+        return 0;
+    }
+
+    QHash<QString, quint32>::const_iterator const known = stringOffsets.constFind( string );
+    if ( known != stringOffsets.constEnd() ) {
+        return known.value();
+    }
+
+    const quint32 offset = stringPool.size();
+    stringPool.resize( offset + 4 + 2 * string.size() );
+    uchar *data = reinterpret_cast<uchar*>( stringPool.data() ) + offset;
+    qToLittleEndian<quint32>( string.size(), data );
+    for ( int i = 0; i < string.size(); ++i ) {
+        qToLittleEndian<quint16>( string.at( i ).unicode(), data + 4 + 2 * i );
+    }
+    // keep the lengths aligned
+    stringPool.append( QByteArray( ( 4 - stringPool.size() % 4 ) % 4, 0 ) );
+
+    stringOffsets.insert( string, offset );
+    return offset;
+}
+
+CacheFile::CacheFile( const QString &fileName )
+    : m_file( fileName ),
+      m_data( 0 ),
+      m_size( 0 ),
+      m_recordCount( 0 ),
+      m_index( 0 ),
+      m_records( 0 ),
+      m_stringPool( 0 ),
+      m_stringPoolSize( 0 )
+{
+}
+
+CacheFile::~CacheFile()
+{
+    // the placemarks do not refer to the mapped memory
+    if ( m_data ) {
+        m_file.unmap( const_cast<uchar*>( m_data ) );
+    }
+}
+
+bool CacheFile::open( QString &error )
+{
+    if ( !m_file.open( QIODevice::ReadOnly ) ) {
+        error = QString( "Cannot open file %1" ).arg( m_file.fileName() );
+        return false;
+    }
+
+    m_size = m_file.size();
+    if ( m_size < headerSize ) {
+        error = QString( "Bad cache file %1: File is too small" ).arg( m_file.fileName() );
+        return false;
+    }
+
+    m_data = m_file.map( 0, m_size );
+    if ( !m_data ) {
+        error = QString( "Cannot map file %1" ).arg( m_file.fileName() );
+        return false;
+    }
+
+    if ( qFromBigEndian<quint32>( m_data ) != MagicNumber || qFromBigEndian<qint32>( m_data + 4 ) != Version ) {
+        error = QString( "Bad cache file %1: Unexpected version" ).arg( m_file.fileName() );
+        return false;
+    }
+
+    m_recordCount = qFromLittleEndian<qint32>( m_data + 8 );
+    const int columns = qFromLittleEndian<qint32>( m_data + 12 );
+    const int rows = qFromLittleEndian<qint32>( m_data + 16 );
+    const quint32 indexOffset = qFromLittleEndian<quint32>( m_data + 20 );
+    const quint32 recordOffset = qFromLittleEndian<quint32>( m_data + 24 );
+    const quint32 stringPoolOffset = qFromLittleEndian<quint32>( m_data + 28 );
+    m_stringPoolSize = qFromLittleEndian<quint32>( m_data + 32 );
+
+    const bool valid = m_recordCount >= 0 && columns == indexColumns && rows == indexRows
+            && indexOffset + qint64( columns * rows * indexEntrySize ) <= m_size
+            && recordOffset + qint64( m_recordCount ) * recordSize <= m_size
+            && stringPoolOffset + qint64( m_stringPoolSize ) <= m_size;
+    if ( !valid ) {
+        error = QString( "Bad cache file %1: Invalid header" ).arg( m_file.fileName() );
+        return false;
+    }
+
+    m_index = m_data + indexOffset;
+    m_records = m_data + recordOffset;
+    m_stringPool = m_data + stringPoolOffset;
+
+    for ( int tile = 0; tile < columns * rows; ++tile ) {
+        const uchar *entry = m_index + tile * indexEntrySize;
+        const qint64 end = qint64( qFromLittleEndian<quint32>( entry ) ) + qFromLittleEndian<quint32>( entry + 4 );
+        if ( end > m_recordCount ) {
+            error = QString( "Bad cache file %1: Invalid index" ).arg( m_file.fileName() );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int CacheFile::size() const
+{
+    return m_recordCount;
+}
+
+int CacheFile::tileCount()
+{
+    return indexColumns * indexRows;
+}
+
+QVector<int> CacheFile::tiles( const GeoDataLatLonBox &box )
+{
+    const int top = row( box.north() );
+    const int bottom = row( box.south() );
+    const int west = column( box.west() );
+    const int east = column( box.east() );
+
+    // the box may cross the date line, it covers all columns then if its
+    // western and eastern edges are in the same column
+    int columns = ( east - west + indexColumns ) % indexColumns + 1;
+    if ( columns == 1 && box.crossesDateLine() ) {
+        columns = indexColumns;
+    }
+
+    QVector<int> result;
+    result.reserve( ( bottom - top + 1 ) * columns );
+    for ( int y = top; y <= bottom; ++y ) {
+        for ( int i = 0; i < columns; ++i ) {
+            result << y * indexColumns + ( west + i ) % indexColumns;
+        }
+    }
+
+    return result;
+}
+
+QVector<GeoDataPlacemark*> CacheFile::placemarks( const GeoDataLatLonBox &box )
+{
+    QVector<GeoDataPlacemark*> result;
+    if ( !m_index ) {
+        return result;
+    }
+
+    // tiles at the border of the box may contain placemarks outside of it
+    foreach ( int tile, tiles( box ) ) {
+        appendTile( tile, &box, result );
+    }
+
+    return result;
+}
+
+QVector<GeoDataPlacemark*> CacheFile::tilePlacemarks( int tile )
+{
+    QVector<GeoDataPlacemark*> result;
+    if ( !m_index || tile < 0 || tile >= tileCount() ) {
+        return result;
+    }
+
+    appendTile( tile, 0, result );
+    return result;
+}
+
+QVector<GeoDataPlacemark*> CacheFile::placemarks()
+{
+    QVector<GeoDataPlacemark*> result;
+    if ( !m_index ) {
+        return result;
+    }
+
+    result.reserve( m_recordCount );
+    for ( int tile = 0; tile < indexColumns * indexRows; ++tile ) {
+        appendTile( tile, 0, result );
+    }
+    return result;
+}
+
+void CacheFile::appendTile( int tile, const GeoDataLatLonBox *box, QVector<GeoDataPlacemark*> &placemarks )
+{
+    const uchar *entry = m_index + tile * indexEntrySize;
+    const int first = qFromLittleEndian<quint32>( entry );
+    const int count = qFromLittleEndian<quint32>( entry + 4 );
+    for ( int i = first; i < first + count; ++i ) {
+        if ( box ) {
+            const uchar *record = m_records + qint64( i ) * recordSize;
+            const GeoDataCoordinates coordinates( readDouble( record + LonField ), readDouble( record + LatField ) );
+            if ( !box->contains( coordinates ) ) {
+                continue;
+            }
+        }
+        placemarks << placemark( i );
+    }
+}
+
+GeoDataPlacemark *CacheFile::placemark( int index )
+{
+    const uchar *record = m_records + qint64( index ) * recordSize;
+
+    GeoDataPlacemark *placemark = new GeoDataPlacemark;
+    placemark->setName( string( qFromLittleEndian<quint32>( record + NameField ) ) );
+    placemark->setCoordinate( readDouble( record + LonField ), readDouble( record + LatField ), readDouble( record + AltField ) );
+    placemark->setRole( string( qFromLittleEndian<quint32>( record + RoleField ) ) );
+    placemark->setDescription( string( qFromLittleEndian<quint32>( record + DescriptionField ) ) );
+    placemark->setCountryCode( string( qFromLittleEndian<quint32>( record + CountryCodeField ) ) );
+    placemark->setState( string( qFromLittleEndian<quint32>( record + StateField ) ) );
+    placemark->setArea( readDouble( record + AreaField ) );
+    placemark->setPopulation( qFromLittleEndian<qint64>( record + PopulationField ) );
+    placemark->extendedData().addValue( GeoDataData( "gmt", int( qFromLittleEndian<qint16>( record + GmtField ) ) ) );
+    placemark->extendedData().addValue( GeoDataData( "dst", int( qint8( record[DstField] ) ) ) );
+    return placemark;
+}
+
+QString CacheFile::string( quint32 offset )
+{
+    // offset 0 is the empty string
+    if ( offset == 0 ) {
+        return QString();
+    }
+
+    QHash<quint32, QString>::const_iterator const cached = m_strings.constFind( offset );
+    if ( cached != m_strings.constEnd() ) {
+        return cached.value();
+    }
+
+    // length in UTF-16 code units, followed by the code units
+    QString result;
+    if ( qint64( offset ) + 4 <= m_stringPoolSize ) {
+        const quint32 length = qFromLittleEndian<quint32>( m_stringPool + offset );
+        if ( offset + 4 + qint64( length ) * 2 <= m_stringPoolSize ) {
+            result.resize( length );
+            const uchar *data = m_stringPool + offset + 4;
+            for ( quint32 i = 0; i < length; ++i ) {
+                result[int( i )] = QChar( qFromLittleEndian<quint16>( data + 2 * i ) );
+            }
+        }
+    }
+
+    m_strings.insert( offset, result );
+    return result;
+}
+
+bool CacheFile::write( const QString &fileName, const QVector<const GeoDataPlacemark*> &placemarks )
+{
+    // the string pool, starting with the empty string at offset 0
+    QByteArray stringPool( 4, 0 );
+    QHash<QString, quint32> stringOffsets;
+
+    QVector<const GeoDataPlacemark*> sorted = placemarks;
+    std::stable_sort( sorted.begin(), sorted.end(), isBefore );
+
+    QByteArray index( indexColumns * indexRows * indexEntrySize, 0 );
+    QByteArray records( sorted.size() * recordSize, 0 );
+    for ( int i = 0; i < sorted.size(); ++i ) {
+        const GeoDataPlacemark *placemark = sorted.at( i );
+
+        uchar *entry = reinterpret_cast<uchar*>( index.data() ) + tile( placemark ) * indexEntrySize;
+        if ( qFromLittleEndian<quint32>( entry + 4 ) == 0 ) {
+            qToLittleEndian<quint32>( i, entry );
+        }
+        qToLittleEndian<quint32>( qFromLittleEndian<quint32>( entry + 4 ) + 1, entry + 4 );
+
+        qreal lon, lat, alt;
+        placemark->coordinate().geoCoordinates( lon, lat, alt );
+        uchar *record = reinterpret_cast<uchar*>( records.data() ) + i * recordSize;
+        writeDouble( lon, record + LonField );
+        writeDouble( lat, record + LatField );
+        writeDouble( alt, record + AltField );
+        writeDouble( placemark->area(), record + AreaField );
+        qToLittleEndian<qint64>( placemark->population(), record + PopulationField );
+        qToLittleEndian<quint32>( addString( placemark->name(), stringPool, stringOffsets ), record + NameField );
+        qToLittleEndian<quint32>( addString( placemark->role(), stringPool, stringOffsets ), record + RoleField );
+        qToLittleEndian<quint32>( addString( placemark->description(), stringPool, stringOffsets ), record + DescriptionField );
+        qToLittleEndian<quint32>( addString( placemark->countryCode(), stringPool, stringOffsets ), record + CountryCodeField );
+        qToLittleEndian<quint32>( addString( placemark->state(), stringPool, stringOffsets ), record + StateField );
+        qToLittleEndian<qint16>( placemark->extendedData().value( "gmt" ).value().toInt(), record + GmtField );
+        record[DstField] = uchar( qint8( placemark->extendedData().value( "dst" ).value().toInt() ) );
+    }
+
+    QByteArray header( headerSize, 0 );
+    uchar *data = reinterpret_cast<uchar*>( header.data() );
+    qToBigEndian<quint32>( MagicNumber, data );
+    qToBigEndian<qint32>( Version, data + 4 );
+    qToLittleEndian<qint32>( sorted.size(), data + 8 );
+    qToLittleEndian<qint32>( indexColumns, data + 12 );
+    qToLittleEndian<qint32>( indexRows, data + 16 );
+    qToLittleEndian<quint32>( headerSize, data + 20 );
+    qToLittleEndian<quint32>( headerSize + index.size(), data + 24 );
+    qToLittleEndian<quint32>( headerSize + index.size() + records.size(), data + 28 );
+    qToLittleEndian<quint32>( stringPool.size(), data + 32 );
+
+    QSaveFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) ) {
+        mDebug() << "Cannot open" << fileName << "for writing";
+        return false;
+    }
+    file.write( header );
+    file.write( index );
+    file.write( records );
+    file.write( stringPool );
+    return file.commit();
+}
+
+}
@@ -0,0 +1,111 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_CACHEFILE_H
+#define MARBLE_CACHEFILE_H
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+namespace Marble
+{
+
+class GeoDataLatLonBox;
+class GeoDataPlacemark;
+
+/**
+ * @brief Placemark cache files with fixed width records.
+ *
+ * Version 16 of the .cache format is read from a memory mapped file rather
+ * than deserialized field by field. It consists of a header, a tile index,
+ * the records and a string pool:
+ *
+ * - The records have a fixed size and refer to their strings by the offset
+ *   in the pool, every distinct string is stored once.
+ * - The records are grouped by the tile of an equirectangular grid they
+ *   are located in and sorted by population within a tile. The index lists
+ *   the records of each tile, so the placemarks in a region can be created
+ *   without touching the others.
+ *
+ * All values are little endian, except for the magic number and the version
+ * at the start of the file, which are big endian like in older versions.
+ * Files of older versions are read by CacheRunner directly.
+ */
+class CacheFile
+{
+public:
+    static const quint32 MagicNumber;
+    static const qint32 Version;
+
+    explicit CacheFile( const QString &fileName );
+    ~CacheFile();
+
+    /**
+     * Maps the file into memory and checks its structure.
+     * @return false if the file is not a valid version 16 cache file
+     */
+    bool open( QString &error );
+
+    int size() const;
+
+    /**
+     * Returns the number of tiles of the index.
+     */
+    static int tileCount();
+
+    /**
+     * Returns the tiles of the index that intersect @p box.
+     */
+    static QVector<int> tiles( const GeoDataLatLonBox &box );
+
+    /**
+     * Creates the placemarks located in @p box in the order of the index.
+     * The placemarks share the strings of the pool.
+     */
+    QVector<GeoDataPlacemark*> placemarks( const GeoDataLatLonBox &box );
+
+    /**
+     * Creates the placemarks of @p tile, the most populated first.
+     */
+    QVector<GeoDataPlacemark*> tilePlacemarks( int tile );
+
+    /**
+     * Creates all placemarks.
+     */
+    QVector<GeoDataPlacemark*> placemarks();
+
+    /**
+     * Writes @p placemarks to @p fileName in the version 16 format.
+     */
+    static bool write( const QString &fileName, const QVector<const GeoDataPlacemark*> &placemarks );
+
+private:
+    Q_DISABLE_COPY( CacheFile )
+
+    GeoDataPlacemark *placemark( int index );
+    QString string( quint32 offset );
+    // appends the placemarks of @p tile, only the ones in @p box if it is set
+    void appendTile( int tile, const GeoDataLatLonBox *box, QVector<GeoDataPlacemark*> &placemarks );
+
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_size;
+    int m_recordCount;
+    const uchar *m_index;
+    const uchar *m_records;
+    const uchar *m_stringPool;
+    quint32 m_stringPoolSize;
+    // strings created already, each distinct string is created once
+    QHash<quint32, QString> m_strings;
+};
+
+}
+
+#endif
@@ -9,6 +9,9 @@
 
 #include "CacheRunner.h"
 
+#include "CacheDocument.h"
+#include "CacheFile.h"
+
 #include "GeoDataDocument.h"
 #include "GeoDataExtendedData.h"
 #include "GeoDataPlacemark.h"
@@ -20,8 +23,6 @@
 namespace Marble
 {
 
-const quint32 MarbleMagicNumber = 0x31415926;
-
 CacheRunner::CacheRunner(QObject *parent) :
     ParsingRunner(parent)
 {
@@ -46,13 +47,50 @@ GeoDataDocument* CacheRunner::parseFile( const QString &fileName, DocumentRole r
     // Read and check the header
     quint32 magic;
     in >> magic;
-    if ( magic != MarbleMagicNumber ) {
+    if ( magic != CacheFile::MagicNumber ) {
         return nullptr;
     }
 
     // Read the version
     qint32 version;
     in >> version;
+    if ( version == CacheFile::Version ) {
+        file.close();
+
+        // the placemarks of map documents are created when they become
+        // visible, the others are needed at once, e.g. for searching
+        if ( role == MapDocument ) {
+            CacheDocument *document = new CacheDocument( fileName );
+            if ( !document->open( error ) ) {
+                mDebug() << error;
+                delete document;
+                return nullptr;
+            }
+            document->setDocumentRole( role );
+            return document;
+        }
+
+        CacheFile cacheFile( fileName );
+        if ( !cacheFile.open( error ) ) {
+            mDebug() << error;
+            return nullptr;
+        }
+
+        GeoDataDocument *document = new GeoDataDocument();
+        document->setDocumentRole( role );
+        foreach ( GeoDataPlacemark *placemark, cacheFile.placemarks() ) {
+            document->append( placemark );
+        }
+        document->setFileName( fileName );
+        return document;
+    }
+
+    if ( version > CacheFile::Version ) {
+        error = QString("Bad cache file %1: Version %2 is too new").arg(fileName).arg(version);
+        mDebug() << error;
+        return nullptr;
+    }
+
     if ( version < 015 ) {
         error = QString("Bad cache file %1: Version %2 is too old, need 15 or later").arg(fileName).arg(version);
         mDebug() << error;
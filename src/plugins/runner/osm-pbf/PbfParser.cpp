@@ -0,0 +1,536 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "PbfParser.h"
+
+#include "fileformat.pb.h"
+#include "osmformat.pb.h"
+
+#include "OsmDocumentBuilder.h"
+#include "OsmNode.h"
+#include "OsmRelation.h"
+#include "OsmWay.h"
+
+#include "GeoDataCoordinates.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QQueue>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QVector>
+#include <QtEndian>
+
+#include <zlib.h>
+
+namespace Marble {
+
+// limits of the OSM PBF specification
+static const int maxBlobHeaderSize = 64 * 1024;
+static const int maxBlobSize = 32 * 1024 * 1024;
+
+/**
+ * The elements of one primitive block. The semaphore is released once the
+ * block has been decoded.
+ */
+struct PbfBlock
+{
+    QVector<OsmNode> nodes;
+    QVector<OsmWay> ways;
+    QVector<OsmRelation> relations;
+    QVector<qint64> relationWayIds;
+    QString error;
+    QSemaphore decoded;
+};
+
+static bool inflateBlob(const QByteArray &data, QByteArray &result, QString &error)
+{
+    OSMPBF::Blob blob;
+    if (!blob.ParseFromArray(data.constData(), data.size())) {
+        error = QString("Failed to parse a blob");
+        return false;
+    }
+
+    if (blob.has_raw()) {
+        result = QByteArray(blob.raw().data(), int(blob.raw().size()));
+        return true;
+    }
+
+    if (blob.has_zlib_data()) {
+        if (blob.raw_size() < 0 || blob.raw_size() > maxBlobSize) {
+            error = QString("Invalid blob size %1").arg(blob.raw_size());
+            return false;
+        }
+        result.resize(blob.raw_size());
+        uLongf size = result.size();
+        int const status = uncompress((Bytef*)result.data(), &size,
+                                      (const Bytef*)blob.zlib_data().data(), uLong(blob.zlib_data().size()));
+        if (status != Z_OK || size != uLongf(result.size())) {
+            error = QString("Failed to inflate a blob");
+            return false;
+        }
+        return true;
+    }
+
+    error = QString("Unsupported blob compression");
+    return false;
+}
+
+/**
+ * Converts the elements of a primitive block to the element classes of the
+ * osm runner.
+ */
+class PbfBlockDecoder
+{
+public:
+    explicit PbfBlockDecoder(const OSMPBF::PrimitiveBlock &primitiveBlock);
+
+    void decode(PbfBlock &block) const;
+    static void decodeRelationWays(const OSMPBF::PrimitiveBlock &primitiveBlock, PbfBlock &block);
+
+private:
+    void decodeNodes(const OSMPBF::PrimitiveGroup &group, PbfBlock &block) const;
+    void decodeDenseNodes(const OSMPBF::DenseNodes &dense, PbfBlock &block) const;
+    void decodeWays(const OSMPBF::PrimitiveGroup &group, PbfBlock &block) const;
+    void decodeRelations(const OSMPBF::PrimitiveGroup &group, PbfBlock &block) const;
+
+    GeoDataCoordinates coordinates(qint64 lat, qint64 lon) const;
+    void setInfo(OsmPlacemarkData &osmData, const OSMPBF::Info &info) const;
+    QString timestamp(qint64 timestamp) const;
+
+    template<class Element>
+    void addTags(OsmPlacemarkData &osmData, const Element &element) const;
+
+    const OSMPBF::PrimitiveBlock &m_primitiveBlock;
+    QVector<QString> m_strings;
+};
+
+PbfBlockDecoder::PbfBlockDecoder(const OSMPBF::PrimitiveBlock &primitiveBlock) :
+    m_primitiveBlock(primitiveBlock)
+{
+    OSMPBF::StringTable const & stringTable = primitiveBlock.stringtable();
+    m_strings.reserve(stringTable.s_size());
+    for (int i = 0; i < stringTable.s_size(); ++i) {
+        std::string const & string = stringTable.s(i);
+        m_strings << QString::fromUtf8(string.data(), int(string.size()));
+    }
+}
+
+void PbfBlockDecoder::decode(PbfBlock &block) const
+{
+    for (int i = 0; i < m_primitiveBlock.primitivegroup_size(); ++i) {
+        OSMPBF::PrimitiveGroup const & group = m_primitiveBlock.primitivegroup(i);
+        decodeNodes(group, block);
+        if (group.has_dense()) {
+            decodeDenseNodes(group.dense(), block);
+        }
+        decodeWays(group, block);
+        decodeRelations(group, block);
+    }
+}
+
+void PbfBlockDecoder::decodeRelationWays(const OSMPBF::PrimitiveBlock &primitiveBlock, PbfBlock &block)
+{
+    for (int i = 0; i < primitiveBlock.primitivegroup_size(); ++i) {
+        OSMPBF::PrimitiveGroup const & group = primitiveBlock.primitivegroup(i);
+        for (int j = 0; j < group.relations_size(); ++j) {
+            OSMPBF::Relation const & relation = group.relations(j);
+            qint64 id = 0;
+            for (int k = 0; k < relation.memids_size(); ++k) {
+                id += relation.memids(k);
+                if (k < relation.types_size() && relation.types(k) == OSMPBF::Relation::WAY) {
+                    block.relationWayIds << id;
+                }
+            }
+        }
+    }
+}
+
+void PbfBlockDecoder::decodeNodes(const OSMPBF::PrimitiveGroup &group, PbfBlock &block) const
+{
+    for (int i = 0; i < group.nodes_size(); ++i) {
+        OSMPBF::Node const & pbfNode = group.nodes(i);
+        OsmNode node;
+        node.osmData().setId(pbfNode.id());
+        if (pbfNode.has_info()) {
+            setInfo(node.osmData(), pbfNode.info());
+        }
+        addTags(node.osmData(), pbfNode);
+        node.setCoordinates(coordinates(pbfNode.lat(), pbfNode.lon()));
+        block.nodes << node;
+    }
+}
+
+void PbfBlockDecoder::decodeDenseNodes(const OSMPBF::DenseNodes &dense, PbfBlock &block) const
+{
+    bool const hasInfo = dense.has_denseinfo() && dense.denseinfo().version_size() == dense.id_size();
+    OSMPBF::DenseInfo const & info = dense.denseinfo();
+
+    // all values but the version are delta coded
+    qint64 id = 0;
+    qint64 lat = 0;
+    qint64 lon = 0;
+    qint64 time = 0;
+    qint64 changeset = 0;
+    qint64 uid = 0;
+    qint64 userIndex = 0;
+    int tag = 0;
+
+    block.nodes.reserve(block.nodes.size() + dense.id_size());
+    for (int i = 0; i < dense.id_size(); ++i) {
+        id += dense.id(i);
+        lat += dense.lat(i);
+        lon += dense.lon(i);
+
+        OsmNode node;
+        OsmPlacemarkData & osmData = node.osmData();
+        osmData.setId(id);
+        node.setCoordinates(coordinates(lat, lon));
+
+        if (hasInfo) {
+            time += info.timestamp(i);
+            changeset += info.changeset(i);
+            uid += info.uid(i);
+            userIndex += info.user_sid(i);
+            osmData.setVersion(QString::number(info.version(i)));
+            osmData.setTimestamp(timestamp(time));
+            osmData.setChangeset(QString::number(changeset));
+            osmData.setUid(QString::number(uid));
+            osmData.setUser(m_strings.value(int(userIndex)));
+            if (i < info.visible_size()) {
+                osmData.setVisible(info.visible(i) ? "true" : "false");
+            }
+        }
+
+        // ( (<keyid> <valid>)* '0' )*
+        while (tag < dense.keys_vals_size()) {
+            int const key = dense.keys_vals(tag);
+            ++tag;
+            if (key == 0 || tag >= dense.keys_vals_size()) {
+                break;
+            }
+            osmData.addTag(m_strings.value(key), m_strings.value(dense.keys_vals(tag)));
+            ++tag;
+        }
+
+        block.nodes << node;
+    }
+}
+
+void PbfBlockDecoder::decodeWays(const OSMPBF::PrimitiveGroup &group, PbfBlock &block) const
+{
+    for (int i = 0; i < group.ways_size(); ++i) {
+        OSMPBF::Way const & pbfWay = group.ways(i);
+        OsmWay way;
+        way.osmData().setId(pbfWay.id());
+        if (pbfWay.has_info()) {
+            setInfo(way.osmData(), pbfWay.info());
+        }
+        addTags(way.osmData(), pbfWay);
+
+        qint64 reference = 0;
+        for (int j = 0; j < pbfWay.refs_size(); ++j) {
+            reference += pbfWay.refs(j);
+            way.addReference(reference);
+        }
+        block.ways << way;
+    }
+}
+
+void PbfBlockDecoder::decodeRelations(const OSMPBF::PrimitiveGroup &group, PbfBlock &block) const
+{
+    QString const node("node");
+    QString const way("way");
+    QString const relation("relation");
+
+    for (int i = 0; i < group.relations_size(); ++i) {
+        OSMPBF::Relation const & pbfRelation = group.relations(i);
+        OsmRelation osmRelation;
+        osmRelation.osmData().setId(pbfRelation.id());
+        if (pbfRelation.has_info()) {
+            setInfo(osmRelation.osmData(), pbfRelation.info());
+        }
+        addTags(osmRelation.osmData(), pbfRelation);
+
+        qint64 reference = 0;
+        int const members = qMin(pbfRelation.memids_size(), pbfRelation.types_size());
+        for (int j = 0; j < members; ++j) {
+            reference += pbfRelation.memids(j);
+            QString const role = j < pbfRelation.roles_sid_size() ? m_strings.value(pbfRelation.roles_sid(j)) : QString();
+            switch (pbfRelation.types(j)) {
+            case OSMPBF::Relation::NODE:     osmRelation.addMember(reference, role, node);     break;
+            case OSMPBF::Relation::WAY:      osmRelation.addMember(reference, role, way);      break;
+            case OSMPBF::Relation::RELATION: osmRelation.addMember(reference, role, relation); break;
+            }
+        }
+        block.relations << osmRelation;
+    }
+}
+
+GeoDataCoordinates PbfBlockDecoder::coordinates(qint64 lat, qint64 lon) const
+{
+    // nanodegrees
+    qint64 const granularity = m_primitiveBlock.granularity();
+    qreal const latitude = 1e-9 * (m_primitiveBlock.lat_offset() + granularity * lat);
+    qreal const longitude = 1e-9 * (m_primitiveBlock.lon_offset() + granularity * lon);
+    return GeoDataCoordinates(longitude, latitude, 0, GeoDataCoordinates::Degree);
+}
+
+void PbfBlockDecoder::setInfo(OsmPlacemarkData &osmData, const OSMPBF::Info &info) const
+{
+    if (info.has_version()) {
+        osmData.setVersion(QString::number(info.version()));
+    }
+    if (info.has_timestamp()) {
+        osmData.setTimestamp(timestamp(info.timestamp()));
+    }
+    if (info.has_changeset()) {
+        osmData.setChangeset(QString::number(info.changeset()));
+    }
+    if (info.has_uid()) {
+        osmData.setUid(QString::number(info.uid()));
+    }
+    if (info.has_user_sid()) {
+        osmData.setUser(m_strings.value(info.user_sid()));
+    }
+    if (info.has_visible()) {
+        osmData.setVisible(info.visible() ? "true" : "false");
+    }
+}
+
+QString PbfBlockDecoder::timestamp(qint64 timestamp) const
+{
+    qint64 const milliseconds = timestamp * m_primitiveBlock.date_granularity();
+    return QDateTime::fromMSecsSinceEpoch(milliseconds, Qt::UTC).toString(Qt::ISODate);
+}
+
+template<class Element>
+void PbfBlockDecoder::addTags(OsmPlacemarkData &osmData, const Element &element) const
+{
+    int const tags = qMin(element.keys_size(), element.vals_size());
+    for (int i = 0; i < tags; ++i) {
+        osmData.addTag(m_strings.value(element.keys(i)), m_strings.value(element.vals(i)));
+    }
+}
+
+class PbfBlockJob : public QRunnable
+{
+public:
+    PbfBlockJob(const QByteArray &blob, bool relationWaysOnly, const QSharedPointer<PbfBlock> &block) :
+        m_blob(blob),
+        m_relationWaysOnly(relationWaysOnly),
+        m_block(block)
+    {
+    }
+
+    virtual void run()
+    {
+        decode();
+        m_block->decoded.release();
+    }
+
+private:
+    void decode()
+    {
+        QByteArray data;
+        if (!inflateBlob(m_blob, data, m_block->error)) {
+            return;
+        }
+        m_blob.clear();
+
+        OSMPBF::PrimitiveBlock primitiveBlock;
+        if (!primitiveBlock.ParseFromArray(data.constData(), data.size())) {
+            m_block->error = QString("Failed to parse a primitive block");
+            return;
+        }
+        data.clear();
+
+        if (m_relationWaysOnly) {
+            PbfBlockDecoder::decodeRelationWays(primitiveBlock, *m_block);
+        } else {
+            PbfBlockDecoder(primitiveBlock).decode(*m_block);
+        }
+    }
+
+    QByteArray m_blob;
+    bool const m_relationWaysOnly;
+    QSharedPointer<PbfBlock> const m_block;
+};
+
+GeoDataDocument *PbfParser::parse(const QString &filename, QString &error)
+{
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    QSet<qint64> relationWayIds;
+    {
+        QFile file(filename);
+        if (!file.open(QFile::ReadOnly)) {
+            error = QString("Cannot open file %1").arg(filename);
+            return nullptr;
+        }
+        PbfParser parser(RelationWaysPass, relationWayIds, nullptr);
+        if (!parser.read(&file, error)) {
+            return nullptr;
+        }
+    }
+
+    QFile file(filename);
+    if (!file.open(QFile::ReadOnly)) {
+        error = QString("Cannot open file %1").arg(filename);
+        return nullptr;
+    }
+    OsmDocumentBuilder builder(relationWayIds);
+    PbfParser parser(ElementsPass, relationWayIds, &builder);
+    if (!parser.read(&file, error)) {
+        return nullptr;
+    }
+    return builder.document();
+}
+
+PbfParser::PbfParser(Pass pass, QSet<qint64> &relationWayIds, OsmDocumentBuilder *builder) :
+    m_pass(pass),
+    m_relationWayIds(relationWayIds),
+    m_builder(builder)
+{
+    // nothing to do
+}
+
+bool PbfParser::read(QIODevice *device, QString &error)
+{
+    QThreadPool threadPool;
+    // Blocks are decoded ahead, but taken in file order so that nodes are
+    // known before the ways referring to them
+    int const maxPendingBlocks = 2 * qMax(1, threadPool.maxThreadCount());
+    QQueue<QSharedPointer<PbfBlock> > pendingBlocks;
+
+    bool headerRead = false;
+    QByteArray type;
+    QByteArray blob;
+    while (!device->atEnd()) {
+        if (!readBlob(device, type, blob, error)) {
+            return false;
+        }
+
+        if (type == "OSMHeader") {
+            QByteArray data;
+            OSMPBF::HeaderBlock header;
+            if (!inflateBlob(blob, data, error)) {
+                return false;
+            }
+            if (!header.ParseFromArray(data.constData(), data.size())) {
+                error = QString("Failed to parse the file header");
+                return false;
+            }
+            for (int i = 0; i < header.required_features_size(); ++i) {
+                std::string const & feature = header.required_features(i);
+                if (feature != "OsmSchema-V0.6" && feature != "DenseNodes") {
+                    error = QString("Unsupported feature %1").arg(QString::fromStdString(feature));
+                    return false;
+                }
+            }
+            headerRead = true;
+            continue;
+        }
+
+        if (type != "OSMData") {
+            // unknown blob types are to be skipped
+            continue;
+        }
+
+        if (!headerRead) {
+            error = QString("The file header is missing");
+            return false;
+        }
+
+        QSharedPointer<PbfBlock> block(new PbfBlock);
+        threadPool.start(new PbfBlockJob(blob, m_pass == RelationWaysPass, block));
+        pendingBlocks.enqueue(block);
+
+        while (pendingBlocks.size() >= maxPendingBlocks) {
+            QSharedPointer<PbfBlock> const next = pendingBlocks.dequeue();
+            next->decoded.acquire();
+            if (!next->error.isEmpty()) {
+                error = next->error;
+                return false;
+            }
+            consume(*next);
+        }
+    }
+
+    while (!pendingBlocks.isEmpty()) {
+        QSharedPointer<PbfBlock> const next = pendingBlocks.dequeue();
+        next->decoded.acquire();
+        if (!next->error.isEmpty()) {
+            error = next->error;
+            return false;
+        }
+        consume(*next);
+    }
+
+    return true;
+}
+
+bool PbfParser::readBlob(QIODevice *device, QByteArray &type, QByteArray &blob, QString &error)
+{
+    uchar sizeData[4];
+    if (device->read((char*)sizeData, 4) != 4) {
+        error = QString("Unexpected end of file");
+        return false;
+    }
+
+    qint32 const headerSize = qFromBigEndian<qint32>(sizeData);
+    if (headerSize < 0 || headerSize > maxBlobHeaderSize) {
+        error = QString("Invalid blob header size %1").arg(headerSize);
+        return false;
+    }
+
+    QByteArray const headerData = device->read(headerSize);
+    OSMPBF::BlobHeader header;
+    if (headerData.size() != headerSize || !header.ParseFromArray(headerData.constData(), headerSize)) {
+        error = QString("Failed to read a blob header");
+        return false;
+    }
+
+    if (header.datasize() < 0 || header.datasize() > maxBlobSize) {
+        error = QString("Invalid blob size %1").arg(header.datasize());
+        return false;
+    }
+
+    type = QByteArray(header.type().data(), int(header.type().size()));
+    blob = device->read(header.datasize());
+    if (blob.size() != header.datasize()) {
+        error = QString("Unexpected end of file");
+        return false;
+    }
+
+    return true;
+}
+
+void PbfParser::consume(const PbfBlock &block)
+{
+    if (m_pass == RelationWaysPass) {
+        foreach(qint64 id, block.relationWayIds) {
+            m_relationWayIds << id;
+        }
+        return;
+    }
+
+    foreach(OsmNode const &node, block.nodes) {
+        m_builder->addNode(node);
+    }
+    foreach(OsmWay const &way, block.ways) {
+        m_builder->addWay(way);
+    }
+    foreach(OsmRelation const &relation, block.relations) {
+        m_builder->addRelation(relation);
+    }
+}
+
+}
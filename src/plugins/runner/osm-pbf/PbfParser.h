@@ -0,0 +1,58 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_PBFPARSER_H
+#define MARBLE_PBFPARSER_H
+
+#include <QByteArray>
+#include <QSet>
+#include <QString>
+
+class QIODevice;
+
+namespace Marble {
+
+class GeoDataDocument;
+class OsmDocumentBuilder;
+struct PbfBlock;
+
+/**
+ * Reads OpenStreetMap .pbf files.
+ *
+ * The primitive blocks of the file are independent of each other, they are
+ * inflated and decoded on a thread pool. A limited number of blocks is
+ * decoded ahead of the one the elements are taken from, in file order, so
+ * the memory use does not depend on the file size. Like for .osm files
+ * the first pass collects the ways which are members of relations, the
+ * second pass creates the placemarks with OsmDocumentBuilder.
+ */
+class PbfParser
+{
+public:
+    static GeoDataDocument* parse(const QString &filename, QString &error);
+
+private:
+    enum Pass {
+        RelationWaysPass,
+        ElementsPass
+    };
+
+    PbfParser(Pass pass, QSet<qint64> &relationWayIds, OsmDocumentBuilder *builder);
+
+    bool read(QIODevice *device, QString &error);
+    bool readBlob(QIODevice *device, QByteArray &type, QByteArray &blob, QString &error);
+    void consume(const PbfBlock &block);
+
+    const Pass m_pass;
+    QSet<qint64> &m_relationWayIds;
+    OsmDocumentBuilder *const m_builder;
+};
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "PbfPlugin.h"
+#include "PbfRunner.h"
+
+namespace Marble
+{
+
+PbfPlugin::PbfPlugin( QObject *parent ) :
+    ParseRunnerPlugin( parent )
+{
+}
+
+QString PbfPlugin::name() const
+{
+    return tr( "Osm PBF File Parser" );
+}
+
+QString PbfPlugin::nameId() const
+{
+    return "OsmPbf";
+}
+
+QString PbfPlugin::version() const
+{
+    return "1.0";
+}
+
+QString PbfPlugin::description() const
+{
+    return tr( "Create GeoDataDocument from Osm PBF Files" );
+}
+
+QString PbfPlugin::copyrightYears() const
+{
+    return "2016";
+}
+
+QList<PluginAuthor> PbfPlugin::pluginAuthors() const
+{
+    return QList<PluginAuthor>()
+            << PluginAuthor( "Marble Developers", "marble-devel@kde.org" );
+}
+
+QString PbfPlugin::fileFormatDescription() const
+{
+    return tr( "OpenStreetMap Binary Data" );
+}
+
+QStringList PbfPlugin::fileExtensions() const
+{
+    return QStringList() << "pbf" << "osm.pbf";
+}
+
+ParsingRunner* PbfPlugin::newRunner() const
+{
+    return new PbfRunner;
+}
+
+}
+
+Q_EXPORT_PLUGIN2( PbfPlugin, Marble::PbfPlugin )
+
+#include "moc_PbfPlugin.cpp"
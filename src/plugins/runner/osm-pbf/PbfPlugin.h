@@ -0,0 +1,46 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLEPBFPLUGIN_H
+#define MARBLEPBFPLUGIN_H
+
+#include "ParseRunnerPlugin.h"
+
+namespace Marble
+{
+
+class PbfPlugin : public ParseRunnerPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA( IID "org.kde.edu.marble.OsmPbfPlugin" )
+    Q_INTERFACES( Marble::ParseRunnerPlugin )
+
+public:
+    explicit PbfPlugin( QObject *parent = 0 );
+
+    QString name() const;
+
+    QString nameId() const;
+
+    QString version() const;
+
+    QString description() const;
+
+    QString copyrightYears() const;
+
+    QList<PluginAuthor> pluginAuthors() const;
+
+    QString fileFormatDescription() const;
+
+    QStringList fileExtensions() const;
+
+    virtual ParsingRunner* newRunner() const;
+};
+
+}
+#endif // MARBLEPBFPLUGIN_H
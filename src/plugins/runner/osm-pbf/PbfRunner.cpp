@@ -0,0 +1,34 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "PbfRunner.h"
+#include "PbfParser.h"
+
+#include "GeoDataDocument.h"
+
+namespace Marble
+{
+
+PbfRunner::PbfRunner(QObject *parent) :
+    ParsingRunner(parent)
+{
+}
+
+GeoDataDocument *PbfRunner::parseFile(const QString &fileName, DocumentRole role, QString &error)
+{
+    GeoDataDocument* document = PbfParser::parse(fileName, error);
+    if (document) {
+        document->setDocumentRole(role);
+        document->setFileName(fileName);
+    }
+    return document;
+}
+
+}
+
+#include "moc_PbfRunner.cpp"
@@ -0,0 +1,26 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLEPBFRUNNER_H
+#define MARBLEPBFRUNNER_H
+
+#include "ParsingRunner.h"
+
+namespace Marble
+{
+
+class PbfRunner : public ParsingRunner
+{
+    Q_OBJECT
+public:
+    explicit PbfRunner(QObject *parent = 0);
+    GeoDataDocument* parseFile( const QString &fileName, DocumentRole role, QString& error );
+};
+
+}
+#endif // MARBLEPBFRUNNER_H
@@ -0,0 +1,477 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "OsmBinaryTile.h"
+#include "OsmDocumentBuilder.h"
+#include "OsmElementDictionary.h"
+#include "GeoDataDocument.h"
+#include "osm/OsmPresetLibrary.h"
+
+#include <QFile>
+#include <QIODevice>
+#include <QSet>
+
+#include <cstring>
+
+namespace Marble {
+
+// "MOBT", followed by the version of the format
+static const char tileMagic[] = { 'M', 'O', 'B', 'T' };
+static const quint64 tileVersion = 2;
+
+// the category index of elements whose category is determined from the tags
+static const int tagsCategoryIndex = 0;
+
+enum MemberType {
+    NodeMember = 0,
+    WayMember = 1,
+    RelationMember = 2
+};
+
+// the first tag of each category in the presets
+static QHash<int, OsmPresetLibrary::OsmTag> categoryTags()
+{
+    QHash<int, OsmPresetLibrary::OsmTag> tags;
+    for (QMap<OsmPresetLibrary::OsmTag, GeoDataFeature::GeoDataVisualCategory>::const_iterator
+         iter = OsmPresetLibrary::begin(), end = OsmPresetLibrary::end(); iter != end; ++iter) {
+        if (!tags.contains(iter.value())) {
+            tags.insert(iter.value(), iter.key());
+        }
+    }
+    return tags;
+}
+
+GeoDataDocument *OsmBinaryTileReader::parse(const QString &fileName, QString &error)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        error = QString("Cannot open file %1").arg(fileName);
+        return nullptr;
+    }
+
+    // Read the whole file if it cannot be mapped
+    QByteArray content;
+    uchar const * data = file.map(0, file.size());
+    if (!data) {
+        content = file.readAll();
+        data = reinterpret_cast<const uchar*>(content.constData());
+    }
+
+    OsmBinaryTileReader reader(data, content.isNull() ? file.size() : content.size());
+    GeoDataDocument* document = reader.read(error);
+    if (content.isNull()) {
+        file.unmap(const_cast<uchar*>(data));
+    }
+    if (!document) {
+        error = QString("%1: %2").arg(fileName).arg(error);
+    }
+    return document;
+}
+
+OsmBinaryTileReader::OsmBinaryTileReader(const uchar *data, qint64 size) :
+    m_position(data),
+    m_end(data + size),
+    m_useCategories(false)
+{
+    // nothing to do
+}
+
+GeoDataDocument *OsmBinaryTileReader::read(QString &error)
+{
+    if (m_end - m_position < int(sizeof(tileMagic)) || memcmp(m_position, tileMagic, sizeof(tileMagic)) != 0) {
+        error = QString("Not a binary vector tile");
+        return nullptr;
+    }
+    m_position += sizeof(tileMagic);
+
+    quint64 version;
+    if (!readVarint(version) || version != tileVersion) {
+        error = QString("Unsupported version of the binary vector tile format");
+        return nullptr;
+    }
+
+    int stringCount;
+    if (!readCount(stringCount)) {
+        error = QString("Corrupt string table");
+        return nullptr;
+    }
+    m_strings.reserve(stringCount);
+    for (int i = 0; i < stringCount; ++i) {
+        int length;
+        if (!readCount(length)) {
+            error = QString("Corrupt string table");
+            return nullptr;
+        }
+        m_strings << QString::fromUtf8(reinterpret_cast<const char*>(m_position), length);
+        m_position += length;
+    }
+
+    int categoryCount;
+    if (!readCount(categoryCount)) {
+        error = QString("Corrupt category table");
+        return nullptr;
+    }
+    m_categories.reserve(categoryCount + 1);
+    m_categories << GeoDataFeature::LastIndex;
+    for (int i = 0; i < categoryCount; ++i) {
+        QString key, value;
+        if (!readString(key) || !readString(value)) {
+            error = QString("Corrupt category table");
+            return nullptr;
+        }
+        if (key.isEmpty()) {
+            m_categories << GeoDataFeature::None;
+        } else {
+            // unknown tags are None as well, their elements fall back to the tags
+            GeoDataFeature::GeoDataVisualCategory const category = OsmPresetLibrary::osmVisualCategory(key + '=' + value);
+            m_categories << (category == GeoDataFeature::None ? GeoDataFeature::LastIndex : category);
+        }
+    }
+
+    QString const corrupt = QString("Unexpected end of the binary vector tile");
+
+    // The relations come first to know the ways used by relations
+    int relationCount;
+    if (!readCount(relationCount)) {
+        error = corrupt;
+        return nullptr;
+    }
+    QVector<OsmRelation> relations;
+    relations.reserve(relationCount);
+    QSet<qint64> relationWayIds;
+    qint64 relationId = 0;
+    qint64 memberReference = 0;
+    for (int i = 0; i < relationCount; ++i) {
+        OsmRelation relation;
+        qint64 idDelta;
+        GeoDataFeature::GeoDataVisualCategory category;
+        int memberCount;
+        if (!readSigned(idDelta) || !readCategory(category) || !readTags(relation.osmData()) || !readCount(memberCount)) {
+            error = corrupt;
+            return nullptr;
+        }
+        relationId += idDelta;
+        relation.osmData().setId(relationId);
+        relation.setVisualCategory(category);
+
+        for (int j = 0; j < memberCount; ++j) {
+            quint64 type;
+            qint64 referenceDelta;
+            QString role;
+            if (!readVarint(type) || type > RelationMember || !readSigned(referenceDelta) || !readString(role)) {
+                error = corrupt;
+                return nullptr;
+            }
+            memberReference += referenceDelta;
+            if (type == WayMember) {
+                relationWayIds << memberReference;
+            }
+            char const * const typeName = type == NodeMember ? osm::osmTag_node :
+                                          type == WayMember ? osm::osmTag_way : osm::osmTag_relation;
+            relation.addMember(memberReference, role, QString::fromLatin1(typeName));
+        }
+        relations << relation;
+    }
+
+    OsmDocumentBuilder builder(relationWayIds);
+
+    int nodeCount;
+    if (!readCount(nodeCount)) {
+        error = corrupt;
+        return nullptr;
+    }
+    qint64 nodeId = 0;
+    qint64 longitude = 0;
+    qint64 latitude = 0;
+    for (int i = 0; i < nodeCount; ++i) {
+        OsmNode node;
+        qint64 idDelta, lonDelta, latDelta;
+        GeoDataFeature::GeoDataVisualCategory category;
+        if (!readSigned(idDelta) || !readSigned(lonDelta) || !readSigned(latDelta)
+                || !readCategory(category) || !readTags(node.osmData())) {
+            error = corrupt;
+            return nullptr;
+        }
+        nodeId += idDelta;
+        longitude += lonDelta;
+        latitude += latDelta;
+        node.osmData().setId(nodeId);
+        node.setCoordinates(GeoDataCoordinates(longitude / 1e7, latitude / 1e7, 0, GeoDataCoordinates::Degree));
+        node.setVisualCategory(category);
+        builder.addNode(node);
+    }
+
+    int wayCount;
+    if (!readCount(wayCount)) {
+        error = corrupt;
+        return nullptr;
+    }
+    qint64 wayId = 0;
+    qint64 nodeReference = 0;
+    for (int i = 0; i < wayCount; ++i) {
+        OsmWay way;
+        qint64 idDelta;
+        GeoDataFeature::GeoDataVisualCategory category;
+        int referenceCount;
+        if (!readSigned(idDelta) || !readCategory(category) || !readTags(way.osmData()) || !readCount(referenceCount)) {
+            error = corrupt;
+            return nullptr;
+        }
+        wayId += idDelta;
+        way.osmData().setId(wayId);
+        way.setVisualCategory(category);
+        for (int j = 0; j < referenceCount; ++j) {
+            qint64 referenceDelta;
+            if (!readSigned(referenceDelta)) {
+                error = corrupt;
+                return nullptr;
+            }
+            nodeReference += referenceDelta;
+            way.addReference(nodeReference);
+        }
+        builder.addWay(way);
+    }
+
+    foreach(const OsmRelation &relation, relations) {
+        builder.addRelation(relation);
+    }
+
+    return builder.document();
+}
+
+bool OsmBinaryTileReader::readVarint(quint64 &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (m_position == m_end) {
+            return false;
+        }
+        uchar const byte = *m_position++;
+        value |= quint64(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool OsmBinaryTileReader::readSigned(qint64 &value)
+{
+    quint64 zigzag;
+    if (!readVarint(zigzag)) {
+        return false;
+    }
+    value = qint64(zigzag >> 1) ^ -qint64(zigzag & 1);
+    return true;
+}
+
+bool OsmBinaryTileReader::readCount(int &count)
+{
+    quint64 value;
+    // every element takes at least one byte, larger counts are corrupt
+    if (!readVarint(value) || value > quint64(m_end - m_position)) {
+        return false;
+    }
+    count = int(value);
+    return true;
+}
+
+bool OsmBinaryTileReader::readString(QString &string)
+{
+    quint64 index;
+    if (!readVarint(index) || index >= quint64(m_strings.size())) {
+        return false;
+    }
+    string = m_strings.at(int(index));
+    return true;
+}
+
+bool OsmBinaryTileReader::readTags(OsmPlacemarkData &osmData)
+{
+    int tagCount;
+    if (!readCount(tagCount)) {
+        return false;
+    }
+    for (int i = 0; i < tagCount; ++i) {
+        QString key, value;
+        if (!readString(key) || !readString(value)) {
+            return false;
+        }
+        osmData.addTag(key, value);
+    }
+    return true;
+}
+
+bool OsmBinaryTileReader::readCategory(GeoDataFeature::GeoDataVisualCategory &category)
+{
+    quint64 index;
+    if (!readVarint(index) || index >= quint64(m_categories.size())) {
+        return false;
+    }
+    category = m_categories.at(int(index));
+    return true;
+}
+
+OsmBinaryTileWriter::OsmBinaryTileWriter() :
+    m_categoryCount(0),
+    m_relationCount(0),
+    m_nodeCount(0),
+    m_wayCount(0),
+    m_relationId(0),
+    m_memberReference(0),
+    m_nodeId(0),
+    m_longitude(0),
+    m_latitude(0),
+    m_wayId(0),
+    m_nodeReference(0)
+{
+    // nothing to do
+}
+
+void OsmBinaryTileWriter::addNode(const OsmNode &node)
+{
+    qint64 const id = node.osmData().id();
+    qint64 const longitude = qRound64(node.coordinates().longitude(GeoDataCoordinates::Degree) * 1e7);
+    qint64 const latitude = qRound64(node.coordinates().latitude(GeoDataCoordinates::Degree) * 1e7);
+
+    writeSigned(m_nodes, id - m_nodeId);
+    writeSigned(m_nodes, longitude - m_longitude);
+    writeSigned(m_nodes, latitude - m_latitude);
+    writeVarint(m_nodes, categoryIndex(node.visualCategory()));
+    writeTags(m_nodes, node.osmData());
+
+    m_nodeId = id;
+    m_longitude = longitude;
+    m_latitude = latitude;
+    ++m_nodeCount;
+}
+
+void OsmBinaryTileWriter::addWay(const OsmWay &way)
+{
+    qint64 const id = way.osmData().id();
+    writeSigned(m_ways, id - m_wayId);
+    writeVarint(m_ways, categoryIndex(way.visualCategory()));
+    writeTags(m_ways, way.osmData());
+    writeVarint(m_ways, way.references().size());
+    foreach(qint64 reference, way.references()) {
+        writeSigned(m_ways, reference - m_nodeReference);
+        m_nodeReference = reference;
+    }
+
+    m_wayId = id;
+    ++m_wayCount;
+}
+
+void OsmBinaryTileWriter::addRelation(const OsmRelation &relation)
+{
+    qint64 const id = relation.osmData().id();
+    writeSigned(m_relations, id - m_relationId);
+    writeVarint(m_relations, categoryIndex(relation.visualCategory()));
+    writeTags(m_relations, relation.osmData());
+    writeVarint(m_relations, relation.members().size());
+    foreach(const OsmRelation::OsmMember &member, relation.members()) {
+        MemberType const type = member.type == osm::osmTag_node ? NodeMember :
+                                member.type == osm::osmTag_way ? WayMember : RelationMember;
+        writeVarint(m_relations, type);
+        writeSigned(m_relations, member.reference - m_memberReference);
+        writeVarint(m_relations, stringIndex(member.role));
+        m_memberReference = member.reference;
+    }
+
+    m_relationId = id;
+    ++m_relationCount;
+}
+
+bool OsmBinaryTileWriter::write(QIODevice *device) const
+{
+    QByteArray header(tileMagic, sizeof(tileMagic));
+    writeVarint(header, tileVersion);
+    writeVarint(header, m_strings.size());
+    foreach(const QString &string, m_strings) {
+        QByteArray const utf8 = string.toUtf8();
+        writeVarint(header, utf8.size());
+        header += utf8;
+    }
+    writeVarint(header, m_categoryCount);
+    header += m_categories;
+
+    QByteArray relationCount, nodeCount, wayCount;
+    writeVarint(relationCount, m_relationCount);
+    writeVarint(nodeCount, m_nodeCount);
+    writeVarint(wayCount, m_wayCount);
+
+    return device->write(header) == header.size()
+            && device->write(relationCount) == relationCount.size()
+            && device->write(m_relations) == m_relations.size()
+            && device->write(nodeCount) == nodeCount.size()
+            && device->write(m_nodes) == m_nodes.size()
+            && device->write(wayCount) == wayCount.size()
+            && device->write(m_ways) == m_ways.size();
+}
+
+int OsmBinaryTileWriter::stringIndex(const QString &string)
+{
+    QHash<QString, int>::const_iterator const iter = m_stringIndexes.constFind(string);
+    if (iter != m_stringIndexes.constEnd()) {
+        return iter.value();
+    }
+
+    int const index = m_strings.size();
+    m_stringIndexes.insert(string, index);
+    m_strings << string;
+    return index;
+}
+
+int OsmBinaryTileWriter::categoryIndex(GeoDataFeature::GeoDataVisualCategory category)
+{
+    QHash<int, int>::const_iterator const iter = m_categoryIndexes.constFind(category);
+    if (iter != m_categoryIndexes.constEnd()) {
+        return iter.value();
+    }
+
+    static QHash<int, OsmPresetLibrary::OsmTag> const presetTags = categoryTags();
+    int index = tagsCategoryIndex;
+    // no category is stored as an empty tag
+    if (category == GeoDataFeature::None || presetTags.contains(category)) {
+        OsmPresetLibrary::OsmTag const tag = presetTags.value(category);
+        writeVarint(m_categories, stringIndex(tag.first));
+        writeVarint(m_categories, stringIndex(tag.second));
+        index = ++m_categoryCount;
+    }
+    m_categoryIndexes.insert(category, index);
+    return index;
+}
+
+void OsmBinaryTileWriter::writeTags(QByteArray &buffer, const OsmPlacemarkData &osmData)
+{
+    QByteArray tags;
+    int tagCount = 0;
+    for (QHash<QString, QString>::const_iterator iter = osmData.tagsBegin(), end = osmData.tagsEnd(); iter != end; ++iter) {
+        writeVarint(tags, stringIndex(iter.key()));
+        writeVarint(tags, stringIndex(iter.value()));
+        ++tagCount;
+    }
+    writeVarint(buffer, tagCount);
+    buffer += tags;
+}
+
+void OsmBinaryTileWriter::writeVarint(QByteArray &buffer, quint64 value)
+{
+    while (value >= 0x80) {
+        buffer += char((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    buffer += char(value);
+}
+
+void OsmBinaryTileWriter::writeSigned(QByteArray &buffer, qint64 value)
+{
+    writeVarint(buffer, (quint64(value) << 1) ^ quint64(value >> 63));
+}
+
+}
@@ -0,0 +1,129 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_OSMBINARYTILE_H
+#define MARBLE_OSMBINARYTILE_H
+
+#include "OsmNode.h"
+#include "OsmWay.h"
+#include "OsmRelation.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+namespace Marble {
+
+class GeoDataDocument;
+
+/**
+ * Reads binary vector tiles (.osmb), a compact encoding of the OSM elements of a tile.
+ *
+ * The file starts with the magic number "MOBT", all further values are
+ * unsigned LEB128 varints:
+ *
+ * - the format version;
+ * - a string table, every tag key, tag value and member role of the tile
+ *   is stored once and referred to by its index;
+ * - a category table, every visual category of the tile is stored once as
+ *   an OSM tag it is assigned to, an empty key stands for no category;
+ * - the relations, the nodes and the ways. Ids, coordinates (in 1e-7 degrees)
+ *   and references are stored as zigzag coded differences to the preceding
+ *   ones, which usually takes one or two bytes.
+ *
+ * Each element carries the index of its visual category in the category
+ * table, the index 0 stands for a category which is determined from the tags
+ * like for .osm files. Categories are not stored as values of
+ * GeoDataFeature::GeoDataVisualCategory, so tiles stay valid if categories
+ * are added or reordered. Categories of tags the reader does not know are
+ * determined from the tags as well.
+ *
+ * Relations come first, so the ways which are members of relations are known
+ * before the ways are read and the file is read in a single pass. The file
+ * is memory mapped and decoded in place, only the strings are copied once.
+ * Version, changeset and user of the elements are not stored.
+ */
+class OsmBinaryTileReader
+{
+public:
+    static GeoDataDocument *parse(const QString &fileName, QString &error);
+
+private:
+    OsmBinaryTileReader(const uchar *data, qint64 size);
+
+    GeoDataDocument *read(QString &error);
+
+    bool readVarint(quint64 &value);
+    bool readSigned(qint64 &value);
+    bool readCount(int &count);
+    bool readString(QString &string);
+    bool readTags(OsmPlacemarkData &osmData);
+    bool readCategory(GeoDataFeature::GeoDataVisualCategory &category);
+
+    const uchar *m_position;
+    const uchar *const m_end;
+    QVector<QString> m_strings;
+    QVector<GeoDataFeature::GeoDataVisualCategory> m_categories;
+};
+
+/**
+ * Writes the elements passed to it in the format read by OsmBinaryTileReader.
+ *
+ * The elements are encoded as they are added, in the order they are
+ * added. Nodes should be added in the order of their ids and ways in
+ * the order of their nodes, which keeps the differences small.
+ */
+class OsmBinaryTileWriter
+{
+public:
+    OsmBinaryTileWriter();
+
+    void addNode(const OsmNode &node);
+    void addWay(const OsmWay &way);
+    void addRelation(const OsmRelation &relation);
+
+    bool write(QIODevice *device) const;
+
+private:
+    int stringIndex(const QString &string);
+    int categoryIndex(GeoDataFeature::GeoDataVisualCategory category);
+    void writeTags(QByteArray &buffer, const OsmPlacemarkData &osmData);
+
+    static void writeVarint(QByteArray &buffer, quint64 value);
+    static void writeSigned(QByteArray &buffer, qint64 value);
+
+    QHash<QString, int> m_stringIndexes;
+    QVector<QString> m_strings;
+
+    QHash<int, int> m_categoryIndexes;
+    QByteArray m_categories;
+    int m_categoryCount;
+
+    QByteArray m_relations;
+    QByteArray m_nodes;
+    QByteArray m_ways;
+    int m_relationCount;
+    int m_nodeCount;
+    int m_wayCount;
+
+    // the values the next differences refer to
+    qint64 m_relationId;
+    qint64 m_memberReference;
+    qint64 m_nodeId;
+    qint64 m_longitude;
+    qint64 m_latitude;
+    qint64 m_wayId;
+    qint64 m_nodeReference;
+};
+
+}
+
+#endif
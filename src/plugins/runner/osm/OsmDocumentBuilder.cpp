@@ -0,0 +1,119 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "OsmDocumentBuilder.h"
+#include "OsmElementDictionary.h"
+
+#include "GeoDataDocument.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPolyStyle.h"
+#include "GeoDataStyle.h"
+
+#include <algorithm>
+
+namespace Marble {
+
+OsmDocumentBuilder::OsmDocumentBuilder(const QSet<qint64> &relationWayIds) :
+    m_document(new GeoDataDocument),
+    m_relationWayIds(relationWayIds)
+{
+    GeoDataPolyStyle backgroundPolyStyle;
+    backgroundPolyStyle.setFill( true );
+    backgroundPolyStyle.setOutline( false );
+    backgroundPolyStyle.setColor("#f1eee8");
+    GeoDataStyle backgroundStyle;
+    backgroundStyle.setPolyStyle( backgroundPolyStyle );
+    backgroundStyle.setId( "background" );
+    m_document->addStyle( backgroundStyle );
+}
+
+OsmDocumentBuilder::~OsmDocumentBuilder()
+{
+    // nothing to do
+}
+
+void OsmDocumentBuilder::addNode(const OsmNode &node)
+{
+    node.create(&m_nodePlacemarks);
+    m_nodes.insert(node);
+}
+
+void OsmDocumentBuilder::addWay(const OsmWay &way)
+{
+    qint64 const id = way.osmData().id();
+    if (m_relationWayIds.contains(id)) {
+        m_relationWays[id] = way;
+    }
+
+    if (way.hasNodes(m_nodes)) {
+        way.create(&m_wayPlacemarks, m_nodes);
+    } else {
+        m_pendingWays[id] = way;
+    }
+}
+
+void OsmDocumentBuilder::addRelation(const OsmRelation &relation)
+{
+    m_relations[relation.osmData().id()] = relation;
+}
+
+QSet<qint64> OsmDocumentBuilder::missingRelationWayIds() const
+{
+    QSet<qint64> result;
+    foreach(OsmRelation const &relation, m_relations) {
+        if (!relation.osmData().containsTag("type", "multipolygon")) {
+            continue;
+        }
+        foreach(OsmRelation::OsmMember const &member, relation.members()) {
+            if (member.type == QLatin1String(osm::osmTag_way) && !m_relationWays.contains(member.reference)) {
+                result << member.reference;
+            }
+        }
+    }
+    return result;
+}
+
+GeoDataDocument *OsmDocumentBuilder::document()
+{
+    foreach(OsmWay const &way, m_pendingWays) {
+        way.create(&m_wayPlacemarks, m_nodes);
+    }
+    m_pendingWays.clear();
+
+    // relations, ways and nodes, each in the order of their ids
+    foreach(OsmRelation const &relation, m_relations) {
+        relation.create(m_document.data(), m_relationWays, m_nodes);
+    }
+    m_relations.clear();
+
+    appendPlacemarks(m_wayPlacemarks);
+    appendPlacemarks(m_nodePlacemarks);
+
+    return m_document.take();
+}
+
+bool OsmDocumentBuilder::lessThanId(const GeoDataFeature *a, const GeoDataFeature *b)
+{
+    return static_cast<const GeoDataPlacemark*>(a)->osmData().id() < static_cast<const GeoDataPlacemark*>(b)->osmData().id();
+}
+
+void OsmDocumentBuilder::appendPlacemarks(GeoDataDocument &placemarks)
+{
+    QVector<GeoDataFeature*> features = placemarks.featureList();
+    std::stable_sort(features.begin(), features.end(), lessThanId);
+
+    // hand the placemarks over without deleting them
+    for (int i = placemarks.size() - 1; i >= 0; --i) {
+        placemarks.remove(i);
+    }
+    foreach(GeoDataFeature *feature, features) {
+        m_document->append(feature);
+    }
+}
+
+}
@@ -0,0 +1,80 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_OSMDOCUMENTBUILDER
+#define MARBLE_OSMDOCUMENTBUILDER
+
+#include "OsmNode.h"
+#include "OsmWay.h"
+#include "OsmRelation.h"
+
+#include <GeoDataDocument.h>
+
+#include <QScopedPointer>
+#include <QSet>
+
+namespace Marble {
+
+/**
+ * Creates the placemarks of OSM elements in the order they are read.
+ *
+ * Nodes and ways are turned into placemarks as soon as they are added,
+ * only node coordinates, the ways used by relations and ways whose nodes
+ * have not been added yet are kept. Relations are created by document().
+ * The document contains the placemarks of relations, ways and nodes in
+ * this order, each sorted by id.
+ * Used by the parsers of all OSM file formats.
+ */
+class OsmDocumentBuilder
+{
+public:
+    /**
+     * @param relationWayIds the ids of all ways that are members of relations
+     */
+    explicit OsmDocumentBuilder(const QSet<qint64> &relationWayIds);
+    ~OsmDocumentBuilder();
+
+    void addNode(const OsmNode &node);
+    void addWay(const OsmWay &way);
+    void addRelation(const OsmRelation &relation);
+
+    /**
+     * Returns the ids of the ways of multipolygon relations which were not
+     * kept because they were not passed to the constructor. The file needs
+     * to be read again with these ids to create the relations.
+     */
+    QSet<qint64> missingRelationWayIds() const;
+
+    /**
+     * Creates the remaining placemarks and returns the document, the
+     * caller takes ownership.
+     */
+    GeoDataDocument *document();
+
+private:
+    Q_DISABLE_COPY(OsmDocumentBuilder)
+
+    static bool lessThanId(const GeoDataFeature *a, const GeoDataFeature *b);
+    void appendPlacemarks(GeoDataDocument &placemarks);
+
+    QScopedPointer<GeoDataDocument> m_document;
+    // placemarks of ways and nodes until they are moved to m_document
+    GeoDataDocument m_wayPlacemarks;
+    GeoDataDocument m_nodePlacemarks;
+    const QSet<qint64> m_relationWayIds;
+    OsmNodes m_nodes;
+    // ways which are members of relations
+    OsmWays m_relationWays;
+    // ways referring to nodes that have not been added yet
+    OsmWays m_pendingWays;
+    OsmRelations m_relations;
+};
+
+}
+
+#endif
@@ -18,8 +18,16 @@
 #include <MarbleDirs.h>
 #include <QDate>
 
+#include <algorithm>
+
 namespace Marble {
 
+OsmNode::OsmNode() :
+    m_visualCategory(GeoDataFeature::LastIndex)
+{
+    // nothing to do
+}
+
 void OsmNode::parseCoordinates(const QXmlStreamAttributes &attributes)
 {
     qreal const lon = attributes.value( "lon" ).toDouble();
@@ -27,9 +35,14 @@ void OsmNode::parseCoordinates(const QXmlStreamAttributes &attributes)
     m_coordinates = GeoDataCoordinates(lon, lat, 0, GeoDataCoordinates::Degree);
 }
 
+void OsmNode::setCoordinates(const GeoDataCoordinates &coordinates)
+{
+    m_coordinates = coordinates;
+}
+
 void OsmNode::create(GeoDataDocument *document) const
 {
-    GeoDataFeature::GeoDataVisualCategory const category = OsmPresetLibrary::determineVisualCategory(m_osmData);
+    GeoDataFeature::GeoDataVisualCategory const category = visualCategory();
     if (category == GeoDataFeature::None ||
        (category >= GeoDataFeature::HighwaySteps && category <= GeoDataFeature::HighwayMotorway)) {
         return;
@@ -117,6 +130,20 @@ int OsmNode::populationIndex(qint64 population) const
     return popidx;
 }
 
+void OsmNode::setVisualCategory(GeoDataFeature::GeoDataVisualCategory category)
+{
+    m_visualCategory = category;
+}
+
+GeoDataFeature::GeoDataVisualCategory OsmNode::visualCategory() const
+{
+    if (m_visualCategory != GeoDataFeature::LastIndex) {
+        return m_visualCategory;
+    }
+
+    return OsmPresetLibrary::determineVisualCategory(m_osmData);
+}
+
 GeoDataCoordinates OsmNode::coordinates() const
 {
     return m_coordinates;
@@ -132,4 +159,135 @@ const OsmPlacemarkData &OsmNode::osmData() const
     return m_osmData;
 }
 
+OsmNodes::OsmNodes() :
+    m_sorted(true)
+{
+    index(QString(), m_versions, m_versionIndices);
+    index(Changeset(), m_changesets, m_changesetIndices);
+}
+
+void OsmNodes::insert(const OsmNode &node)
+{
+    OsmPlacemarkData const & osmData = node.osmData();
+    if (!isCompact(osmData)) {
+        m_nodes[osmData.id()] = node;
+        return;
+    }
+
+    CompactNode compactNode;
+    compactNode.id = osmData.id();
+    compactNode.lon = qRound(node.coordinates().longitude(GeoDataCoordinates::Degree) * 1e7);
+    compactNode.lat = qRound(node.coordinates().latitude(GeoDataCoordinates::Degree) * 1e7);
+    compactNode.version = index(osmData.version(), m_versions, m_versionIndices);
+
+    Changeset changeset;
+    changeset.changeset = osmData.changeset();
+    changeset.user = osmData.user();
+    changeset.uid = osmData.uid();
+    changeset.timestamp = osmData.timestamp();
+    changeset.visible = osmData.isVisible();
+    changeset.action = osmData.action();
+    compactNode.changeset = index(changeset, m_changesets, m_changesetIndices);
+
+    if (!m_compactNodes.isEmpty() && compactNode.id < m_compactNodes.last().id) {
+        m_sorted = false;
+    }
+    m_compactNodes << compactNode;
+}
+
+bool OsmNodes::contains(qint64 id) const
+{
+    return m_nodes.contains(id) || findCompact(id);
+}
+
+bool OsmNodes::find(qint64 id, GeoDataCoordinates &coordinates) const
+{
+    if (CompactNode const * compactNode = findCompact(id)) {
+        coordinates = GeoDataCoordinates(compactNode->lon * 1e-7, compactNode->lat * 1e-7, 0, GeoDataCoordinates::Degree);
+        return true;
+    }
+
+    QHash<qint64,OsmNode>::const_iterator const node = m_nodes.constFind(id);
+    if (node == m_nodes.constEnd()) {
+        return false;
+    }
+    coordinates = node->coordinates();
+    return true;
+}
+
+OsmPlacemarkData OsmNodes::osmData(qint64 id) const
+{
+    QHash<qint64,OsmNode>::const_iterator const node = m_nodes.constFind(id);
+    if (node != m_nodes.constEnd()) {
+        return node->osmData();
+    }
+
+    OsmPlacemarkData osmData;
+    osmData.setId(id);
+    if (CompactNode const * compactNode = findCompact(id)) {
+        Changeset const & changeset = m_changesets.at(compactNode->changeset);
+        osmData.setVersion(m_versions.at(compactNode->version));
+        osmData.setChangeset(changeset.changeset);
+        osmData.setUser(changeset.user);
+        osmData.setUid(changeset.uid);
+        osmData.setTimestamp(changeset.timestamp);
+        osmData.setVisible(changeset.visible);
+        osmData.setAction(changeset.action);
+    }
+    return osmData;
+}
+
+bool OsmNodes::isCompact(const OsmPlacemarkData &osmData)
+{
+    return osmData.tagsBegin() == osmData.tagsEnd();
+}
+
+template<class T>
+quint32 OsmNodes::index(const T &value, QVector<T> &values, QHash<T,quint32> &indices)
+{
+    typename QHash<T,quint32>::const_iterator const position = indices.constFind(value);
+    if (position != indices.constEnd()) {
+        return position.value();
+    }
+
+    quint32 const result = values.size();
+    values << value;
+    indices.insert(value, result);
+    return result;
+}
+
+const OsmNodes::CompactNode *OsmNodes::findCompact(qint64 id) const
+{
+    if (!m_sorted) {
+        std::sort(m_compactNodes.begin(), m_compactNodes.end());
+        m_sorted = true;
+    }
+
+    CompactNode key;
+    key.id = id;
+    CompactNode const * const end = m_compactNodes.constData() + m_compactNodes.size();
+    CompactNode const * const position = std::lower_bound(m_compactNodes.constData(), end, key);
+    return position != end && position->id == id ? position : nullptr;
+}
+
+bool OsmNodes::CompactNode::operator<(const CompactNode &other) const
+{
+    return id < other.id;
+}
+
+bool OsmNodes::Changeset::operator==(const Changeset &other) const
+{
+    return changeset == other.changeset
+            && user == other.user
+            && uid == other.uid
+            && timestamp == other.timestamp
+            && visible == other.visible
+            && action == other.action;
+}
+
+uint qHash(const OsmNodes::Changeset &changeset)
+{
+    return qHash(changeset.changeset) ^ qHash(changeset.timestamp) ^ qHash(changeset.uid);
+}
+
 }
@@ -14,19 +14,31 @@
 #include <osm/OsmPlacemarkData.h>
 #include <GeoDataDocument.h>
 
+#include <QHash>
 #include <QString>
+#include <QVector>
 #include <QXmlStreamAttributes>
 
 namespace Marble {
 
 class OsmNode {
 public:
+    OsmNode();
+
     OsmPlacemarkData & osmData();
     void parseCoordinates(const QXmlStreamAttributes &attributes);
+    void setCoordinates(const GeoDataCoordinates &coordinates);
 
     GeoDataCoordinates coordinates() const;
     const OsmPlacemarkData & osmData() const;
 
+    /**
+     * Sets the visual category of the placemark, which is determined from
+     * the tags otherwise. Used for files with precomputed categories.
+     */
+    void setVisualCategory(GeoDataFeature::GeoDataVisualCategory category);
+    GeoDataFeature::GeoDataVisualCategory visualCategory() const;
+
     void create(GeoDataDocument* document) const;
 
 private:
@@ -34,9 +46,91 @@ private:
 
     OsmPlacemarkData m_osmData;
     GeoDataCoordinates m_coordinates;
+    // GeoDataFeature::LastIndex if not set
+    GeoDataFeature::GeoDataVisualCategory m_visualCategory;
 };
 
-typedef QMap<qint64,OsmNode> OsmNodes;
+/**
+ * The nodes which ways and relations refer to.
+ *
+ * Most nodes of a file are plain way vertices without tags. For these just
+ * the id and the coordinates are stored, in the fixed point representation
+ * of OSM (1e-7 degrees), which needs a small fraction of the memory of an
+ * OsmNode. Their version and their changeset attributes (changeset, user,
+ * uid, timestamp, visible and action) are stored out-of-line: nodes of the
+ * same upload share them, so each distinct value is stored once and the
+ * nodes refer to it by index. Nodes with tags are kept as a whole.
+ */
+class OsmNodes
+{
+public:
+    OsmNodes();
+
+    void insert(const OsmNode &node);
+
+    bool contains(qint64 id) const;
+
+    /**
+     * Sets @p coordinates to the ones of the node @p id.
+     * @return false if the node is unknown
+     */
+    bool find(qint64 id, GeoDataCoordinates &coordinates) const;
+
+    /**
+     * Returns the osm data of the node @p id, for compactly stored nodes
+     * it contains the id and the attributes, but no tags.
+     */
+    OsmPlacemarkData osmData(qint64 id) const;
+
+private:
+    struct CompactNode
+    {
+        qint64 id;
+        qint32 lon;
+        qint32 lat;
+        // indices into m_versions and m_changesets
+        quint32 version;
+        quint32 changeset;
+
+        bool operator<(const CompactNode &other) const;
+    };
+
+    /**
+     * The attributes of a node which are the same for all nodes of an upload.
+     */
+    struct Changeset
+    {
+        QString changeset;
+        QString user;
+        QString uid;
+        QString timestamp;
+        QString visible;
+        QString action;
+
+        bool operator==(const Changeset &other) const;
+    };
+    friend uint qHash(const Changeset &changeset);
+
+    /**
+     * Returns true if nothing but the id, the coordinates and the attributes
+     * of a node with @p osmData need to be stored.
+     */
+    static bool isCompact(const OsmPlacemarkData &osmData);
+    const CompactNode *findCompact(qint64 id) const;
+
+    template<class T>
+    static quint32 index(const T &value, QVector<T> &values, QHash<T,quint32> &indices);
+
+    QHash<qint64,OsmNode> m_nodes;
+    // sorted by id before lookups, nodes usually arrive sorted already
+    mutable QVector<CompactNode> m_compactNodes;
+    mutable bool m_sorted;
+    // the distinct attributes of compact nodes, the first ones are empty
+    QVector<QString> m_versions;
+    QHash<QString,quint32> m_versionIndices;
+    QVector<Changeset> m_changesets;
+    QHash<Changeset,quint32> m_changesetIndices;
+};
 
 }
 
@@ -12,6 +12,8 @@
 //
 
 #include "OsmParser.h"
+#include "OsmBinaryTile.h"
+#include "OsmDocumentBuilder.h"
 #include "OsmElementDictionary.h"
 #include "osm/OsmPresetLibrary.h"
 #include "osm/OsmObjectManager.h"
@@ -24,108 +26,180 @@
 
 #include <QFile>
 #include <QFileInfo>
-#include <QBuffer>
+#include <QSaveFile>
+#include <QScopedPointer>
+#include <QXmlStreamReader>
 
 namespace Marble {
 
-GeoDataDocument *OsmParser::parse(const QString &filename, QString &error)
+/**
+ * Opens an .osm file or the single file of an .osm.zip archive, which is
+ * inflated while it is read.
+ */
+class OsmInputFile
+{
+public:
+    bool open(const QString &filename, QString &error);
+    QIODevice *device();
+
+private:
+    QFile m_file;
+    QScopedPointer<MarbleZipReader> m_zipReader;
+    QScopedPointer<QIODevice> m_zipDevice;
+};
+
+bool OsmInputFile::open(const QString &filename, QString &error)
 {
-    QXmlStreamReader parser;
-    QFile file;
-    QBuffer buffer;
     QFileInfo fileInfo(filename);
     if (fileInfo.completeSuffix() == "osm.zip") {
-        MarbleZipReader zipReader(filename);
-        if (zipReader.fileInfoList().size() != 1) {
-            int const fileNumber = zipReader.fileInfoList().size();
+        m_zipReader.reset(new MarbleZipReader(filename));
+        if (m_zipReader->fileInfoList().size() != 1) {
+            int const fileNumber = m_zipReader->fileInfoList().size();
             error = QString("Unexpected number of files (%1) in %2").arg(fileNumber).arg(filename);
-            return nullptr;
+            return false;
+        }
+        m_zipDevice.reset(m_zipReader->fileDevice(m_zipReader->fileInfoList().first().filePath));
+        if (!m_zipDevice) {
+            error = QString("Cannot read the compressed file %1").arg(filename);
+            return false;
         }
-        QByteArray const data = zipReader.fileData(zipReader.fileInfoList().first().filePath);
-        buffer.setData(data);
-        buffer.open(QBuffer::ReadOnly);
-        parser.setDevice(&buffer);
     } else {
-        file.setFileName(filename);
-        if (!file.open(QFile::ReadOnly)) {
+        m_file.setFileName(filename);
+        if (!m_file.open(QFile::ReadOnly)) {
             error = QString("Cannot open file %1").arg(filename);
-            return nullptr;
+            return false;
         }
-        parser.setDevice(&file);
     }
 
-    OsmPlacemarkData* osmData(0);
-    QString parentTag;
-    qint64 parentId(0);
+    return true;
+}
+
+QIODevice *OsmInputFile::device()
+{
+    return m_zipDevice ? m_zipDevice.data() : &m_file;
+}
+
+GeoDataDocument *OsmParser::parse(const QString &filename, QString &error)
+{
+    if (QFileInfo(filename).suffix() == "osmb") {
+        return OsmBinaryTileReader::parse(filename, error);
+    }
+
+    return createDocument(filename, QSet<qint64>(), error);
+}
 
-    OsmNodes m_nodes;
-    OsmWays m_ways;
-    OsmRelations m_relations;
+bool OsmParser::convert(const QString &filename, const QString &tileFilename, QString &error)
+{
+    OsmInputFile file;
+    if (!file.open(filename, error)) {
+        return false;
+    }
+
+    OsmBinaryTileWriter writer;
+    if (!readElements(file.device(), writer, error)) {
+        return false;
+    }
+
+    QSaveFile tileFile(tileFilename);
+    if (!tileFile.open(QFile::WriteOnly) || !writer.write(&tileFile) || !tileFile.commit()) {
+        error = QString("Cannot write file %1").arg(tileFilename);
+        return false;
+    }
+    return true;
+}
+
+GeoDataDocument *OsmParser::createDocument(const QString &filename, const QSet<qint64> &relationWayIds, QString &error)
+{
+    OsmInputFile file;
+    if (!file.open(filename, error)) {
+        return nullptr;
+    }
+
+    OsmDocumentBuilder builder(relationWayIds);
+    if (!readElements(file.device(), builder, error)) {
+        return nullptr;
+    }
+
+    // The ways of multipolygon relations are only known after reading them,
+    // so read the file again keeping these ways
+    QSet<qint64> const missingWayIds = builder.missingRelationWayIds();
+    if (relationWayIds.isEmpty() && !missingWayIds.isEmpty()) {
+        return createDocument(filename, missingWayIds, error);
+    }
+
+    return builder.document();
+}
+
+template<class Builder>
+bool OsmParser::readElements(QIODevice *device, Builder &builder, QString &error)
+{
+    enum ElementType {
+        NoElement,
+        NodeElement,
+        WayElement,
+        RelationElement
+    };
+
+    QXmlStreamReader parser(device);
+    ElementType element = NoElement;
+    OsmPlacemarkData* osmData(0);
+    OsmNode node;
+    OsmWay way;
+    OsmRelation relation;
 
     while (!parser.atEnd()) {
         parser.readNext();
+        if (parser.isEndElement()) {
+            QStringRef const tagName = parser.name();
+            if (element == NodeElement && tagName == osm::osmTag_node) {
+                builder.addNode(node);
+                element = NoElement;
+            } else if (element == WayElement && tagName == osm::osmTag_way) {
+                builder.addWay(way);
+                element = NoElement;
+            } else if (element == RelationElement && tagName == osm::osmTag_relation) {
+                builder.addRelation(relation);
+                element = NoElement;
+            }
+            continue;
+        }
+
         if (!parser.isStartElement()) {
             continue;
         }
 
         QStringRef const tagName = parser.name();
-        if (tagName == osm::osmTag_node || tagName == osm::osmTag_way || tagName == osm::osmTag_relation) {
-            parentTag = parser.name().toString();
-            parentId = parser.attributes().value("id").toLongLong();
-
-            if (tagName == osm::osmTag_node) {
-                m_nodes[parentId].osmData() = OsmPlacemarkData::fromParserAttributes(parser.attributes());
-                m_nodes[parentId].parseCoordinates(parser.attributes());
-                osmData = &m_nodes[parentId].osmData();
-            } else if (tagName == osm::osmTag_way) {
-                m_ways[parentId].osmData() = OsmPlacemarkData::fromParserAttributes(parser.attributes());
-                osmData = &m_ways[parentId].osmData();
-            } else {
-                Q_ASSERT(tagName == osm::osmTag_relation);
-                m_relations[parentId].osmData() = OsmPlacemarkData::fromParserAttributes(parser.attributes());
-                osmData = &m_relations[parentId].osmData();
-            }
-        } else if (tagName == osm::osmTag_tag) {
+        if (tagName == osm::osmTag_node) {
+            node = OsmNode();
+            node.osmData() = OsmPlacemarkData::fromParserAttributes(parser.attributes());
+            node.parseCoordinates(parser.attributes());
+            osmData = &node.osmData();
+            element = NodeElement;
+        } else if (tagName == osm::osmTag_way) {
+            way = OsmWay();
+            way.osmData() = OsmPlacemarkData::fromParserAttributes(parser.attributes());
+            osmData = &way.osmData();
+            element = WayElement;
+        } else if (tagName == osm::osmTag_relation) {
+            relation = OsmRelation();
+            relation.osmData() = OsmPlacemarkData::fromParserAttributes(parser.attributes());
+            osmData = &relation.osmData();
+            element = RelationElement;
+        } else if (tagName == osm::osmTag_tag && element != NoElement) {
             osmData->addTag(parser.attributes().value("k").toString(), parser.attributes().value("v").toString());
-        } else if (tagName == osm::osmTag_nd && parentTag == osm::osmTag_way) {
-            m_ways[parentId].addReference(parser.attributes().value("ref").toLongLong());
-        } else if (tagName == osm::osmTag_member && parentTag == osm::osmTag_relation) {
-            m_relations[parentId].parseMember(parser.attributes());
+        } else if (tagName == osm::osmTag_nd && element == WayElement) {
+            way.addReference(parser.attributes().value("ref").toLongLong());
+        } else if (tagName == osm::osmTag_member && element == RelationElement) {
+            relation.parseMember(parser.attributes());
         } // other tags like osm, bounds ignored
     }
 
     if (parser.hasError()) {
         error = parser.errorString();
-        return nullptr;
-    }
-
-    return createDocument(m_nodes, m_ways, m_relations);
-}
-
-GeoDataDocument *OsmParser::createDocument(OsmNodes &nodes, OsmWays &ways, OsmRelations &relations)
-{
-    GeoDataDocument* document = new GeoDataDocument;
-    GeoDataPolyStyle backgroundPolyStyle;
-    backgroundPolyStyle.setFill( true );
-    backgroundPolyStyle.setOutline( false );
-    backgroundPolyStyle.setColor("#f1eee8");
-    GeoDataStyle backgroundStyle;
-    backgroundStyle.setPolyStyle( backgroundPolyStyle );
-    backgroundStyle.setId( "background" );
-    document->addStyle( backgroundStyle );
-
-    foreach(OsmRelation const &relation, relations) {
-        relation.create(document, ways, nodes);
+        return false;
     }
 
-    foreach(OsmWay const &way, ways) {
-        way.create(document, nodes);
-    }
-
-    foreach(OsmNode const &node, nodes) {
-        node.create(document);
-    }
-    return document;
+    return true;
 }
 
 }
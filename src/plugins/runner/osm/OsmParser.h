@@ -18,19 +18,45 @@
 #include "OsmWay.h"
 #include "OsmRelation.h"
 
+#include <QSet>
 #include <QString>
 
+class QIODevice;
+
 namespace Marble {
 
 class GeoDataDocument;
 
+/**
+ * Reads .osm and .osm.zip files, binary vector tiles (.osmb) are passed
+ * on to OsmBinaryTileReader.
+ *
+ * The file is streamed once, creating the placemarks of nodes and ways as
+ * soon as they are complete, just node coordinates are kept until the end of
+ * the file. Relations follow the ways in OSM files, so if the file contains
+ * multipolygon relations it is streamed a second time, keeping the ways of
+ * these relations.
+ */
 class OsmParser
 {
 public:
     static GeoDataDocument* parse(const QString &filename, QString &error);
 
+    /**
+     * Converts the .osm or .osm.zip file @p filename to the binary vector
+     * tile @p tileFilename.
+     */
+    static bool convert(const QString &filename, const QString &tileFilename, QString &error);
+
 private:
-    static GeoDataDocument *createDocument(OsmNodes &nodes, OsmWays &way, OsmRelations &relations);
+    static GeoDataDocument *createDocument(const QString &filename, const QSet<qint64> &relationWayIds, QString &error);
+
+    /**
+     * Passes the nodes, ways and relations of the XML @p device to @p builder
+     * in the order of the file.
+     */
+    template<class Builder>
+    static bool readElements(QIODevice *device, Builder &builder, QString &error);
 };
 
 }
@@ -56,7 +56,7 @@ QString OsmPlugin::fileFormatDescription() const
 
 QStringList OsmPlugin::fileExtensions() const
 {
-    return QStringList() << "osm" << "osm.zip";
+    return QStringList() << "osm" << "osm.zip" << "osmb";
 }
 
 ParsingRunner* OsmPlugin::newRunner() const
@@ -22,6 +22,12 @@ OsmRelation::OsmMember::OsmMember() :
     // nothing to do
 }
 
+OsmRelation::OsmRelation() :
+    m_visualCategory(GeoDataFeature::LastIndex)
+{
+    // nothing to do
+}
+
 OsmPlacemarkData &OsmRelation::osmData()
 {
     return m_osmData;
@@ -33,14 +39,40 @@ const OsmPlacemarkData &OsmRelation::osmData() const
 }
 
 void OsmRelation::parseMember(const QXmlStreamAttributes &attributes)
+{
+    addMember(attributes.value("ref").toLongLong(),
+              attributes.value("role").toString(),
+              attributes.value("type").toString());
+}
+
+void OsmRelation::addMember(qint64 reference, const QString &role, const QString &type)
 {
     OsmMember member;
-    member.reference = attributes.value("ref").toLongLong();
-    member.role = attributes.value("role").toString();
-    member.type = attributes.value("type").toString();
+    member.reference = reference;
+    member.role = role;
+    member.type = type;
     m_members << member;
 }
 
+const QVector<OsmRelation::OsmMember> &OsmRelation::members() const
+{
+    return m_members;
+}
+
+void OsmRelation::setVisualCategory(GeoDataFeature::GeoDataVisualCategory category)
+{
+    m_visualCategory = category;
+}
+
+GeoDataFeature::GeoDataVisualCategory OsmRelation::visualCategory() const
+{
+    if (m_visualCategory != GeoDataFeature::LastIndex) {
+        return m_visualCategory;
+    }
+
+    return OsmPresetLibrary::determineVisualCategory(m_osmData);
+}
+
 void OsmRelation::create(GeoDataDocument *document, const OsmWays &ways, const OsmNodes &nodes) const
 {
     if (!m_osmData.containsTag("type", "multipolygon")) {
@@ -60,7 +92,7 @@ void OsmRelation::create(GeoDataDocument *document, const OsmWays &ways, const O
     GeoDataPlacemark* placemark = new GeoDataPlacemark;
     placemark->setName(m_osmData.tagValue("name"));
     placemark->setOsmData(m_osmData);
-    placemark->setVisualCategory(OsmPresetLibrary::determineVisualCategory(m_osmData));
+    placemark->setVisualCategory(visualCategory());
     placemark->setStyle( 0 );
 
     GeoDataPolygon* polygon = new GeoDataPolygon;
@@ -104,11 +136,12 @@ QList<GeoDataLinearRing> OsmRelation::rings(const QStringList &roles, const OsmW
             continue;
         }
         foreach(qint64 id, way.references()) {
-            if (!nodes.contains(id)) {
+            GeoDataCoordinates coordinates;
+            if (!nodes.find(id, coordinates)) {
                 // A node is missing. Return nothing.
                 return QList<GeoDataLinearRing>();
             }
-            ring << nodes[id].coordinates();
+            ring << coordinates;
         }
         result << ring;
     }
@@ -131,12 +164,13 @@ QList<GeoDataLinearRing> OsmRelation::rings(const QStringList &roles, const OsmW
                         QVector<qint64> v = nextWay.references();
                         while( !v.isEmpty() ) {
                             qint64 id = isReversed ? v.takeLast() : v.takeFirst();
-                            if (!nodes.contains(id)) {
+                            GeoDataCoordinates coordinates;
+                            if (!nodes.find(id, coordinates)) {
                                 // A node is missing. Return nothing.
                                 return QList<GeoDataLinearRing>();
                             }
                             if ( id != lastReference ) {
-                                ring << nodes[id].coordinates();
+                                ring << coordinates;
                             }
                         }
                         lastReference = isReversed ? nextWay.references().first()
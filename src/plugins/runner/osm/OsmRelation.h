@@ -25,14 +25,6 @@ namespace Marble {
 class OsmRelation
 {
 public:
-    OsmPlacemarkData & osmData();
-    void parseMember(const QXmlStreamAttributes &attributes);
-
-    const OsmPlacemarkData & osmData() const;
-
-    void create(GeoDataDocument* document, const OsmWays &ways, const OsmNodes &nodes) const;
-
-private:
     struct OsmMember
     {
         QString type;
@@ -42,10 +34,31 @@ private:
         OsmMember();
     };
 
+    OsmRelation();
+
+    OsmPlacemarkData & osmData();
+    void parseMember(const QXmlStreamAttributes &attributes);
+    void addMember(qint64 reference, const QString &role, const QString &type);
+
+    const OsmPlacemarkData & osmData() const;
+    const QVector<OsmMember> &members() const;
+
+    /**
+     * Sets the visual category of the placemark, which is determined from
+     * the tags otherwise. Used for files with precomputed categories.
+     */
+    void setVisualCategory(GeoDataFeature::GeoDataVisualCategory category);
+    GeoDataFeature::GeoDataVisualCategory visualCategory() const;
+
+    void create(GeoDataDocument* document, const OsmWays &ways, const OsmNodes &nodes) const;
+
+private:
     QList<GeoDataLinearRing> rings(const QStringList &roles, const OsmWays &ways, const OsmNodes &nodes) const;
 
     OsmPlacemarkData m_osmData;
     QVector<OsmMember> m_members;
+    // GeoDataFeature::LastIndex if not set
+    GeoDataFeature::GeoDataVisualCategory m_visualCategory;
 };
 
 typedef QMap<qint64,OsmRelation> OsmRelations;
@@ -20,6 +20,11 @@
 
 namespace Marble {
 
+OsmWay::OsmWay() :
+    m_visualCategory(GeoDataFeature::LastIndex)
+{
+    // nothing to do
+}
 
 void OsmWay::create(GeoDataDocument *document, const OsmNodes &nodes) const
 {
@@ -35,7 +40,7 @@ void OsmWay::create(GeoDataDocument *document, const OsmNodes &nodes) const
 
     GeoDataPlacemark* placemark = new GeoDataPlacemark;
     placemark->setOsmData(m_osmData);
-    placemark->setVisualCategory(OsmPresetLibrary::determineVisualCategory(m_osmData));
+    placemark->setVisualCategory(visualCategory());
     placemark->setName(m_osmData.tagValue("name"));
     placemark->setVisible(shouldRender);
 
@@ -44,14 +49,14 @@ void OsmWay::create(GeoDataDocument *document, const OsmNodes &nodes) const
         placemark->setGeometry(linearRing);
 
         foreach(qint64 nodeId, m_references) {
-            if (!nodes.contains(nodeId)) {
+            GeoDataCoordinates coordinates;
+            if (!nodes.find(nodeId, coordinates)) {
                 delete placemark;
                 return;
             }
 
-            OsmNode const & node = nodes[nodeId];
-            placemark->osmData().addNodeReference(node.coordinates(), node.osmData());
-            linearRing->append(node.coordinates());
+            placemark->osmData().addNodeReference(coordinates, nodes.osmData(nodeId));
+            linearRing->append(coordinates);
         }
 
         *linearRing = linearRing->optimized();
@@ -90,14 +95,14 @@ void OsmWay::create(GeoDataDocument *document, const OsmNodes &nodes) const
         placemark->setGeometry(lineString);
 
         foreach(qint64 nodeId, m_references) {
-            if (!nodes.contains(nodeId)) {
+            GeoDataCoordinates coordinates;
+            if (!nodes.find(nodeId, coordinates)) {
                 delete placemark;
                 return;
             }
 
-            OsmNode const & node = nodes[nodeId];
-            placemark->osmData().addNodeReference(node.coordinates(), node.osmData());
-            lineString->append(node.coordinates());
+            placemark->osmData().addNodeReference(coordinates, nodes.osmData(nodeId));
+            lineString->append(coordinates);
         }
 
         *lineString = lineString->optimized();
@@ -150,6 +155,20 @@ void OsmWay::create(GeoDataDocument *document, const OsmNodes &nodes) const
     document->append(placemark);
 }
 
+void OsmWay::setVisualCategory(GeoDataFeature::GeoDataVisualCategory category)
+{
+    m_visualCategory = category;
+}
+
+GeoDataFeature::GeoDataVisualCategory OsmWay::visualCategory() const
+{
+    if (m_visualCategory != GeoDataFeature::LastIndex) {
+        return m_visualCategory;
+    }
+
+    return OsmPresetLibrary::determineVisualCategory(m_osmData);
+}
+
 const QVector<qint64> &OsmWay::references() const
 {
     return m_references;
@@ -165,6 +184,17 @@ const OsmPlacemarkData &OsmWay::osmData() const
     return m_osmData;
 }
 
+bool OsmWay::hasNodes(const OsmNodes &nodes) const
+{
+    foreach(qint64 nodeId, m_references) {
+        if (!nodes.contains(nodeId)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 void OsmWay::addReference(qint64 id)
 {
     m_references << id;
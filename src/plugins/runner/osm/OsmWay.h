@@ -22,12 +22,26 @@ namespace Marble {
 
 class OsmWay {
 public:
+    OsmWay();
+
     OsmPlacemarkData & osmData();
     void addReference(qint64 id);
 
     const OsmPlacemarkData & osmData() const;
     const QVector<qint64> &references() const;
 
+    /**
+     * Returns true if all nodes of the way are known already.
+     */
+    bool hasNodes(const OsmNodes &nodes) const;
+
+    /**
+     * Sets the visual category of the placemark, which is determined from
+     * the tags otherwise. Used for files with precomputed categories.
+     */
+    void setVisualCategory(GeoDataFeature::GeoDataVisualCategory category);
+    GeoDataFeature::GeoDataVisualCategory visualCategory() const;
+
     void create(GeoDataDocument* document, const OsmNodes &nodes) const;
 
 private:
@@ -35,6 +49,8 @@ private:
 
     OsmPlacemarkData m_osmData;
     QVector<qint64> m_references;
+    // GeoDataFeature::LastIndex if not set
+    GeoDataFeature::GeoDataVisualCategory m_visualCategory;
 };
 typedef QMap<qint64,OsmWay> OsmWays;
 
@@ -12,7 +12,10 @@
 
 #include "GeoDataTreeModel.h"
 
+#include "FeatureRegistry.h"
 #include "GeoDataDocument.h"
+#include "GeoDataFolder.h"
+#include "GeoDataGroundOverlay.h"
 #include "GeoDataPlacemark.h"
 
 namespace Marble
@@ -26,6 +29,7 @@ class GeoDataTreeModelTest : public QObject
     void defaultConstructor();
     void setRootDocument();
     void addDocument();
+    void featureRegistry();
 };
 
 void GeoDataTreeModelTest::defaultConstructor()
@@ -73,6 +77,51 @@ void GeoDataTreeModelTest::addDocument()
     }
 }
 
+void GeoDataTreeModelTest::featureRegistry()
+{
+    GeoDataTreeModel model;
+    const FeatureRegistry *registry = model.featureRegistry();
+
+    GeoDataDocument *document = new GeoDataDocument;
+    GeoDataFolder *folder = new GeoDataFolder;
+    GeoDataPlacemark *first = new GeoDataPlacemark;
+    GeoDataPlacemark *second = new GeoDataPlacemark;
+    GeoDataGroundOverlay *overlay = new GeoDataGroundOverlay;
+    folder->append( first );
+    folder->append( second );
+    document->append( folder );
+    document->append( overlay );
+
+    // the placemarks in the folders of a document are registered with the document
+    model.addDocument( document );
+    QCOMPARE( registry->placemarks().size(), 2 );
+    QVERIFY( registry->placemarks().contains( first ) );
+    QVERIFY( registry->placemarks().contains( second ) );
+    QCOMPARE( registry->groundOverlays().size(), 1 );
+    QCOMPARE( registry->groundOverlays().first(), static_cast<const GeoDataGroundOverlay *>( overlay ) );
+
+    GeoDataPlacemark *third = new GeoDataPlacemark;
+    model.addFeature( folder, third );
+    QCOMPARE( registry->placemarks().size(), 3 );
+
+    model.removeFeature( first );
+    QCOMPARE( registry->placemarks().size(), 2 );
+    QVERIFY( !registry->placemarks().contains( first ) );
+    QVERIFY( registry->placemarks().contains( third ) );
+    delete first;
+
+    model.removeDocument( document );
+    QVERIFY( registry->placemarks().isEmpty() );
+    QVERIFY( registry->groundOverlays().isEmpty() );
+
+    // the features of a new root document are registered
+    model.setRootDocument( document );
+    QCOMPARE( registry->placemarks().size(), 2 );
+    model.setRootDocument( 0 );
+    QVERIFY( registry->placemarks().isEmpty() );
+    delete document;
+}
+
 }
 
 QTEST_MAIN( Marble::GeoDataTreeModelTest )
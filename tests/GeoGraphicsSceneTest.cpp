@@ -0,0 +1,260 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoGraphicsScene.h"
+
+#include "GeoDataLatLonAltBox.h"
+#include "GeoDataPlacemark.h"
+#include "GeoGraphicsItem.h"
+
+#include <QTest>
+
+namespace Marble
+{
+
+class TestGraphicsItem : public GeoGraphicsItem
+{
+ public:
+    TestGraphicsItem( const GeoDataFeature *feature, qreal north, qreal south, qreal east, qreal west ) :
+        GeoGraphicsItem( feature )
+    {
+        setLatLonAltBox( GeoDataLatLonAltBox( GeoDataLatLonBox( north, south, east, west, GeoDataCoordinates::Degree ), 0, 0 ) );
+    }
+
+    virtual void paint( GeoPainter *painter, const ViewportParams *viewport )
+    {
+        Q_UNUSED( painter );
+        Q_UNUSED( viewport );
+    }
+};
+
+class DecoratedGraphicsItem : public TestGraphicsItem
+{
+ public:
+    DecoratedGraphicsItem( const GeoDataFeature *feature, qreal north, qreal south, qreal east, qreal west ) :
+        TestGraphicsItem( feature, north, south, east, west ),
+        m_north( north ),
+        m_south( south ),
+        m_east( east ),
+        m_west( west )
+    {
+    }
+
+ protected:
+    virtual void createDecorations()
+    {
+        GeoGraphicsItem *const outline = new TestGraphicsItem( feature(), m_north, m_south, m_east, m_west );
+        outline->setZValue( zValue() - 0.5 );
+        addDecoration( outline );
+    }
+
+ private:
+    const qreal m_north;
+    const qreal m_south;
+    const qreal m_east;
+    const qreal m_west;
+};
+
+class GeoGraphicsSceneTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void items();
+    void itemsAcrossDateLine();
+    void minZoomLevel();
+    void removeItem();
+    void clear();
+    void sortedItems();
+};
+
+void GeoGraphicsSceneTest::items()
+{
+    GeoDataPlacemark europe;
+    GeoDataPlacemark australia;
+    GeoDataPlacemark world;
+
+    GeoGraphicsScene scene;
+    GeoGraphicsItem *const europeItem = new TestGraphicsItem( &europe, 55, 45, 15, 5 );
+    GeoGraphicsItem *const australiaItem = new TestGraphicsItem( &australia, -20, -35, 150, 120 );
+    GeoGraphicsItem *const worldItem = new TestGraphicsItem( &world, 80, -80, 170, -170 );
+    europeItem->setMinZoomLevel( 10 );
+    australiaItem->setMinZoomLevel( 10 );
+    scene.addItem( europeItem );
+    scene.addItem( australiaItem );
+    scene.addItem( worldItem );
+
+    const GeoDataLatLonBox europeBox( 60, 40, 20, 0, GeoDataCoordinates::Degree );
+    QList<GeoGraphicsItem*> result = scene.items( europeBox, 10 );
+    QCOMPARE( result.size(), 2 );
+    QVERIFY( result.contains( europeItem ) );
+    QVERIFY( result.contains( worldItem ) );
+
+    const GeoDataLatLonBox southBox( -10, -40, 160, 100, GeoDataCoordinates::Degree );
+    result = scene.items( southBox, 10 );
+    QCOMPARE( result.size(), 2 );
+    QVERIFY( result.contains( australiaItem ) );
+    QVERIFY( result.contains( worldItem ) );
+}
+
+void GeoGraphicsSceneTest::itemsAcrossDateLine()
+{
+    GeoDataPlacemark fiji;
+    GeoDataPlacemark hawaii;
+    GeoDataPlacemark world;
+
+    GeoGraphicsScene scene;
+    GeoGraphicsItem *const fijiItem = new TestGraphicsItem( &fiji, -15, -20, 179, 177 );
+    GeoGraphicsItem *const hawaiiItem = new TestGraphicsItem( &hawaii, 22, 19, -155, -160 );
+    GeoGraphicsItem *const worldItem = new TestGraphicsItem( &world, 80, -80, 170, -170 );
+    fijiItem->setMinZoomLevel( 8 );
+    hawaiiItem->setMinZoomLevel( 8 );
+    scene.addItem( fijiItem );
+    scene.addItem( hawaiiItem );
+    scene.addItem( worldItem );
+
+    // box from 170 degrees east to 150 degrees west
+    const GeoDataLatLonBox pacificBox( 30, -30, -150, 170, GeoDataCoordinates::Degree );
+    const QList<GeoGraphicsItem*> result = scene.items( pacificBox, 8 );
+
+    // every item is reported exactly once
+    QCOMPARE( result.size(), 3 );
+    QCOMPARE( result.count( fijiItem ), 1 );
+    QCOMPARE( result.count( hawaiiItem ), 1 );
+    QCOMPARE( result.count( worldItem ), 1 );
+}
+
+void GeoGraphicsSceneTest::minZoomLevel()
+{
+    GeoDataPlacemark city;
+
+    GeoGraphicsScene scene;
+    GeoGraphicsItem *const cityItem = new TestGraphicsItem( &city, 48.2, 48.1, 11.7, 11.5 );
+    cityItem->setMinZoomLevel( 12 );
+    scene.addItem( cityItem );
+
+    const GeoDataLatLonBox box( 50, 45, 15, 10, GeoDataCoordinates::Degree );
+    QVERIFY( scene.items( box, 11 ).isEmpty() );
+    QCOMPARE( scene.items( box, 12 ).size(), 1 );
+
+    cityItem->setVisible( false );
+    QVERIFY( scene.items( box, 12 ).isEmpty() );
+}
+
+void GeoGraphicsSceneTest::removeItem()
+{
+    GeoDataPlacemark first;
+    GeoDataPlacemark second;
+
+    GeoGraphicsScene scene;
+    GeoGraphicsItem *const firstItem = new TestGraphicsItem( &first, 10, 5, 10, 5 );
+    GeoGraphicsItem *const secondItem = new TestGraphicsItem( &second, 10, 5, 10, 5 );
+    firstItem->setMinZoomLevel( 6 );
+    secondItem->setMinZoomLevel( 6 );
+    scene.addItem( firstItem );
+    scene.addItem( secondItem );
+
+    const GeoDataLatLonBox box( 20, 0, 20, 0, GeoDataCoordinates::Degree );
+    QCOMPARE( scene.items( box, 6 ).size(), 2 );
+
+    scene.removeItem( &first );
+    const QList<GeoGraphicsItem*> result = scene.items( box, 6 );
+    QCOMPARE( result.size(), 1 );
+    QCOMPARE( result.first(), secondItem );
+
+    scene.removeItem( &second );
+    QVERIFY( scene.items( box, 6 ).isEmpty() );
+
+    // the scene can be filled again after its nodes have been pruned
+    GeoGraphicsItem *const thirdItem = new TestGraphicsItem( &first, 10, 5, 10, 5 );
+    thirdItem->setMinZoomLevel( 6 );
+    scene.addItem( thirdItem );
+    QCOMPARE( scene.items( box, 6 ).size(), 1 );
+}
+
+void GeoGraphicsSceneTest::clear()
+{
+    GeoDataPlacemark placemark;
+
+    GeoGraphicsScene scene;
+    scene.addItem( new TestGraphicsItem( &placemark, 10, 5, 10, 5 ) );
+
+    const GeoDataLatLonBox box( 20, 0, 20, 0, GeoDataCoordinates::Degree );
+    QCOMPARE( scene.items( box, 1 ).size(), 1 );
+
+    scene.clear();
+    QVERIFY( scene.items( box, 1 ).isEmpty() );
+}
+
+void GeoGraphicsSceneTest::sortedItems()
+{
+    GeoDataPlacemark road;
+    GeoDataPlacemark lake;
+    GeoDataPlacemark city;
+
+    GeoGraphicsScene scene;
+    GeoGraphicsItem *const roadItem = new DecoratedGraphicsItem( &road, 10, 5, 10, 5 );
+    GeoGraphicsItem *const lakeItem = new TestGraphicsItem( &lake, 10, 5, 10, 5 );
+    roadItem->setZValue( 3 );
+    lakeItem->setZValue( 1 );
+    roadItem->setMinZoomLevel( 6 );
+    lakeItem->setMinZoomLevel( 6 );
+    scene.addItem( roadItem );
+    scene.addItem( lakeItem );
+
+    const GeoDataLatLonBox box( 20, 0, 20, 0, GeoDataCoordinates::Degree );
+    QVector<GeoGraphicsItem*> result = scene.sortedItems( box, 6, false );
+    QCOMPARE( result.size(), 2 );
+    QCOMPARE( result.at( 0 ), lakeItem );
+    QCOMPARE( result.at( 1 ), roadItem );
+
+    // the outline of the road is painted right before the road
+    result = scene.sortedItems( box, 6, true );
+    QCOMPARE( result.size(), 3 );
+    QCOMPARE( result.at( 0 ), lakeItem );
+    QCOMPARE( result.at( 1 ), roadItem->decorations().first() );
+    QCOMPARE( result.at( 2 ), roadItem );
+
+    // the order is updated when items are added or removed
+    GeoGraphicsItem *const cityItem = new TestGraphicsItem( &city, 10, 5, 10, 5 );
+    cityItem->setZValue( 2 );
+    cityItem->setMinZoomLevel( 6 );
+    scene.addItem( cityItem );
+    scene.removeItem( &lake );
+
+    result = scene.sortedItems( box, 6, false );
+    QCOMPARE( result.size(), 2 );
+    QCOMPARE( result.at( 0 ), cityItem );
+    QCOMPARE( result.at( 1 ), roadItem );
+
+    // items are sorted in again when their z value changes
+    cityItem->setZValue( 4 );
+    result = scene.sortedItems( box, 6, false );
+    QCOMPARE( result.size(), 2 );
+    QCOMPARE( result.at( 0 ), roadItem );
+    QCOMPARE( result.at( 1 ), cityItem );
+
+    // items removed before they were sorted are left out
+    GeoDataPlacemark river;
+    GeoGraphicsItem *const riverItem = new TestGraphicsItem( &river, 10, 5, 10, 5 );
+    riverItem->setMinZoomLevel( 6 );
+    scene.addItem( riverItem );
+    scene.removeItem( &river );
+    QCOMPARE( scene.sortedItems( box, 6, false ).size(), 2 );
+
+    // items outside of the box or the zoom level are left out
+    QVERIFY( scene.sortedItems( box, 5, true ).isEmpty() );
+    const GeoDataLatLonBox otherBox( -10, -20, -10, -20, GeoDataCoordinates::Degree );
+    QVERIFY( scene.sortedItems( otherBox, 6, true ).isEmpty() );
+}
+
+}
+
+QTEST_MAIN( Marble::GeoGraphicsSceneTest )
+
+#include "GeoGraphicsSceneTest.moc"
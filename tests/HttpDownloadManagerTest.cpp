@@ -0,0 +1,143 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "HttpDownloadManager.h"
+#include "GeoDataLatLonBox.h"
+#include "MarbleGlobal.h"
+
+#include <QSignalSpy>
+#include <QTest>
+#include <QUrl>
+
+namespace Marble
+{
+
+class HttpDownloadManagerTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void browseJobOutOfSight();
+    void browseJobTooDetailed();
+    void bulkJobOutOfSight();
+    void bulkJobWaitsForBrowseJob();
+    void browseJobReturnsToSight();
+    void browseJobsDropped();
+
+ private:
+    static void addJob( HttpDownloadManager *manager, const QString &name, DownloadUsage usage,
+                        const GeoDataLatLonBox &tileLatLonBox, int tileZoomLevel );
+    static QList<QVariant> lastProgress( const QSignalSpy &spy );
+};
+
+// the viewport of all tests, showing tiles of level 5
+static const GeoDataLatLonBox viewport( 50.0, 40.0, 20.0, 0.0, GeoDataCoordinates::Degree );
+static const int viewportTileZoomLevel = 5;
+
+static const GeoDataLatLonBox visibleTile( 45.0, 40.0, 10.0, 0.0, GeoDataCoordinates::Degree );
+static const GeoDataLatLonBox hiddenTile( 45.0, 40.0, 110.0, 100.0, GeoDataCoordinates::Degree );
+
+void HttpDownloadManagerTest::addJob( HttpDownloadManager *manager, const QString &name, DownloadUsage usage,
+                                      const GeoDataLatLonBox &tileLatLonBox, int tileZoomLevel )
+{
+    const QUrl url( QString( "http://localhost/%1.png" ).arg( name ) );
+    manager->addJob( url, name, name, usage, tileLatLonBox, tileZoomLevel );
+}
+
+QList<QVariant> HttpDownloadManagerTest::lastProgress( const QSignalSpy &spy )
+{
+    return spy.isEmpty() ? QList<QVariant>() : spy.last();
+}
+
+void HttpDownloadManagerTest::browseJobOutOfSight()
+{
+    HttpDownloadManager manager( 0 );
+    manager.setViewport( viewport, viewportTileZoomLevel );
+    QSignalSpy progressSpy( &manager, SIGNAL(progressChanged(int,int)) );
+
+    addJob( &manager, "hidden", DownloadBrowse, hiddenTile, viewportTileZoomLevel );
+
+    // held back until the viewport returns to the tile, not waited for meanwhile
+    QCOMPARE( lastProgress( progressSpy ), QList<QVariant>() << 0 << 0 );
+}
+
+void HttpDownloadManagerTest::browseJobTooDetailed()
+{
+    HttpDownloadManager manager( 0 );
+    manager.setViewport( viewport, viewportTileZoomLevel );
+    QSignalSpy progressSpy( &manager, SIGNAL(progressChanged(int,int)) );
+
+    addJob( &manager, "detailed", DownloadBrowse, visibleTile, viewportTileZoomLevel + 1 );
+
+    QCOMPARE( lastProgress( progressSpy ), QList<QVariant>() << 0 << 0 );
+}
+
+void HttpDownloadManagerTest::bulkJobOutOfSight()
+{
+    HttpDownloadManager manager( 0 );
+    manager.setViewport( viewport, viewportTileZoomLevel );
+    QSignalSpy progressSpy( &manager, SIGNAL(progressChanged(int,int)) );
+
+    // tiles loaded in advance of the viewport, see VectorTileModel
+    addJob( &manager, "hidden", DownloadBulk, hiddenTile, viewportTileZoomLevel );
+    QCOMPARE( lastProgress( progressSpy ), QList<QVariant>() << 1 << 0 );
+
+    addJob( &manager, "detailed", DownloadBulk, visibleTile, viewportTileZoomLevel + 1 );
+    QCOMPARE( lastProgress( progressSpy ), QList<QVariant>() << 2 << 0 );
+}
+
+void HttpDownloadManagerTest::bulkJobWaitsForBrowseJob()
+{
+    HttpDownloadManager manager( 0 );
+    manager.setViewport( viewport, viewportTileZoomLevel );
+    QSignalSpy progressSpy( &manager, SIGNAL(progressChanged(int,int)) );
+
+    addJob( &manager, "visible", DownloadBrowse, visibleTile, viewportTileZoomLevel );
+    QCOMPARE( lastProgress( progressSpy ), QList<QVariant>() << 1 << 0 );
+
+    addJob( &manager, "hidden", DownloadBulk, hiddenTile, viewportTileZoomLevel );
+    QCOMPARE( lastProgress( progressSpy ), QList<QVariant>() << 0 << 1 );
+}
+
+}
+
+void HttpDownloadManagerTest::browseJobReturnsToSight()
+{
+    HttpDownloadManager manager( 0 );
+    manager.setViewport( viewport, viewportTileZoomLevel );
+    QSignalSpy progressSpy( &manager, SIGNAL(progressChanged(int,int)) );
+
+    addJob( &manager, "hidden", DownloadBrowse, hiddenTile, viewportTileZoomLevel );
+    QCOMPARE( lastProgress( progressSpy ), QList<QVariant>() << 0 << 0 );
+
+    manager.setViewport( hiddenTile, viewportTileZoomLevel );
+    QCOMPARE( lastProgress( progressSpy ), QList<QVariant>() << 1 << 0 );
+}
+
+void HttpDownloadManagerTest::browseJobsDropped()
+{
+    HttpDownloadManager manager( 0 );
+    manager.setViewport( viewport, viewportTileZoomLevel );
+    QSignalSpy droppedSpy( &manager, SIGNAL(downloadDropped(QString)) );
+
+    // one more than the held back jobs that are kept
+    for ( int i = 0; i <= 1000; ++i ) {
+        addJob( &manager, QString( "hidden%1" ).arg( i ), DownloadBrowse, hiddenTile, viewportTileZoomLevel );
+    }
+    QCOMPARE( droppedSpy.count(), 0 );
+
+    manager.setViewport( viewport, viewportTileZoomLevel );
+
+    // the oldest one is dropped and needs to be requested again
+    QCOMPARE( droppedSpy.count(), 1 );
+    QCOMPARE( droppedSpy.first().first().toString(), QString( "hidden0" ) );
+}
+
+QTEST_MAIN( Marble::HttpDownloadManagerTest )
+
+#include "HttpDownloadManagerTest.moc"
@@ -0,0 +1,114 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "JobGroup.h"
+
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QTest>
+#include <QThreadPool>
+
+namespace Marble
+{
+
+class CountingJob : public QRunnable
+{
+ public:
+    explicit CountingJob( QAtomicInt *counter ) : m_counter( counter ) {}
+
+    virtual void run() { m_counter->ref(); }
+
+ private:
+    QAtomicInt *const m_counter;
+};
+
+class BlockingJob : public QRunnable
+{
+ public:
+    explicit BlockingJob( QSemaphore *semaphore ) : m_semaphore( semaphore ) {}
+
+    virtual void run() { m_semaphore->acquire(); }
+
+ private:
+    QSemaphore *const m_semaphore;
+};
+
+class JobGroupTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void waitForDone();
+    void otherClientsAreNotAwaited();
+    void saturatedPool();
+};
+
+void JobGroupTest::waitForDone()
+{
+    QThreadPool threadPool;
+    QAtomicInt counter;
+
+    JobGroup jobs( &threadPool );
+    for ( int i = 0; i < 100; ++i ) {
+        jobs.start( new CountingJob( &counter ) );
+    }
+    jobs.waitForDone();
+
+    QCOMPARE( counter.load(), 100 );
+}
+
+void JobGroupTest::otherClientsAreNotAwaited()
+{
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount( 2 );
+
+    // occupies one thread of the pool until it is released below
+    QSemaphore semaphore;
+    threadPool.start( new BlockingJob( &semaphore ) );
+
+    QAtomicInt counter;
+    JobGroup jobs( &threadPool );
+    for ( int i = 0; i < 10; ++i ) {
+        jobs.start( new CountingJob( &counter ) );
+    }
+    jobs.waitForDone();
+
+    QCOMPARE( counter.load(), 10 );
+
+    semaphore.release();
+    threadPool.waitForDone();
+}
+
+void JobGroupTest::saturatedPool()
+{
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount( 1 );
+
+    QSemaphore semaphore;
+    threadPool.start( new BlockingJob( &semaphore ) );
+
+    // none of the jobs can be run by the pool, so they are run by waitForDone()
+    QAtomicInt counter;
+    JobGroup jobs( &threadPool );
+    for ( int i = 0; i < 10; ++i ) {
+        jobs.start( new CountingJob( &counter ) );
+    }
+    jobs.waitForDone();
+
+    QCOMPARE( counter.load(), 10 );
+
+    semaphore.release();
+    threadPool.waitForDone();
+}
+
+}
+
+QTEST_MAIN( Marble::JobGroupTest )
+
+#include "JobGroupTest.moc"
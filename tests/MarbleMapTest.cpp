@@ -11,6 +11,8 @@
 #include "GeoPainter.h"
 #include "MarbleMap.h"
 #include "MarbleModel.h"
+#include "TextureLayer.h"
+#include "TileId.h"
 #include "TestUtils.h"
 
 #include <QThreadPool>
@@ -66,7 +68,18 @@ class MarbleMapTest : public QObject
     void paint_data();
     void paint();
 
+    void asynchronousLoading();
+
+    void scrollTexture_data();
+    void scrollTexture();
+
+    void updateTextureTile_data();
+    void updateTextureTile();
+
  private:
+    static MarbleMap *createTextureMap( MarbleModel *model, Projection projection );
+    static int countDifferentPixels( const QImage &image1, const QImage &image2 );
+
     MarbleModel m_model;
 };
 
@@ -594,6 +607,175 @@ void MarbleMapTest::paint()
     QThreadPool::globalInstance()->waitForDone();  // wait for all runners to terminate
 }
 
+void MarbleMapTest::asynchronousLoading()
+{
+    QImage image( QSize( 200, 200 ), QImage::Format_ARGB32_Premultiplied );
+
+    MarbleMap map;
+    map.setMapThemeId( "earth/srtm/srtm.dgml" );
+    map.setSize( image.size() );
+    QVERIFY( !map.textureLayer()->asynchronousLoading() );
+
+    map.setViewContext( Animation );
+    QVERIFY( map.textureLayer()->asynchronousLoading() );
+
+    {
+        GeoPainter painter( &image, map.viewport(), map.mapQuality() );
+        map.paint( painter, QRect() );
+
+        // the tiles of the next level are scaled up from the ones in memory
+        map.setRadius( 4 * map.radius() );
+        map.paint( painter, QRect() );
+    }
+
+    map.setViewContext( Still );
+    QVERIFY( !map.textureLayer()->asynchronousLoading() );
+
+    {
+        GeoPainter painter( &image, map.viewport(), map.mapQuality() );
+        map.paint( painter, QRect() );
+    }
+
+    QThreadPool::globalInstance()->waitForDone();  // wait for all runners to terminate
+}
+
+MarbleMap *MarbleMapTest::createTextureMap( MarbleModel *model, Projection projection )
+{
+    MarbleMap *const map = new MarbleMap( model );
+    map->setMapThemeId( "earth/bluemarble/bluemarble.dgml" );
+    map->setProjection( projection );
+    map->setSize( 200, 200 );
+    map->setRadius( 256 );
+    map->centerOn( 0.0, 0.0 );
+    map->setShowClouds( false );
+    map->setMapQualityForViewContext( PrintQuality, Still );
+
+    return map;
+}
+
+int MarbleMapTest::countDifferentPixels( const QImage &image1, const QImage &image2 )
+{
+    int count = 0;
+    for ( int y = 0; y < image1.height(); ++y ) {
+        for ( int x = 0; x < image1.width(); ++x ) {
+            if ( image1.pixel( x, y ) != image2.pixel( x, y ) ) {
+                ++count;
+            }
+        }
+    }
+
+    return count;
+}
+
+void MarbleMapTest::scrollTexture_data()
+{
+    QTest::addColumn<int>( "projection" );
+    QTest::addColumn<int>( "dx" );
+    QTest::addColumn<qreal>( "lat" );
+
+    addRow() << int( Equirectangular ) << 10 << 0.0;
+    addRow() << int( Equirectangular ) << -37 << 0.0;
+    addRow() << int( Equirectangular ) << 0 << 20.0;
+    addRow() << int( Equirectangular ) << 23 << -35.0;
+    addRow() << int( Mercator ) << 10 << 0.0;
+    addRow() << int( Mercator ) << -37 << 0.0;
+    addRow() << int( Mercator ) << 0 << 20.0;
+    addRow() << int( Mercator ) << 23 << -35.0;
+}
+
+void MarbleMapTest::scrollTexture()
+{
+    QFETCH( int, projection );
+    QFETCH( int, dx );
+    QFETCH( qreal, lat );
+
+    QScopedPointer<MarbleMap> map( createTextureMap( &m_model, Projection( projection ) ) );
+
+    QImage scrolled( map->size(), QImage::Format_ARGB32_Premultiplied );
+    QImage repainted( map->size(), QImage::Format_ARGB32_Premultiplied );
+    scrolled.fill( Qt::transparent );
+    repainted.fill( Qt::transparent );
+
+    {
+        GeoPainter painter( &scrolled, map->viewport(), PrintQuality );
+        map->paint( painter, QRect() );
+    }
+
+    // at a radius of 256 pixels, one pixel corresponds to 180 / 512 degrees,
+    // so the canvas is moved by whole pixels
+    map->centerOn( -dx * 180.0 / 512, lat );
+
+    {
+        GeoPainter painter( &scrolled, map->viewport(), PrintQuality );
+        map->paint( painter, QRect() );
+    }
+
+    map->textureLayer()->setNeedsUpdate();
+
+    {
+        GeoPainter painter( &repainted, map->viewport(), PrintQuality );
+        map->paint( painter, QRect() );
+    }
+
+    // the rendering of the partial areas may differ by single pixels at their edges
+    QVERIFY( countDifferentPixels( scrolled, repainted ) <= scrolled.width() * scrolled.height() / 100 );
+
+    QThreadPool::globalInstance()->waitForDone();  // wait for all runners to terminate
+}
+
+void MarbleMapTest::updateTextureTile_data()
+{
+    QTest::addColumn<int>( "projection" );
+
+    addRow() << int( Equirectangular );
+    addRow() << int( Mercator );
+}
+
+void MarbleMapTest::updateTextureTile()
+{
+    QFETCH( int, projection );
+
+    QScopedPointer<MarbleMap> map( createTextureMap( &m_model, Projection( projection ) ) );
+
+    QImage updated( map->size(), QImage::Format_ARGB32_Premultiplied );
+    QImage repainted( map->size(), QImage::Format_ARGB32_Premultiplied );
+    updated.fill( Qt::transparent );
+    repainted.fill( Qt::transparent );
+
+    {
+        GeoPainter painter( &updated, map->viewport(), PrintQuality );
+        map->paint( painter, QRect() );
+    }
+
+    // replace the tile east of the center by a plain one, which is only
+    // rendered if the area of the tile is repainted completely
+    const int level = map->textureLayer()->tileZoomLevel();
+    const TileId tileId( "earth/bluemarble", level,
+                         map->textureLayer()->tileColumnCount( level ) / 2,
+                         map->textureLayer()->tileRowCount( level ) / 2 );
+    QImage tileImage( map->textureLayer()->tileSize(), QImage::Format_ARGB32 );
+    tileImage.fill( qRgb( 255, 0, 0 ) );
+
+    QVERIFY( QMetaObject::invokeMethod( map->textureLayer(), "updateTile", Qt::DirectConnection,
+                                        Q_ARG( TileId, tileId ), Q_ARG( QImage, tileImage ) ) );
+
+    {
+        GeoPainter painter( &updated, map->viewport(), PrintQuality );
+        map->paint( painter, QRect() );
+    }
+
+    map->textureLayer()->setNeedsUpdate();
+
+    {
+        GeoPainter painter( &repainted, map->viewport(), PrintQuality );
+        map->paint( painter, QRect() );
+    }
+
+    QVERIFY( countDifferentPixels( updated, repainted ) <= updated.width() * updated.height() / 100 );
+
+    QThreadPool::globalInstance()->waitForDone();  // wait for all runners to terminate
+}
+
 }
 
 QTEST_MAIN( Marble::MarbleMapTest )
@@ -0,0 +1,81 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include <QTest>
+
+#include "routing/Route.h"
+
+namespace Marble
+{
+
+class RouteTest : public QObject
+{
+    Q_OBJECT
+
+ private Q_SLOTS:
+    void initTestCase();
+    void position();
+    void closestPathPoint();
+
+ private:
+    Route m_route;
+};
+
+void RouteTest::initTestCase()
+{
+    // east along the equator, then north
+    GeoDataLineString east;
+    GeoDataLineString north;
+    for ( int i = 0; i <= 100; ++i ) {
+        east << GeoDataCoordinates( i * 0.1, 0.0, 0.0, GeoDataCoordinates::Degree );
+        north << GeoDataCoordinates( 10.0, i * 0.1, 0.0, GeoDataCoordinates::Degree );
+    }
+
+    RouteSegment eastSegment;
+    eastSegment.setPath( east );
+    m_route.addRouteSegment( eastSegment );
+
+    RouteSegment northSegment;
+    northSegment.setPath( north );
+    m_route.addRouteSegment( northSegment );
+}
+
+void RouteTest::position()
+{
+    m_route.setPosition( GeoDataCoordinates( 5.05, 0.01, 0.0, GeoDataCoordinates::Degree ) );
+    QCOMPARE( m_route.currentSegment(), m_route.at( 0 ) );
+    QCOMPARE( m_route.positionOnRoute().longitude( GeoDataCoordinates::Degree ), 5.05 );
+    QCOMPARE( m_route.positionOnRoute().latitude( GeoDataCoordinates::Degree ) + 1.0, 1.0 );
+    QCOMPARE( m_route.currentWaypoint(), m_route.path().at( 51 ) );
+
+    m_route.setPosition( GeoDataCoordinates( 10.01, 5.05, 0.0, GeoDataCoordinates::Degree ) );
+    QCOMPARE( m_route.currentSegment(), m_route.at( 1 ) );
+    QCOMPARE( m_route.positionOnRoute().longitude( GeoDataCoordinates::Degree ), 10.0 );
+    QCOMPARE( m_route.positionOnRoute().latitude( GeoDataCoordinates::Degree ), 5.05 );
+
+    // far away from the previous position
+    m_route.setPosition( GeoDataCoordinates( 1.0, -0.5, 0.0, GeoDataCoordinates::Degree ) );
+    QCOMPARE( m_route.currentSegment(), m_route.at( 0 ) );
+    QCOMPARE( m_route.positionOnRoute().longitude( GeoDataCoordinates::Degree ), 1.0 );
+}
+
+void RouteTest::closestPathPoint()
+{
+    QCOMPARE( m_route.closestPathPoint( GeoDataCoordinates( 3.0, 0.2, 0.0, GeoDataCoordinates::Degree ) ), 30 );
+    QCOMPARE( m_route.closestPathPoint( GeoDataCoordinates( 10.5, 5.0, 0.0, GeoDataCoordinates::Degree ) ), 151 );
+
+    // points before the given one are ignored
+    QCOMPARE( m_route.closestPathPoint( GeoDataCoordinates( 0.0, 0.0, 0.0, GeoDataCoordinates::Degree ), 120 ), 120 );
+    QCOMPARE( m_route.closestPathPoint( GeoDataCoordinates( 0.0, 0.0, 0.0, GeoDataCoordinates::Degree ), 300 ), -1 );
+}
+
+}
+
+QTEST_MAIN( Marble::RouteTest )
+
+#include "RouteTest.moc"
@@ -0,0 +1,179 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "ScanlineKernels.h"
+#include "MarbleGlobal.h"
+#include "TestUtils.h"
+
+#include <QVector>
+
+namespace Marble
+{
+
+class ScanlineKernelsTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void sphericalCoordinates_data();
+    void sphericalCoordinates();
+
+    void tilePositions_data();
+    void tilePositions();
+
+    void benchmarkSphericalCoordinates();
+    void benchmarkSphericalCoordinatesScalar();
+
+ private:
+    static QVector<qreal> scanLine( int width );
+};
+
+QVector<qreal> ScanlineKernelsTest::scanLine( int width )
+{
+    // all points of a scanline of a globe filling the width, including the
+    // ones right at and slightly beyond the horizon
+    QVector<qreal> qx( width );
+    for ( int x = 0; x < width; ++x ) {
+        qx[x] = (qreal)( x - width / 2 ) / ( width / 2 );
+    }
+
+    return qx;
+}
+
+void ScanlineKernelsTest::sphericalCoordinates_data()
+{
+    QTest::addColumn<qreal>( "pitch" );
+    QTest::addColumn<qreal>( "yaw" );
+    QTest::addColumn<qreal>( "qy" );
+
+    addRow() << qreal(0.0) << qreal(0.0) << qreal(0.0);
+    addRow() << qreal(0.0) << qreal(0.0) << qreal(0.5);
+    addRow() << qreal(0.3) << qreal(-2.0) << qreal(-0.3);
+    addRow() << qreal(M_PI / 2) << qreal(1.0) << qreal(0.1);   // north pole in the center
+    addRow() << qreal(-M_PI / 2) << qreal(3.0) << qreal(-0.9); // south pole in the center
+    addRow() << qreal(1.2) << qreal(M_PI) << qreal(0.999);     // dateline, close to the horizon
+    addRow() << qreal(-0.7) << qreal(0.5) << qreal(1.0);
+}
+
+void ScanlineKernelsTest::sphericalCoordinates()
+{
+    QFETCH( qreal, pitch );
+    QFETCH( qreal, yaw );
+    QFETCH( qreal, qy );
+
+    matrix planetAxisMatrix;
+    Quaternion::fromEuler( pitch, yaw, 0.0 ).toMatrix( planetAxisMatrix );
+
+    // odd count to cover the remainder of the SIMD loop as well
+    const QVector<qreal> qx = scanLine( 257 );
+    QVector<qreal> lon( qx.size() );
+    QVector<qreal> lat( qx.size() );
+    QVector<qreal> scalarLon( qx.size() );
+    QVector<qreal> scalarLat( qx.size() );
+
+    Marble::sphericalCoordinates( qx.constData(), qx.size(), qy, planetAxisMatrix,
+                                  lon.data(), lat.data() );
+    sphericalCoordinatesScalar( qx.constData(), qx.size(), qy, planetAxisMatrix,
+                                scalarLon.data(), scalarLat.data() );
+
+    for ( int i = 0; i < qx.size(); ++i ) {
+        QFUZZYCOMPARE( lon[i], scalarLon[i], 1e-12 );
+        QFUZZYCOMPARE( lat[i], scalarLat[i], 1e-12 );
+    }
+
+    // the scalar path agrees with rotating each point on the globe individually
+    const qreal qr = 1.0 - qy * qy;
+    for ( int i = 0; i < qx.size(); ++i ) {
+        const qreal qr2z = qr - qx[i] * qx[i];
+        if ( qr2z <= 0.0 ) {
+            continue;
+        }
+
+        Quaternion q( 0.0, qx[i], qy, sqrt( qr2z ) );
+        q.rotateAroundAxis( planetAxisMatrix );
+
+        if ( q.v[Q_X] * q.v[Q_X] + q.v[Q_Z] * q.v[Q_Z] <= 0.00005 ) {
+            continue;
+        }
+
+        qreal expectedLon;
+        qreal expectedLat;
+        q.getSpherical( expectedLon, expectedLat );
+
+        QFUZZYCOMPARE( scalarLon[i], expectedLon, 1e-9 );
+        QFUZZYCOMPARE( scalarLat[i], expectedLat, 1e-6 );
+    }
+}
+
+void ScanlineKernelsTest::tilePositions_data()
+{
+    QTest::addColumn<int>( "start" );
+    QTest::addColumn<int>( "step" );
+    QTest::addColumn<int>( "offset" );
+    QTest::addColumn<int>( "shift" );
+    QTest::addColumn<int>( "count" );
+
+    addRow() << 0 << 128 << 0 << 0 << 15;
+    addRow() << 1000 << 77 << 256 << 1 << 16;
+    addRow() << 32000 << -95 << 0 << 2 << 31;
+    addRow() << 5 << 0 << 3 << 0 << 1;
+    addRow() << 700 << 3 << 10 << 3 << 47;
+}
+
+void ScanlineKernelsTest::tilePositions()
+{
+    QFETCH( int, start );
+    QFETCH( int, step );
+    QFETCH( int, offset );
+    QFETCH( int, shift );
+    QFETCH( int, count );
+
+    QVector<int> position( count );
+    QVector<int> scalarPosition( count );
+
+    Marble::tilePositions( start, step, offset, shift, count, position.data() );
+    tilePositionsScalar( start, step, offset, shift, count, scalarPosition.data() );
+
+    QCOMPARE( position, scalarPosition );
+}
+
+void ScanlineKernelsTest::benchmarkSphericalCoordinates()
+{
+    matrix planetAxisMatrix;
+    Quaternion::fromEuler( 0.3, -2.0, 0.0 ).toMatrix( planetAxisMatrix );
+
+    const QVector<qreal> qx = scanLine( 1024 );
+    QVector<qreal> lon( qx.size() );
+    QVector<qreal> lat( qx.size() );
+
+    QBENCHMARK {
+        Marble::sphericalCoordinates( qx.constData(), qx.size(), 0.3, planetAxisMatrix,
+                                      lon.data(), lat.data() );
+    }
+}
+
+void ScanlineKernelsTest::benchmarkSphericalCoordinatesScalar()
+{
+    matrix planetAxisMatrix;
+    Quaternion::fromEuler( 0.3, -2.0, 0.0 ).toMatrix( planetAxisMatrix );
+
+    const QVector<qreal> qx = scanLine( 1024 );
+    QVector<qreal> lon( qx.size() );
+    QVector<qreal> lat( qx.size() );
+
+    QBENCHMARK {
+        sphericalCoordinatesScalar( qx.constData(), qx.size(), 0.3, planetAxisMatrix,
+                                    lon.data(), lat.data() );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::ScanlineKernelsTest )
+
+#include "ScanlineKernelsTest.moc"
@@ -0,0 +1,229 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "CacheDocument.h"
+#include "CacheFile.h"
+
+#include "GeoDataExtendedData.h"
+#include "GeoDataLatLonBox.h"
+#include "GeoDataPlacemark.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace Marble;
+
+class TestCacheFile : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void roundTrip();
+    void populationOrder();
+    void box_data();
+    void box();
+    void tiles();
+    void createPlacemarks();
+
+private:
+    static GeoDataPlacemark *city( const QString &name, qreal lon, qreal lat, qint64 population );
+    static QStringList names( const QVector<GeoDataPlacemark*> &placemarks );
+
+    QTemporaryDir m_dir;
+    QString m_fileName;
+    QVector<GeoDataPlacemark*> m_cities;
+};
+
+GeoDataPlacemark *TestCacheFile::city( const QString &name, qreal lon, qreal lat, qint64 population )
+{
+    GeoDataPlacemark *placemark = new GeoDataPlacemark( name );
+    placemark->setCoordinate( lon, lat, 0.0, GeoDataCoordinates::Degree );
+    placemark->setPopulation( population );
+    return placemark;
+}
+
+QStringList TestCacheFile::names( const QVector<GeoDataPlacemark*> &placemarks )
+{
+    QStringList result;
+    foreach ( const GeoDataPlacemark *placemark, placemarks ) {
+        result << placemark->name();
+    }
+    result.sort();
+    return result;
+}
+
+void TestCacheFile::initTestCase()
+{
+    QVERIFY( m_dir.isValid() );
+    m_fileName = m_dir.path() + "/test.cache";
+
+    GeoDataPlacemark *berlin = city( "Berlin", 13.4, 52.5, 3500000 );
+    berlin->setCoordinate( 13.4, 52.5, 34.0, GeoDataCoordinates::Degree );
+    berlin->setRole( "PPLC" );
+    berlin->setDescription( QString::fromUtf8( "Hauptstadt, größte Stadt" ) );
+    berlin->setCountryCode( "DE" );
+    berlin->setState( "Berlin" );
+    berlin->setArea( 891.8 );
+    berlin->extendedData().addValue( GeoDataData( "gmt", 100 ) );
+    berlin->extendedData().addValue( GeoDataData( "dst", 1 ) );
+
+    GeoDataPlacemark *potsdam = city( "Potsdam", 13.07, 52.4, 170000 );
+    potsdam->setRole( "PPLA" );
+    potsdam->setCountryCode( "DE" );
+    potsdam->setState( "Brandenburg" );
+
+    GeoDataPlacemark *honolulu = city( "Honolulu", -157.86, 21.3, 350000 );
+    honolulu->setCountryCode( "US" );
+    honolulu->extendedData().addValue( GeoDataData( "gmt", -1000 ) );
+    honolulu->extendedData().addValue( GeoDataData( "dst", -1 ) );
+
+    m_cities << berlin << potsdam << honolulu
+             << city( "Suva", 178.44, -18.14, 85000 )
+             << city( "Apia", -171.76, -13.83, 37000 )
+             << city( "Lambarene", 10.24, -0.7, 25000 )
+             << city( "Nuuk", -51.7, 64.2, 17000 );
+
+    QVector<const GeoDataPlacemark*> placemarks;
+    foreach ( const GeoDataPlacemark *placemark, m_cities ) {
+        placemarks << placemark;
+    }
+    QVERIFY( CacheFile::write( m_fileName, placemarks ) );
+}
+
+void TestCacheFile::cleanupTestCase()
+{
+    qDeleteAll( m_cities );
+}
+
+void TestCacheFile::roundTrip()
+{
+    CacheFile cacheFile( m_fileName );
+    QString error;
+    QVERIFY2( cacheFile.open( error ), qPrintable( error ) );
+    QCOMPARE( cacheFile.size(), m_cities.size() );
+
+    const QVector<GeoDataPlacemark*> placemarks = cacheFile.placemarks();
+    QCOMPARE( names( placemarks ), names( m_cities ) );
+
+    foreach ( const GeoDataPlacemark *expected, m_cities ) {
+        const GeoDataPlacemark *placemark = 0;
+        foreach ( const GeoDataPlacemark *candidate, placemarks ) {
+            if ( candidate->name() == expected->name() ) {
+                placemark = candidate;
+            }
+        }
+        QVERIFY( placemark );
+        QCOMPARE( placemark->coordinate(), expected->coordinate() );
+        QCOMPARE( placemark->coordinate().altitude(), expected->coordinate().altitude() );
+        QCOMPARE( placemark->role(), expected->role() );
+        QCOMPARE( placemark->description(), expected->description() );
+        QCOMPARE( placemark->countryCode(), expected->countryCode() );
+        QCOMPARE( placemark->state(), expected->state() );
+        QCOMPARE( placemark->area(), expected->area() );
+        QCOMPARE( placemark->population(), expected->population() );
+        QCOMPARE( placemark->extendedData().value( "gmt" ).value().toInt(),
+                  expected->extendedData().value( "gmt" ).value().toInt() );
+        QCOMPARE( placemark->extendedData().value( "dst" ).value().toInt(),
+                  expected->extendedData().value( "dst" ).value().toInt() );
+    }
+
+    qDeleteAll( placemarks );
+}
+
+void TestCacheFile::populationOrder()
+{
+    CacheFile cacheFile( m_fileName );
+    QString error;
+    QVERIFY2( cacheFile.open( error ), qPrintable( error ) );
+
+    // Potsdam is in the same tile as Berlin and written first
+    const GeoDataLatLonBox box( 53.0, 52.0, 14.0, 13.0, GeoDataCoordinates::Degree );
+    const QVector<GeoDataPlacemark*> placemarks = cacheFile.placemarks( box );
+    QCOMPARE( placemarks.size(), 2 );
+    QCOMPARE( placemarks.at( 0 )->name(), QString( "Berlin" ) );
+    QCOMPARE( placemarks.at( 1 )->name(), QString( "Potsdam" ) );
+    qDeleteAll( placemarks );
+}
+
+void TestCacheFile::box_data()
+{
+    QTest::addColumn<GeoDataLatLonBox>( "box" );
+    QTest::addColumn<QStringList>( "expected" );
+
+    QTest::newRow( "Berlin" )
+            << GeoDataLatLonBox( 53.0, 52.45, 14.0, 13.0, GeoDataCoordinates::Degree )
+            << ( QStringList() << "Berlin" );
+    QTest::newRow( "Europe and Africa" )
+            << GeoDataLatLonBox( 60.0, -10.0, 20.0, 0.0, GeoDataCoordinates::Degree )
+            << ( QStringList() << "Berlin" << "Lambarene" << "Potsdam" );
+    QTest::newRow( "date line" )
+            << GeoDataLatLonBox( 0.0, -30.0, -170.0, 170.0, GeoDataCoordinates::Degree )
+            << ( QStringList() << "Apia" << "Suva" );
+    // both edges of the box are in the same column of the index
+    QTest::newRow( "date line, all around" )
+            << GeoDataLatLonBox( 70.0, -30.0, 178.0, 179.0, GeoDataCoordinates::Degree )
+            << ( QStringList() << "Apia" << "Berlin" << "Honolulu" << "Lambarene" << "Nuuk" << "Potsdam" );
+    QTest::newRow( "whole globe" )
+            << GeoDataLatLonBox( 90.0, -90.0, 180.0, -180.0, GeoDataCoordinates::Degree )
+            << ( QStringList() << "Apia" << "Berlin" << "Honolulu" << "Lambarene" << "Nuuk" << "Potsdam" << "Suva" );
+}
+
+void TestCacheFile::box()
+{
+    QFETCH( GeoDataLatLonBox, box );
+    QFETCH( QStringList, expected );
+
+    CacheFile cacheFile( m_fileName );
+    QString error;
+    QVERIFY2( cacheFile.open( error ), qPrintable( error ) );
+
+    const QVector<GeoDataPlacemark*> placemarks = cacheFile.placemarks( box );
+    QCOMPARE( names( placemarks ), expected );
+    qDeleteAll( placemarks );
+}
+
+void TestCacheFile::tiles()
+{
+    // Berlin and Potsdam are in tile 3 * 32 + 17
+    QCOMPARE( CacheFile::tiles( GeoDataLatLonBox( 53.0, 52.45, 14.0, 13.0, GeoDataCoordinates::Degree ) ),
+              QVector<int>() << 113 );
+
+    const QVector<int> dateLine = CacheFile::tiles( GeoDataLatLonBox( 0.0, -10.0, -170.0, 170.0, GeoDataCoordinates::Degree ) );
+    QCOMPARE( dateLine, QVector<int>() << 8 * 32 + 31 << 8 * 32 + 0 );
+
+    const QVector<int> globe = CacheFile::tiles( GeoDataLatLonBox( 90.0, -90.0, 180.0, -180.0, GeoDataCoordinates::Degree ) );
+    QCOMPARE( globe.size(), CacheFile::tileCount() );
+}
+
+void TestCacheFile::createPlacemarks()
+{
+    CacheDocument document( m_fileName );
+    QString error;
+    QVERIFY2( document.open( error ), qPrintable( error ) );
+    QCOMPARE( document.size(), 0 );
+
+    // whole tiles are created, Potsdam is outside of the box
+    const GeoDataLatLonBox berlin( 53.0, 52.45, 14.0, 13.0, GeoDataCoordinates::Degree );
+    QVector<GeoDataPlacemark*> placemarks = document.createPlacemarks( berlin );
+    QCOMPARE( names( placemarks ), QStringList() << "Berlin" << "Potsdam" );
+    qDeleteAll( placemarks );
+
+    QVERIFY( document.createPlacemarks( berlin ).isEmpty() );
+
+    // only the tiles not created before
+    const GeoDataLatLonBox europeAndAfrica( 60.0, -10.0, 20.0, 0.0, GeoDataCoordinates::Degree );
+    placemarks = document.createPlacemarks( europeAndAfrica );
+    QCOMPARE( names( placemarks ), QStringList() << "Lambarene" );
+    qDeleteAll( placemarks );
+}
+
+QTEST_MAIN( TestCacheFile )
+
+#include "TestCacheFile.moc"
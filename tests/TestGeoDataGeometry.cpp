@@ -26,6 +26,8 @@ private slots:
     void deleteAndDetachTest1();
     void deleteAndDetachTest2();
     void deleteAndDetachTest3();
+    void compactTest();
+    void resolvedNodesTest();
 };
 
 void TestGeoDataGeometry::downcastPointTest_data()
@@ -85,6 +87,98 @@ void TestGeoDataGeometry::deleteAndDetachTest3()
     line2 << GeoDataCoordinates();
 }
 
+void TestGeoDataGeometry::compactTest()
+{
+    GeoDataLineString line1;
+    line1 << GeoDataCoordinates( 10, 50, 0, GeoDataCoordinates::Degree );
+    line1 << GeoDataCoordinates( 12, 52, 0, GeoDataCoordinates::Degree, 3 );
+    line1 << GeoDataCoordinates( 14, 48, 250, GeoDataCoordinates::Degree );
+    const GeoDataLineString original = line1;
+    const GeoDataLatLonAltBox box = line1.latLonAltBox();
+
+    line1.compact();
+    QVERIFY( line1.isCompact() );
+    QVERIFY( !original.isCompact() );
+    QCOMPARE( line1.size(), 3 );
+    QVERIFY( !line1.isEmpty() );
+    QVERIFY( line1.latLonAltBox() == box );
+
+    // copies share the compact nodes
+    GeoDataLineString line2 = line1;
+    QVERIFY( line2.isCompact() );
+
+    QVERIFY( line1 == original );
+    QVERIFY( !line1.isCompact() );
+    QCOMPARE( line1.at( 1 ).detail(), 3 );
+    QCOMPARE( line1.last().altitude(), 250.0 );
+
+    line2 << GeoDataCoordinates( 16, 46, 0, GeoDataCoordinates::Degree );
+    QVERIFY( !line2.isCompact() );
+    QCOMPARE( line2.size(), 4 );
+    QCOMPARE( line1.size(), 3 );
+
+    GeoDataLineString line3 = original;
+    line3.compact( GeoDataLineString::SinglePrecision );
+    QCOMPARE( line3.size(), 3 );
+    for ( int i = 0; i < line3.size(); ++i ) {
+        QVERIFY( qAbs( line3.at( i ).longitude() - original.at( i ).longitude() ) < 1e-6 );
+        QVERIFY( qAbs( line3.at( i ).latitude() - original.at( i ).latitude() ) < 1e-6 );
+        QCOMPARE( line3.at( i ).altitude(), original.at( i ).altitude() );
+    }
+
+    GeoDataLinearRing ring;
+    ring << GeoDataCoordinates( 10, 50, 0, GeoDataCoordinates::Degree );
+    ring << GeoDataCoordinates( 12, 52, 0, GeoDataCoordinates::Degree );
+    ring << GeoDataCoordinates( 14, 48, 0, GeoDataCoordinates::Degree );
+    ring.compact();
+    QVERIFY( ring.isCompact() );
+    QVERIFY( ring.isClosed() );
+    QCOMPARE( ring.size(), 3 );
+}
+
+void TestGeoDataGeometry::resolvedNodesTest()
+{
+    // nodes 0.1 degree apart, every other node lies within the resolution
+    // of the previous one
+    GeoDataLineString line;
+    for ( int i = 0; i < 20; ++i ) {
+        line << GeoDataCoordinates( i * 0.1 + ( i / 2 ) * 0.5, 10, 0, GeoDataCoordinates::Degree );
+    }
+    const qreal resolution = 0.2 * DEG2RAD;
+
+    GeoDataLineString regular;
+    line.resolvedNodes( resolution, 0, regular );
+    QCOMPARE( regular.size(), 10 );
+
+    GeoDataLineString compactLine = line;
+    compactLine.compact();
+    GeoDataLineString compact;
+    compactLine.resolvedNodes( resolution, 0, compact );
+    QVERIFY( compactLine.isCompact() );
+    QVERIFY( compact == regular );
+
+    // short line strings are not reduced
+    GeoDataLineString shortLine;
+    shortLine << line.at( 0 ) << line.at( 1 ) << line.at( 2 );
+    shortLine.compact();
+    shortLine.resolvedNodes( resolution, 0, compact );
+    QCOMPARE( compact.size(), 3 );
+
+    // nodes with detail levels are filtered by the maximum detail
+    GeoDataLineString detailed;
+    for ( int i = 0; i < 12; ++i ) {
+        detailed << GeoDataCoordinates( i, 10, 0, GeoDataCoordinates::Degree, i % 2 ? 11 : 5 );
+    }
+    detailed.resolvedNodes( 0.0, 9, regular );
+    QCOMPARE( regular.size(), 6 );
+
+    detailed.compact();
+    detailed.resolvedNodes( 0.0, 9, compact );
+    QVERIFY( detailed.isCompact() );
+    QVERIFY( compact == regular );
+    QCOMPARE( compact.at( 1 ).detail(), 5 );
+}
+
 QTEST_MAIN( TestGeoDataGeometry )
 #include "TestGeoDataGeometry.moc"
 
@@ -0,0 +1,284 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "OsmBinaryTile.h"
+#include "OsmElementDictionary.h"
+#include "GeoDataDocument.h"
+#include "GeoDataLinearRing.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPolygon.h"
+#include "GeoDataTypes.h"
+#include "osm/OsmPlacemarkData.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace Marble;
+
+class TestOsmBinaryTile : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void roundTrip();
+    void stringTable();
+    void storedCategories();
+    void categoryFallback();
+    void unsupportedVersion();
+
+private:
+    bool write(const QString &fileName, const OsmBinaryTileWriter &writer);
+    bool write(const QString &fileName, const QByteArray &content);
+    GeoDataDocument *parse(const QString &fileName);
+    static const GeoDataPlacemark *placemark(const GeoDataDocument *document, qint64 id);
+    static OsmNode node(qint64 id, qreal lon, qreal lat);
+    static OsmWay way(qint64 id, const QVector<qint64> &references);
+    static OsmNode restaurant(qint64 id);
+    static bool fuzzyCompare(const GeoDataCoordinates &a, const GeoDataCoordinates &b);
+
+    QTemporaryDir m_dir;
+};
+
+void TestOsmBinaryTile::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+}
+
+bool TestOsmBinaryTile::write(const QString &fileName, const OsmBinaryTileWriter &writer)
+{
+    QFile file(fileName);
+    return file.open(QFile::WriteOnly) && writer.write(&file);
+}
+
+bool TestOsmBinaryTile::write(const QString &fileName, const QByteArray &content)
+{
+    QFile file(fileName);
+    return file.open(QFile::WriteOnly) && file.write(content) == content.size();
+}
+
+GeoDataDocument *TestOsmBinaryTile::parse(const QString &fileName)
+{
+    QString error;
+    GeoDataDocument *const document = OsmBinaryTileReader::parse(fileName, error);
+    if (!error.isEmpty()) {
+        qWarning() << error;
+    }
+    return document;
+}
+
+const GeoDataPlacemark *TestOsmBinaryTile::placemark(const GeoDataDocument *document, qint64 id)
+{
+    foreach (const GeoDataPlacemark *placemark, document->placemarkList()) {
+        if (placemark->osmData().id() == id) {
+            return placemark;
+        }
+    }
+    return 0;
+}
+
+OsmNode TestOsmBinaryTile::node(qint64 id, qreal lon, qreal lat)
+{
+    OsmNode node;
+    node.osmData().setId(id);
+    node.setCoordinates(GeoDataCoordinates(lon, lat, 0, GeoDataCoordinates::Degree));
+    return node;
+}
+
+OsmWay TestOsmBinaryTile::way(qint64 id, const QVector<qint64> &references)
+{
+    OsmWay way;
+    way.osmData().setId(id);
+    foreach (qint64 reference, references) {
+        way.addReference(reference);
+    }
+    return way;
+}
+
+OsmNode TestOsmBinaryTile::restaurant(qint64 id)
+{
+    OsmNode restaurant = node(id, 11.0, 48.0);
+    restaurant.osmData().addTag("amenity", "restaurant");
+    restaurant.osmData().addTag("name", "Restaurant");
+    return restaurant;
+}
+
+bool TestOsmBinaryTile::fuzzyCompare(const GeoDataCoordinates &a, const GeoDataCoordinates &b)
+{
+    // coordinates are stored in 1e-7 degrees
+    return qAbs(a.longitude(GeoDataCoordinates::Degree) - b.longitude(GeoDataCoordinates::Degree)) < 1e-7
+            && qAbs(a.latitude(GeoDataCoordinates::Degree) - b.latitude(GeoDataCoordinates::Degree)) < 1e-7;
+}
+
+void TestOsmBinaryTile::roundTrip()
+{
+    OsmBinaryTileWriter writer;
+
+    // ids, coordinates and references decrease, so all differences are negative
+    OsmRelation building;
+    building.osmData().setId(20);
+    building.osmData().addTag("type", "multipolygon");
+    building.osmData().addTag("building", "yes");
+    building.addMember(12, "outer", QString::fromLatin1(osm::osmTag_way));
+    building.addMember(11, "inner", QString::fromLatin1(osm::osmTag_way));
+    writer.addRelation(building);
+
+    OsmRelation courtyard;
+    courtyard.osmData().setId(15);
+    courtyard.osmData().addTag("type", "multipolygon");
+    courtyard.osmData().addTag("leisure", "park");
+    courtyard.addMember(1, "label", QString::fromLatin1(osm::osmTag_node));
+    courtyard.addMember(11, "outer", QString::fromLatin1(osm::osmTag_way));
+    writer.addRelation(courtyard);
+
+    QVector<OsmNode> nodes;
+    nodes << node(9, -43.2, -22.9) << node(8, -43.19, -22.9)
+          << node(7, -43.19, -22.91) << node(6, -43.2, -22.91)
+          << node(5, -43.198, -22.902) << node(4, -43.192, -22.902)
+          << node(3, -43.192, -22.908) << node(2, -43.198, -22.908)
+          << node(1, -43.1950001, -22.9050001);
+    nodes.last().osmData().addTag("amenity", "restaurant");
+    nodes.last().osmData().addTag("name", QString::fromUtf8("Churrascaria São Jorge"));
+    foreach (const OsmNode &node, nodes) {
+        writer.addNode(node);
+    }
+
+    writer.addWay(way(12, QVector<qint64>() << 9 << 8 << 7 << 6 << 9));
+    writer.addWay(way(11, QVector<qint64>() << 5 << 4 << 3 << 2 << 5));
+
+    const QString fileName = m_dir.path() + "/roundTrip.osmb";
+    QVERIFY(write(fileName, writer));
+    QScopedPointer<GeoDataDocument> document(parse(fileName));
+    QVERIFY(document);
+
+    const GeoDataPlacemark *restaurant = placemark(document.data(), 1);
+    QVERIFY(restaurant);
+    QVERIFY(fuzzyCompare(restaurant->coordinate(), nodes.last().coordinates()));
+    QCOMPARE(restaurant->osmData().tagValue("amenity"), QString("restaurant"));
+    QCOMPARE(restaurant->name(), QString::fromUtf8("Churrascaria São Jorge"));
+
+    // the roles of the members decide about the rings
+    const GeoDataPlacemark *buildingPlacemark = placemark(document.data(), 20);
+    QVERIFY(buildingPlacemark);
+    QCOMPARE(buildingPlacemark->geometry()->nodeType(), GeoDataTypes::GeoDataPolygonType);
+    const GeoDataPolygon *buildingPolygon = static_cast<const GeoDataPolygon *>(buildingPlacemark->geometry());
+    QCOMPARE(buildingPolygon->innerBoundaries().size(), 1);
+    QVERIFY(fuzzyCompare(buildingPolygon->outerBoundary().first(), nodes.at(0).coordinates()));
+    QVERIFY(fuzzyCompare(buildingPolygon->innerBoundaries().first().first(), nodes.at(4).coordinates()));
+
+    const GeoDataPlacemark *courtyardPlacemark = placemark(document.data(), 15);
+    QVERIFY(courtyardPlacemark);
+    QCOMPARE(courtyardPlacemark->osmData().tagValue("leisure"), QString("park"));
+    QCOMPARE(courtyardPlacemark->geometry()->nodeType(), GeoDataTypes::GeoDataPolygonType);
+    const GeoDataPolygon *courtyardPolygon = static_cast<const GeoDataPolygon *>(courtyardPlacemark->geometry());
+    QVERIFY(courtyardPolygon->innerBoundaries().isEmpty());
+    QCOMPARE(courtyardPolygon->outerBoundary().size(), buildingPolygon->innerBoundaries().first().size());
+    for (int i = 0; i < courtyardPolygon->outerBoundary().size(); ++i) {
+        QVERIFY(fuzzyCompare(courtyardPolygon->outerBoundary().at(i), nodes.at(4 + i % 4).coordinates()));
+    }
+}
+
+void TestOsmBinaryTile::stringTable()
+{
+    OsmBinaryTileWriter writer;
+    for (qint64 id = 1; id <= 3; ++id) {
+        writer.addNode(restaurant(id));
+    }
+
+    const QString fileName = m_dir.path() + "/stringTable.osmb";
+    QVERIFY(write(fileName, writer));
+
+    // tags and the category table refer to the same strings
+    QFile file(fileName);
+    QVERIFY(file.open(QFile::ReadOnly));
+    const QByteArray content = file.readAll();
+    QCOMPARE(content.count("amenity"), 1);
+    QCOMPARE(content.count("restaurant"), 1);
+    QCOMPARE(content.count("Restaurant"), 1);
+
+    QScopedPointer<GeoDataDocument> document(parse(fileName));
+    QVERIFY(document);
+    QCOMPARE(document->placemarkList().size(), 3);
+    foreach (const GeoDataPlacemark *placemark, document->placemarkList()) {
+        QCOMPARE(placemark->osmData().tagValue("amenity"), QString("restaurant"));
+        QCOMPARE(placemark->name(), QString("Restaurant"));
+    }
+}
+
+void TestOsmBinaryTile::storedCategories()
+{
+    OsmBinaryTileWriter writer;
+    OsmNode bar = restaurant(1);
+    bar.setVisualCategory(GeoDataFeature::FoodBar);
+    writer.addNode(bar);
+    writer.addNode(restaurant(2));
+
+    const QString fileName = m_dir.path() + "/storedCategories.osmb";
+    QVERIFY(write(fileName, writer));
+    QScopedPointer<GeoDataDocument> document(parse(fileName));
+    QVERIFY(document);
+
+    // the stored category takes precedence over the tags
+    QVERIFY(placemark(document.data(), 1));
+    QCOMPARE(placemark(document.data(), 1)->visualCategory(), GeoDataFeature::FoodBar);
+    QVERIFY(placemark(document.data(), 2));
+    QCOMPARE(placemark(document.data(), 2)->visualCategory(), GeoDataFeature::FoodRestaurant);
+}
+
+void TestOsmBinaryTile::categoryFallback()
+{
+    // a category without an OSM tag is determined from the tags
+    OsmBinaryTileWriter writer;
+    OsmNode city = restaurant(1);
+    city.setVisualCategory(GeoDataFeature::SmallCity);
+    writer.addNode(city);
+
+    const QString writtenFileName = m_dir.path() + "/categoryFallback.osmb";
+    QVERIFY(write(writtenFileName, writer));
+    QScopedPointer<GeoDataDocument> written(parse(writtenFileName));
+    QVERIFY(written);
+    QVERIFY(placemark(written.data(), 1));
+    QCOMPARE(placemark(written.data(), 1)->visualCategory(), GeoDataFeature::FoodRestaurant);
+
+    // so is a category of a tag unknown to the reader, as written by a later version
+    static const char unknownCategoryTile[] =
+        "MOBT" "\x02"                                  // version
+        "\x03" "\x07" "amenity" "\x0a" "restaurant" "\x0a" "teleporter"  // strings
+        "\x01" "\x00" "\x02"                           // categories: amenity=teleporter
+        "\x00"                                         // relations
+        "\x01" "\x02" "\x00" "\x00" "\x01" "\x01" "\x00" "\x01"   // node 1 of amenity=teleporter, amenity=restaurant
+        "\x00";                                        // ways
+    const QByteArray content(unknownCategoryTile, sizeof(unknownCategoryTile) - 1);
+
+    const QString craftedFileName = m_dir.path() + "/unknownCategory.osmb";
+    QVERIFY(write(craftedFileName, content));
+    QScopedPointer<GeoDataDocument> crafted(parse(craftedFileName));
+    QVERIFY(crafted);
+    QVERIFY(placemark(crafted.data(), 1));
+    QCOMPARE(placemark(crafted.data(), 1)->visualCategory(), GeoDataFeature::FoodRestaurant);
+}
+
+void TestOsmBinaryTile::unsupportedVersion()
+{
+    // the first version stored categories as values of GeoDataVisualCategory
+    static const char version1Tile[] = "MOBT" "\x01" "\xb7\x01" "\x00" "\x00" "\x00" "\x00";
+    const QByteArray content(version1Tile, sizeof(version1Tile) - 1);
+
+    const QString fileName = m_dir.path() + "/version1.osmb";
+    QVERIFY(write(fileName, content));
+    QString error;
+    QScopedPointer<GeoDataDocument> document(OsmBinaryTileReader::parse(fileName, error));
+    QVERIFY(!document);
+    QVERIFY(!error.isEmpty());
+}
+
+QTEST_MAIN( TestOsmBinaryTile )
+
+#include "TestOsmBinaryTile.moc"
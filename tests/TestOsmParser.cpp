@@ -0,0 +1,195 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "OsmParser.h"
+#include "OsmElementDictionary.h"
+#include "GeoDataDocument.h"
+#include "GeoDataLineString.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTypes.h"
+#include "GeoWriter.h"
+#include "osm/OsmPlacemarkData.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace Marble;
+
+class TestOsmParser : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void wayNodeAttributes();
+    void placemarkOrder();
+    void roundTrip();
+
+private:
+    GeoDataDocument *parse(const QString &fileName);
+    static const GeoDataPlacemark *placemark(const GeoDataDocument *document, qint64 id);
+    static OsmPlacemarkData wayNode(const GeoDataPlacemark *way, int index);
+
+    QTemporaryDir m_dir;
+    QString m_fileName;
+};
+
+static const char osmFile[] =
+    "<?xml version='1.0' encoding='UTF-8'?>\n"
+    "<osm version='0.6' generator='TestOsmParser'>\n"
+    " <node id='1' version='3' changeset='100' user='alice' uid='7' visible='true' timestamp='2015-01-01T00:00:00Z' lat='48.0' lon='11.0'/>\n"
+    " <node id='2' version='1' changeset='101' user='bob' uid='8' visible='true' timestamp='2015-01-02T00:00:00Z' lat='48.001' lon='11.001'/>\n"
+    " <node id='3' lat='48.002' lon='11.0'/>\n"
+    " <node id='4' lat='48.003' lon='11.003'/>\n"
+    " <node id='5' lat='48.0' lon='11.003'>\n"
+    "  <tag k='amenity' v='restaurant'/>\n"
+    "  <tag k='name' v='Nodes'/>\n"
+    " </node>\n"
+    " <node id='6' lat='48.003' lon='11.0'/>\n"
+    " <way id='11' version='2'>\n"
+    "  <nd ref='3'/>\n"
+    "  <nd ref='4'/>\n"
+    "  <nd ref='6'/>\n"
+    "  <nd ref='3'/>\n"
+    " </way>\n"
+    " <way id='10' version='5' user='alice'>\n"
+    "  <nd ref='1'/>\n"
+    "  <nd ref='2'/>\n"
+    "  <nd ref='3'/>\n"
+    "  <tag k='highway' v='residential'/>\n"
+    "  <tag k='name' v='Ways'/>\n"
+    " </way>\n"
+    " <relation id='20'>\n"
+    "  <member type='way' ref='11' role='outer'/>\n"
+    "  <tag k='type' v='multipolygon'/>\n"
+    "  <tag k='building' v='yes'/>\n"
+    " </relation>\n"
+    "</osm>\n";
+
+void TestOsmParser::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    m_fileName = m_dir.path() + "/test.osm";
+
+    QFile file(m_fileName);
+    QVERIFY(file.open(QFile::WriteOnly));
+    QVERIFY(file.write(osmFile) > 0);
+}
+
+GeoDataDocument *TestOsmParser::parse(const QString &fileName)
+{
+    QString error;
+    GeoDataDocument *const document = OsmParser::parse(fileName, error);
+    if (!error.isEmpty()) {
+        qWarning() << error;
+    }
+    return document;
+}
+
+const GeoDataPlacemark *TestOsmParser::placemark(const GeoDataDocument *document, qint64 id)
+{
+    foreach (const GeoDataPlacemark *placemark, document->placemarkList()) {
+        if (placemark->osmData().id() == id) {
+            return placemark;
+        }
+    }
+    return 0;
+}
+
+OsmPlacemarkData TestOsmParser::wayNode(const GeoDataPlacemark *way, int index)
+{
+    const GeoDataLineString *lineString = static_cast<const GeoDataLineString *>(way->geometry());
+    return way->osmData().nodeReference(lineString->at(index));
+}
+
+void TestOsmParser::wayNodeAttributes()
+{
+    QScopedPointer<GeoDataDocument> document(parse(m_fileName));
+    QVERIFY(document);
+
+    const GeoDataPlacemark *way = placemark(document.data(), 10);
+    QVERIFY(way);
+    QCOMPARE(way->geometry()->nodeType(), GeoDataTypes::GeoDataLineStringType);
+
+    const OsmPlacemarkData first = wayNode(way, 0);
+    QCOMPARE(first.id(), qint64(1));
+    QCOMPARE(first.version(), QString("3"));
+    QCOMPARE(first.changeset(), QString("100"));
+    QCOMPARE(first.user(), QString("alice"));
+    QCOMPARE(first.uid(), QString("7"));
+    QCOMPARE(first.isVisible(), QString("true"));
+    QCOMPARE(first.timestamp(), QString("2015-01-01T00:00:00Z"));
+
+    QCOMPARE(wayNode(way, 1).user(), QString("bob"));
+
+    // stored compactly, nothing but the id to restore
+    const OsmPlacemarkData third = wayNode(way, 2);
+    QCOMPARE(third.id(), qint64(3));
+    QVERIFY(third.version().isEmpty());
+}
+
+void TestOsmParser::placemarkOrder()
+{
+    QScopedPointer<GeoDataDocument> document(parse(m_fileName));
+    QVERIFY(document);
+
+    // relations, ways and nodes, each sorted by id
+    QVector<qint64> ids;
+    foreach (const GeoDataPlacemark *placemark, document->placemarkList()) {
+        ids << placemark->osmData().id();
+    }
+    QCOMPARE(ids, QVector<qint64>() << 20 << 10 << 11 << 5);
+}
+
+void TestOsmParser::roundTrip()
+{
+    QScopedPointer<GeoDataDocument> document(parse(m_fileName));
+    QVERIFY(document);
+
+    const QString writtenFileName = m_dir.path() + "/written.osm";
+    {
+        QFile file(writtenFileName);
+        QVERIFY(file.open(QFile::WriteOnly));
+        GeoWriter writer;
+        writer.setDocumentType(osm::osmTag_version06);
+        QVERIFY(writer.write(&file, document.data()));
+    }
+
+    QScopedPointer<GeoDataDocument> reloaded(parse(writtenFileName));
+    QVERIFY(reloaded);
+
+    const GeoDataPlacemark *way = placemark(reloaded.data(), 10);
+    QVERIFY(way);
+    QCOMPARE(way->osmData().version(), QString("5"));
+    QCOMPARE(way->osmData().user(), QString("alice"));
+    QCOMPARE(way->osmData().tagValue("highway"), QString("residential"));
+
+    const OsmPlacemarkData first = wayNode(way, 0);
+    QCOMPARE(first.id(), qint64(1));
+    QCOMPARE(first.version(), QString("3"));
+    QCOMPARE(first.changeset(), QString("100"));
+    QCOMPARE(first.user(), QString("alice"));
+    QCOMPARE(first.uid(), QString("7"));
+    QCOMPARE(first.isVisible(), QString("true"));
+    QCOMPARE(first.timestamp(), QString("2015-01-01T00:00:00Z"));
+
+    const OsmPlacemarkData second = wayNode(way, 1);
+    QCOMPARE(second.id(), qint64(2));
+    QCOMPARE(second.user(), QString("bob"));
+    QCOMPARE(second.timestamp(), QString("2015-01-02T00:00:00Z"));
+
+    const GeoDataPlacemark *node = placemark(reloaded.data(), 5);
+    QVERIFY(node);
+    QCOMPARE(node->osmData().tagValue("amenity"), QString("restaurant"));
+}
+
+QTEST_MAIN( TestOsmParser )
+
+#include "TestOsmParser.moc"
@@ -13,74 +13,39 @@
 
 #include <ParsingRunnerManager.h>
 #include <PluginManager.h>
-#include <MarbleClock.h>
 #include <GeoDataDocument.h>
 #include <GeoDataFolder.h>
 #include <GeoDataPlacemark.h>
-#include <GeoDataExtendedData.h>
 #include <GeoWriter.h>
+#include "CacheFile.h"
 
 #include <QApplication>
 #include <QDebug>
 #include <QFile>
 #include <iostream>
-#include <QDataStream>
 
 using namespace std;
 using namespace Marble;
 
-const quint32 MarbleMagicNumber = 0x31415926;
-
-void savePlacemarks( QDataStream &out, const GeoDataContainer *container, MarbleClock* clock )
+void collectPlacemarks( const GeoDataContainer *container, QVector<const GeoDataPlacemark*> &placemarks )
 {
-    qreal lon;
-    qreal lat;
-    qreal alt;
-
-    const QVector<GeoDataPlacemark*> placemarks = container->placemarkList();
-    QVector<GeoDataPlacemark*>::const_iterator it = placemarks.constBegin();
-    QVector<GeoDataPlacemark*>::const_iterator const end = placemarks.constEnd();
-    for (; it != end; ++it ) {
-        out << (*it)->name();
-        (*it)->coordinate().geoCoordinates( lon, lat, alt );
-
-        // Use double to provide a single cache file format across architectures
-        out << (double)(lon) << (double)(lat) << (double)(alt);
-        out << QString( (*it)->role() );
-        out << QString( (*it)->description() );
-        out << QString( (*it)->countryCode() );
-        out << QString( (*it)->state() );
-        out << (double) (*it)->area();
-        out << (qint64) (*it)->population();
-        out << ( qint16 ) ( (*it)->extendedData().value("gmt").value().toInt() );
-        out << ( qint8 ) ( (*it)->extendedData().value("dst").value().toInt() );
+    foreach ( const GeoDataPlacemark *placemark, container->placemarkList() ) {
+        placemarks << placemark;
     }
 
-    const QVector<GeoDataFolder*> folders = container->folderList();
-    QVector<GeoDataFolder*>::const_iterator cont = folders.constBegin();
-    QVector<GeoDataFolder*>::const_iterator endcont = folders.constEnd();
-    for (; cont != endcont; ++cont ) {
-            savePlacemarks( out, *cont, clock );
+    foreach ( const GeoDataFolder *folder, container->folderList() ) {
+        collectPlacemarks( folder, placemarks );
     }
 }
 
 void saveFile( const QString& filename, GeoDataDocument* document )
 {
-    QFile file( filename );
-    if ( !file.open( QIODevice::WriteOnly ) ) {
-        qDebug() << Q_FUNC_INFO << "Can't open" << filename << "for writing";
-        return;
-    }
-    QDataStream out( &file );
+    QVector<const GeoDataPlacemark*> placemarks;
+    collectPlacemarks( document, placemarks );
 
-    // Write a header with a "magic number" and a version
-    // out << (quint32)0xA0B0C0D0;
-    out << (quint32)MarbleMagicNumber;
-    out << (qint32)015;
-
-    out.setVersion( QDataStream::Qt_4_2 );
-
-    savePlacemarks( out, document, new MarbleClock );
+    if ( !CacheFile::write( filename, placemarks ) ) {
+        qDebug() << Q_FUNC_INFO << "Can't write" << filename;
+    }
 }
 
 int main(int argc, char** argv)
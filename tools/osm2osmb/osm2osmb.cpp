@@ -0,0 +1,43 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+// Converts an .osm or .osm.zip vector tile to a binary vector tile (.osmb)
+
+#include "OsmParser.h"
+
+#include <QApplication>
+#include <QDebug>
+
+using namespace Marble;
+
+int main(int argc, char** argv)
+{
+    QApplication app(argc,argv);
+
+    QString inputFilename;
+    int inputIndex = app.arguments().indexOf( "-i" );
+    if ( inputIndex > 0 && inputIndex + 1 < argc ) {
+        inputFilename = app.arguments().at( inputIndex + 1 );
+    } else {
+        qDebug( " Syntax: osm2osmb -i sourcefile [-o osmb-targetfile]" );
+        return 1;
+    }
+
+    QString outputFilename = "output.osmb";
+    int outputIndex = app.arguments().indexOf("-o");
+    if ( outputIndex > 0 && outputIndex + 1 < argc )
+        outputFilename = app.arguments().at( outputIndex + 1 );
+
+    QString error;
+    if ( !OsmParser::convert( inputFilename, outputFilename, error ) ) {
+        qDebug() << "Could not convert" << inputFilename << ":" << error;
+        return 2;
+    }
+
+    return 0;
+}
@@ -12,7 +12,7 @@
 #
 
 """
-Creates vector tiles (small .osm.zip files with standardized path/filenames) from larger osm files
+Creates vector tiles (small .osm.zip or binary .osmb files with standardized path/filenames) from larger osm files
 """
 
 
@@ -82,6 +82,7 @@ if __name__ == "__main__":
     parser.add_argument('-c', '--cache', help='directory to store intermediate files in', default='.')
     parser.add_argument('-r', '--refresh', type=int, default=-1, help='Re-download cached OSM base file if it is older than REFRESH days (-1: do not re-download)')
     parser.add_argument('-z', '--zoomLevels', type=int, nargs='+', help='zoom levels to generate', default=[13,15,17])
+    parser.add_argument('-b', '--binary', action='store_true', help='Write binary .osmb tiles using osm2osmb instead of .osm.zip files')
     args = parser.parse_args()    
     
     for csvfilename in args.file:
@@ -108,7 +109,7 @@ if __name__ == "__main__":
                             path = "{}/{}/{}".format(args.directory, zoom, x-1)
                             target = "{}.osm".format(y-1)
                             filterTarget = "{}_tmp.osm".format(y-1)
-                            zipTarget = "{}.osm.zip".format(y-1)
+                            zipTarget = "{}.osmb".format(y-1) if args.binary else "{}.osm.zip".format(y-1)
                             if not args.overwrite and os.path.exists(os.path.join(path, zipTarget)):
                                 print("Skipping existing file {}\r".format(os.path.join(path, zipTarget)), end='')
                             else:
@@ -122,6 +123,9 @@ if __name__ == "__main__":
                                 else:
                                     call(["osmconvert", "-t={}/osmconvert_tmp-".format(args.cache), "--complete-ways", "--complex-ways", "--drop-version", "-b={},{},{},{}".format(tl[1],br[0],br[1],tl[0]), cutted, "-o={}".format(os.path.join(args.cache, target))])
                                 call(["chmod", "644", os.path.join(args.cache, target)])
-                                with zipfile.ZipFile(os.path.join(path, zipTarget), 'w') as myzip:
-                                    myzip.write(os.path.join(args.cache, target), "{}.osm".format(y-1))
+                                if args.binary:
+                                    call(["osm2osmb", "-i", os.path.join(args.cache, target), "-o", os.path.join(path, zipTarget)])
+                                else:
+                                    with zipfile.ZipFile(os.path.join(path, zipTarget), 'w') as myzip:
+                                        myzip.write(os.path.join(args.cache, target), "{}.osm".format(y-1))
                                 os.remove(os.path.join(args.cache, target))